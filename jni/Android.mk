@@ -15,7 +15,13 @@ LOCAL_MODULE := libopenvoice
 LOCAL_SRC_FILES := \
         main/siren_control.cpp \
         main/VoiceService.cpp \
-        main/VoiceCallback.cpp
+        main/VoiceCallback.cpp \
+        main/CallbackBatch.cpp \
+        main/CallbackDispatcher.cpp \
+        main/JsonFields.cpp \
+        main/CaptureBackend.cpp \
+        main/CaptureAlsa.cpp \
+        main/CaptureSources.cpp
 LOCAL_C_INCLUDES := \
         $(LOCAL_PATH)/include \
         $(LOCAL_PATH)/blacksiren/libbsiren/include \
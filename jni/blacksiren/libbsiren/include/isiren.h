@@ -8,6 +8,8 @@ namespace BlackSiren {
 
 enum {
     SIREN_CALLBACK_ON_STATE_CHANGED = 0,
+    SIREN_CALLBACK_ON_CONFIG_RELOADED,
+    SIREN_CALLBACK_ON_AEC_DELAY,
 };
 
 enum {
@@ -21,8 +23,10 @@ enum {
     SIREN_REQUEST_MSG_SET_STEER,
     SIREN_REQUEST_MSG_DATA_PROCESS,
     SIREN_REQUEST_MSG_SYNC_VT_WORD_LIST,
+    SIREN_REQUEST_MSG_RELOAD_CONFIG,
     SIREN_REQUEST_MSG_DESTROY_ON_INIT,
     SIREN_REQUEST_MSG_DESTROY,
+    SIREN_REQUEST_MSG_HEARTBEAT,
 
 
     SIREN_RESPONSE_MSG_ON_INIT_OK,
@@ -32,6 +36,7 @@ enum {
     SIREN_RESPONSE_MSG_ON_RAW_VOICE,
     SIREN_RESPONSE_MSG_ON_CALLBACK,
     SIREN_RESPONSE_MSG_ON_DESTROY,
+    SIREN_RESPONSE_MSG_ON_HEARTBEAT,
 };
 
 
@@ -0,0 +1,90 @@
+//
+//  r2aecdelay.h
+//  r2ad2
+//
+//  far end delay estimation on decimated envelopes, and alignment of
+//  mic and reference frames in front of aec
+//
+
+#ifndef __r2ad2__r2aecdelay__
+#define __r2ad2__r2aecdelay__
+
+//samples of one envelope point, 2ms at 16k
+#define R2AECDELAY_DECIM 32
+//envelope points of correlation memory, about 1s
+#define R2AECDELAY_WIN 500
+//peak correlation needed to take an estimate
+#define R2AECDELAY_CONFIDENCE 0.4f
+//frames an estimate must hold before it is applied
+#define R2AECDELAY_HOLD 25
+//echo is left this many samples behind reference, aec filter covers it
+#define R2AECDELAY_MARGIN 64
+
+
+class r2aecdelay
+{
+public:
+  //iFrmLen: samples of each channel per call, multiple of R2AECDELAY_DECIM
+  //iMaxDelay: largest offset searched either way, in samples
+  r2aecdelay(int iMicNum, int iRefNum, int iFrmLen, int iMaxDelay);
+public:
+  ~r2aecdelay(void);
+
+public:
+  int reset();
+  //frames are channel after channel, estimate on them then align in
+  //place, reference is delayed when echo lags it, mics when it leads.
+  //returns 1 when the applied offset changes
+  int process(float* pMic, float* pRef);
+
+public:
+
+  int m_iMicNum ;
+  int m_iRefNum ;
+  int m_iFrmLen ;
+
+  //lags -m_iLagMax..m_iLagMax in envelope points, echo lags reference
+  //for positive ones
+  int m_iLagMax ;
+  int m_iLagNum ;
+  float* m_pSxy ;
+  float m_fSxx ;
+  float m_fSyy ;
+
+  //log envelope history, newest at m_iEnvPos
+  float* m_pEnvMic ;
+  float* m_pEnvRef ;
+  int m_iEnvPos ;
+  float m_fLastMic ;
+  float m_fLastRef ;
+  float m_fRefFloor ;
+  float m_fRefLevel ;
+  //points of playback so far, and of silence since the last one
+  int m_iActive ;
+  int m_iSilent ;
+
+  //candidate waiting for R2AECDELAY_HOLD frames
+  int m_iCand ;
+  int m_iCandFrm ;
+
+  //estimated echo delay in samples, negative when reference lags echo
+  int m_iDelay ;
+  int m_iDelayFirst ;
+  int m_bLocked ;
+  int m_iChanges ;
+  float m_fConfidence ;
+
+  //applied offset, > 0 reference delayed, < 0 mics delayed
+  int m_iAlign ;
+  int m_iRingLen ;
+  int m_iRingPos ;
+  float** m_pRingMic ;
+  float** m_pRingRef ;
+
+private:
+  void estimate(const float* pMic, const float* pRef);
+  void delayFrm(float* pFrm, float* pRing, int iDelay);
+};
+
+
+#endif /* __r2ad2__r2aecdelay__ */
@@ -0,0 +1,79 @@
+//
+//  r2frm.h
+//  r2ad2
+//
+//  framing of a chain driven in fixed hops: every unit declares the block
+//  it works in, a unit whose block does not fit the hop holds back a fixed
+//  lookahead so it still gives out exactly one hop per hop. units take
+//  and give their data through rings of fixed size.
+//
+
+#ifndef __r2ad2__r2frm__
+#define __r2ad2__r2frm__
+
+#define R2FRM_UNIT_MAX 8
+
+
+class r2frm_plan
+{
+public:
+  r2frm_plan(int iHop);
+public:
+  ~r2frm_plan(void);
+
+public:
+  //iBlock 1 for units taking any length, returns unit index
+  int add(const char* pName, int iBlock);
+  //samples a unit holds back, B - gcd(hop, B), 0 when B divides hop
+  int getLookahead(int iUnit);
+  //added by framing over the chain
+  int getLatency();
+  //hop at which no unit needs a lookahead, lcm of hop and blocks
+  int getCommonHop();
+  //one line of units, blocks and lookaheads
+  int dump(char* pBuf, int iLen);
+
+public:
+
+  int m_iHop ;
+  int m_iUnitNum ;
+  const char* m_pName[R2FRM_UNIT_MAX] ;
+  int m_iBlock[R2FRM_UNIT_MAX] ;
+  int m_iLookahead[R2FRM_UNIT_MAX] ;
+};
+
+
+class r2frm_ring
+{
+public:
+  r2frm_ring(int iCn, int iCap);
+public:
+  ~r2frm_ring(void);
+
+public:
+  int reset();
+  int size();
+  int space();
+  //channel i from pData[pIdLst[i]] + iOffset, or pData[i] + iOffset when
+  //pIdLst is NULL, returns samples taken, at most space()
+  int put(float** pData, const int* pIdLst, int iOffset, int iLen);
+  int putZero(int iLen);
+  //copy oldest samples out without taking them, at most size()
+  int peek(float** pData, const int* pIdLst, int iOffset, int iLen);
+  int drop(int iLen);
+  int get(float** pData, const int* pIdLst, int iOffset, int iLen);
+  //copy newest samples out, oldest of them first, at most size()
+  int last(float** pData, const int* pIdLst, int iOffset, int iLen);
+
+public:
+
+  int m_iCn ;
+  int m_iCap ;
+  float** m_pData ;
+  //oldest sample and samples held
+  int m_iHead ;
+  int m_iSize ;
+};
+
+
+#endif /* __r2ad2__r2frm__ */
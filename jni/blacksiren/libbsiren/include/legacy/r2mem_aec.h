@@ -2,13 +2,19 @@
 #define R2_MEM_AEC_H
 
 #include "r2ssp.h"
+#include "r2aecdelay.h"
+#include "r2frm.h"
 #include "r2math.h"
 
 
 class r2mem_aec
 {
 public:
-  r2mem_aec(int iMicNum, r2_mic_info* pMicInfo_Aec, r2_mic_info* pMicInfo_AecRef, r2_mic_info*  m_pCpuInfo_Aec);
+  //iMaxDelay: far end offset searched and aligned in samples, 0 for none
+  //iHop: samples of each process call, iLookahead: from r2frm_plan, output
+  //is input iLookahead samples late and as long as input
+  r2mem_aec(int iMicNum, r2_mic_info* pMicInfo_Aec, r2_mic_info* pMicInfo_AecRef, r2_mic_info*  m_pCpuInfo_Aec, int iMaxDelay,
+            int iHop, int iLookahead);
 public:
   ~r2mem_aec(void);
   
@@ -27,17 +33,29 @@ public:
   float * m_pData_Aec_Ref ;
   float * m_pData_Aec_In ;
   float * m_pData_Aec_Out ;
+  //channels of aec buffers, mics then refs
+  float ** m_pData_Aec_Lst ;
+  float ** m_pData_Aec_Out_Lst ;
   
-  int m_iLen_In ;
-  float** m_pData_In ;
+  //aec mics then refs, until a frame is full
+  int* m_pRingId_In ;
+  r2frm_ring* m_pRing_In ;
+  
+  //aec mics, primed with lookahead of zeros
+  int m_iLookahead ;
+  r2frm_ring* m_pRing_Out ;
+  //output still owed when ring ran short on odd input lengths
+  int m_iOwe ;
   
-  int m_iFrmLen_Out ;
-  int m_iLen_Out ;
   int m_iLen_Out_Total ;
   float ** m_pData_Out ;
   
   r2ssp_handle m_hEngine_Aec ;
   
+  //far end delay estimation and alignment, NULL when off
+  r2aecdelay* m_pDelay ;
+  int m_bDelayChanged ;
+  
   int m_iRt ;
   
   
@@ -5,35 +5,86 @@
 //  Created by hadoop on 8/4/16.
 //  Copyright © 2016 hadoop. All rights reserved.
 //
+//  agc of one channel at 16 bit scale: an attack/release envelope of
+//  speech level sets the gain, a noise floor keeps the envelope from
+//  following noise and a peak limiter keeps the output under a ceiling.
+//  gain steps every R2AGC_BLOCK samples and is ramped inside a step
+//
 
 #ifndef __r2ad2__r2mem_agc__
 #define __r2ad2__r2mem_agc__
 
-#include "r2ssp.h"
 #include "r2math.h"
 
+//samples of one gain step, 2.5ms
+#define R2AGC_BLOCK 40
+//db per second the noise floor rises, slower while level is over it
+#define R2AGC_FLOOR_RISE 6.0f
+#define R2AGC_FLOOR_RISE_ACTIVE 0.5f
+//ms the noise floor takes to fall to a lower level
+#define R2AGC_FLOOR_FALL_MS 50.0f
+//ms the limiter takes to give gain back
+#define R2AGC_LIMIT_RELEASE_MS 50.0f
+
+//levels in db of 32768 full scale
+struct r2agc_param {
+  //level of speech envelope the gain aims at, the envelope follows
+  //short term level so whole utterances sit a few db under it
+  float fTargetDb = -18.0f ;
+  float fMaxGainDb = 24.0f ;
+  float fMinGainDb = -12.0f ;
+  //peak of output
+  float fLimitDb = -1.0f ;
+  float fAttackMs = 10.0f ;
+  float fReleaseMs = 300.0f ;
+  //level over noise floor the envelope follows, below it gain holds
+  float fGateDb = 10.0f ;
+};
 
 class r2mem_agc
 {
 public:
-  r2mem_agc(void);
+  r2mem_agc(const r2agc_param& param);
 public:
   ~r2mem_agc(void);
-  
+
 public:
+  //pData_Out is owned by agc and valid until next process
   int process(float* pData_In, int iLen_In, float*& pData_Out, int& iLen_Out);
+  //audio that does not go out, keeps noise floor current
+  int track(float* pData_In, int iLen_In);
+  //per utterance: gain and envelope start over, noise floor is kept
   int reset();
-  
+  float getgain_db();
+  float getfloor_db();
+
 public:
-  
-  int m_iFrmSize ;
-  r2ssp_handle m_hEngine_Agc ;
-  
+
+  r2agc_param m_param ;
+
+  //per full block
+  float m_fAttack ;
+  float m_fRelease ;
+  float m_fFloorFall ;
+  float m_fLimitRelease ;
+  float m_fLimit ;
+
+  float m_fEnv ;
+  float m_fFloor ;
+  bool m_bFloor ;
+  //gain of envelope in db, limiter part and last applied gain
+  float m_fGainDb ;
+  float m_fGainLimit ;
+  float m_fGain ;
+
   int m_iDataLen_Total ;
   float * m_pData_Out ;
-  
-  short* m_pData_Tmp ;
-  
+
+private:
+  float level(float* pData, int iLen, float& fPeak);
+  void floor(float fLevel, int iLen);
+  float coef(float fMs, int iLen);
+
 };
 
 
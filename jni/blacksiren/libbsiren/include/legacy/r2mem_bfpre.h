@@ -0,0 +1,72 @@
+//
+//  r2mem_bfpre.h
+//  r2ad2
+//
+//  preroll of beamformed audio: output of the steered bf and of a few
+//  fixed directions kept in rings, so audio before a wake is taken from
+//  them instead of beamforming it again
+//
+
+#ifndef __r2ad2__r2mem_bfpre__
+#define __r2ad2__r2mem_bfpre__
+
+#include "r2mem_bf.h"
+#include "r2frm.h"
+
+//fixed directions at most
+#define R2BFPRE_DIR_MAX 16
+//wake further than this from the two nearest fixed directions is beamformed again
+#define R2BFPRE_FAR (R2_BFSL_MIN_DIS * 2)
+
+enum r2bfpre_result {
+  r2bfpre_miss = 0,
+  r2bfpre_select = 1,
+  r2bfpre_interpolate = 2
+};
+
+class r2mem_bfpre
+{
+public:
+  //iDirNum: fixed directions spread over azimuth, 0 keeps only the steered bf
+  //iPrerollLen: samples kept of each direction
+  r2mem_bfpre(int iMicNum, float* pMicPosLst, float* pMicDelay, r2_mic_info* pMicInfo_Bf,
+              int iDirNum, int iPrerollLen);
+
+public:
+  ~r2mem_bfpre(void);
+
+public:
+  int reset();
+  //pData_Sig is what the steered bf gave out of the same input
+  int process(float** pData_In, int iLen_In, float* pData_Sig, int iLen_Sig);
+  //steered bf moved, what it gave so far is of another direction
+  int steer(float fAzimuth, float fElevation);
+  //newest iLen samples towards a direction, r2bfpre_miss when none is near
+  //enough or not that much is kept
+  int fetch(float fAzimuth, float fElevation, int iLen, float*& pData_Out);
+
+public:
+
+  int m_iDirNum ;
+  int m_iPrerollLen ;
+
+  //steered bf direction and its output since it was steered
+  float m_fSteer[2] ;
+  r2frm_ring* m_pRing_Steer ;
+
+  //fixed directions, their bf and output
+  float m_fDir[R2BFPRE_DIR_MAX][2] ;
+  r2mem_bf* m_pMem_Bf[R2BFPRE_DIR_MAX] ;
+  r2frm_ring* m_pRing_Dir[R2BFPRE_DIR_MAX] ;
+
+  float* m_pData_Tmp ;
+  float* m_pData_Out ;
+
+  //wakes served each way
+  int m_iCount[3] ;
+
+private:
+  void keep(r2frm_ring* pRing, float* pData, int iLen);
+};
+
+#endif /* defined(__r2ad2__r2mem_bfpre__) */
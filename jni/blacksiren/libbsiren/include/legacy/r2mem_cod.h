@@ -57,7 +57,8 @@ public:
   
   OpusEncoder *m_hEngine_Cod ;
 
-  //for amplitude norm
+  //for amplitude norm, off when an agc is in front
+  bool m_bNorm_Am ;
   int m_iLen_Am ;
   float m_fShield_Am ;
   
@@ -0,0 +1,80 @@
+//
+//  r2mem_gate.h
+//  r2ad2
+//
+//  gate of vt in sleep: a cheap level and flux detector over a few mics
+//  tells a silent hop from sound. silent hops are only kept in a ring,
+//  at onset the newest of them are given back so bf and vt catch up
+//  over audio they skipped
+//
+
+#ifndef __r2ad2__r2mem_gate__
+#define __r2ad2__r2mem_gate__
+
+#include "r2math.h"
+#include "r2frm.h"
+
+//full band and first difference, the last one stands for high band
+#define R2GATE_BAND_NUM 2
+//db the noise floor rises per hop, slower while there is sound
+#define R2GATE_FLOOR_RISE 0.05f
+#define R2GATE_FLOOR_RISE_ACTIVE 0.005f
+
+enum r2gate_result {
+  r2gate_closed = 0,
+  r2gate_open = 1,
+  r2gate_onset = 2
+};
+
+class r2mem_gate
+{
+public:
+  //iMicNum: channels of input, all are kept
+  //pMicInfo_Det: channels the detector looks at
+  //iLookback: newest samples kept while closed
+  //fOnsetDb: level over noise floor or rise in one hop that is sound
+  //iHangLen: samples the gate stays open after last sound
+  r2mem_gate(int iMicNum, r2_mic_info* pMicInfo_Det, int iLookback, float fOnsetDb, int iHangLen);
+
+public:
+  ~r2mem_gate(void);
+
+public:
+  int reset();
+  //one hop, bHold keeps the gate open as if it was sound. a closed hop
+  //is kept, at r2gate_onset kept() samples before this hop wait for fetch
+  int process(float** pData_In, int iLen_In, bool bHold);
+  int kept();
+  //kept samples into pData_Out[channel], oldest first, drops them
+  int fetch(float** pData_Out, int iLen);
+
+public:
+
+  int m_iMicNum ;
+  r2_mic_info* m_pMicInfo_Det ;
+  int m_iLookback ;
+  float m_fOnsetDb ;
+  int m_iHangLen ;
+
+  r2frm_ring* m_pRing ;
+
+  //band levels of last hop and noise floor, db
+  float m_fLevel[R2GATE_BAND_NUM] ;
+  float m_fFloor[R2GATE_BAND_NUM] ;
+  bool m_bFloor ;
+  //last sample of each detector mic, first difference goes across hops
+  float* m_pLast ;
+
+  bool m_bOpen ;
+  int m_iHang ;
+
+  //samples closed and open, onsets
+  long long m_iLen_Closed ;
+  long long m_iLen_Open ;
+  int m_iOnset ;
+
+private:
+  bool detect(float** pData_In, int iLen_In);
+};
+
+#endif /* defined(__r2ad2__r2mem_gate__) */
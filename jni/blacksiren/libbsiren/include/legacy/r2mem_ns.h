@@ -0,0 +1,97 @@
+//
+//  r2mem_ns.h
+//  r2ad2
+//
+//  single channel noise suppression of bf output: wiener gain from a
+//  decision directed a priori snr over a tracked noise spectrum. runs
+//  in hops of the 10ms pipeline, a window of two hops zero padded to the
+//  fft, so output is one hop late. bypassed hops cost a copy and keep
+//  the same delay, noise is still tracked every few of them
+//
+
+#ifndef __r2ad2__r2mem_ns__
+#define __r2ad2__r2mem_ns__
+
+#include "r2math.h"
+
+#define R2NS_FFT 512
+#define R2NS_BIN (R2NS_FFT / 2 + 1)
+//bins rounded up to simd width
+#define R2NS_BIN_PAD ((R2NS_BIN + 3) / 4 * 4)
+
+//decision directed weight of last clean estimate
+#define R2NS_DD_ALPHA 0.98f
+//noise estimate follows smoothed power, falls fast and rises slowly,
+//slower still where power is far over it
+#define R2NS_PSD_SMOOTH 0.5f
+#define R2NS_NOISE_FALL 0.2f
+#define R2NS_NOISE_RISE_DB 5.0f
+#define R2NS_NOISE_RISE_ACTIVE_DB 0.5f
+#define R2NS_NOISE_ACTIVE_RATIO 4.0f
+//tracker sits under mean of noise
+#define R2NS_NOISE_BIAS 2.0f
+//one of these bypassed hops updates noise
+#define R2NS_BYPASS_TRACK 8
+
+class r2mem_ns
+{
+public:
+  //fFloorDb: lowest gain of a bin
+  r2mem_ns(float fFloorDb);
+public:
+  ~r2mem_ns(void);
+
+public:
+  int reset();
+  //audio jumps, as on preroll: next hop overlaps nothing, noise is kept
+  int cut();
+  //whole hops of input, a partial one waits for the next call. output
+  //is as long as hops done and owned by ns until next process
+  int process(float* pData_In, int iLen_In, bool bBypass, float*& pData_Out, int& iLen_Out);
+
+public:
+
+  int m_iHop ;
+  int m_iWin ;
+  float m_fFloor ;
+
+  //sqrt hann of two hops, squared it adds up to one over hops
+  float* m_pWin ;
+  //last two hops, newest last
+  float* m_pHist ;
+  //second half of last frame's output
+  float* m_pTail ;
+  float* m_pPend ;
+  int m_iPend ;
+
+  float* m_pFft_In ;
+  fftwf_complex* m_pFft_Out ;
+  float* m_pFft_Back ;
+  fftwf_plan m_hPlan_Fwd ;
+  fftwf_plan m_hPlan_Bwd ;
+
+  //per bin: power of frame, smoothed power, noise, last clean power, gain
+  float* m_pPow ;
+  float* m_pPsd ;
+  float* m_pNoise ;
+  float* m_pClean ;
+  float* m_pGain ;
+  bool m_bNoise ;
+  bool m_bActive ;
+  int m_iSkip ;
+
+  int m_iDataLen_Total ;
+  float* m_pData_Out ;
+
+  //hops run and bypassed
+  long long m_iHop_Active ;
+  long long m_iHop_Bypass ;
+
+private:
+  void analyse();
+  //noise over iHops hops since last update
+  void track(int iHops);
+  void hop(float* pIn, bool bBypass, float* pOut);
+};
+
+#endif /* defined(__r2ad2__r2mem_ns__) */
@@ -9,7 +9,7 @@
 #ifndef __r2ad2__r2mem_rs2__
 #define __r2ad2__r2mem_rs2__
 
-#include "zrsapi.h"
+#include "r2prs.h"
 #include "r2math.h"
 
 
@@ -29,15 +29,16 @@ public:
   int m_iMicNum ;
   r2_mic_info* m_pMicInfo_Rs ;
   
-  r2_rs_htask m_hRs_48_16 ;
+  //iSampleRate to R2_AUDIO_SAMPLE_RATE, mic delay in its filter
+  r2prs* m_pRs ;
   
   float** m_pData_Tmp ;
+  float** m_pData_Tmp_Out ;
 
   int m_iLen_Out_Total ;
   float ** m_pData_Out ;
   
   bool m_bDelay ;
-  r2_rs_htask m_hRs_48_96 ;
   
   
 };
@@ -0,0 +1,61 @@
+//
+//  r2prs.h
+//  r2ad2
+//
+//  polyphase fir resampler, any rational rate, tables built at init
+//
+
+#ifndef __r2ad2__r2prs__
+#define __r2ad2__r2prs__
+
+//zero crossings of sinc on each side, in samples of the lower rate
+#define R2PRS_ZERO_CROSSINGS 24
+//kaiser beta, about 72db stop band
+#define R2PRS_KAISER_BETA 7.0f
+//-6db point of the filter, of the lower nyquist
+#define R2PRS_CUTOFF 0.91f
+
+
+class r2prs
+{
+public:
+  //pDelay: fractional delay of each channel in input samples, NULL for none,
+  //folded into the channel filter instead of a separate interpolation
+  r2prs(int iCn, int iSrIn, int iSrOut, const float* pDelay);
+public:
+  ~r2prs(void);
+
+public:
+  int reset();
+  //output samples of each channel, at most getOutLenMax(iLenIn)
+  int process(const float** pWavIn, int iLenIn, float** pWavOut);
+  int getOutLenMax(int iLenIn);
+  //filter latency in input samples, without channel delay
+  float getLatency();
+
+public:
+
+  int m_iCn ;
+  int m_iL ;
+  int m_iM ;
+  //taps of one phase, multiple of 4
+  int m_iTaps ;
+
+  //one table of m_iL phases for each distinct delay
+  int m_iCoefNum ;
+  float** m_pCoef ;
+  int* m_pCoefId ;
+
+  //m_iTaps - 1 history samples then input of current block
+  int m_iBuffLen ;
+  float** m_pBuff ;
+
+  //next output in m_iL units from first sample of next block
+  int m_iT ;
+
+private:
+  void buildCoef(float* pCoef, float fDelay);
+};
+
+
+#endif /* __r2ad2__r2prs__ */
@@ -22,6 +22,9 @@ typedef int (*start_input_stream_t)(void *token);
 typedef void (*stop_input_stream_t)(void *token);
 typedef int (*read_input_stream_t)(void *token, char *buff, int len);
 typedef void (*on_err_input_stream_t)(void *token);
+/* next 'len' bytes in place of read_input, valid until release_input_frame */
+typedef int (*acquire_input_frame_t)(void *token, char **buff, int len);
+typedef void (*release_input_frame_t)(void *token, int len);
 
 #define VT_TYPE_AWAKE 1
 #define VT_TYPE_SLEEP 2
@@ -58,8 +61,46 @@ typedef struct {
     stop_input_stream_t stop_input;
     read_input_stream_t read_input;
     on_err_input_stream_t on_err_input;
+    /* optional, null to use read_input */
+    acquire_input_frame_t acquire_input_frame;
+    release_input_frame_t release_input_frame;
 } siren_input_if_t;
 
+/* stream format siren reads from siren_input_if_t, from siren config */
+typedef struct {
+    int channels;
+    int sample_rate;
+    /* bytes per sample of one channel */
+    int sample_bytes;
+    /* bytes of every read_input or acquire_input_frame */
+    int frame_bytes;
+} siren_input_format_t;
+
+/* counted since init_siren by supervisor of forked siren */
+typedef struct {
+    int32_t restarts;
+    int32_t crashes;
+    int32_t hangs;
+    int32_t spawn_failures;
+    /* mic frames buffered while siren restarts, and lost when buffer is full */
+    uint64_t gap_frames;
+    uint64_t dropped_frames;
+} siren_supervisor_stats_t;
+
+/* far end delay of aec found by siren, in samples at 16k */
+typedef struct {
+    /* echo behind reference, negative when reference comes after echo */
+    int32_t delay;
+    /* first delay locked on, drift is delay - first_delay */
+    int32_t first_delay;
+    int32_t drift;
+    /* offset put in front of aec, reference held back if > 0, mics if < 0 */
+    int32_t align;
+    /* times delay moved, 0 until first lock */
+    int32_t changes;
+    float confidence;
+} siren_aec_stats_t;
+
 typedef struct {
     int start;
     int end;
@@ -114,7 +155,8 @@ enum {
     SIREN_STATUS_OK = 0,
     SIREN_STATUS_CONFIG_ERROR,
     SIREN_STATUS_CONFIG_NO_FOUND,
-    SIREN_STATUS_ERROR
+    SIREN_STATUS_ERROR,
+    SIREN_STATUS_NEED_RESTART
 };
 
 enum {
@@ -148,6 +190,42 @@ enum {
     SIREN_STATE_SLEEP
 };
 
+/* bit of an event in siren_subscriber_t.events */
+#define SIREN_EVENT_BIT(event) (1u << ((event) - SIREN_EVENT_VAD_START))
+
+enum {
+    /* full queue drops the oldest event held, subscriber keeps up with the latest */
+    SIREN_DROP_OLDEST = 0,
+    /* full queue drops the new event, subscriber gets what it holds without gaps */
+    SIREN_DROP_NEWEST
+};
+
+/*
+ * subscriber of processed events, called on a thread of its own from a
+ * queue of its own, so a slow one drops its own events and never holds
+ * back the others. every subscriber is given the same voice_event and
+ * buff, read only, siren_event_ref keeps them past the callback
+ */
+typedef struct {
+    on_voice_event_t voice_event_callback;
+    void *token;
+    /* SIREN_EVENT_BIT of events taken, 0 for every event */
+    uint32_t events;
+    /* events taken by flag, VOICE_MASK for vad data, VT_MASK, SL_MASK, 0 for any */
+    int flags;
+    /* events held while subscriber is busy, at least 1 */
+    int queue_len;
+    int drop_policy;
+} siren_subscriber_t;
+
+typedef struct {
+    uint64_t delivered;
+    uint64_t dropped;
+    int32_t queued;
+} siren_subscriber_stats_t;
+
+typedef int32_t siren_sub_t;
+
 siren_t init_siren(void *token, const char *path, siren_input_if_t *input);
 siren_t start_siren_process_stream(siren_t siren, siren_proc_callback_t *callback);
 siren_t start_siren_raw_stream(siren_t siren, siren_raw_stream_callback_t *callback);
@@ -170,6 +248,49 @@ int get_vt_word(siren_t siren, siren_vt_word **words);
 void start_siren_monitor(siren_t siren, siren_net_callback_t *callback);
 siren_status_t broadcast_siren_event(siren_t siren, char *data, int len);
 
+siren_status_t get_siren_input_format(siren_t siren, siren_input_format_t *format);
+
+/*
+ * parse config file of init_siren again and apply it between two frames,
+ * SIREN_STATUS_NEED_RESTART if a changed key can not be taken by a running
+ * siren, on any failure siren keeps running with current config
+ */
+siren_status_t reload_siren_config(siren_t siren);
+/* reload_siren_config whenever config file is written */
+siren_status_t watch_siren_config(siren_t siren, bool watch);
+
+/* all zero when siren_supervise is off or siren runs as thread */
+siren_status_t get_siren_supervisor_stats(siren_t siren, siren_supervisor_stats_t *stats);
+/* all zero until delay locks, or when alg_aec or alg_aec_max_delay is off */
+siren_status_t get_siren_aec_stats(siren_t siren, siren_aec_stats_t *stats);
+
+/*
+ * voice_event passed to on_voice_event_t is valid until callback returns,
+ * siren_event_ref keeps it and its buff alive without copy, every ref
+ * must be paired with siren_event_unref from any thread
+ */
+void siren_event_ref(voice_event_t *voice_event);
+void siren_event_unref(voice_event_t *voice_event);
+
+/*
+ * buff passed to on_raw_voice_t is pcm of raw_stream_channel_num channels
+ * interleaved, raw_stream_byte bytes each at raw_stream_sample_rate, valid
+ * until callback returns. siren_raw_ref keeps it alive without copy, every
+ * ref must be paired with siren_raw_unref from any thread
+ */
+void siren_raw_ref(void *buff);
+void siren_raw_unref(void *buff);
+
+/*
+ * processed events to more than one consumer without copy, next to
+ * siren_proc_callback_t of start_siren_process_stream. returns id > 0, or
+ * -1 for a bad subscriber. unsubscribe waits for a running callback,
+ * unless called from that callback
+ */
+siren_sub_t subscribe_siren_event(siren_t siren, const siren_subscriber_t *subscriber);
+void unsubscribe_siren_event(siren_t siren, siren_sub_t sub);
+siren_status_t get_siren_subscriber_stats(siren_t siren, siren_sub_t sub, siren_subscriber_stats_t *stats);
+
 
 #ifdef __cplusplus
 }
@@ -61,6 +61,7 @@ public:
         averageDelay(0) {}
     ~SirenAudioPreProcessor() = default;
     void preprocess(char *rawBuffer, PreprocessVoicePackage **voicePackage);
+    bool getAecStats(siren_aec_stats_t *stats);
     siren_status_t init();
     siren_status_t destroy();
 private:
@@ -99,7 +100,13 @@ public:
 
     void setSysState(int state, bool shouldCallback);
     void setSysSteer(float ho, float ver);
-    void syncVTWord(std::vector<siren_vt_word> &words);
+    /* vt word list in wire format, false if it is malformed */
+    bool syncVTWord(const char *wire, int len);
+    /* CONFIG_RELOAD_LIVE keys of config changed, between frames */
+    void reloadLive();
+    int getSysState() {
+        return r2v_state;
+    }
     siren_status_t init();
     siren_status_t destroy();
 
@@ -1,6 +1,8 @@
 #ifndef SIREN_ALG_LEGACY_HELPER_
 #define SIREN_ALG_LEGACY_HELPER_
 
+#include <mutex>
+
 #include "legacy/r2math.h"
 
 #include "legacy/r2math.h"
@@ -14,10 +16,56 @@
 #include "legacy/r2mem_vad2.h"
 #include "legacy/r2mem_vbv3.h"
 #include "legacy/r2mem_bf.h"
+#include "legacy/r2mem_bfpre.h"
+#include "legacy/r2mem_gate.h"
 #include "legacy/r2mem_cod.h"
+#include "legacy/r2mem_agc.h"
+#include "legacy/r2mem_ns.h"
+
+#include "siren_config_if.h"
 
 namespace BlackSiren {
 
+//r2ssp_ssp_init/exit are process wide, preprocessor and processor
+//init on their own threads
+inline std::mutex &r2sspGlobalMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+//preprocessor, processor and raw stream each hold r2ssp while they
+//run and are rebuilt on reload next to the others, so only the first
+//one inits and the last one exits. call with r2sspGlobalMutex held
+inline int &r2sspUsers() {
+    static int users = 0;
+    return users;
+}
+
+inline void r2sspAcquire() {
+    if (r2sspUsers()++ == 0) {
+        r2ssp_ssp_init();
+    }
+}
+
+inline void r2sspRelease() {
+    if (r2sspUsers() > 0 && --r2sspUsers() == 0) {
+        r2ssp_ssp_exit();
+    }
+}
+
+//agc of upload path and raw stream share alg_agc_* keys
+inline r2agc_param agcParam(const AlgConfig &alg) {
+    r2agc_param param;
+    param.fTargetDb = alg.alg_agc_target_db;
+    param.fMaxGainDb = alg.alg_agc_max_gain_db;
+    param.fMinGainDb = alg.alg_agc_min_gain_db;
+    param.fLimitDb = alg.alg_agc_limit_db;
+    param.fAttackMs = alg.alg_agc_attack_ms;
+    param.fReleaseMs = alg.alg_agc_release_ms;
+    param.fGateDb = alg.alg_agc_gate_db;
+    return param;
+}
+
 struct PreprocessorMicInfoAdapter {
     r2_mic_info *m_pMicInfo_in;
     r2_mic_info *m_pMicInfo_rs;
@@ -52,8 +100,12 @@ struct ProcessorUnitAdapter {
     r2mem_i *m_pMem_in = nullptr;
     r2mem_vbv3* m_pMem_vbv3 = nullptr;
     r2mem_bf* m_pMmem_bf = nullptr;
+    r2mem_bfpre* m_pMem_bfpre = nullptr;
     r2mem_cod *m_pMem_cod = nullptr;
     r2mem_vad2 *m_pMem_vad2 = nullptr;
+    r2mem_gate *m_pMem_gate = nullptr;
+    r2mem_agc *m_pMem_agc = nullptr;
+    r2mem_ns *m_pMem_ns = nullptr;
 };
 
 }
@@ -8,6 +8,7 @@
 #include <condition_variable>
 #include <functional>
 #include <fstream>
+#include <memory>
 
 #include "lfqueue.h"
 #include "siren_channel.h"
@@ -15,9 +16,13 @@
 #include "sutils.h"
 #include "siren.h"
 #include "isiren.h"
+#include "siren_alg.h"
+#include "siren_config_schema.h"
+#include "siren_raw_stream.h"
 
 namespace BlackSiren {
 
+struct SirenReloadTicket;
 
 //will work as Recording thread after fork
 class SirenBase : public ISiren {
@@ -54,9 +59,23 @@ private:
     std::thread processThread;
     void launchProcessThread();
     void waitingProcessInit();
+    bool initPreprocessor();
     void loopRecording();
+
+    //config reload, decoded on response thread, applied on recording
+    //thread between frames, processor part handed to process thread
+    void reloadConfig(Message *message);
+    bool prepareProcessor(std::unique_ptr<SirenConfig> &next, uint32_t seq);
+    void finishPrepare();
+    void applyConfig(const SirenConfig &next, uint32_t seq);
+    bool reloadPreprocessor(const SirenConfig &next, const SirenConfigChange &change);
+    bool reloadProcessor(const SirenConfig &next, const SirenConfigChange &change);
+    bool applyProcessorConfig(SirenReloadTicket &ticket);
+    void responseConfigReloaded(bool ok, uint32_t seq);
+    void responseAecStats(const siren_aec_stats_t &stats);
         
     bool processInitFailed;
+    bool preprocessInitFailed = false;
 
 
     std::mutex initMutex;
@@ -78,7 +97,36 @@ private:
 
     std::mutex recordingMutex;
     std::condition_variable recordingCond;
+    //either stream started
     bool recordingStart;
+    std::atomic_bool processStart;
+    bool rawStart = false;
+    //guarded by recordingMutex
+    std::unique_ptr<SirenConfig> pendingConfig;
+    uint32_t pendingReloadSeq = 0;
+    bool preparing = false;
+    bool prepareDone = false;
+
+    //processor of a reload built on its own thread while recording
+    //thread keeps reading frames, process thread only swaps it in
+    std::thread prepareThread;
+    std::unique_ptr<SirenConfig> preparedConfig;
+    uint32_t preparedSeq = 0;
+    //null if its init failed, set under recordingMutex
+    std::unique_ptr<SirenAudioVBVProcessor> preparedProcessor;
+
+    //recording thread stage, with the config it runs
+    std::unique_ptr<SirenConfig> recordConfig;
+    std::unique_ptr<SirenAudioPreProcessor> preProcessor;
+    //taps preprocessed frames on recording thread, null if init failed
+    std::unique_ptr<SirenRawStream> rawStream;
+
+    //process thread stage, with the config it runs
+    std::unique_ptr<SirenConfig> processConfig;
+    std::unique_ptr<SirenAudioVBVProcessor> audioProcessor;
+    //vt word list in wire format, as last synced
+    std::string syncedWords;
+    bool hasSyncedWords = false;
 
     LFQueue processQueue;
     LFQueue recordingQueue;
@@ -24,25 +24,6 @@ enum {
     SIREN_CHANNEL_ERROR,
 };
 
-struct UnpackedVTConfig {
-    float vt_block_avg_score;
-    float vt_block_min_score;
-    float vt_classify_shield;
-
-    bool vt_left_sil_det;
-    bool vt_right_sil_det;
-    bool vt_remote_check_with_aec;
-    bool vt_remote_check_without_aec;
-    bool vt_local_classify_check;
-
-    int total_len;
-    int vt_type;
-    int vt_word_size;
-    int vt_phone_size;
-    int vt_nnet_path_size;
-}  __attribute__((packed));
-
-
 struct Message {
     Message () {
         magic[0] = 'a';
@@ -81,6 +62,7 @@ struct InterstedResponse {
 };
 
 class SirenSocketChannel;
+struct SirenEventBlock;
 class SirenSocketReader {
 public:
     SirenSocketReader(SirenSocketChannel *channel_) :
@@ -89,9 +71,15 @@ public:
 
     void prepareOnReadSideProcess();
     int pollMessage(Message **msg);
+    // read message into a pooled event block, released by
+    // SirenEventPool::unref instead of delete
+    int pollMessage(SirenEventBlock **block);
 private:
+    int pollHeader(Message &temp);
+    void readData(Message *rmsg);
+
     bool isPrepareOnReadSide = false;
-    int socket;
+    int socket = -1;
     int epollFD;
     SirenSocketChannel *channel;
 };
@@ -104,10 +92,12 @@ public:
 
     void prepareOnWriteSideProcess();
     int writeMessage(Message *message);
+    // write header and data from separate buffers
+    int writeMessage(int msg, const char *data, int len);
 private:
     std::mutex writeGuard;
     bool isPrepareOnWriteSide = false;
-    int socket;
+    int socket = -1;
     SirenSocketChannel *channel;
 };
 
@@ -117,6 +107,11 @@ public:
     ~SirenSocketChannel();
 
     bool open();
+    // both ends, only for a channel no reader or writer was prepared on
+    void close();
+    // own copy of both ends for siren base in a thread, as fork gives
+    // to a child, so closing one side leaves the other side open
+    bool duplicate(SirenSocketChannel &to);
 
     friend class SirenSocketReader;
     friend class SirenSocketWriter;
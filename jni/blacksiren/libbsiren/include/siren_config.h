@@ -8,6 +8,10 @@
 #include "siren_config_if.h"
 namespace BlackSiren {
 
+#define CONFIG_SNAPSHOT_FILE "blacksiren_config.snapshot"
+
+struct SirenConfigSource;
+
 class SirenConfigurationManager {
 public:
     SirenConfigurationManager(const char *file) {
@@ -17,6 +21,9 @@ public:
             config_file_path = file;
             validPath = true;
         }    
+#ifdef CONFIG_STORE_FILE_PATH
+        snapshot_path = CONFIG_STORE_FILE_PATH CONFIG_SNAPSHOT_FILE;
+#endif
     }
     ~SirenConfigurationManager() {}
     config_error_t parseConfigFile();
@@ -27,9 +34,24 @@ public:
 
     config_error_t loadConfigFromJSON(std::string &, SirenConfig &);
 
+    /* parse config file again into config, current config is not touched */
+    config_error_t reloadConfigFile(SirenConfig &config);
+    /* file reloadConfigFile reads */
+    std::string getConfigPath();
+
+    /* parsed config is kept here for next start, empty path to not use it */
+    void setSnapshotPath(const std::string &path) {
+        snapshot_path = path;
+    }
+
 private:
+    config_error_t loadConfigFile(const char *path);
+    bool loadSnapshot(const SirenConfigSource &source);
+    void saveSnapshot(const SirenConfigSource &source);
+
     bool validPath;
     std::string config_file_path;
+    std::string snapshot_path;
     SirenConfig siren_config;
 };
 
@@ -19,6 +19,9 @@ struct MicPos {
 #define IPC_BINDER "binder"
 #define IPC_SHARE_MEM "share_mem"
 
+#define PROCESS_MODE_FORK "fork"
+#define PROCESS_MODE_THREAD "thread"
+
 #define KEY_BASIC_CONFIG "basic_config"
 #define KEY_ALG_CONFIG "alg_config"
 #define KEY_DEBUG_CONFIG "debug_config"
@@ -32,6 +35,10 @@ struct MicPos {
 #define KEY_SIREN_IPC "siren_ipc"
 #define KEY_SIREN_CHANNEL_RMEM "siren_channel_rmem"
 #define KEY_SIREN_CHANNEL_WMEM "siren_channel_wmem"
+#define KEY_SIREN_PROCESS_MODE "siren_process_mode"
+#define KEY_SIREN_SUPERVISE "siren_supervise"
+#define KEY_SIREN_HEARTBEAT_TIMEOUT "siren_heartbeat_timeout"
+#define KEY_SIREN_GAP_BUFFER "siren_gap_buffer"
 
 #define KEY_SIREN_INPUT_ERR_RETRY_NUM "siren_input_err_retry_num"
 #define KEY_SIREN_INPUT_ERR_RETRY_TIMEOUT "siren_input_err_retry_timeout"
@@ -48,7 +55,25 @@ struct MicPos {
 #define KEY_ALG_AEC_SHIELD "alg_aec_shield"
 #define KEY_ALG_AEC_AFF_CPUS "alg_aec_aff_cpus"
 #define KEY_ALG_AEC_MAT_AFF_CPUS "alg_aec_mat_aff_cpus"
+#define KEY_ALG_AEC_MAX_DELAY "alg_aec_max_delay"
 #define KEY_ALG_BF_SCALING "alg_bf_scaling"
+#define KEY_ALG_BF_PREROLL_MS "alg_bf_preroll_ms"
+#define KEY_ALG_BF_PREROLL_DIRS "alg_bf_preroll_dirs"
+#define KEY_ALG_VT_GATE "alg_vt_gate"
+#define KEY_ALG_VT_GATE_ONSET_DB "alg_vt_gate_onset_db"
+#define KEY_ALG_VT_GATE_HANGOVER_MS "alg_vt_gate_hangover_ms"
+#define KEY_ALG_VT_GATE_LOOKBACK_MS "alg_vt_gate_lookback_ms"
+#define KEY_ALG_AGC "alg_agc"
+#define KEY_ALG_AGC_TARGET_DB "alg_agc_target_db"
+#define KEY_ALG_AGC_MAX_GAIN_DB "alg_agc_max_gain_db"
+#define KEY_ALG_AGC_MIN_GAIN_DB "alg_agc_min_gain_db"
+#define KEY_ALG_AGC_LIMIT_DB "alg_agc_limit_db"
+#define KEY_ALG_AGC_ATTACK_MS "alg_agc_attack_ms"
+#define KEY_ALG_AGC_RELEASE_MS "alg_agc_release_ms"
+#define KEY_ALG_AGC_GATE_DB "alg_agc_gate_db"
+#define KEY_ALG_NS "alg_ns"
+#define KEY_ALG_NS_SLEEP "alg_ns_sleep"
+#define KEY_ALG_NS_FLOOR_DB "alg_ns_floor_db"
 
 #define KEY_ALG_RAW_STREAM_SL_DIRECTION "alg_raw_stream_sl_direction"
 #define KEY_ALG_RAW_STREAM_BF "alg_raw_stream_bf"
@@ -106,17 +131,17 @@ struct MicPos {
 
 
 struct DefVTConfig {
-    int vt_type;
+    int vt_type = 4;
     std::string vt_word;
     std::string vt_phone;
-    float vt_avg_score;
-    float vt_min_score;
-    bool vt_left_sil_det;
-    bool vt_right_sil_det;
-    bool vt_remote_check_with_aec;
-    bool vt_remote_check_without_aec;
-    bool vt_local_classify_check;
-    float vt_classify_shield;
+    float vt_avg_score = 0.0f;
+    float vt_min_score = 0.0f;
+    bool vt_left_sil_det = false;
+    bool vt_right_sil_det = false;
+    bool vt_remote_check_with_aec = false;
+    bool vt_remote_check_without_aec = false;
+    bool vt_local_classify_check = false;
+    float vt_classify_shield = 0.0f;
     std::string vt_nnet_path;
 };
 
@@ -138,7 +163,12 @@ struct AlgConfig {
     std::string alg_vt_dnnmod;
     std::vector<DefVTConfig> def_vt_configs;
 
-    int alg_lan;
+    int alg_lan = 0;
+    int alg_aec_max_delay = 200;
+    int alg_bf_preroll_ms = 2500;
+    int alg_bf_preroll_dirs = 0;
+    int alg_vt_gate_hangover_ms = 2000;
+    int alg_vt_gate_lookback_ms = 600;
    
     float alg_aec_shield = 200.0f;
     float alg_raw_stream_sl_direction = 180.0f;
@@ -147,16 +177,29 @@ struct AlgConfig {
     float alg_vad_dynrange_min = 3.5f;
     float alg_vad_dynrange_max = 6.0f;
     float alg_bf_scaling = 1.0f;
+    float alg_vt_gate_onset_db = 9.0f;
+    float alg_agc_target_db = -18.0f;
+    float alg_agc_max_gain_db = 24.0f;
+    float alg_agc_min_gain_db = -12.0f;
+    float alg_agc_limit_db = -1.0f;
+    float alg_agc_attack_ms = 10.0f;
+    float alg_agc_release_ms = 300.0f;
+    float alg_agc_gate_db = 10.0f;
+    float alg_ns_floor_db = -12.0f;
 
     bool alg_use_legacy_ssp_config_file = true;
     bool alg_aec = true;
-    bool alg_rs_delay_on_left_right_channel;
+    bool alg_rs_delay_on_left_right_channel = false;
     bool alg_raw_stream_bf = true;
     bool alg_raw_stream_agc = true;
     bool alg_rs_enable = true;
     bool alg_vt_enable = true;
     bool alg_vad_enable = true;
     bool alg_opus_compress = false;
+    bool alg_vt_gate = false;
+    bool alg_agc = true;
+    bool alg_ns = false;
+    bool alg_ns_sleep = false;
     bool alg_use_legacy_vt_config_file = true;
 };
 
@@ -187,14 +230,22 @@ struct SirenConfig {
     int mic_audio_byte = 4;
     int mic_frame_length = 10;
 
+    int siren_ipc = 0;
+    /* siren_ipc is not channel */
     bool siren_use_share_mem = false;
     unsigned long siren_recording_socket_wmem = 4 * 1024 * 1024;
     unsigned long siren_recording_socket_rmem = 6 * 1024 * 1024;
+    /* siren base in forked process or in thread of caller */
+    int siren_process_mode = 0;
+    /* respawn forked siren base when it dies or hangs, in ms */
+    bool siren_supervise = true;
+    int siren_heartbeat_timeout = 2000;
+    int siren_gap_buffer = 2000;
     
     int siren_input_err_retry_num = 5;
     int siren_input_err_retry_timeout = 100;
 
-    int udp_port;
+    int udp_port = 0;
 
     struct AlgConfig alg_config;
     struct RawStreamConfig raw_stream_config;
@@ -214,6 +265,18 @@ enum {
     CONFIG_LAN_EN,
 };
 
+enum {
+    CONFIG_IPC_CHANNEL = 0,
+    CONFIG_IPC_DBUS,
+    CONFIG_IPC_BINDER,
+    CONFIG_IPC_SHARE_MEM,
+};
+
+enum {
+    CONFIG_PROCESS_FORK = 0,
+    CONFIG_PROCESS_THREAD,
+};
+
 }
 
 #endif
@@ -0,0 +1,116 @@
+#ifndef SIREN_CONFIG_SCHEMA_H_
+#define SIREN_CONFIG_SCHEMA_H_
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include "siren_config_if.h"
+
+namespace BlackSiren {
+
+enum {
+    CONFIG_TYPE_BOOL = 0,
+    CONFIG_TYPE_INT,
+    /* unsigned long */
+    CONFIG_TYPE_SIZE,
+    CONFIG_TYPE_FLOAT,
+    /* string one of names, stored as index */
+    CONFIG_TYPE_ENUM,
+    CONFIG_TYPE_STRING,
+    CONFIG_TYPE_INT_ARRAY,
+    CONFIG_TYPE_DOUBLE_ARRAY,
+    /* array of MicPos */
+    CONFIG_TYPE_POS_ARRAY,
+    /* array of DefVTConfig objects */
+    CONFIG_TYPE_VT_ARRAY,
+};
+
+/* what a running siren has to do to take a changed key, bits */
+enum {
+    /* fork and init siren again */
+    CONFIG_RELOAD_PROCESS = 0,
+    /* build SirenAudioPreProcessor again */
+    CONFIG_RELOAD_PREPROCESSOR = 1 << 0,
+    /* build SirenAudioVBVProcessor again */
+    CONFIG_RELOAD_PROCESSOR = 1 << 1,
+    /* read by SirenAudioVBVProcessor every frame */
+    CONFIG_RELOAD_LIVE = 1 << 2,
+};
+
+/*
+ * one config key: where it is, what it holds and where it goes.
+ * min/max bound numbers and array elements, optional keys take
+ * def/def_str when absent, arrays default to empty.
+ */
+struct SirenConfigKey {
+    const char *section;
+    const char *key;
+    int type;
+    bool required;
+    double min;
+    double max;
+    double def;
+    const char *def_str;
+    const char * const *names;
+    /* address of the field in SirenConfig, or DefVTConfig for vt keys */
+    void *(*field)(void *config);
+    /* CONFIG_RELOAD_ bits */
+    int reload;
+};
+
+const std::vector<SirenConfigKey> &siren_config_keys();
+const std::vector<SirenConfigKey> &siren_vt_config_keys();
+
+struct SirenConfigReport {
+    /* any error fails the parse */
+    std::vector<std::string> errors;
+    /* unknown keys */
+    std::vector<std::string> warnings;
+};
+
+/*
+ * check and load json in one pass over the document, every problem is
+ * added to report instead of stopping at the first one
+ */
+config_error_t parse_siren_config(const char *json, size_t len, SirenConfig &config,
+                                  SirenConfigReport &report);
+
+/* file a snapshot was made from, snapshot is stale if it changes */
+struct SirenConfigSource {
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+};
+
+#define SIREN_CONFIG_SNAPSHOT_VERSION 1
+
+/* binary image of parsed config, loaded without json-c or validation */
+void encode_siren_config_snapshot(const SirenConfig &config, const SirenConfigSource &source,
+                                  std::string &snapshot);
+
+/* false if snapshot is corrupt, of other version or schema, or source changed */
+bool decode_siren_config_snapshot(const char *data, size_t len, const SirenConfigSource &source,
+                                  SirenConfig &config);
+
+/* fields that follow from others, after parse or decode */
+void finish_siren_config(SirenConfig &config);
+
+void dump_siren_config(const SirenConfig &config);
+
+struct SirenConfigChange {
+    /* CONFIG_RELOAD_ bits of changed keys */
+    int reload = 0;
+    /* a changed key is CONFIG_RELOAD_PROCESS */
+    bool restart = false;
+    /* section.key of every changed key */
+    std::vector<std::string> keys;
+};
+
+void diff_siren_config(const SirenConfig &from, const SirenConfig &to, SirenConfigChange &change);
+
+}
+
+#endif
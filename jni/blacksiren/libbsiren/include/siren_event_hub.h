@@ -0,0 +1,52 @@
+#ifndef SIREN_EVENT_HUB_H_
+#define SIREN_EVENT_HUB_H_
+
+#include <stdint.h>
+#include <mutex>
+#include <memory>
+#include <vector>
+
+#include "siren.h"
+#include "siren_event_pool.h"
+
+namespace BlackSiren {
+
+// fan out of event blocks to subscribers. publisher refs the one block
+// once for every subscriber taking it, each subscriber thread unrefs it
+// after callback, so payload is never copied and a full subscriber queue
+// drops by its own policy instead of waiting
+class SirenEventHub {
+public:
+    SirenEventHub() :
+        subscribers(std::make_shared<SubscriberList>()) {}
+    ~SirenEventHub() {
+        clear();
+    }
+
+    SirenEventHub(const SirenEventHub &) = delete;
+    SirenEventHub &operator=(const SirenEventHub &) = delete;
+
+    siren_sub_t subscribe(const siren_subscriber_t &subscriber);
+    bool unsubscribe(siren_sub_t id);
+    bool getStats(siren_sub_t id, siren_subscriber_stats_t &stats);
+    // unsubscribe all
+    void clear();
+
+    // from proxy response thread, block is read only after this
+    void publish(SirenEventBlock *block);
+
+private:
+    struct Subscriber;
+    typedef std::vector<std::shared_ptr<Subscriber>> SubscriberList;
+
+    std::shared_ptr<const SubscriberList> snapshot();
+
+    // copied on change, publish walks the list it took without lock
+    std::mutex listMutex;
+    std::shared_ptr<const SubscriberList> subscribers;
+    siren_sub_t nextId = 1;
+};
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef SIREN_EVENT_POOL_H_
+#define SIREN_EVENT_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "siren.h"
+
+namespace BlackSiren {
+
+struct Message;
+class SirenEventPool;
+
+// one response message read from channel and the voice event built on it,
+// voice_event.buff points into message data so nothing is copied after
+// socket read. shared by proxy response thread and callback user through
+// siren_event_ref/siren_event_unref
+struct SirenEventBlock {
+    std::atomic<int> refs;
+    int capacity;
+    int sizeClass;
+    SirenEventPool *pool;
+    voice_event_t event;
+
+    Message *message() {
+        return (Message *)((char *)this + sizeof(SirenEventBlock));
+    }
+
+    static SirenEventBlock *fromEvent(voice_event_t *event) {
+        return (SirenEventBlock *)((char *)event - offsetof(SirenEventBlock, event));
+    }
+
+    // from message data, as raw voice is given to callback
+    static SirenEventBlock *fromData(void *data);
+};
+
+struct SirenEventPoolStat {
+    // blocks allocated from heap
+    uint64_t allocated;
+    // blocks taken from free list
+    uint64_t reused;
+    // blocks in use
+    uint32_t outstanding;
+    // blocks kept in free list
+    uint32_t cached;
+};
+
+// free lists of event blocks by power of two size, process wide because
+// blocks may outlive the proxy which received them
+class SirenEventPool {
+public:
+    static SirenEventPool &instance();
+
+    // block with refs = 1 holding a message of 'len' data bytes
+    SirenEventBlock *obtain(int msg, int len);
+
+    void ref(SirenEventBlock *block) {
+        block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void unref(SirenEventBlock *block);
+
+    void getStat(SirenEventPoolStat &stat);
+
+    // free cached blocks
+    void trim();
+
+private:
+    SirenEventPool();
+    ~SirenEventPool();
+
+    enum {
+        MIN_SIZE_SHIFT = 9,
+        SIZE_CLASSES = 12,
+        MAX_CACHED_PER_CLASS = 16,
+    };
+
+    std::mutex poolMutex;
+    std::vector<SirenEventBlock *> freeList[SIZE_CLASSES];
+    uint64_t allocated;
+    uint64_t reused;
+    uint32_t outstanding;
+    uint32_t cached;
+};
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef SIREN_PREPROCESSOR_H_
 #define SIREN_PREPROCESSOR_H_
 
+#include "siren.h"
 #include "siren_config.h"
 #include "common.h"
 #include "siren_alg_legacy_helper.h"
@@ -60,6 +61,8 @@ public:
     int processData(char *pDataIn, int lenIn);
     int getResultLen();
     void getResult(char *pDataOut, int lenOut);
+    /* true once after far end delay of aec moved */
+    bool getAecStats(siren_aec_stats_t *stats);
 private:
     int processData(char *pDataIn, int lenIn, char *& pData_out, int &lenOut);
     SirenConfig &config;
@@ -79,6 +82,8 @@ private:
 
     bool firstFrm = true;
     bool doAEC = true;
+    /* r2ssp reference taken by init, init may fail before it */
+    bool r2sspHeld = false;
 };
 
 }
@@ -56,12 +56,18 @@ public:
     void setSLSteer(float ho, float ver);
     void getMsgs(r2ad_msg_block** &pMsgLst, int &iMsgNum);
     void reset();
-    void syncVTWord(std::vector<siren_vt_word> &words);
+    /* words of wire list after default ones, false and nothing changed if malformed */
+    bool syncVTWord(const char *wire, int len);
     int getVTInfo(std::string &vt_word, int &start, int &end, float &vt_energy);
     void setState(r2v_sys_state state);
 
+    /* open or close debug recordings after debug_config changed */
+    void reloadRecording();
+
     float getLastFrameEnergy();
     float getLastFrameThreshold();
+    /* part of audio vt gate only kept and its onsets, false without gate */
+    bool getGateStats(float &closed, int &onsets);
 
     class ProcessState {
     public:
@@ -106,7 +112,10 @@ private:
     void addMsg(r2ad_msg msgid, const char *sl);
     void addMsg(r2ad_msg msgid, r2mem_cod *cod);
     void clearMsgLst();
+    void reloadRecording(bool enable, bool &recording, std::ofstream &stream, const std::string &path);
     void resetASR();
+    /* bf and vbv over audio the gate kept, returns what vbv gave */
+    int catchUpGate(bool aec, bool awake, bool sleep, bool hotword);
 
 
 
@@ -116,6 +125,8 @@ private:
     ProcessState state;
     TinyAllocator allocator;
     float slinfo[3];
+    /* r2ssp reference taken by init, init may fail before it */
+    bool r2sspHeld = false;
 
     bool bf_record;
     bool bf_raw_record;
@@ -11,6 +11,8 @@
 #include <vector>
 #include <iterator>
 #include <fstream>
+#include <atomic>
+#include <memory>
 
 #include "siren_config.h"
 #include "siren_channel.h"
@@ -19,6 +21,8 @@
 #include "sutils.h"
 #include "lfqueue.h"
 #include "siren_alg.h"
+#include "siren_supervisor.h"
+#include "siren_event_hub.h"
 
 namespace BlackSiren {
 
@@ -32,6 +36,8 @@ public:
     bool start();
     void stop();
     void pause();
+    //new socketpair for a respawned siren base
+    bool reopen();
 
     int getReader() {
         close (sockets[0]);
@@ -40,9 +46,15 @@ public:
 
     int getWriter() {
         close (sockets[1]);
+        sockets[1] = -1;
         return sockets[0];
     }
 
+    //siren base in thread, both ends stay open in this process
+    int dupReader() {
+        return dup(sockets[1]);
+    }
+
     bool isRecordingStart() {
         return recordingStart;
     }
@@ -57,6 +69,12 @@ public:
 
     void recordingFn();
 private:
+    //read_input to frameBuffer or acquire_input_frame in place
+    int readFrame(char **frame);
+    void releaseFrame(char *frame);
+    void sendFrame(const char *frame);
+    void keepFrame(SirenSupervisor *supervisor, const char *frame);
+
     std::mutex startMutex;
     std::mutex termMutex;
     std::condition_variable startCond;
@@ -73,6 +91,9 @@ private:
 
     int frameSize;
     int sockets[2];
+    //sockets and gap, swapped on respawn
+    std::mutex socketMutex;
+    SirenFrameGap gap;
 
     bool doMicRecording;
     std::string micRecording;
@@ -100,7 +121,7 @@ public:
         requestQueue(32, nullptr),
         udpRecvStart(false)
     {
-
+        memset(&aecStats, 0, sizeof(aecStats));
     }
     virtual ~SirenProxy() {}
 
@@ -140,6 +161,23 @@ public:
 
     void start_siren_monitor(siren_net_callback_t *callback);
     siren_status_t broadcast_siren_event(char *data, int len); 
+    siren_status_t get_input_format(siren_input_format_t *format);
+
+    siren_status_t reload_config();
+    siren_status_t watch_config(bool watch);
+
+    void get_supervisor_stats(siren_supervisor_stats_t *stats);
+    void get_aec_stats(siren_aec_stats_t *stats);
+
+    siren_sub_t subscribe_event(const siren_subscriber_t *subscriber) {
+        return eventHub.subscribe(*subscriber);
+    }
+    void unsubscribe_event(siren_sub_t sub) {
+        eventHub.unsubscribe(sub);
+    }
+    bool get_subscriber_stats(siren_sub_t sub, siren_subscriber_stats_t *stats) {
+        return eventHub.getStats(sub, *stats);
+    }
 private:
     std::function<void(void*, int)> stateChangeCallback; 
     void *token;
@@ -179,16 +217,29 @@ private:
     SirenConfigurationManager *global_config;
     siren_input_if_t *input_callback;
     siren_proc_callback_t *proc_callback;
+    siren_raw_stream_callback_t *raw_callback = nullptr;
+    //processed events to subscribers besides proc_callback
+    SirenEventHub eventHub;
     siren_net_callback_t *net_callback;
 
     bool realStreamStart;
     bool procStreamStart;
+    bool rawStreamStart = false;
     bool recordStreamStart;
+    //input runs while either stream is started
+    bool startInput();
+    void pauseInput();
 
     RecordingThread *recordingThread;
     SirenSocketChannel requestChannel;
     SirenSocketChannel responseChannel;
 
+    //CONFIG_PROCESS_THREAD
+    bool sirenInThread = false;
+    SirenSocketChannel baseRequestChannel;
+    SirenSocketChannel baseResponseChannel;
+    std::thread sirenThread;
+
     LFQueue requestQueue;  
     int siren_pid;
     siren_state_t prevState; 
@@ -200,9 +251,45 @@ private:
     SirenUDPAgent udpAgent;
 
     //vt
+    std::mutex vtMutex;
     std::vector<siren_vt_word> vt_words;
+    bool vtSynced = false;
     siren_vt_word *stored_words = nullptr;
     SirenPhonemeGen phonemeGen;
+
+    //config reload
+    void watchThreadHandler(std::string dir, std::string name);
+    std::mutex reloadMutex;
+    std::mutex reloadResultMutex;
+    std::condition_variable reloadCond;
+    bool reloadDone = false;
+    bool reloadResult = false;
+    //reloads are numbered, a reply names the one it answers
+    uint32_t reloadSeq = 0;
+    //reload timed out, siren may run a config proxy does not know yet
+    bool reloadLost = false;
+    uint32_t lostReloadSeq = 0;
+    SirenConfig lostReloadConfig;
+    std::mutex watchMutex;
+    std::thread watchThread;
+    //eventfd waking watch thread to stop
+    int watchStopFd = -1;
+
+    //supervisor of forked siren base
+    bool spawnSiren();
+    void reapSiren();
+    void replaySiren();
+    std::unique_ptr<SirenSupervisor> supervisor;
+    std::mutex replayMutex;
+    bool hasState = false;
+    siren_state_t lastState;
+    bool hasSteer = false;
+    float lastHo;
+    float lastVer;
+
+    //last far end delay reported by siren base
+    std::mutex aecStatsMutex;
+    siren_aec_stats_t aecStats;
 };
 
 
@@ -0,0 +1,84 @@
+#ifndef SIREN_RAW_STREAM_H_
+#define SIREN_RAW_STREAM_H_
+
+#include <stdint.h>
+
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "lfqueue.h"
+#include "siren_channel.h"
+#include "siren_config.h"
+#include "siren_alg.h"
+
+namespace BlackSiren {
+
+struct SirenRawStreamUnits;
+
+/*
+ * raw stream of siren base: every preprocessed frame, or the beam of it
+ * towards alg_raw_stream_sl_direction when alg_raw_stream_bf is set, with
+ * optional agc, resampled and converted to raw_stream_config and sent as
+ * SIREN_RESPONSE_MSG_ON_RAW_VOICE. runs on its own thread below the
+ * process thread, recording thread only copies frames to it and drops
+ * them when it falls behind, so processed stream never waits for it.
+ */
+class SirenRawStream {
+public:
+    SirenRawStream(const SirenConfig &config, SirenSocketWriter &writer);
+    ~SirenRawStream();
+
+    bool init();
+    void destroy();
+
+    void start();
+    void stop();
+    bool isStarted() {
+        return started.load(std::memory_order_acquire);
+    }
+
+    //recording thread, never waits
+    void feed(const PreprocessVoicePackage *voicePackage);
+    //recording thread, taken between two frames
+    void reload(const SirenConfig &next);
+
+    //frames sent and dropped since init
+    uint64_t getSent() {
+        return sent.load(std::memory_order_relaxed);
+    }
+    uint64_t getDropped() {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    //frames waiting for raw thread at most, 320ms of 10ms frames
+    enum {
+        MAX_PENDING = 32,
+    };
+
+    void threadHandler();
+    void processFrame(PreprocessVoicePackage *voicePackage);
+    bool buildUnits(const SirenConfig &next);
+    void freeUnits();
+
+    SirenConfig config;
+    SirenSocketWriter &writer;
+    std::unique_ptr<SirenRawStreamUnits> units;
+
+    LFQueue queue;
+    std::atomic_int pending;
+    std::thread thread;
+
+    std::atomic_bool started;
+    std::atomic<uint64_t> sent;
+    std::atomic<uint64_t> dropped;
+
+    //interleaved output in raw_stream_config format
+    std::vector<char> out;
+};
+
+}
+
+#endif
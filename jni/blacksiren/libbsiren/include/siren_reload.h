@@ -0,0 +1,28 @@
+#ifndef SIREN_RELOAD_H_
+#define SIREN_RELOAD_H_
+
+#include <functional>
+#include <vector>
+
+#include "siren_config_schema.h"
+
+namespace BlackSiren {
+
+/* part of the running pipeline that takes a new config between frames */
+struct SirenReloadStage {
+    const char *name;
+    /* false if the stage can not run with config and kept the old one */
+    std::function<bool(const SirenConfig &config, const SirenConfigChange &change)> reload;
+};
+
+/*
+ * stages in pipeline order take to, if one fails the stages before it go
+ * back to from in reverse order. nothing is tried when a changed key
+ * needs siren restarted.
+ */
+bool apply_siren_config(const std::vector<SirenReloadStage> &stages, const SirenConfig &from,
+                        const SirenConfig &to, SirenConfigChange &change);
+
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef SIREN_SUPERVISOR_H_
+#define SIREN_SUPERVISOR_H_
+
+#include <stdint.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <chrono>
+
+#include "siren.h"
+
+namespace BlackSiren {
+
+struct SirenSupervisorConfig {
+    //heartbeat sent every interval, child lost without reply in timeout
+    int heartbeatInterval = 500;
+    int heartbeatTimeout = 2000;
+    //respawn delay doubles from min to max on every failed start
+    int backoffMin = 100;
+    int backoffMax = 5000;
+    //child alive this long starts backoff from min again
+    int stableTime = 30000;
+};
+
+/*
+ * watch forked siren base, respawn it when it exits or stops answering
+ * heartbeat. child callbacks run on supervisor thread only.
+ */
+class SirenSupervisor {
+public:
+    struct Child {
+        //start child, true once it inits
+        std::function<bool()> spawn;
+        //kill child if still there, wait for it and its channels
+        std::function<void()> reap;
+        //ask child for SIREN_RESPONSE_MSG_ON_HEARTBEAT
+        std::function<void()> heartbeat;
+        //give respawned child the state of the one lost
+        std::function<void()> replay;
+    };
+
+    SirenSupervisor(const SirenSupervisorConfig &config_, const Child &child_) :
+        config(config_),
+        child(child_) {}
+    ~SirenSupervisor() {
+        stop();
+    }
+
+    //child is running
+    void start();
+    void stop();
+
+    //from proxy response thread
+    void onHeartbeat();
+    void onChildLost();
+
+    //frames kept while down and lost since gap was full, from recording thread
+    void onGapFrames(uint64_t kept, uint64_t dropped);
+
+    bool isDown() {
+        return down.load(std::memory_order_acquire);
+    }
+
+    void getStats(siren_supervisor_stats_t *stats);
+
+    //respawn delay after 'failures' starts in a row
+    static int backoff(const SirenSupervisorConfig &config, int failures);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void supervisorFn();
+    //false if stopped while waiting
+    bool waitFor(int ms);
+    void respawn(bool hang);
+
+    SirenSupervisorConfig config;
+    Child child;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool stopping = false;
+    bool lost = false;
+
+    std::atomic_bool down {false};
+    std::atomic<int64_t> lastHeartbeat {0};
+    Clock::time_point spawnTime;
+    int failures = 0;
+
+    std::mutex statsMutex;
+    siren_supervisor_stats_t stats = {};
+};
+
+/* mic frames kept while siren base is down, oldest dropped when full */
+class SirenFrameGap {
+public:
+    void init(int frameSize_, int frames);
+
+    //false if oldest frame was dropped for it
+    bool push(const char *frame);
+    const char *front();
+    void pop();
+
+    bool empty() {
+        return count == 0;
+    }
+
+    int size() {
+        return count;
+    }
+
+private:
+    std::vector<char> buffer;
+    int frameSize = 0;
+    int capacity = 0;
+    int head = 0;
+    int count = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef SIREN_TIMELINE_H_
+#define SIREN_TIMELINE_H_
+
+#include <stdint.h>
+#include <vector>
+
+namespace BlackSiren {
+
+#define SIREN_TIMELINE_MAX_STEPS 64
+
+struct SirenTimelineStep {
+    /* literal, kept by pointer */
+    const char *step;
+    /* since siren_timeline_begin */
+    int64_t us;
+};
+
+/*
+ * startup steps of proxy and siren base on CLOCK_MONOTONIC, begin time
+ * is inherited by forked siren so both sides share one time axis
+ */
+void siren_timeline_begin();
+/* any thread, steps after the first SIREN_TIMELINE_MAX_STEPS are dropped */
+void siren_timeline_mark(const char *step);
+/* steps of this process */
+std::vector<SirenTimelineStep> siren_timeline_steps();
+void siren_timeline_dump(const char *who);
+
+}
+
+#endif
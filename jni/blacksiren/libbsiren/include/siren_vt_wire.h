@@ -0,0 +1,107 @@
+#ifndef SIREN_VT_WIRE_H_
+#define SIREN_VT_WIRE_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "siren.h"
+
+struct WordInfo;
+
+namespace BlackSiren {
+
+// vt word list as sent from proxy to siren:
+//   header: u8 version, u8 reserved, u16 word count
+//   word:   u8 type, u8 flags, f32 avg score, f32 min score, f32 classify
+//           shield, u16 word len, u16 phone len, u16 nnet path len, then
+//           the three strings without '\0'
+// in host order and unaligned, both ends are on one device. strings are
+// kept short enough for WordInfo, so a parsed word always fits it
+
+#define SIREN_VT_WIRE_VERSION 1
+#define SIREN_VT_WIRE_HEADER_SIZE 4
+#define SIREN_VT_WIRE_WORD_SIZE 20
+
+// longest strings WordInfo takes, its arrays less '\0'
+#define SIREN_VT_WIRE_WORD_MAX 255
+#define SIREN_VT_WIRE_PHONE_MAX 25599
+#define SIREN_VT_WIRE_NNET_PATH_MAX 255
+
+enum {
+    SIREN_VT_WIRE_LEFT_SIL_DET = 1 << 0,
+    SIREN_VT_WIRE_RIGHT_SIL_DET = 1 << 1,
+    SIREN_VT_WIRE_REMOTE_CHECK_WITH_AEC = 1 << 2,
+    SIREN_VT_WIRE_REMOTE_CHECK_WITHOUT_AEC = 1 << 3,
+    SIREN_VT_WIRE_LOCAL_CLASSIFY_CHECK = 1 << 4,
+};
+
+// one word of a parsed list, strings point into the list
+struct SirenVTWireWord {
+    int type;
+    int flags;
+    float avg_score;
+    float min_score;
+    float classify_shield;
+
+    const char *word;
+    int word_len;
+    const char *phone;
+    int phone_len;
+    const char *nnet_path;
+    int nnet_path_len;
+};
+
+class SirenVTWireBuilder {
+public:
+    SirenVTWireBuilder(char *buff_, int len_) :
+        buff(buff_),
+        len(len_),
+        used(SIREN_VT_WIRE_HEADER_SIZE) {}
+
+    // bytes of word, -1 if a string is too long for WordInfo
+    static int measure(const siren_vt_word &word);
+    // bytes of whole list, -1 if any word is too long
+    static int measure(const std::vector<siren_vt_word> &words);
+
+    bool add(const siren_vt_word &word);
+    // writes header, returns bytes used or -1 if something did not fit
+    int finish();
+
+private:
+    char *buff;
+    int len;
+    int used;
+    int num = 0;
+    bool failed = false;
+};
+
+class SirenVTWireParser {
+public:
+    SirenVTWireParser(const char *buff_, int len_);
+
+    // words in header, -1 if header is bad
+    int count() const {
+        return num;
+    }
+    // false at end of list or on a malformed word, see failed()
+    bool next(SirenVTWireWord &word);
+    bool failed() const {
+        return bad;
+    }
+
+private:
+    const char *buff;
+    int len;
+    int pos;
+    int num;
+    int parsed = 0;
+    bool bad = false;
+};
+
+void toVTWord(const SirenVTWireWord &wire, siren_vt_word &word);
+// engine boundary, only place a wire word becomes WordInfo
+void toWordInfo(const SirenVTWireWord &wire, WordInfo &info);
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define BLACK_SIREN_UTILS_H
 
 #include <cassert>
+#include <stdint.h>
 
 #include "common.h"
 
@@ -23,9 +24,16 @@ enum {
 
 void set_sig_child_handler();
 void unset_sig_child_handler();
+/* exit status of children reaped by SIGCHLD handler, from a normal thread */
+void log_sig_child_reaped();
 
 
 
+/* logs below this level are removed at compile time */
+#ifndef CONFIG_SIREN_LOG_LEVEL
+#define CONFIG_SIREN_LOG_LEVEL 0
+#endif
+
 #ifdef CONFIG_NO_STDOUT_DEBUG
 #define siren_debug_print_timestamp do{}while(0)
 #define siren_printf(args...) do{}while(0)
@@ -33,11 +41,32 @@ void unset_sig_child_handler();
 #else /* CONFIG_NO_STDOUT_DEBUG */
 
 void siren_debug_print_timestamp(void);
-void siren_printf(int level, const char *fmt, ...)
+
+/*
+ * logs are recorded to per-thread lock-free ring as format string
+ * and raw args, formatted and written by a background thread,
+ * so logging not block the processing thread. fmt must be literal.
+ */
+void siren_log(int level, const char *fmt, ...)
 PRINTF_FORMAT(2, 3);
 
+#define siren_printf(level, fmt, args...)                   \
+    do {                                                    \
+        if ((level) >= CONFIG_SIREN_LOG_LEVEL)              \
+            BlackSiren::siren_log((level), fmt, ##args);    \
+    } while (0)
+
 #endif
 
+/* false: format and write on caller thread, as old siren_printf */
+void siren_log_set_async(bool async);
+
+/* write all recorded logs */
+void siren_log_flush();
+
+/* logs dropped since ring of thread was full */
+uint64_t siren_log_dropped();
+
 
 #ifdef CONFIG_NO_STDOUT_DEBUG
 #define SIREN_ASSERT(a) dp{}while(0)
@@ -49,6 +78,8 @@ PRINTF_FORMAT(2, 3);
                     "SIREN_ASSERT FAILED '" #a "' " \
                     "%s %s:%d\n",   \
                     __FUNCTION__, __FILE__, __LINE__);  \
+            /* write the log before abort */ \
+            BlackSiren::siren_log_flush(); \
             assert(a);               \
         }                           \
     } while (0)
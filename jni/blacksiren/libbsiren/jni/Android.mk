@@ -82,6 +82,11 @@ $(info CONFIG_REMOTE_CONFIG_HOSTNAME)
 L_CFLAGS += -DCONFIG_REMOTE_CONFIG_HOSTNAME=\"$(CONFIG_REMOTE_CONFIG_HOSTNAME)\"
 endif
 
+ifdef CONFIG_ARM_NEON
+$(info CONFIG_ARM_NEON)
+L_ARM_NEON := true
+endif
+
 ifdef CONFIG_USE_AD1
 $(info CONFIG_USE_AD1)
 L_CFLAGS += -DCONFIG_USE_AD1
@@ -92,10 +97,14 @@ LOCAL_SRC_FILES:= $(call all-named-files-under,*.cpp, ../src)
 LOCAL_C_INCLUDES += \
 		$(LOCAL_PATH)/../include \
 		$(LOCAL_PATH)/../prebuilt/support/include \
-		$(LOCAL_PATH)/../../libjsonc/include
+		$(LOCAL_PATH)/../../libjsonc/include \
+		$(LOCAL_PATH)/../../../include
 
 LOCAL_CFLAGS:= $(L_CFLAGS) -Wall -Wextra -std=c++11
 LOCAL_MODULE:= libbsiren
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_ARM_NEON := $(L_ARM_NEON)
+endif
 LOCAL_LDLIBS:= -L$(SYSROOT)/usr/lib -llog
 LOCAL_SHARED_LIBRARIES := libr2ssp libztvad libr2vt 
 LOCAL_STATIC_LIBRARIES += libjsonc_static libopus
@@ -0,0 +1,273 @@
+//
+//  r2aecdelay.cpp
+//  r2ad2
+//
+
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "legacy/r2aecdelay.h"
+
+//log envelope mean tracker, high pass at about 1.6hz of the 500hz envelope
+#define R2AECDELAY_HP 0.98f
+//reference floor rise per envelope point, and activity above floor
+#define R2AECDELAY_FLOOR_RISE 0.0005f
+#define R2AECDELAY_ACTIVE 4.0f
+//playback level tracker, and how far under it pauses are clamped, 26db
+#define R2AECDELAY_LEVEL_RISE 0.002f
+#define R2AECDELAY_RANGE 3.0f
+
+  r2aecdelay::r2aecdelay(int iMicNum, int iRefNum, int iFrmLen, int iMaxDelay){
+
+    m_iMicNum = iMicNum ;
+    m_iRefNum = iRefNum ;
+    m_iFrmLen = iFrmLen ;
+
+    m_iLagMax = iMaxDelay / R2AECDELAY_DECIM ;
+    m_iLagNum = 2 * m_iLagMax + 1 ;
+    m_pSxy = new float[m_iLagNum] ;
+    m_pEnvMic = new float[m_iLagMax + 1] ;
+    m_pEnvRef = new float[m_iLagMax + 1] ;
+
+    //largest offset either way plus the frame being written
+    m_iRingLen = iMaxDelay + R2AECDELAY_MARGIN + m_iFrmLen ;
+    m_pRingMic = new float*[m_iMicNum] ;
+    for (int i = 0 ; i < m_iMicNum ; i ++) {
+      m_pRingMic[i] = new float[m_iRingLen] ;
+    }
+    m_pRingRef = new float*[m_iRefNum] ;
+    for (int i = 0 ; i < m_iRefNum ; i ++) {
+      m_pRingRef[i] = new float[m_iRingLen] ;
+    }
+
+    reset() ;
+  }
+
+  r2aecdelay::~r2aecdelay(void){
+
+    delete [] m_pSxy ;
+    delete [] m_pEnvMic ;
+    delete [] m_pEnvRef ;
+
+    for (int i = 0 ; i < m_iMicNum ; i ++) {
+      delete [] m_pRingMic[i] ;
+    }
+    delete [] m_pRingMic ;
+    for (int i = 0 ; i < m_iRefNum ; i ++) {
+      delete [] m_pRingRef[i] ;
+    }
+    delete [] m_pRingRef ;
+
+  }
+
+  int r2aecdelay::reset(){
+
+    memset(m_pSxy, 0, sizeof(float) * m_iLagNum) ;
+    m_fSxx = 0.0f ;
+    m_fSyy = 0.0f ;
+
+    memset(m_pEnvMic, 0, sizeof(float) * (m_iLagMax + 1)) ;
+    memset(m_pEnvRef, 0, sizeof(float) * (m_iLagMax + 1)) ;
+    m_iEnvPos = 0 ;
+    m_fLastMic = 0.0f ;
+    m_fLastRef = 0.0f ;
+    m_fRefFloor = -1.0f ;
+    m_fRefLevel = 0.0f ;
+    m_iActive = 0 ;
+    m_iSilent = 0 ;
+
+    m_iCand = 0 ;
+    m_iCandFrm = 0 ;
+
+    m_iDelay = 0 ;
+    m_iDelayFirst = 0 ;
+    m_bLocked = 0 ;
+    m_iChanges = 0 ;
+    m_fConfidence = 0.0f ;
+
+    m_iAlign = 0 ;
+    m_iRingPos = 0 ;
+    for (int i = 0 ; i < m_iMicNum ; i ++) {
+      memset(m_pRingMic[i], 0, sizeof(float) * m_iRingLen) ;
+    }
+    for (int i = 0 ; i < m_iRefNum ; i ++) {
+      memset(m_pRingRef[i], 0, sizeof(float) * m_iRingLen) ;
+    }
+
+    return 0 ;
+  }
+
+  void r2aecdelay::estimate(const float* pMic, const float* pRef){
+
+    const float a = 1.0f - 1.0f / R2AECDELAY_WIN ;
+    int iHist = m_iLagMax + 1 ;
+    int bUpdated = 0 ;
+
+    for (int b = 0 ; b + R2AECDELAY_DECIM <= m_iFrmLen ; b += R2AECDELAY_DECIM) {
+      float fMic = 0.0f, fRef = 0.0f ;
+      for (int i = 0 ; i < m_iMicNum ; i ++) {
+        const float* pX = pMic + i * m_iFrmLen + b ;
+        for (int k = 0 ; k < R2AECDELAY_DECIM ; k ++) {
+          fMic += fabsf(pX[k]) ;
+        }
+      }
+      for (int i = 0 ; i < m_iRefNum ; i ++) {
+        const float* pX = pRef + i * m_iFrmLen + b ;
+        for (int k = 0 ; k < R2AECDELAY_DECIM ; k ++) {
+          fRef += fabsf(pX[k]) ;
+        }
+      }
+      fMic /= R2AECDELAY_DECIM * m_iMicNum ;
+      fRef /= R2AECDELAY_DECIM * m_iRefNum ;
+
+      //floor drops at once and rises slowly, playback stands above it
+      if (m_fRefFloor < 0.0f || fRef < m_fRefFloor) {
+        m_fRefFloor = fRef ;
+      } else {
+        m_fRefFloor += (fRef - m_fRefFloor) * R2AECDELAY_FLOOR_RISE ;
+      }
+      int bActive = fRef > m_fRefFloor * R2AECDELAY_ACTIVE && fRef > 0.0f ;
+
+      //level free log envelope, pauses of playback clamped under its
+      //level so they keep the edges but not what is in them
+      float fLogMic = logf(fMic + 1e-6f) ;
+      float fLogRef = logf(fRef + 1e-6f) ;
+      if (bActive) {
+        if (m_iActive == 0) {
+          m_fRefLevel = fLogRef ;
+        }
+        m_fRefLevel += (fLogRef - m_fRefLevel) * R2AECDELAY_LEVEL_RISE ;
+        m_iActive ++ ;
+        m_iSilent = 0 ;
+      } else {
+        m_iSilent ++ ;
+      }
+      if (m_iActive == 0) {
+        continue ;
+      }
+      if (fLogRef < m_fRefLevel - R2AECDELAY_RANGE) {
+        fLogRef = m_fRefLevel - R2AECDELAY_RANGE ;
+      }
+      m_fLastMic = R2AECDELAY_HP * m_fLastMic + (1.0f - R2AECDELAY_HP) * fLogMic ;
+      m_fLastRef = R2AECDELAY_HP * m_fLastRef + (1.0f - R2AECDELAY_HP) * fLogRef ;
+      float x = fLogMic - m_fLastMic ;
+      float y = fLogRef - m_fLastRef ;
+
+      m_iEnvPos = (m_iEnvPos + 1) % iHist ;
+      m_pEnvMic[m_iEnvPos] = x ;
+      m_pEnvRef[m_iEnvPos] = y ;
+
+      //no playback within any lag says nothing about the delay, keep
+      //what is learned through near end talk
+      if (m_iSilent > m_iLagMax) {
+        continue ;
+      }
+      bUpdated = 1 ;
+
+      m_fSxx = a * m_fSxx + x * x ;
+      m_fSyy = a * m_fSyy + y * y ;
+      for (int l = 0 ; l <= m_iLagMax ; l ++) {
+        int p = (m_iEnvPos - l + iHist) % iHist ;
+        //mic now against reference l points ago
+        m_pSxy[m_iLagMax + l] = a * m_pSxy[m_iLagMax + l] + x * m_pEnvRef[p] ;
+        //mic l points ago against reference now
+        if (l > 0) {
+          m_pSxy[m_iLagMax - l] = a * m_pSxy[m_iLagMax - l] + m_pEnvMic[p] * y ;
+        }
+      }
+    }
+
+    if (!bUpdated || m_iActive < R2AECDELAY_WIN / 2) {
+      return ;
+    }
+
+    int iPeak = 0 ;
+    for (int l = 1 ; l < m_iLagNum ; l ++) {
+      if (m_pSxy[l] > m_pSxy[iPeak]) {
+        iPeak = l ;
+      }
+    }
+    m_fConfidence = m_pSxy[iPeak] / sqrtf(m_fSxx * m_fSyy + 1e-20f) ;
+    //a peak on the edge of search is no peak, offset is out of range
+    if (iPeak == 0 || iPeak == m_iLagNum - 1) {
+      m_fConfidence = 0.0f ;
+    }
+    if (m_fConfidence < R2AECDELAY_CONFIDENCE) {
+      m_iCandFrm = 0 ;
+      return ;
+    }
+
+    //parabola through the peak for less than an envelope point
+    float fLag = (float)(iPeak - m_iLagMax) ;
+    float y0 = m_pSxy[iPeak - 1], y1 = m_pSxy[iPeak], y2 = m_pSxy[iPeak + 1] ;
+    float d = y0 - 2.0f * y1 + y2 ;
+    if (d < 0.0f) {
+      fLag += 0.5f * (y0 - y2) / d ;
+    }
+    int iEst = (int)lrintf(fLag * R2AECDELAY_DECIM) ;
+
+    if (m_iCandFrm > 0 && abs(iEst - m_iCand) <= R2AECDELAY_DECIM) {
+      m_iCandFrm ++ ;
+    } else {
+      m_iCandFrm = 1 ;
+    }
+    m_iCand = iEst ;
+  }
+
+  void r2aecdelay::delayFrm(float* pFrm, float* pRing, int iDelay){
+
+    //write frame, then read it back iDelay samples late
+    int w = m_iRingPos ;
+    int n = m_iRingLen - w < m_iFrmLen ? m_iRingLen - w : m_iFrmLen ;
+    memcpy(pRing + w, pFrm, sizeof(float) * n) ;
+    memcpy(pRing, pFrm + n, sizeof(float) * (m_iFrmLen - n)) ;
+
+    if (iDelay == 0) {
+      return ;
+    }
+    int r = (w - iDelay + m_iRingLen) % m_iRingLen ;
+    n = m_iRingLen - r < m_iFrmLen ? m_iRingLen - r : m_iFrmLen ;
+    memcpy(pFrm, pRing + r, sizeof(float) * n) ;
+    memcpy(pFrm + n, pRing, sizeof(float) * (m_iFrmLen - n)) ;
+  }
+
+  int r2aecdelay::process(float* pMic, float* pRef){
+
+    int bChanged = 0 ;
+    if (m_iLagMax > 0 && m_iMicNum > 0 && m_iRefNum > 0) {
+      estimate(pMic, pRef) ;
+    }
+
+    //small moves are left to aec filter, so it does not restart on jitter
+    if (m_iCandFrm >= R2AECDELAY_HOLD && (!m_bLocked || abs(m_iCand - m_iDelay) > R2AECDELAY_DECIM)) {
+      m_iDelay = m_iCand ;
+      if (!m_bLocked) {
+        m_iDelayFirst = m_iDelay ;
+        m_bLocked = 1 ;
+      }
+      m_iChanges ++ ;
+      bChanged = 1 ;
+
+      //echo just behind reference is what aec expects, only pull it back
+      //when it is too late, or push it behind when it comes first
+      int iAlign = 0 ;
+      if (m_iDelay > R2AECDELAY_MARGIN || m_iDelay < 0) {
+        iAlign = m_iDelay - R2AECDELAY_MARGIN ;
+      }
+      int iAlignMax = m_iRingLen - m_iFrmLen ;
+      m_iAlign = iAlign > iAlignMax ? iAlignMax : (iAlign < -iAlignMax ? -iAlignMax : iAlign) ;
+    }
+
+    int iMicDelay = m_iAlign < 0 ? -m_iAlign : 0 ;
+    int iRefDelay = m_iAlign > 0 ? m_iAlign : 0 ;
+    for (int i = 0 ; i < m_iMicNum ; i ++) {
+      delayFrm(pMic + i * m_iFrmLen, m_pRingMic[i], iMicDelay) ;
+    }
+    for (int i = 0 ; i < m_iRefNum ; i ++) {
+      delayFrm(pRef + i * m_iFrmLen, m_pRingRef[i], iRefDelay) ;
+    }
+    m_iRingPos = (m_iRingPos + m_iFrmLen) % m_iRingLen ;
+
+    return bChanged ;
+  }
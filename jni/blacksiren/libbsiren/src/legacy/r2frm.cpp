@@ -0,0 +1,196 @@
+//
+//  r2frm.cpp
+//  r2ad2
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "legacy/r2frm.h"
+
+static int r2frm_gcd(int a, int b){
+  while (b != 0) {
+    int t = a % b ;
+    a = b ;
+    b = t ;
+  }
+  return a ;
+}
+
+  r2frm_plan::r2frm_plan(int iHop){
+
+    m_iHop = iHop ;
+    m_iUnitNum = 0 ;
+  }
+
+  r2frm_plan::~r2frm_plan(void){
+
+  }
+
+  int r2frm_plan::add(const char* pName, int iBlock){
+
+    if (m_iUnitNum == R2FRM_UNIT_MAX || iBlock < 1) {
+      return -1 ;
+    }
+
+    //after k hops a unit has k * hop mod B left over, which runs through
+    //multiples of gcd(hop, B) up to B - gcd(hop, B)
+    m_pName[m_iUnitNum] = pName ;
+    m_iBlock[m_iUnitNum] = iBlock ;
+    m_iLookahead[m_iUnitNum] = iBlock - r2frm_gcd(m_iHop, iBlock) ;
+    return m_iUnitNum ++ ;
+  }
+
+  int r2frm_plan::getLookahead(int iUnit){
+    return iUnit < 0 || iUnit >= m_iUnitNum ? 0 : m_iLookahead[iUnit] ;
+  }
+
+  int r2frm_plan::getLatency(){
+
+    int iLatency = 0 ;
+    for (int i = 0 ; i < m_iUnitNum ; i ++) {
+      iLatency += m_iLookahead[i] ;
+    }
+    return iLatency ;
+  }
+
+  int r2frm_plan::getCommonHop(){
+
+    int iHop = m_iHop ;
+    for (int i = 0 ; i < m_iUnitNum ; i ++) {
+      iHop = iHop / r2frm_gcd(iHop, m_iBlock[i]) * m_iBlock[i] ;
+    }
+    return iHop ;
+  }
+
+  int r2frm_plan::dump(char* pBuf, int iLen){
+
+    int n = snprintf(pBuf, iLen, "hop %d", m_iHop) ;
+    for (int i = 0 ; i < m_iUnitNum && n < iLen ; i ++) {
+      n += snprintf(pBuf + n, iLen - n, ", %s block %d lookahead %d",
+                    m_pName[i], m_iBlock[i], m_iLookahead[i]) ;
+    }
+    if (n < iLen) {
+      n += snprintf(pBuf + n, iLen - n, ", latency %d, common hop %d", getLatency(), getCommonHop()) ;
+    }
+    return n ;
+  }
+
+  r2frm_ring::r2frm_ring(int iCn, int iCap){
+
+    m_iCn = iCn ;
+    m_iCap = iCap ;
+    m_pData = new float*[m_iCn] ;
+    for (int i = 0 ; i < m_iCn ; i ++) {
+      m_pData[i] = new float[m_iCap] ;
+    }
+
+    reset() ;
+  }
+
+  r2frm_ring::~r2frm_ring(void){
+
+    for (int i = 0 ; i < m_iCn ; i ++) {
+      delete [] m_pData[i] ;
+    }
+    delete [] m_pData ;
+
+  }
+
+  int r2frm_ring::reset(){
+
+    m_iHead = 0 ;
+    m_iSize = 0 ;
+    return 0 ;
+  }
+
+  int r2frm_ring::size(){
+    return m_iSize ;
+  }
+
+  int r2frm_ring::space(){
+    return m_iCap - m_iSize ;
+  }
+
+  int r2frm_ring::put(float** pData, const int* pIdLst, int iOffset, int iLen){
+
+    if (iLen > space()) {
+      iLen = space() ;
+    }
+
+    int iTail = (m_iHead + m_iSize) % m_iCap ;
+    int n = m_iCap - iTail < iLen ? m_iCap - iTail : iLen ;
+    for (int i = 0 ; i < m_iCn ; i ++) {
+      const float* pSrc = pData[pIdLst == NULL ? i : pIdLst[i]] + iOffset ;
+      memcpy(m_pData[i] + iTail, pSrc, sizeof(float) * n) ;
+      memcpy(m_pData[i], pSrc + n, sizeof(float) * (iLen - n)) ;
+    }
+    m_iSize += iLen ;
+
+    return iLen ;
+  }
+
+  int r2frm_ring::putZero(int iLen){
+
+    if (iLen > space()) {
+      iLen = space() ;
+    }
+
+    int iTail = (m_iHead + m_iSize) % m_iCap ;
+    int n = m_iCap - iTail < iLen ? m_iCap - iTail : iLen ;
+    for (int i = 0 ; i < m_iCn ; i ++) {
+      memset(m_pData[i] + iTail, 0, sizeof(float) * n) ;
+      memset(m_pData[i], 0, sizeof(float) * (iLen - n)) ;
+    }
+    m_iSize += iLen ;
+
+    return iLen ;
+  }
+
+  int r2frm_ring::peek(float** pData, const int* pIdLst, int iOffset, int iLen){
+
+    if (iLen > m_iSize) {
+      iLen = m_iSize ;
+    }
+
+    int n = m_iCap - m_iHead < iLen ? m_iCap - m_iHead : iLen ;
+    for (int i = 0 ; i < m_iCn ; i ++) {
+      float* pDst = pData[pIdLst == NULL ? i : pIdLst[i]] + iOffset ;
+      memcpy(pDst, m_pData[i] + m_iHead, sizeof(float) * n) ;
+      memcpy(pDst + n, m_pData[i], sizeof(float) * (iLen - n)) ;
+    }
+
+    return iLen ;
+  }
+
+  int r2frm_ring::drop(int iLen){
+
+    if (iLen > m_iSize) {
+      iLen = m_iSize ;
+    }
+    m_iHead = (m_iHead + iLen) % m_iCap ;
+    m_iSize -= iLen ;
+
+    return iLen ;
+  }
+
+  int r2frm_ring::get(float** pData, const int* pIdLst, int iOffset, int iLen){
+    return drop(peek(pData, pIdLst, iOffset, iLen)) ;
+  }
+
+  int r2frm_ring::last(float** pData, const int* pIdLst, int iOffset, int iLen){
+
+    if (iLen > m_iSize) {
+      iLen = m_iSize ;
+    }
+
+    int iStart = (m_iHead + m_iSize - iLen) % m_iCap ;
+    int n = m_iCap - iStart < iLen ? m_iCap - iStart : iLen ;
+    for (int i = 0 ; i < m_iCn ; i ++) {
+      float* pDst = pData[pIdLst == NULL ? i : pIdLst[i]] + iOffset ;
+      memcpy(pDst, m_pData[i] + iStart, sizeof(float) * n) ;
+      memcpy(pDst + n, m_pData[i], sizeof(float) * (iLen - n)) ;
+    }
+
+    return iLen ;
+  }
@@ -1,7 +1,8 @@
 #include "legacy/r2mem_aec.h"
 #include <assert.h>
 
-r2mem_aec::r2mem_aec(int iMicNum, r2_mic_info* pMicInfo_Aec, r2_mic_info* pMicInfo_AecRef, r2_mic_info*  m_pCpuInfo_Aec)
+r2mem_aec::r2mem_aec(int iMicNum, r2_mic_info* pMicInfo_Aec, r2_mic_info* pMicInfo_AecRef, r2_mic_info*  m_pCpuInfo_Aec, int iMaxDelay,
+                     int iHop, int iLookahead)
 {
   m_iMicNum = iMicNum ;
   
@@ -20,16 +21,37 @@ r2mem_aec::r2mem_aec(int iMicNum, r2_mic_info* pMicInfo_Aec, r2_mic_info* pMicIn
   m_pData_Aec_Ref = R2_SAFE_NEW_AR1(m_pData_Aec_Ref,float,m_iFrmLen_Aec * m_pMicInfo_AecRef->iMicNum);
   m_pData_Aec_Out = R2_SAFE_NEW_AR1(m_pData_Aec_Out,float,m_iFrmLen_Aec * m_pMicInfo_Aec->iMicNum);
   
-  //In
-  m_iLen_In = 0 ;
-  m_pData_In = R2_SAFE_NEW_AR2(m_pData_In,float,m_iMicNum,m_iFrmLen_Aec);
+  //Delay
+  m_pDelay = NULL ;
+  if (iMaxDelay > 0) {
+    m_pDelay = R2_SAFE_NEW(m_pDelay, r2aecdelay, m_pMicInfo_Aec->iMicNum, m_pMicInfo_AecRef->iMicNum, m_iFrmLen_Aec, iMaxDelay);
+  }
+  m_bDelayChanged = 0 ;
   
-  //Out
-  m_iFrmLen_Out = R2_AUDIO_SAMPLE_RATE / 1000 * R2_AUDIO_FRAME_MS ;
-  m_iLen_Out = 0 ;
-  m_iLen_Out_Total = R2_AUDIO_SAMPLE_RATE ;
+  m_pData_Aec_Lst = R2_SAFE_NEW_AR1(m_pData_Aec_Lst, float*, m_pMicInfo_Aec->iMicNum + m_pMicInfo_AecRef->iMicNum);
+  m_pData_Aec_Out_Lst = R2_SAFE_NEW_AR1(m_pData_Aec_Out_Lst, float*, m_pMicInfo_Aec->iMicNum);
+  for (int j = 0 ; j < m_pMicInfo_Aec->iMicNum ; j ++) {
+    m_pData_Aec_Lst[j] = m_pData_Aec_In + j * m_iFrmLen_Aec ;
+    m_pData_Aec_Out_Lst[j] = m_pData_Aec_Out + j * m_iFrmLen_Aec ;
+  }
+  for (int j = 0 ; j < m_pMicInfo_AecRef->iMicNum ; j ++) {
+    m_pData_Aec_Lst[m_pMicInfo_Aec->iMicNum + j] = m_pData_Aec_Ref + j * m_iFrmLen_Aec ;
+  }
+  
+  //In
+  m_pRingId_In = R2_SAFE_NEW_AR1(m_pRingId_In, int, m_pMicInfo_Aec->iMicNum + m_pMicInfo_AecRef->iMicNum);
+  memcpy(m_pRingId_In, m_pMicInfo_Aec->pMicIdLst, sizeof(int) * m_pMicInfo_Aec->iMicNum);
+  memcpy(m_pRingId_In + m_pMicInfo_Aec->iMicNum, m_pMicInfo_AecRef->pMicIdLst, sizeof(int) * m_pMicInfo_AecRef->iMicNum);
+  m_pRing_In = R2_SAFE_NEW(m_pRing_In, r2frm_ring, m_pMicInfo_Aec->iMicNum + m_pMicInfo_AecRef->iMicNum, m_iFrmLen_Aec);
+  
+  //Out, what is owed stays under a frame, so lookahead and two frames hold it
+  m_iLookahead = iLookahead ;
+  m_pRing_Out = R2_SAFE_NEW(m_pRing_Out, r2frm_ring, m_pMicInfo_Aec->iMicNum, m_iLookahead + m_iFrmLen_Aec * 2);
+  m_iLen_Out_Total = iHop + m_iLookahead ;
   m_pData_Out = R2_SAFE_NEW_AR2(m_pData_Out,float,m_iMicNum,m_iLen_Out_Total);
   
+  reset();
+  
   m_iRt = 0 ;
   
 }
@@ -38,20 +60,32 @@ r2mem_aec::~r2mem_aec(void)
 {
   
   R2_SAFE_DEL_AR2(m_pData_Out);
-  R2_SAFE_DEL_AR2(m_pData_In);
+  R2_SAFE_DEL(m_pRing_In);
+  R2_SAFE_DEL(m_pRing_Out);
+  R2_SAFE_DEL_AR1(m_pRingId_In);
+  R2_SAFE_DEL_AR1(m_pData_Aec_Lst);
+  R2_SAFE_DEL_AR1(m_pData_Aec_Out_Lst);
   
   R2_SAFE_DEL_AR1(m_pData_Aec_In);
   R2_SAFE_DEL_AR1(m_pData_Aec_Ref);
   R2_SAFE_DEL_AR1(m_pData_Aec_Out);
   
+  R2_SAFE_DEL(m_pDelay);
+  
   r2ssp_aec_free(m_hEngine_Aec);
   
 }
 
 int r2mem_aec::reset(){
   
-  m_iLen_In = 0 ;
-  m_iLen_Out = 0 ;
+  m_pRing_In->reset();
+  m_pRing_Out->reset();
+  m_pRing_Out->putZero(m_iLookahead);
+  m_iOwe = 0 ;
+  
+  if (m_pDelay != NULL) {
+    m_pDelay->reset();
+  }
   
   return 0 ;
 }
@@ -63,51 +97,32 @@ int r2mem_aec::process(float** pData_In, int iLen_In, float**& pData_Out, int& i
   
   m_iRt = 0 ;
   
-  int left = m_iLen_Out % m_iFrmLen_Out ;
-  for (int i = 0; i < m_pMicInfo_Aec->iMicNum ; i ++) {
-    int iMicId = m_pMicInfo_Aec->pMicIdLst[i];
-    memcpy(m_pData_Out[iMicId], m_pData_Out[iMicId] + m_iLen_Out - left, sizeof(float) * left);
-  }
-  for (int i = 0; i < m_pMicInfo_AecRef->iMicNum ; i ++) {
-    int iMicId = m_pMicInfo_AecRef->pMicIdLst[i];
-    memcpy(m_pData_Out[iMicId], m_pData_Out[iMicId] + m_iLen_Out - left, sizeof(float) * left);
-    
-  }
-  m_iLen_Out = left ;
-  
-  if (iLen_In + m_iLen_In + m_iLen_Out > m_iLen_Out_Total) {
-    m_iLen_Out_Total = (iLen_In + m_iLen_In + m_iLen_Out) * 2 ;
-    float** pTmp = R2_SAFE_NEW_AR2(pTmp,float,m_iMicNum,m_iLen_Out_Total);
-    for (int i = 0; i < m_iMicNum ; i ++) {
-      memcpy(pTmp[i], m_pData_Out[i] , sizeof(float) * m_iLen_Out);
-    }
+  //only longer input than planned hop gets here
+  if (iLen_In + m_iOwe > m_iLen_Out_Total) {
+    m_iLen_Out_Total = iLen_In + m_iOwe ;
     R2_SAFE_DEL_AR2(m_pData_Out);
-    m_pData_Out = pTmp ;
+    m_pData_Out = R2_SAFE_NEW_AR2(m_pData_Out,float,m_iMicNum,m_iLen_Out_Total);
   }
   
   int cur = 0 , ll = 0 ;
+  iLen_Out = 0 ;
   while (cur < iLen_In) {
-    ll = r2_min(m_iFrmLen_Aec - m_iLen_In, iLen_In - cur);
-    for (int i = 0; i < m_pMicInfo_Aec->iMicNum ; i ++) {
-      int iMicId = m_pMicInfo_Aec->pMicIdLst[i];
-      memcpy(m_pData_In[iMicId] + m_iLen_In, pData_In[iMicId] + cur, sizeof(float) * ll);
-    }
-    for (int i = 0; i < m_pMicInfo_AecRef->iMicNum ; i ++) {
-      int iMicId = m_pMicInfo_AecRef->pMicIdLst[i];
-      memcpy(m_pData_In[iMicId] + m_iLen_In, pData_In[iMicId] + cur, sizeof(float) * ll);
-      
-    }
+    ll = m_pRing_In->put(pData_In, m_pRingId_In, cur, iLen_In - cur);
     cur += ll ;
-    m_iLen_In += ll ;
     
-    if (m_iLen_In == m_iFrmLen_Aec) {
+    if (m_pRing_In->size() == m_iFrmLen_Aec) {
+      m_pRing_In->get(m_pData_Aec_Lst, NULL, 0, m_iFrmLen_Aec);
       processfrm() ;
-      m_iLen_In = 0 ;
     }
+    
+    //as much out as went in, lookahead covers the frame being filled
+    int want = ll + m_iOwe ;
+    int got = m_pRing_Out->get(m_pData_Out, m_pMicInfo_Aec->pMicIdLst, iLen_Out, want);
+    m_iOwe = want - got ;
+    iLen_Out += got ;
   }
   
   pData_Out = m_pData_Out ;
-  iLen_Out = m_iLen_Out / m_iFrmLen_Out * m_iFrmLen_Out ;
   
   return m_iRt ;
 }
@@ -119,26 +134,21 @@ int r2mem_aec::processfrm(){
   int iLen1 = m_pMicInfo_AecRef->iMicNum * m_iFrmLen_Aec ;
   int iLen2 = m_pMicInfo_Aec->iMicNum * m_iFrmLen_Aec ;
   
-  for (int j = 0 ; j < m_pMicInfo_AecRef->iMicNum ; j ++) {
-    int iMicId = m_pMicInfo_AecRef->pMicIdLst[j] ;
-    memcpy(m_pData_Aec_Ref + j * m_iFrmLen_Aec, m_pData_In[iMicId], sizeof(float) * m_iFrmLen_Aec);
-  }
-  
   for (int j = 0 ; j < iLen1 ; j ++) {
     m_pData_Aec_Ref[j] = m_pData_Aec_Ref[j] / aaa ;
   }
   
-  r2ssp_aec_buffer_farend(m_hEngine_Aec,m_pData_Aec_Ref,m_iFrmLen_Aec * m_pMicInfo_AecRef->iMicNum );
-  
-  for (int j = 0 ; j < m_pMicInfo_Aec->iMicNum ; j ++) {
-    int iMicId = m_pMicInfo_Aec->pMicIdLst[j] ;
-    memcpy(m_pData_Aec_In + j * m_iFrmLen_Aec, m_pData_In[iMicId] , sizeof(float) * m_iFrmLen_Aec);
-  }
-  
   for (int j = 0 ; j < iLen2 ; j ++) {
     m_pData_Aec_In[j] = m_pData_Aec_In[j] / aaa ;
   }
   
+  //line echo up just behind reference before aec sees either
+  if (m_pDelay != NULL && m_pDelay->process(m_pData_Aec_In, m_pData_Aec_Ref)) {
+    m_bDelayChanged = 1 ;
+  }
+  
+  r2ssp_aec_buffer_farend(m_hEngine_Aec,m_pData_Aec_Ref,m_iFrmLen_Aec * m_pMicInfo_AecRef->iMicNum );
+  
   int rt = r2ssp_aec_process(m_hEngine_Aec,m_pData_Aec_In,m_iFrmLen_Aec * m_pMicInfo_Aec->iMicNum,m_pData_Aec_Out,0);
   if (rt == 0) {
     m_iRt = 1 ;
@@ -148,12 +158,7 @@ int r2mem_aec::processfrm(){
     m_pData_Aec_Out[j]  = m_pData_Aec_Out[j] * aaa ;
   }
   
-  for (int j = 0 ; j < m_pMicInfo_Aec->iMicNum ; j ++) {
-    int iMicId = m_pMicInfo_Aec->pMicIdLst[j] ;
-    memcpy(m_pData_Out[iMicId] + m_iLen_Out, m_pData_Aec_Out + j * m_iFrmLen_Aec,  sizeof(float) * m_iFrmLen_Aec);
-  }
-  
-  m_iLen_Out += m_iFrmLen_Aec ;
+  m_pRing_Out->put(m_pData_Aec_Out_Lst, NULL, 0, m_iFrmLen_Aec);
   
   return 0 ;
   
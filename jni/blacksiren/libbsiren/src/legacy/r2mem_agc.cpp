@@ -6,62 +6,225 @@
 //  Copyright © 2016 hadoop. All rights reserved.
 //
 
+#include <math.h>
+#include <float.h>
+
 #include "legacy/r2mem_agc.h"
 
-r2mem_agc::r2mem_agc(void){
-  
-  m_iFrmSize = R2_AUDIO_SAMPLE_RATE / 1000 * R2_AUDIO_FRAME_MS ;
-  m_hEngine_Agc =  r2ssp_agc_create();
-  r2ssp_agc_init(m_hEngine_Agc, R2_AUDIO_FRAME_MS, R2_AUDIO_SAMPLE_RATE);
+#ifndef R2AGC_NO_SIMD
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define R2AGC_NEON
+#elif defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#define R2AGC_SSE
+#endif
+#endif
+
+#define R2AGC_FULL_SCALE 32768.0f
+#define R2AGC_CLIP 32767.0f
 
-  m_iDataLen_Total = m_iFrmSize * 100 ;
+//sum of squares, peak of absolute value into fPeak
+static inline float r2agc_energy(const float* pData, int iLen, float& fPeak){
+
+  int i = 0 ;
+#if defined(R2AGC_NEON)
+  float32x4_t acc = vdupq_n_f32(0.0f) ;
+  float32x4_t peak = vdupq_n_f32(0.0f) ;
+  for ( ; i + 4 <= iLen ; i += 4) {
+    float32x4_t x = vld1q_f32(pData + i) ;
+    acc = vmlaq_f32(acc, x, x) ;
+    peak = vmaxq_f32(peak, vabsq_f32(x)) ;
+  }
+  float32x2_t s = vadd_f32(vget_low_f32(acc), vget_high_f32(acc)) ;
+  float fEn = vget_lane_f32(vpadd_f32(s, s), 0) ;
+  float32x2_t m = vmax_f32(vget_low_f32(peak), vget_high_f32(peak)) ;
+  fPeak = vget_lane_f32(vpmax_f32(m, m), 0) ;
+#elif defined(R2AGC_SSE)
+  const __m128 sign = _mm_set1_ps(-0.0f) ;
+  __m128 acc = _mm_setzero_ps() ;
+  __m128 peak = _mm_setzero_ps() ;
+  for ( ; i + 4 <= iLen ; i += 4) {
+    __m128 x = _mm_loadu_ps(pData + i) ;
+    acc = _mm_add_ps(acc, _mm_mul_ps(x, x)) ;
+    peak = _mm_max_ps(peak, _mm_andnot_ps(sign, x)) ;
+  }
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc)) ;
+  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1)) ;
+  float fEn = _mm_cvtss_f32(acc) ;
+  peak = _mm_max_ps(peak, _mm_movehl_ps(peak, peak)) ;
+  peak = _mm_max_ss(peak, _mm_shuffle_ps(peak, peak, 1)) ;
+  fPeak = _mm_cvtss_f32(peak) ;
+#else
+  float fEn = 0.0f ;
+  fPeak = 0.0f ;
+#endif
+  for ( ; i < iLen ; i ++) {
+    fEn += pData[i] * pData[i] ;
+    fPeak = r2_max(fPeak, fabsf(pData[i])) ;
+  }
+  return fEn ;
+}
+
+//pOut[i] = pIn[i] * (fGain + fStep * (i + 1)), clipped to 16 bit
+static inline void r2agc_ramp(const float* pIn, float* pOut, int iLen, float fGain, float fStep){
+
+  int i = 0 ;
+#if defined(R2AGC_NEON)
+  const float32x4_t hi = vdupq_n_f32(R2AGC_CLIP) ;
+  const float32x4_t lo = vdupq_n_f32(-R2AGC_CLIP) ;
+  const float pOff[4] = {1.0f, 2.0f, 3.0f, 4.0f} ;
+  float32x4_t g = vmlaq_n_f32(vdupq_n_f32(fGain), vld1q_f32(pOff), fStep) ;
+  const float32x4_t inc = vdupq_n_f32(fStep * 4.0f) ;
+  for ( ; i + 4 <= iLen ; i += 4) {
+    float32x4_t y = vmulq_f32(vld1q_f32(pIn + i), g) ;
+    vst1q_f32(pOut + i, vminq_f32(vmaxq_f32(y, lo), hi)) ;
+    g = vaddq_f32(g, inc) ;
+  }
+#elif defined(R2AGC_SSE)
+  const __m128 hi = _mm_set1_ps(R2AGC_CLIP) ;
+  const __m128 lo = _mm_set1_ps(-R2AGC_CLIP) ;
+  __m128 g = _mm_add_ps(_mm_set1_ps(fGain),
+                        _mm_mul_ps(_mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f), _mm_set1_ps(fStep))) ;
+  const __m128 inc = _mm_set1_ps(fStep * 4.0f) ;
+  for ( ; i + 4 <= iLen ; i += 4) {
+    __m128 y = _mm_mul_ps(_mm_loadu_ps(pIn + i), g) ;
+    _mm_storeu_ps(pOut + i, _mm_min_ps(_mm_max_ps(y, lo), hi)) ;
+    g = _mm_add_ps(g, inc) ;
+  }
+#endif
+  for ( ; i < iLen ; i ++) {
+    float y = pIn[i] * (fGain + fStep * (i + 1)) ;
+    pOut[i] = r2_min(r2_max(y, -R2AGC_CLIP), R2AGC_CLIP) ;
+  }
+}
+
+r2mem_agc::r2mem_agc(const r2agc_param& param){
+
+  m_param = param ;
+  m_param.fMinGainDb = r2_min(m_param.fMinGainDb, m_param.fMaxGainDb) ;
+
+  m_fAttack = coef(m_param.fAttackMs, R2AGC_BLOCK) ;
+  m_fRelease = coef(m_param.fReleaseMs, R2AGC_BLOCK) ;
+  m_fFloorFall = coef(R2AGC_FLOOR_FALL_MS, R2AGC_BLOCK) ;
+  m_fLimitRelease = coef(R2AGC_LIMIT_RELEASE_MS, R2AGC_BLOCK) ;
+  m_fLimit = R2AGC_FULL_SCALE * powf(10.0f, m_param.fLimitDb / 20.0f) ;
+
+  m_iDataLen_Total = R2_AUDIO_SAMPLE_RATE / 1000 * R2_AUDIO_FRAME_MS * 100 ;
   m_pData_Out =  R2_SAFE_NEW_AR1(m_pData_Out, float, m_iDataLen_Total);
-  m_pData_Tmp = R2_SAFE_NEW_AR1(m_pData_Tmp, short, m_iFrmSize);
-  
+
+  m_fFloor = 0.0f ;
+  m_bFloor = false ;
+
+  reset();
 }
 
 r2mem_agc::~r2mem_agc(void){
-  
-  
-  r2ssp_agc_free(m_hEngine_Agc);
+
   R2_SAFE_DEL_AR1(m_pData_Out);
-  R2_SAFE_DEL_AR1(m_pData_Tmp);
+}
+
+float r2mem_agc::coef(float fMs, int iLen){
+
+  return 1.0f - expf(-iLen * 1000.0f / (r2_max(fMs, 0.1f) * R2_AUDIO_SAMPLE_RATE)) ;
+}
+
+float r2mem_agc::level(float* pData, int iLen, float& fPeak){
+
+  float fEn = r2agc_energy(pData, iLen, fPeak) ;
+  return 10.0f * log10f(fEn / (iLen * R2AGC_FULL_SCALE * R2AGC_FULL_SCALE) + 1e-10f) ;
+}
+
+void r2mem_agc::floor(float fLevel, int iLen){
+
+  if (!m_bFloor) {
+    m_fFloor = fLevel ;
+    m_bFloor = true ;
+  }else if (fLevel < m_fFloor) {
+    float fFall = iLen == R2AGC_BLOCK ? m_fFloorFall : coef(R2AGC_FLOOR_FALL_MS, iLen) ;
+    m_fFloor += (fLevel - m_fFloor) * fFall ;
+  }else{
+    float fRise = fLevel > m_fFloor + m_param.fGateDb ? R2AGC_FLOOR_RISE_ACTIVE : R2AGC_FLOOR_RISE ;
+    m_fFloor = r2_min(m_fFloor + fRise * iLen / R2_AUDIO_SAMPLE_RATE, fLevel) ;
+  }
 }
 
 int r2mem_agc::process(float* pData_In, int iLen_In, float*& pData_Out, int& iLen_Out){
-  
-  assert(iLen_In % m_iFrmSize == 0);
-  
+
   if (iLen_In > m_iDataLen_Total) {
     R2_SAFE_DEL_AR1(m_pData_Out);
     m_iDataLen_Total = iLen_In * 2 ;
     m_pData_Out =  R2_SAFE_NEW_AR1(m_pData_Out, float, m_iDataLen_Total);
   }
-  
-  int iFrmNum = iLen_In / m_iFrmSize ;
-  for (int i = 0 ; i < iFrmNum ; i ++) {
-    for (int j = 0 ; j < m_iFrmSize ; j ++) {
-      m_pData_Tmp[j] = pData_In[i * m_iFrmSize + j ] / 4.0f;
+
+  for (int i = 0 ; i < iLen_In ; i += R2AGC_BLOCK) {
+    int iLen = r2_min(R2AGC_BLOCK, iLen_In - i) ;
+    float fPeak = 0.0f ;
+    float fLevel = level(pData_In + i, iLen, fPeak) ;
+    floor(fLevel, iLen) ;
+
+    //envelope of speech only, gain holds over noise and pauses
+    if (fLevel > m_fFloor + m_param.fGateDb) {
+      float fUp = iLen == R2AGC_BLOCK ? m_fAttack : coef(m_param.fAttackMs, iLen) ;
+      float fDown = iLen == R2AGC_BLOCK ? m_fRelease : coef(m_param.fReleaseMs, iLen) ;
+      m_fEnv += (fLevel - m_fEnv) * (fLevel > m_fEnv ? fUp : fDown) ;
     }
-    r2ssp_agc_process(m_hEngine_Agc, m_pData_Tmp);
-    for (int j = 0 ; j < m_iFrmSize ; j ++) {
-      m_pData_Out[i * m_iFrmSize + j ] = m_pData_Tmp[j] ;
+
+    //envelope is smooth already, gain follows it
+    m_fGainDb = r2_min(r2_max(m_param.fTargetDb - m_fEnv, m_param.fMinGainDb), m_param.fMaxGainDb) ;
+    float fGain = powf(10.0f, m_fGainDb / 20.0f) ;
+
+    //limiter: drops at once to keep peak under ceiling, gives gain back slowly
+    float fGainMax = fPeak * fGain > m_fLimit ? m_fLimit / fPeak : FLT_MAX ;
+    float fNeed = r2_min(fGainMax / fGain, 1.0f) ;
+    if (fNeed < m_fGainLimit) {
+      m_fGainLimit = fNeed ;
+    }else{
+      m_fGainLimit += (1.0f - m_fGainLimit) * m_fLimitRelease ;
+      m_fGainLimit = r2_min(m_fGainLimit, fNeed) ;
     }
+    fGain *= m_fGainLimit ;
+
+    //ramp from last gain, both ends under the ceiling so the ramp is too
+    float fStart = r2_min(m_fGain, fGainMax) ;
+    r2agc_ramp(pData_In + i, m_pData_Out + i, iLen, fStart, (fGain - fStart) / iLen) ;
+    m_fGain = fGain ;
   }
-  
+
   pData_Out = m_pData_Out ;
   iLen_Out = iLen_In ;
-  
+
+  return 0 ;
+}
+
+int r2mem_agc::track(float* pData_In, int iLen_In){
+
+  for (int i = 0 ; i < iLen_In ; i += R2AGC_BLOCK) {
+    int iLen = r2_min(R2AGC_BLOCK, iLen_In - i) ;
+    float fPeak = 0.0f ;
+    floor(level(pData_In + i, iLen, fPeak), iLen) ;
+  }
+
   return 0 ;
-  
-  
 }
 
 int r2mem_agc::reset(){
-  
-  r2ssp_agc_reset(m_hEngine_Agc);
-  
+
+  //unity gain until the envelope learns the speech
+  m_fEnv = m_param.fTargetDb ;
+  m_fGainDb = r2_min(r2_max(0.0f, m_param.fMinGainDb), m_param.fMaxGainDb) ;
+  m_fGainLimit = 1.0f ;
+  m_fGain = powf(10.0f, m_fGainDb / 20.0f) ;
+
   return 0 ;
 }
 
+float r2mem_agc::getgain_db(){
+
+  return 20.0f * log10f(m_fGain + 1e-10f) ;
+}
+
+float r2mem_agc::getfloor_db(){
 
+  return m_fFloor ;
+}
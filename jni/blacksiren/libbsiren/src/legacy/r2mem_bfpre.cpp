@@ -0,0 +1,167 @@
+//
+//  r2mem_bfpre.cpp
+//  r2ad2
+//
+
+#include "legacy/r2mem_bfpre.h"
+
+static float r2bfpre_dis(float fAz1, float fEl1, float fAz2, float fEl2){
+
+  //angle between the two directions on the sphere
+  float d = sinf(fEl1) * sinf(fEl2) + cosf(fEl1) * cosf(fEl2) * cosf(fAz1 - fAz2) ;
+  if (d > 1.0f) {
+    d = 1.0f ;
+  }
+  if (d < -1.0f) {
+    d = -1.0f ;
+  }
+  return acosf(d) ;
+}
+
+r2mem_bfpre::r2mem_bfpre(int iMicNum, float* pMicPosLst, float* pMicDelay, r2_mic_info* pMicInfo_Bf,
+                         int iDirNum, int iPrerollLen){
+
+  m_iDirNum = r2_min(r2_max(iDirNum, 0), R2BFPRE_DIR_MAX) ;
+  m_iPrerollLen = r2_max(iPrerollLen, 0) ;
+
+  m_fSteer[0] = 0.0f ;
+  m_fSteer[1] = 0.0f ;
+  m_pRing_Steer = R2_SAFE_NEW(m_pRing_Steer, r2frm_ring, 1, r2_max(m_iPrerollLen, 1));
+
+  for (int i = 0 ; i < m_iDirNum ; i ++) {
+    m_fDir[i][0] = 2.0f * 3.1415926f * i / m_iDirNum ;
+    m_fDir[i][1] = 0.0f ;
+    m_pMem_Bf[i] = R2_SAFE_NEW(m_pMem_Bf[i], r2mem_bf, iMicNum, pMicPosLst, pMicDelay, pMicInfo_Bf);
+    m_pMem_Bf[i]->steer(m_fDir[i][0], m_fDir[i][1]) ;
+    m_pRing_Dir[i] = R2_SAFE_NEW(m_pRing_Dir[i], r2frm_ring, 1, r2_max(m_iPrerollLen, 1));
+  }
+
+  m_pData_Tmp = R2_SAFE_NEW_AR1(m_pData_Tmp, float, r2_max(m_iPrerollLen, 1));
+  m_pData_Out = R2_SAFE_NEW_AR1(m_pData_Out, float, r2_max(m_iPrerollLen, 1));
+
+  memset(m_iCount, 0, sizeof(int) * 3);
+}
+
+r2mem_bfpre::~r2mem_bfpre(void)
+{
+
+  R2_SAFE_DEL(m_pRing_Steer);
+  for (int i = 0 ; i < m_iDirNum ; i ++) {
+    R2_SAFE_DEL(m_pMem_Bf[i]);
+    R2_SAFE_DEL(m_pRing_Dir[i]);
+  }
+
+  R2_SAFE_DEL_AR1(m_pData_Tmp);
+  R2_SAFE_DEL_AR1(m_pData_Out);
+}
+
+int r2mem_bfpre::reset(){
+
+  m_pRing_Steer->reset();
+  for (int i = 0 ; i < m_iDirNum ; i ++) {
+    m_pMem_Bf[i]->reset();
+    m_pMem_Bf[i]->steer(m_fDir[i][0], m_fDir[i][1]) ;
+    m_pRing_Dir[i]->reset();
+  }
+
+  return 0 ;
+}
+
+void r2mem_bfpre::keep(r2frm_ring* pRing, float* pData, int iLen){
+
+  //only the newest preroll is of use
+  if (iLen > m_iPrerollLen) {
+    pData += iLen - m_iPrerollLen ;
+    iLen = m_iPrerollLen ;
+  }
+  if (iLen > pRing->space()) {
+    pRing->drop(iLen - pRing->space());
+  }
+  pRing->put(&pData, NULL, 0, iLen);
+}
+
+int r2mem_bfpre::process(float** pData_In, int iLen_In, float* pData_Sig, int iLen_Sig){
+
+  assert(iLen_In == 0 || (iLen_In > 0 && pData_In != NULL)) ;
+
+  if (m_iPrerollLen == 0) {
+    return 0 ;
+  }
+
+  keep(m_pRing_Steer, pData_Sig, iLen_Sig);
+
+  for (int i = 0 ; i < m_iDirNum ; i ++) {
+    float* pData_Out = NULL ;
+    int iLen_Out = 0 ;
+    m_pMem_Bf[i]->process(pData_In, iLen_In, pData_Out, iLen_Out);
+    keep(m_pRing_Dir[i], pData_Out, iLen_Out);
+  }
+
+  return 0 ;
+}
+
+int r2mem_bfpre::steer(float fAzimuth, float fElevation){
+
+  m_fSteer[0] = fAzimuth ;
+  m_fSteer[1] = fElevation ;
+  m_pRing_Steer->reset();
+
+  return 0 ;
+}
+
+int r2mem_bfpre::fetch(float fAzimuth, float fElevation, int iLen, float*& pData_Out){
+
+  pData_Out = m_pData_Out ;
+  if (iLen <= 0 || iLen > m_iPrerollLen) {
+    m_iCount[r2bfpre_miss] ++ ;
+    return r2bfpre_miss ;
+  }
+
+  //steered bf first, it is where the last wake came from
+  if (m_pRing_Steer->size() >= iLen
+      && r2bfpre_dis(fAzimuth, fElevation, m_fSteer[0], m_fSteer[1]) < R2_BFSL_MIN_DIS) {
+    m_pRing_Steer->last(&m_pData_Out, NULL, 0, iLen);
+    m_iCount[r2bfpre_select] ++ ;
+    return r2bfpre_select ;
+  }
+
+  int i1 = -1, i2 = -1 ;
+  float d1 = 0.0f, d2 = 0.0f ;
+  for (int i = 0 ; i < m_iDirNum ; i ++) {
+    if (m_pRing_Dir[i]->size() < iLen) {
+      continue ;
+    }
+    float d = r2bfpre_dis(fAzimuth, fElevation, m_fDir[i][0], m_fDir[i][1]) ;
+    if (i1 < 0 || d < d1) {
+      i2 = i1 ;
+      d2 = d1 ;
+      i1 = i ;
+      d1 = d ;
+    } else if (i2 < 0 || d < d2) {
+      i2 = i ;
+      d2 = d ;
+    }
+  }
+
+  if (i1 >= 0 && d1 < R2_BFSL_MIN_DIS) {
+    m_pRing_Dir[i1]->last(&m_pData_Out, NULL, 0, iLen);
+    m_iCount[r2bfpre_select] ++ ;
+    return r2bfpre_select ;
+  }
+
+  //between two beams, mix them by how near each is
+  if (i2 >= 0 && d2 < R2BFPRE_FAR) {
+    float w1 = d2 / (d1 + d2) ;
+    float w2 = 1.0f - w1 ;
+    m_pRing_Dir[i1]->last(&m_pData_Out, NULL, 0, iLen);
+    m_pRing_Dir[i2]->last(&m_pData_Tmp, NULL, 0, iLen);
+    for (int j = 0 ; j < iLen ; j ++) {
+      m_pData_Out[j] = m_pData_Out[j] * w1 + m_pData_Tmp[j] * w2 ;
+    }
+    m_iCount[r2bfpre_interpolate] ++ ;
+    return r2bfpre_interpolate ;
+  }
+
+  m_iCount[r2bfpre_miss] ++ ;
+  return r2bfpre_miss ;
+}
@@ -42,6 +42,7 @@ r2mem_cod::r2mem_cod(r2cod_type iCodeType){
   m_iShield_TooLong = R2_AUDIO_SAMPLE_RATE * 6 ;
   m_iShield_Resume = R2_AUDIO_SAMPLE_RATE * 0.5f ;
 
+  m_bNorm_Am = true ;
   m_fShield_Am = 1.0f ;
   m_iLen_Am = m_iLen_Frm_Cod * 3 ;
   
@@ -123,7 +124,7 @@ int r2mem_cod::processdata(){
   
   assert(!m_bPaused) ;
   
-  if (m_iLen_Cod == 0 && m_iLen_Frm_Cod < m_iLen_In ) {
+  if (m_bNorm_Am && m_iLen_Cod == 0 && m_iLen_Frm_Cod < m_iLen_In ) {
     if (m_iLen_Am > m_iLen_In) {
       float total = 0.0f ;
       for (int i = 0; i < m_iLen_In ; i ++) {
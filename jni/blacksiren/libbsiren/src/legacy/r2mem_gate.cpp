@@ -0,0 +1,143 @@
+//
+//  r2mem_gate.cpp
+//  r2ad2
+//
+
+#include "legacy/r2mem_gate.h"
+
+r2mem_gate::r2mem_gate(int iMicNum, r2_mic_info* pMicInfo_Det, int iLookback, float fOnsetDb, int iHangLen){
+
+  m_iMicNum = iMicNum ;
+  m_pMicInfo_Det = r2_copymicinfo(pMicInfo_Det);
+  m_iLookback = r2_max(iLookback, 0) ;
+  m_fOnsetDb = fOnsetDb ;
+  m_iHangLen = r2_max(iHangLen, 0) ;
+
+  m_pRing = R2_SAFE_NEW(m_pRing, r2frm_ring, m_iMicNum, r2_max(m_iLookback, 1));
+  m_pLast = R2_SAFE_NEW_AR1(m_pLast, float, m_pMicInfo_Det->iMicNum);
+
+  m_iLen_Closed = 0 ;
+  m_iLen_Open = 0 ;
+  m_iOnset = 0 ;
+
+  reset();
+}
+
+r2mem_gate::~r2mem_gate(void)
+{
+
+  R2_SAFE_DEL(m_pRing);
+  R2_SAFE_DEL_AR1(m_pLast);
+  r2_free_micinfo(m_pMicInfo_Det) ;
+}
+
+int r2mem_gate::reset(){
+
+  m_pRing->reset();
+  memset(m_pLast, 0, sizeof(float) * m_pMicInfo_Det->iMicNum);
+  memset(m_fLevel, 0, sizeof(float) * R2GATE_BAND_NUM);
+  memset(m_fFloor, 0, sizeof(float) * R2GATE_BAND_NUM);
+  m_bFloor = false ;
+
+  //open until the floor is learnt
+  m_bOpen = true ;
+  m_iHang = m_iHangLen ;
+
+  return 0 ;
+}
+
+bool r2mem_gate::detect(float** pData_In, int iLen_In){
+
+  float fEn[R2GATE_BAND_NUM] = {0.0f, 0.0f} ;
+  for (int i = 0 ; i < m_pMicInfo_Det->iMicNum ; i ++) {
+    float* pData = pData_In[m_pMicInfo_Det->pMicIdLst[i]] ;
+    float fLast = m_pLast[i] ;
+    for (int j = 0 ; j < iLen_In ; j ++) {
+      float fDif = pData[j] - fLast ;
+      fEn[0] += pData[j] * pData[j] ;
+      fEn[1] += fDif * fDif ;
+      fLast = pData[j] ;
+    }
+    m_pLast[i] = fLast ;
+  }
+
+  float fNum = (float)r2_max(m_pMicInfo_Det->iMicNum * iLen_In, 1) ;
+  float fFlux = 0.0f ;
+  bool bLevel = false ;
+  for (int k = 0 ; k < R2GATE_BAND_NUM ; k ++) {
+    //input is at 16 bit scale, +1 keeps digital silence finite
+    float fLevel = 10.0f * log10f(fEn[k] / fNum + 1.0f) ;
+    if (m_bFloor) {
+      fFlux += r2_max(fLevel - m_fLevel[k], 0.0f) ;
+      if (fLevel - m_fFloor[k] > m_fOnsetDb) {
+        bLevel = true ;
+      }
+    } else {
+      m_fFloor[k] = fLevel ;
+    }
+    m_fLevel[k] = fLevel ;
+  }
+  m_bFloor = true ;
+
+  bool bActive = bLevel || fFlux > m_fOnsetDb ;
+
+  //floor falls at once and rises slowly, so it follows noise under sound
+  for (int k = 0 ; k < R2GATE_BAND_NUM ; k ++) {
+    if (m_fLevel[k] < m_fFloor[k]) {
+      m_fFloor[k] = m_fLevel[k] ;
+    } else {
+      m_fFloor[k] += r2_min(m_fLevel[k] - m_fFloor[k], bActive ? R2GATE_FLOOR_RISE_ACTIVE : R2GATE_FLOOR_RISE) ;
+    }
+  }
+
+  return bActive ;
+}
+
+int r2mem_gate::process(float** pData_In, int iLen_In, bool bHold){
+
+  bool bActive = detect(pData_In, iLen_In) || bHold ;
+
+  if (bActive) {
+    m_iHang = m_iHangLen ;
+  }
+
+  if (m_bOpen) {
+    m_iLen_Open += iLen_In ;
+    if (!bActive) {
+      m_iHang -= iLen_In ;
+      if (m_iHang <= 0) {
+        m_bOpen = false ;
+        m_pRing->reset();
+      }
+    }
+    return r2gate_open ;
+  }
+
+  if (bActive) {
+    m_bOpen = true ;
+    m_iOnset ++ ;
+    m_iLen_Open += iLen_In ;
+    return r2gate_onset ;
+  }
+
+  m_iLen_Closed += iLen_In ;
+  int iPut = r2_min(iLen_In, m_iLookback) ;
+  if (iPut > m_pRing->space()) {
+    m_pRing->drop(iPut - m_pRing->space());
+  }
+  m_pRing->put(pData_In, NULL, iLen_In - iPut, iPut);
+
+  return r2gate_closed ;
+}
+
+int r2mem_gate::kept(){
+
+  return m_bOpen ? m_pRing->size() : 0 ;
+}
+
+int r2mem_gate::fetch(float** pData_Out, int iLen){
+
+  int iGot = m_pRing->last(pData_Out, NULL, 0, r2_min(iLen, m_pRing->size()));
+  m_pRing->reset();
+  return iGot ;
+}
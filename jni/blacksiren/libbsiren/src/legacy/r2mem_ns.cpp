@@ -0,0 +1,389 @@
+//
+//  r2mem_ns.cpp
+//  r2ad2
+//
+
+#include <math.h>
+#include <string.h>
+
+#include "legacy/r2mem_ns.h"
+
+#ifndef R2NS_NO_SIMD
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define R2NS_NEON
+#elif defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#define R2NS_SSE
+#endif
+#endif
+
+//noise of an empty bin, keeps gain math finite
+#define R2NS_NOISE_MIN 1e-3f
+
+#if defined(R2NS_NEON)
+//no divide on armv7, estimate and two newton steps
+static inline float32x4_t r2ns_rcp(float32x4_t x){
+
+  float32x4_t r = vrecpeq_f32(x) ;
+  r = vmulq_f32(vrecpsq_f32(x, r), r) ;
+  return vmulq_f32(vrecpsq_f32(x, r), r) ;
+}
+#endif
+
+//power of iBin interleaved complex bins
+static inline void r2ns_power(const float* pC, float* pPow, int iBin){
+
+  int k = 0 ;
+#if defined(R2NS_NEON)
+  for ( ; k + 4 <= iBin ; k += 4) {
+    float32x4x2_t c = vld2q_f32(pC + 2 * k) ;
+    vst1q_f32(pPow + k, vmlaq_f32(vmulq_f32(c.val[0], c.val[0]), c.val[1], c.val[1])) ;
+  }
+#elif defined(R2NS_SSE)
+  for ( ; k + 4 <= iBin ; k += 4) {
+    __m128 a = _mm_loadu_ps(pC + 2 * k) ;
+    __m128 b = _mm_loadu_ps(pC + 2 * k + 4) ;
+    a = _mm_mul_ps(a, a) ;
+    b = _mm_mul_ps(b, b) ;
+    __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)) ;
+    __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)) ;
+    _mm_storeu_ps(pPow + k, _mm_add_ps(re, im)) ;
+  }
+#endif
+  for ( ; k < iBin ; k ++) {
+    pPow[k] = pC[2 * k] * pC[2 * k] + pC[2 * k + 1] * pC[2 * k + 1] ;
+  }
+}
+
+//smoothed power, then noise falls toward it or rises by a factor, iBin
+//is a multiple of 4
+static inline void r2ns_track(const float* pPow, float* pPsd, float* pNoise, int iBin,
+                              float fSmooth, float fFall, float fRise, float fRiseActive){
+
+  int k = 0 ;
+#if defined(R2NS_NEON)
+  const float32x4_t smooth = vdupq_n_f32(fSmooth) ;
+  const float32x4_t fall = vdupq_n_f32(fFall) ;
+  const float32x4_t rise = vdupq_n_f32(fRise) ;
+  const float32x4_t riseActive = vdupq_n_f32(fRiseActive) ;
+  const float32x4_t ratio = vdupq_n_f32(R2NS_NOISE_ACTIVE_RATIO) ;
+  for ( ; k + 4 <= iBin ; k += 4) {
+    float32x4_t ps = vld1q_f32(pPsd + k) ;
+    float32x4_t n = vld1q_f32(pNoise + k) ;
+    ps = vmlaq_f32(ps, smooth, vsubq_f32(vld1q_f32(pPow + k), ps)) ;
+    float32x4_t down = vmlaq_f32(n, fall, vsubq_f32(ps, n)) ;
+    uint32x4_t active = vcgtq_f32(ps, vmulq_f32(n, ratio)) ;
+    float32x4_t up = vminq_f32(vmulq_f32(n, vbslq_f32(active, riseActive, rise)), ps) ;
+    vst1q_f32(pNoise + k, vbslq_f32(vcltq_f32(ps, n), down, up)) ;
+    vst1q_f32(pPsd + k, ps) ;
+  }
+#elif defined(R2NS_SSE)
+  const __m128 smooth = _mm_set1_ps(fSmooth) ;
+  const __m128 fall = _mm_set1_ps(fFall) ;
+  const __m128 rise = _mm_set1_ps(fRise) ;
+  const __m128 riseActive = _mm_set1_ps(fRiseActive) ;
+  const __m128 ratio = _mm_set1_ps(R2NS_NOISE_ACTIVE_RATIO) ;
+  for ( ; k + 4 <= iBin ; k += 4) {
+    __m128 ps = _mm_loadu_ps(pPsd + k) ;
+    __m128 n = _mm_loadu_ps(pNoise + k) ;
+    ps = _mm_add_ps(ps, _mm_mul_ps(smooth, _mm_sub_ps(_mm_loadu_ps(pPow + k), ps))) ;
+    __m128 down = _mm_add_ps(n, _mm_mul_ps(fall, _mm_sub_ps(ps, n))) ;
+    __m128 active = _mm_cmpgt_ps(ps, _mm_mul_ps(n, ratio)) ;
+    __m128 factor = _mm_or_ps(_mm_and_ps(active, riseActive), _mm_andnot_ps(active, rise)) ;
+    __m128 up = _mm_min_ps(_mm_mul_ps(n, factor), ps) ;
+    __m128 below = _mm_cmplt_ps(ps, n) ;
+    _mm_storeu_ps(pNoise + k, _mm_or_ps(_mm_and_ps(below, down), _mm_andnot_ps(below, up))) ;
+    _mm_storeu_ps(pPsd + k, ps) ;
+  }
+#endif
+  for ( ; k < iBin ; k ++) {
+    pPsd[k] += fSmooth * (pPow[k] - pPsd[k]) ;
+    if (pPsd[k] < pNoise[k]) {
+      pNoise[k] += fFall * (pPsd[k] - pNoise[k]) ;
+    }else{
+      float f = pPsd[k] > pNoise[k] * R2NS_NOISE_ACTIVE_RATIO ? fRiseActive : fRise ;
+      pNoise[k] = r2_min(pNoise[k] * f, pPsd[k]) ;
+    }
+  }
+}
+
+//wiener gain of decision directed a priori snr, keeps clean power for
+//next frame, iBin is a multiple of 4
+static inline void r2ns_gain(const float* pPow, const float* pNoise, float* pClean, float* pGain,
+                             int iBin, float fFloor){
+
+  int k = 0 ;
+#if defined(R2NS_NEON)
+  const float32x4_t bias = vdupq_n_f32(R2NS_NOISE_BIAS) ;
+  const float32x4_t nmin = vdupq_n_f32(R2NS_NOISE_MIN) ;
+  const float32x4_t alpha = vdupq_n_f32(R2NS_DD_ALPHA) ;
+  const float32x4_t beta = vdupq_n_f32(1.0f - R2NS_DD_ALPHA) ;
+  const float32x4_t one = vdupq_n_f32(1.0f) ;
+  const float32x4_t zero = vdupq_n_f32(0.0f) ;
+  const float32x4_t floor = vdupq_n_f32(fFloor) ;
+  for ( ; k + 4 <= iBin ; k += 4) {
+    float32x4_t p = vld1q_f32(pPow + k) ;
+    float32x4_t inv = r2ns_rcp(vmlaq_f32(nmin, vld1q_f32(pNoise + k), bias)) ;
+    float32x4_t post = vmaxq_f32(vsubq_f32(vmulq_f32(p, inv), one), zero) ;
+    float32x4_t xi = vmlaq_f32(vmulq_f32(beta, post), alpha, vmulq_f32(vld1q_f32(pClean + k), inv)) ;
+    float32x4_t g = vmaxq_f32(vsubq_f32(one, r2ns_rcp(vaddq_f32(one, xi))), floor) ;
+    vst1q_f32(pGain + k, g) ;
+    vst1q_f32(pClean + k, vmulq_f32(vmulq_f32(g, g), p)) ;
+  }
+#elif defined(R2NS_SSE)
+  const __m128 bias = _mm_set1_ps(R2NS_NOISE_BIAS) ;
+  const __m128 nmin = _mm_set1_ps(R2NS_NOISE_MIN) ;
+  const __m128 alpha = _mm_set1_ps(R2NS_DD_ALPHA) ;
+  const __m128 beta = _mm_set1_ps(1.0f - R2NS_DD_ALPHA) ;
+  const __m128 one = _mm_set1_ps(1.0f) ;
+  const __m128 zero = _mm_setzero_ps() ;
+  const __m128 floor = _mm_set1_ps(fFloor) ;
+  for ( ; k + 4 <= iBin ; k += 4) {
+    __m128 p = _mm_loadu_ps(pPow + k) ;
+    __m128 nb = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(pNoise + k), bias), nmin) ;
+    __m128 post = _mm_max_ps(_mm_sub_ps(_mm_div_ps(p, nb), one), zero) ;
+    __m128 xi = _mm_add_ps(_mm_mul_ps(beta, post),
+                           _mm_mul_ps(alpha, _mm_div_ps(_mm_loadu_ps(pClean + k), nb))) ;
+    __m128 g = _mm_max_ps(_mm_div_ps(xi, _mm_add_ps(one, xi)), floor) ;
+    _mm_storeu_ps(pGain + k, g) ;
+    _mm_storeu_ps(pClean + k, _mm_mul_ps(_mm_mul_ps(g, g), p)) ;
+  }
+#endif
+  for ( ; k < iBin ; k ++) {
+    float nb = pNoise[k] * R2NS_NOISE_BIAS + R2NS_NOISE_MIN ;
+    float post = r2_max(pPow[k] / nb - 1.0f, 0.0f) ;
+    float xi = R2NS_DD_ALPHA * pClean[k] / nb + (1.0f - R2NS_DD_ALPHA) * post ;
+    float g = r2_max(xi / (1.0f + xi), fFloor) ;
+    pGain[k] = g ;
+    pClean[k] = g * g * pPow[k] ;
+  }
+}
+
+//iBin interleaved complex bins times gain
+static inline void r2ns_apply(float* pC, const float* pGain, int iBin){
+
+  int k = 0 ;
+#if defined(R2NS_NEON)
+  for ( ; k + 4 <= iBin ; k += 4) {
+    float32x4x2_t c = vld2q_f32(pC + 2 * k) ;
+    float32x4_t g = vld1q_f32(pGain + k) ;
+    c.val[0] = vmulq_f32(c.val[0], g) ;
+    c.val[1] = vmulq_f32(c.val[1], g) ;
+    vst2q_f32(pC + 2 * k, c) ;
+  }
+#elif defined(R2NS_SSE)
+  for ( ; k + 4 <= iBin ; k += 4) {
+    __m128 g = _mm_loadu_ps(pGain + k) ;
+    _mm_storeu_ps(pC + 2 * k, _mm_mul_ps(_mm_loadu_ps(pC + 2 * k), _mm_unpacklo_ps(g, g))) ;
+    _mm_storeu_ps(pC + 2 * k + 4, _mm_mul_ps(_mm_loadu_ps(pC + 2 * k + 4), _mm_unpackhi_ps(g, g))) ;
+  }
+#endif
+  for ( ; k < iBin ; k ++) {
+    pC[2 * k] *= pGain[k] ;
+    pC[2 * k + 1] *= pGain[k] ;
+  }
+}
+
+//pOut = pA * pB, iLen is a multiple of 4
+static inline void r2ns_mul(const float* pA, const float* pB, float* pOut, int iLen){
+
+  int i = 0 ;
+#if defined(R2NS_NEON)
+  for ( ; i + 4 <= iLen ; i += 4) {
+    vst1q_f32(pOut + i, vmulq_f32(vld1q_f32(pA + i), vld1q_f32(pB + i))) ;
+  }
+#elif defined(R2NS_SSE)
+  for ( ; i + 4 <= iLen ; i += 4) {
+    _mm_storeu_ps(pOut + i, _mm_mul_ps(_mm_loadu_ps(pA + i), _mm_loadu_ps(pB + i))) ;
+  }
+#endif
+  for ( ; i < iLen ; i ++) {
+    pOut[i] = pA[i] * pB[i] ;
+  }
+}
+
+r2mem_ns::r2mem_ns(float fFloorDb){
+
+  m_iHop = R2_AUDIO_SAMPLE_RATE / 1000 * R2_AUDIO_FRAME_MS ;
+  m_iWin = m_iHop * 2 ;
+  assert(m_iWin <= R2NS_FFT) ;
+  m_fFloor = powf(10.0f, r2_min(fFloorDb, 0.0f) / 20.0f) ;
+
+  m_pWin = R2_SAFE_NEW_AR1(m_pWin, float, m_iWin);
+  for (int i = 0 ; i < m_iWin ; i ++) {
+    m_pWin[i] = sqrtf(0.5f - 0.5f * cosf(2.0f * M_PI * i / m_iWin)) ;
+  }
+  m_pHist = R2_SAFE_NEW_AR1(m_pHist, float, m_iWin);
+  m_pTail = R2_SAFE_NEW_AR1(m_pTail, float, m_iHop);
+  m_pPend = R2_SAFE_NEW_AR1(m_pPend, float, m_iHop);
+
+  m_pFft_In = (float*)fftwf_malloc(sizeof(float) * R2NS_FFT) ;
+  m_pFft_Out = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * R2NS_BIN) ;
+  m_pFft_Back = (float*)fftwf_malloc(sizeof(float) * R2NS_FFT) ;
+  m_hPlan_Fwd = fftwf_plan_dft_r2c_1d(R2NS_FFT, m_pFft_In, m_pFft_Out, FFTW_ESTIMATE) ;
+  m_hPlan_Bwd = fftwf_plan_dft_c2r_1d(R2NS_FFT, m_pFft_Out, m_pFft_Back, FFTW_ESTIMATE) ;
+
+  m_pPow = R2_SAFE_NEW_AR1(m_pPow, float, R2NS_BIN_PAD);
+  m_pPsd = R2_SAFE_NEW_AR1(m_pPsd, float, R2NS_BIN_PAD);
+  m_pNoise = R2_SAFE_NEW_AR1(m_pNoise, float, R2NS_BIN_PAD);
+  m_pClean = R2_SAFE_NEW_AR1(m_pClean, float, R2NS_BIN_PAD);
+  m_pGain = R2_SAFE_NEW_AR1(m_pGain, float, R2NS_BIN_PAD);
+
+  m_iDataLen_Total = m_iHop * 100 ;
+  m_pData_Out = R2_SAFE_NEW_AR1(m_pData_Out, float, m_iDataLen_Total);
+
+  m_iHop_Active = 0 ;
+  m_iHop_Bypass = 0 ;
+
+  reset();
+}
+
+r2mem_ns::~r2mem_ns(void){
+
+  fftwf_destroy_plan(m_hPlan_Fwd);
+  fftwf_destroy_plan(m_hPlan_Bwd);
+  fftwf_free(m_pFft_In);
+  fftwf_free(m_pFft_Out);
+  fftwf_free(m_pFft_Back);
+
+  R2_SAFE_DEL_AR1(m_pWin);
+  R2_SAFE_DEL_AR1(m_pHist);
+  R2_SAFE_DEL_AR1(m_pTail);
+  R2_SAFE_DEL_AR1(m_pPend);
+  R2_SAFE_DEL_AR1(m_pPow);
+  R2_SAFE_DEL_AR1(m_pPsd);
+  R2_SAFE_DEL_AR1(m_pNoise);
+  R2_SAFE_DEL_AR1(m_pClean);
+  R2_SAFE_DEL_AR1(m_pGain);
+  R2_SAFE_DEL_AR1(m_pData_Out);
+}
+
+int r2mem_ns::reset(){
+
+  memset(m_pHist, 0, sizeof(float) * m_iWin);
+  memset(m_pTail, 0, sizeof(float) * m_iHop);
+  m_iPend = 0 ;
+
+  //zero padding is never written again
+  memset(m_pFft_In, 0, sizeof(float) * R2NS_FFT);
+  memset(m_pPow, 0, sizeof(float) * R2NS_BIN_PAD);
+  memset(m_pPsd, 0, sizeof(float) * R2NS_BIN_PAD);
+  memset(m_pNoise, 0, sizeof(float) * R2NS_BIN_PAD);
+  memset(m_pClean, 0, sizeof(float) * R2NS_BIN_PAD);
+  for (int k = 0 ; k < R2NS_BIN_PAD ; k ++) {
+    m_pGain[k] = 1.0f ;
+  }
+  m_bNoise = false ;
+  m_bActive = false ;
+  m_iSkip = 0 ;
+
+  return 0 ;
+}
+
+int r2mem_ns::cut(){
+
+  memset(m_pHist, 0, sizeof(float) * m_iWin);
+  memset(m_pTail, 0, sizeof(float) * m_iHop);
+  m_iPend = 0 ;
+  m_bActive = false ;
+
+  return 0 ;
+}
+
+void r2mem_ns::analyse(){
+
+  r2ns_mul(m_pHist, m_pWin, m_pFft_In, m_iWin);
+  fftwf_execute(m_hPlan_Fwd);
+  r2ns_power((float*)m_pFft_Out, m_pPow, R2NS_BIN);
+}
+
+void r2mem_ns::track(int iHops){
+
+  if (!m_bNoise) {
+    memcpy(m_pPsd, m_pPow, sizeof(float) * R2NS_BIN_PAD);
+    memcpy(m_pNoise, m_pPow, sizeof(float) * R2NS_BIN_PAD);
+    m_bNoise = true ;
+    return ;
+  }
+
+  //smoothing and fall are per update so sparse updates have the same
+  //variance and bias, rise is per second
+  float fSec = (float)iHops * m_iHop / R2_AUDIO_SAMPLE_RATE ;
+  r2ns_track(m_pPow, m_pPsd, m_pNoise, R2NS_BIN_PAD, R2NS_PSD_SMOOTH, R2NS_NOISE_FALL,
+             powf(10.0f, R2NS_NOISE_RISE_DB * fSec / 10.0f),
+             powf(10.0f, R2NS_NOISE_RISE_ACTIVE_DB * fSec / 10.0f));
+}
+
+void r2mem_ns::hop(float* pIn, bool bBypass, float* pOut){
+
+  memmove(m_pHist, m_pHist + m_iHop, sizeof(float) * m_iHop);
+  memcpy(m_pHist + m_iHop, pIn, sizeof(float) * m_iHop);
+
+  if (bBypass) {
+    if (++m_iSkip >= R2NS_BYPASS_TRACK) {
+      analyse();
+      track(m_iSkip);
+      m_iSkip = 0 ;
+    }
+    //what a frame of unity gain gives, so active and bypassed hops join
+    memcpy(pOut, m_pHist, sizeof(float) * m_iHop);
+    for (int i = 0 ; i < m_iHop ; i ++) {
+      m_pTail[i] = m_pHist[m_iHop + i] * m_pWin[m_iHop + i] * m_pWin[m_iHop + i] ;
+    }
+    m_bActive = false ;
+    m_iHop_Bypass ++ ;
+    return ;
+  }
+
+  analyse();
+  track(m_iSkip + 1);
+  m_iSkip = 0 ;
+  if (!m_bActive) {
+    //no clean estimate after bypass, start from power over noise
+    for (int k = 0 ; k < R2NS_BIN_PAD ; k ++) {
+      m_pClean[k] = r2_max(m_pPow[k] - m_pNoise[k] * R2NS_NOISE_BIAS, 0.0f) ;
+    }
+    m_bActive = true ;
+  }
+  r2ns_gain(m_pPow, m_pNoise, m_pClean, m_pGain, R2NS_BIN_PAD, m_fFloor);
+  r2ns_apply((float*)m_pFft_Out, m_pGain, R2NS_BIN);
+  fftwf_execute(m_hPlan_Bwd);
+
+  //fftw leaves out 1/n, folded into synthesis window
+  float fScale = 1.0f / R2NS_FFT ;
+  for (int i = 0 ; i < m_iHop ; i ++) {
+    pOut[i] = m_pTail[i] + m_pFft_Back[i] * m_pWin[i] * fScale ;
+    m_pTail[i] = m_pFft_Back[m_iHop + i] * m_pWin[m_iHop + i] * fScale ;
+  }
+  m_iHop_Active ++ ;
+}
+
+int r2mem_ns::process(float* pData_In, int iLen_In, bool bBypass, float*& pData_Out, int& iLen_Out){
+
+  int iHops = (m_iPend + iLen_In) / m_iHop ;
+  if (iHops * m_iHop > m_iDataLen_Total) {
+    R2_SAFE_DEL_AR1(m_pData_Out);
+    m_iDataLen_Total = iHops * m_iHop * 2 ;
+    m_pData_Out = R2_SAFE_NEW_AR1(m_pData_Out, float, m_iDataLen_Total);
+  }
+
+  int iUsed = 0 ;
+  iLen_Out = 0 ;
+  if (m_iPend > 0 && m_iPend + iLen_In >= m_iHop) {
+    iUsed = m_iHop - m_iPend ;
+    memcpy(m_pPend + m_iPend, pData_In, sizeof(float) * iUsed);
+    hop(m_pPend, bBypass, m_pData_Out);
+    m_iPend = 0 ;
+    iLen_Out = m_iHop ;
+  }
+  for ( ; iUsed + m_iHop <= iLen_In ; iUsed += m_iHop, iLen_Out += m_iHop) {
+    hop(pData_In + iUsed, bBypass, m_pData_Out + iLen_Out);
+  }
+  memcpy(m_pPend + m_iPend, pData_In + iUsed, sizeof(float) * (iLen_In - iUsed));
+  m_iPend += iLen_In - iUsed ;
+
+  pData_Out = m_pData_Out ;
+
+  return 0 ;
+}
@@ -15,16 +15,19 @@
     
     m_bDelay = bDelay ;
     
-    m_hRs_48_16 = r2_rs_create(m_pMicInfo_Rs->iMicNum, 3, 1, 160) ;
-    
+    //odd mics half an input sample late, even mics stay
+    float* pDelay = NULL ;
     if (m_bDelay) {
-      m_hRs_48_96 = r2_rs_create(m_pMicInfo_Rs->iMicNum, 1, 2, 960) ;
-    }else{
-      m_hRs_48_96 = NULL ;
+      pDelay = R2_SAFE_NEW_AR1(pDelay, float, m_pMicInfo_Rs->iMicNum) ;
+      for (int i = 0 ; i < m_pMicInfo_Rs->iMicNum ; i ++) {
+        pDelay[i] = m_pMicInfo_Rs->pMicIdLst[i] % 2 == 0 ? 0.0f : 0.5f ;
+      }
     }
-    
+    m_pRs = R2_SAFE_NEW(m_pRs, r2prs, m_pMicInfo_Rs->iMicNum, iSampleRate, R2_AUDIO_SAMPLE_RATE, pDelay) ;
+    R2_SAFE_DEL_AR1(pDelay) ;
     
     m_pData_Tmp = R2_SAFE_NEW_AR1(m_pData_Tmp, float*, m_pMicInfo_Rs->iMicNum) ;
+    m_pData_Tmp_Out = R2_SAFE_NEW_AR1(m_pData_Tmp_Out, float*, m_pMicInfo_Rs->iMicNum) ;
 
     m_iLen_Out_Total = 16000 ;
     m_pData_Out = R2_SAFE_NEW_AR2(m_pData_Out, float, m_iMicNum, m_iLen_Out_Total) ;
@@ -35,70 +38,38 @@
   
   r2mem_rs2::~r2mem_rs2(void){
     
-    r2_rs_free(m_hRs_48_16) ;
-    
-    if (m_bDelay) {
-      r2_rs_free(m_hRs_48_96) ;
-    }
-    
+    R2_SAFE_DEL(m_pRs) ;
     
     R2_SAFE_DEL_AR1(m_pData_Tmp) ;
+    R2_SAFE_DEL_AR1(m_pData_Tmp_Out) ;
     R2_SAFE_DEL_AR2(m_pData_Out) ;
     
   }
 
   int r2mem_rs2::reset(){
     
-    r2_rs_reset(m_hRs_48_16);
-    if (m_bDelay) {
-      r2_rs_reset(m_hRs_48_96) ;
-    }
+    m_pRs->reset() ;
     
     return 0 ;
   }
   
   int r2mem_rs2::process(float** pData_In, int iLen_In, float**& pData_Out, int& iLen_Out){
     
-    for (int i = 0 ; i < m_pMicInfo_Rs->iMicNum ; i ++) {
-      m_pData_Tmp[i] = pData_In[m_pMicInfo_Rs->pMicIdLst[i]] ;
-    }
-    
-    float** pData_Tmp = m_pData_Tmp ;
-    int iLen_Tmp = iLen_In ;
-    
-    
-    
-    if (m_bDelay) {
-      r2_rs_process_float(m_hRs_48_96, (const float**)pData_Tmp, iLen_Tmp, pData_Tmp, iLen_Tmp) ;
-      iLen_Tmp = iLen_Tmp / 2 ;
-      
-      for (int i = 0 ; i < m_pMicInfo_Rs->iMicNum; i ++) {
-        if (m_pMicInfo_Rs->pMicIdLst[i] % 2 == 0) {
-          for (int j = 0 ; j < iLen_Tmp ; j ++) {
-            pData_Tmp[i][j] = pData_Tmp[i][j * 2 + 1] ;
-          }
-        }else{
-          for (int j = 0 ; j < iLen_Tmp ; j ++) {
-            pData_Tmp[i][j] = pData_Tmp[i][j * 2] ;
-          }
-        }
-      }
-      
-    }
-    
-    r2_rs_process_float(m_hRs_48_16, (const float**)pData_Tmp, iLen_Tmp, pData_Tmp, iLen_Tmp) ;
-    if (iLen_Tmp > m_iLen_Out_Total) {
-      m_iLen_Out_Total = iLen_Tmp * 2 ;
+    int iLen_Max = m_pRs->getOutLenMax(iLen_In) ;
+    if (iLen_Max > m_iLen_Out_Total) {
+      m_iLen_Out_Total = iLen_Max * 2 ;
       R2_SAFE_DEL_AR2(m_pData_Out);
       m_pData_Out = R2_SAFE_NEW_AR2(m_pData_Out, float, m_iMicNum, m_iLen_Out_Total) ;
     }
     
-    for (int i = 0 ; i < m_pMicInfo_Rs->iMicNum; i ++) {
-      memcpy(m_pData_Out[m_pMicInfo_Rs->pMicIdLst[i]], pData_Tmp[i], sizeof(float) * iLen_Tmp) ;
+    //resample straight into output rows of the mics
+    for (int i = 0 ; i < m_pMicInfo_Rs->iMicNum ; i ++) {
+      m_pData_Tmp[i] = pData_In[m_pMicInfo_Rs->pMicIdLst[i]] ;
+      m_pData_Tmp_Out[i] = m_pData_Out[m_pMicInfo_Rs->pMicIdLst[i]] ;
     }
     
+    iLen_Out = m_pRs->process((const float**)m_pData_Tmp, iLen_In, m_pData_Tmp_Out) ;
     pData_Out = m_pData_Out ;
-    iLen_Out = iLen_Tmp ;
     
     return 0 ;
   }
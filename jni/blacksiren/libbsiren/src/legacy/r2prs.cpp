@@ -0,0 +1,243 @@
+//
+//  r2prs.cpp
+//  r2ad2
+//
+
+#include <math.h>
+#include <string.h>
+
+#include "legacy/r2prs.h"
+
+#ifndef R2PRS_NO_SIMD
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define R2PRS_NEON
+#elif defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#define R2PRS_SSE
+#endif
+#endif
+
+//iTaps is multiple of 4
+static inline float r2prs_dot(const float* pX, const float* pH, int iTaps){
+
+#if defined(R2PRS_NEON)
+  float32x4_t acc0 = vdupq_n_f32(0.0f) ;
+  float32x4_t acc1 = vdupq_n_f32(0.0f) ;
+  int i = 0 ;
+  for ( ; i + 8 <= iTaps ; i += 8) {
+    acc0 = vmlaq_f32(acc0, vld1q_f32(pX + i), vld1q_f32(pH + i)) ;
+    acc1 = vmlaq_f32(acc1, vld1q_f32(pX + i + 4), vld1q_f32(pH + i + 4)) ;
+  }
+  for ( ; i < iTaps ; i += 4) {
+    acc0 = vmlaq_f32(acc0, vld1q_f32(pX + i), vld1q_f32(pH + i)) ;
+  }
+  acc0 = vaddq_f32(acc0, acc1) ;
+  float32x2_t sum = vadd_f32(vget_low_f32(acc0), vget_high_f32(acc0)) ;
+  return vget_lane_f32(vpadd_f32(sum, sum), 0) ;
+#elif defined(R2PRS_SSE)
+  __m128 acc0 = _mm_setzero_ps() ;
+  __m128 acc1 = _mm_setzero_ps() ;
+  int i = 0 ;
+  for ( ; i + 8 <= iTaps ; i += 8) {
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(pX + i), _mm_loadu_ps(pH + i))) ;
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(pX + i + 4), _mm_loadu_ps(pH + i + 4))) ;
+  }
+  for ( ; i < iTaps ; i += 4) {
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(pX + i), _mm_loadu_ps(pH + i))) ;
+  }
+  acc0 = _mm_add_ps(acc0, acc1) ;
+  acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0)) ;
+  acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1)) ;
+  return _mm_cvtss_f32(acc0) ;
+#else
+  float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f ;
+  for (int i = 0 ; i < iTaps ; i += 4) {
+    s0 += pX[i] * pH[i] ;
+    s1 += pX[i + 1] * pH[i + 1] ;
+    s2 += pX[i + 2] * pH[i + 2] ;
+    s3 += pX[i + 3] * pH[i + 3] ;
+  }
+  return (s0 + s1) + (s2 + s3) ;
+#endif
+
+}
+
+static int r2prs_gcd(int a, int b){
+  while (b != 0) {
+    int t = a % b ;
+    a = b ;
+    b = t ;
+  }
+  return a ;
+}
+
+//modified bessel function of first kind, order 0
+static double r2prs_i0(double x){
+  double sum = 1.0, term = 1.0 ;
+  for (int k = 1 ; k < 50 ; k ++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k)) ;
+    sum += term ;
+    if (term < sum * 1e-12) {
+      break ;
+    }
+  }
+  return sum ;
+}
+
+  r2prs::r2prs(int iCn, int iSrIn, int iSrOut, const float* pDelay){
+
+    m_iCn = iCn ;
+    int g = r2prs_gcd(iSrIn, iSrOut) ;
+    m_iL = iSrOut / g ;
+    m_iM = iSrIn / g ;
+
+    //filter spans the same zero crossings of the lower rate for any ratio
+    int iMax = m_iL > m_iM ? m_iL : m_iM ;
+    m_iTaps = (2 * R2PRS_ZERO_CROSSINGS * iMax + m_iL - 1) / m_iL ;
+    m_iTaps = (m_iTaps + 3) / 4 * 4 ;
+
+    //channels with the same delay share a table
+    m_pCoefId = new int[m_iCn] ;
+    float* pTableDelay = new float[m_iCn] ;
+    m_iCoefNum = 0 ;
+    for (int i = 0 ; i < m_iCn ; i ++) {
+      float fDelay = pDelay == NULL ? 0.0f : pDelay[i] ;
+      int j = 0 ;
+      for ( ; j < m_iCoefNum ; j ++) {
+        if (pTableDelay[j] == fDelay) {
+          break ;
+        }
+      }
+      if (j == m_iCoefNum) {
+        pTableDelay[m_iCoefNum ++] = fDelay ;
+      }
+      m_pCoefId[i] = j ;
+    }
+
+    m_pCoef = new float*[m_iCoefNum] ;
+    for (int i = 0 ; i < m_iCoefNum ; i ++) {
+      m_pCoef[i] = new float[m_iL * m_iTaps] ;
+      buildCoef(m_pCoef[i], pTableDelay[i]) ;
+    }
+    delete [] pTableDelay ;
+
+    m_iBuffLen = 0 ;
+    m_pBuff = new float*[m_iCn] ;
+    for (int i = 0 ; i < m_iCn ; i ++) {
+      m_pBuff[i] = NULL ;
+    }
+
+    reset() ;
+  }
+
+  r2prs::~r2prs(void){
+
+    for (int i = 0 ; i < m_iCoefNum ; i ++) {
+      delete [] m_pCoef[i] ;
+    }
+    delete [] m_pCoef ;
+    delete [] m_pCoefId ;
+
+    for (int i = 0 ; i < m_iCn ; i ++) {
+      delete [] m_pBuff[i] ;
+    }
+    delete [] m_pBuff ;
+
+  }
+
+  void r2prs::buildCoef(float* pCoef, float fDelay){
+
+    //prototype runs at m_iL * input rate, cutoff of the lower nyquist
+    int iLen = m_iL * m_iTaps ;
+    int iMax = m_iL > m_iM ? m_iL : m_iM ;
+    double fc = 0.5 * R2PRS_CUTOFF / iMax ;
+    double center = (iLen - 1) / 2.0 + fDelay * m_iL ;
+    double half = iLen / 2.0 ;
+    double norm = r2prs_i0(R2PRS_KAISER_BETA) ;
+
+    //phase p, tap j weights input sample j of the window, newest last
+    for (int p = 0 ; p < m_iL ; p ++) {
+      float* pPhase = pCoef + p * m_iTaps ;
+      double sum = 0.0 ;
+      for (int j = 0 ; j < m_iTaps ; j ++) {
+        double x = p + (m_iTaps - 1 - j) * m_iL - center ;
+        double h = 0.0 ;
+        if (fabs(x) < half) {
+          double r = x / half ;
+          double w = r2prs_i0(R2PRS_KAISER_BETA * sqrt(1.0 - r * r)) / norm ;
+          double s = x == 0.0 ? 1.0 : sin(2.0 * M_PI * fc * x) / (2.0 * M_PI * fc * x) ;
+          h = 2.0 * fc * s * w ;
+        }
+        pPhase[j] = (float)h ;
+        sum += h ;
+      }
+      //unity dc gain on every phase
+      for (int j = 0 ; j < m_iTaps ; j ++) {
+        pPhase[j] = (float)(pPhase[j] / sum) ;
+      }
+    }
+
+  }
+
+  int r2prs::reset(){
+
+    for (int i = 0 ; i < m_iCn ; i ++) {
+      if (m_pBuff[i] != NULL) {
+        memset(m_pBuff[i], 0, sizeof(float) * m_iBuffLen) ;
+      }
+    }
+    m_iT = 0 ;
+
+    return 0 ;
+  }
+
+  int r2prs::getOutLenMax(int iLenIn){
+    return (iLenIn * m_iL + m_iM - 1) / m_iM + 1 ;
+  }
+
+  float r2prs::getLatency(){
+    return (m_iL * m_iTaps - 1) / 2.0f / m_iL ;
+  }
+
+  int r2prs::process(const float** pWavIn, int iLenIn, float** pWavOut){
+
+    int iHist = m_iTaps - 1 ;
+    if (iHist + iLenIn > m_iBuffLen) {
+      int iBuffLen = iHist + iLenIn ;
+      for (int i = 0 ; i < m_iCn ; i ++) {
+        float* pBuff = new float[iBuffLen] ;
+        memset(pBuff, 0, sizeof(float) * iBuffLen) ;
+        if (m_pBuff[i] != NULL) {
+          memcpy(pBuff, m_pBuff[i], sizeof(float) * iHist) ;
+          delete [] m_pBuff[i] ;
+        }
+        m_pBuff[i] = pBuff ;
+      }
+      m_iBuffLen = iBuffLen ;
+    }
+
+    //outputs whose window ends in this block, same for all channels
+    int iLenOut = 0 ;
+    if (iLenIn * m_iL > m_iT) {
+      iLenOut = (iLenIn * m_iL - m_iT + m_iM - 1) / m_iM ;
+    }
+
+    for (int i = 0 ; i < m_iCn ; i ++) {
+      float* pBuff = m_pBuff[i] ;
+      const float* pCoef = m_pCoef[m_pCoefId[i]] ;
+      memcpy(pBuff + iHist, pWavIn[i], sizeof(float) * iLenIn) ;
+
+      //window of input n ends at buffer n + iHist
+      int t = m_iT ;
+      for (int k = 0 ; k < iLenOut ; k ++, t += m_iM) {
+        pWavOut[i][k] = r2prs_dot(pBuff + t / m_iL, pCoef + (t % m_iL) * m_iTaps, m_iTaps) ;
+      }
+
+      memmove(pBuff, pBuff + iLenIn, sizeof(float) * iHist) ;
+    }
+
+    m_iT += iLenOut * m_iM - iLenIn * m_iL ;
+
+    return iLenOut ;
+  }
@@ -14,7 +14,7 @@
 #include "isiren.h"
 #include "siren_proxy.h"
 
-using BlackSiren::siren_printf;
+using BlackSiren::siren_log;
 using BlackSiren::ISiren;
 using BlackSiren::SirenProxy;
 
@@ -24,7 +24,8 @@ static bool check_nullptr_input_interface(siren_input_if_t *interface) {
             interface->start_input == nullptr ||
             interface->stop_input == nullptr ||
             interface->read_input == nullptr ||
-            interface->on_err_input == nullptr) {
+            interface->on_err_input == nullptr ||
+            (interface->acquire_input_frame == nullptr) != (interface->release_input_frame == nullptr)) {
         return true;
     } else {
         return false;
@@ -206,3 +207,100 @@ siren_status_t broadcast_siren_event(siren_t siren, char *data, int len) {
     SirenProxy *proxy = (SirenProxy *)siren;
     return proxy->broadcast_siren_event(data, len);
 }
+
+siren_status_t get_siren_input_format(siren_t siren, siren_input_format_t *format) {
+    if (siren == 0) {
+        siren_printf(BlackSiren::SIREN_ERROR, "siren is null");
+        return SIREN_STATUS_ERROR;
+    }
+
+    if (format == nullptr) {
+        siren_printf(BlackSiren::SIREN_ERROR, "format is nullptr");
+        return SIREN_STATUS_ERROR;
+    }
+
+    SirenProxy *proxy = (SirenProxy *)siren;
+    return proxy->get_input_format(format);
+}
+
+siren_sub_t subscribe_siren_event(siren_t siren, const siren_subscriber_t *subscriber) {
+    if (siren == 0) {
+        siren_printf(BlackSiren::SIREN_ERROR, "siren is null");
+        return -1;
+    }
+
+    if (subscriber == nullptr) {
+        siren_printf(BlackSiren::SIREN_ERROR, "subscriber is nullptr");
+        return -1;
+    }
+
+    SirenProxy *proxy = (SirenProxy *)siren;
+    return proxy->subscribe_event(subscriber);
+}
+
+void unsubscribe_siren_event(siren_t siren, siren_sub_t sub) {
+    if (siren == 0) {
+        siren_printf(BlackSiren::SIREN_ERROR, "siren is null");
+        return;
+    }
+
+    SirenProxy *proxy = (SirenProxy *)siren;
+    proxy->unsubscribe_event(sub);
+}
+
+siren_status_t get_siren_subscriber_stats(siren_t siren, siren_sub_t sub, siren_subscriber_stats_t *stats) {
+    if (siren == 0) {
+        siren_printf(BlackSiren::SIREN_ERROR, "siren is null");
+        return SIREN_STATUS_ERROR;
+    }
+
+    if (stats == nullptr) {
+        siren_printf(BlackSiren::SIREN_ERROR, "stats is nullptr");
+        return SIREN_STATUS_ERROR;
+    }
+
+    SirenProxy *proxy = (SirenProxy *)siren;
+    return proxy->get_subscriber_stats(sub, stats) ? SIREN_STATUS_OK : SIREN_STATUS_ERROR;
+}
+
+siren_status_t reload_siren_config(siren_t siren) {
+    if (siren == 0) {
+        siren_printf(BlackSiren::SIREN_ERROR, "siren is null");
+        return SIREN_STATUS_ERROR;
+    }
+
+    SirenProxy *proxy = (SirenProxy *)siren;
+    return proxy->reload_config();
+}
+
+siren_status_t watch_siren_config(siren_t siren, bool watch) {
+    if (siren == 0) {
+        siren_printf(BlackSiren::SIREN_ERROR, "siren is null");
+        return SIREN_STATUS_ERROR;
+    }
+
+    SirenProxy *proxy = (SirenProxy *)siren;
+    return proxy->watch_config(watch);
+}
+
+siren_status_t get_siren_supervisor_stats(siren_t siren, siren_supervisor_stats_t *stats) {
+    if (siren == 0 || stats == nullptr) {
+        siren_printf(BlackSiren::SIREN_ERROR, "siren or stats is null");
+        return SIREN_STATUS_ERROR;
+    }
+
+    SirenProxy *proxy = (SirenProxy *)siren;
+    proxy->get_supervisor_stats(stats);
+    return SIREN_STATUS_OK;
+}
+
+siren_status_t get_siren_aec_stats(siren_t siren, siren_aec_stats_t *stats) {
+    if (siren == 0 || stats == nullptr) {
+        siren_printf(BlackSiren::SIREN_ERROR, "siren or stats is null");
+        return SIREN_STATUS_ERROR;
+    }
+
+    SirenProxy *proxy = (SirenProxy *)siren;
+    proxy->get_aec_stats(stats);
+    return SIREN_STATUS_OK;
+}
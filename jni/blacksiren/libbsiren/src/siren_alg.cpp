@@ -181,6 +181,17 @@ void SirenAudioPreProcessor::preprocess(char *rawBuffer, PreprocessVoicePackage
 #endif
 }
 
+bool SirenAudioPreProcessor::getAecStats(siren_aec_stats_t *stats) {
+#ifdef CONFIG_USE_AD1
+    return false;
+#else
+    if (!preprocessorInit) {
+        return false;
+    }
+    return pImpl->getAecStats(stats);
+#endif
+}
+
 siren_status_t SirenAudioPreProcessor::destroy() {
 #ifdef CONFIG_USE_AD1
     if (ad1Init) {
@@ -289,19 +300,27 @@ void SirenAudioVBVProcessor::setSysSteer(float ho, float ver) {
 }
 
 
-void SirenAudioVBVProcessor::syncVTWord(std::vector<siren_vt_word> &words) {
-    if (words.empty()) {
-        siren_printf(SIREN_INFO, "sync vt words with empty words mean remove all");
-    }
+bool SirenAudioVBVProcessor::syncVTWord(const char *wire, int len) {
 #ifdef CONFIG_USE_AD2
     siren_printf(SIREN_INFO, "not support in ad2 version");
-    return;
+    return false;
 #else
-    pImpl->syncVTWord(words);
+    return pImpl->syncVTWord(wire, len);
 #endif
 
 }
 
+void SirenAudioVBVProcessor::reloadLive() {
+#ifdef CONFIG_USE_AD2
+    siren_printf(SIREN_INFO, "not support in ad2 version");
+#else
+    /* bf scaling and vad enable are read every frame */
+    if (processorInit) {
+        pImpl->reloadRecording();
+    }
+#endif
+}
+
 // legacy vbv process just for testing
 int SirenAudioVBVProcessor::process(PreprocessVoicePackage *voicePackage,
                                     std::vector<ProcessedVoiceResult *> &result) {
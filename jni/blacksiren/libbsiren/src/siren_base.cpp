@@ -16,6 +16,7 @@
 #include <thread>
 #include <atomic>
 #include <functional>
+#include <future>
 
 #include <fstream>
 
@@ -25,8 +26,34 @@
 #include "siren_base.h"
 #include "siren_config.h"
 #include "siren_alg.h"
+#include "siren_reload.h"
+#include "siren_timeline.h"
 
 namespace BlackSiren {
+
+enum {
+    RELOAD_TICKET_QUEUED,
+    RELOAD_TICKET_TAKEN,
+    RELOAD_TICKET_CANCELLED
+};
+
+//processor part of a reload, shared since the waiting side may give up,
+//whoever moves it out of queued first decides if it is applied
+struct SirenReloadTicket {
+    ~SirenReloadTicket() {
+        if (processor != nullptr) {
+            processor->destroy();
+        }
+    }
+
+    SirenConfig config;
+    SirenConfigChange change;
+    //built before the reload, with the config it runs, null to build here
+    std::unique_ptr<SirenConfig> processorConfig;
+    std::unique_ptr<SirenAudioVBVProcessor> processor;
+    std::promise<bool> done;
+    std::atomic<int> state {RELOAD_TICKET_QUEUED};
+};
 SirenBase::SirenBase(SirenConfig &config_, int socket_, SirenSocketReader &reader_,
                      SirenSocketWriter &writer) :
     processInitFailed(false),
@@ -37,6 +64,7 @@ SirenBase::SirenBase(SirenConfig &config_, int socket_, SirenSocketReader &reade
     socket(socket_),
     recordingExit(false),
     recordingStart(false),
+    processStart(false),
     processQueue(4 * 1024, nullptr),
     recordingQueue(256, nullptr),
     state(2) {
@@ -68,6 +96,7 @@ siren_status_t SirenBase::start_siren_process_stream(siren_proc_callback_t *call
     ((void)callback);
     siren_printf(SIREN_INFO, "base recording thread start");
     std::unique_lock<decltype(recordingMutex)> l_(recordingMutex);
+    processStart.store(true, std::memory_order_release);
     recordingStart = true;
     recordingCond.notify_one();
     return SIREN_STATUS_OK;
@@ -75,21 +104,38 @@ siren_status_t SirenBase::start_siren_process_stream(siren_proc_callback_t *call
 
 siren_status_t SirenBase::start_siren_raw_stream(siren_raw_stream_callback_t *callback) {
     ((void)callback);
+    if (rawStream == nullptr) {
+        siren_printf(SIREN_ERROR, "raw stream not init");
+        return SIREN_STATUS_ERROR;
+    }
+    std::unique_lock<decltype(recordingMutex)> l_(recordingMutex);
+    rawStream->start();
+    rawStart = true;
+    recordingStart = true;
+    recordingCond.notify_one();
     return SIREN_STATUS_OK;
 }
 
 void SirenBase::stop_siren_process_stream() {
     siren_printf(SIREN_INFO, "base recording thread stop");
     std::unique_lock<decltype(recordingMutex)> l_(recordingMutex);
-    recordingStart = false;
+    processStart.store(false, std::memory_order_release);
+    recordingStart = rawStart;
 }
 
 void SirenBase::stop_siren_raw_stream() {
-
+    if (rawStream == nullptr) {
+        return;
+    }
+    std::unique_lock<decltype(recordingMutex)> l_(recordingMutex);
+    rawStream->stop();
+    rawStart = false;
+    recordingStart = processStart.load(std::memory_order_acquire);
 }
 
 void SirenBase::stop_siren_stream() {
-
+    stop_siren_process_stream();
+    stop_siren_raw_stream();
 }
 
 void SirenBase::set_siren_state(siren_state_t state, siren_state_changed_callback_t *callback) {
@@ -150,7 +196,8 @@ void SirenBase::responseThreadHandler() {
 
         if ((status = requestReader.pollMessage(&message)) != SIREN_CHANNEL_OK) {
             siren_printf(SIREN_ERROR, "[SirenBase::responseThread] poll message with %d", status);
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            //10ms doubled, a dead proxy is known in 310ms instead of 5s
+            std::this_thread::sleep_for(std::chrono::milliseconds(10 << retry));
             retry++;
             if (retry >= 5) {
                 return;
@@ -175,6 +222,16 @@ void SirenBase::responseThreadHandler() {
             stop_siren_process_stream();
         }
         break;
+        case SIREN_REQUEST_MSG_START_RAW_STREAM: {
+            siren_printf(SIREN_INFO, "read message START_RAW_STREAM");
+            start_siren_raw_stream(nullptr);
+        }
+        break;
+        case SIREN_REQUEST_MSG_STOP_RAW_STREAM: {
+            siren_printf(SIREN_INFO, "read message STOP_RAW_STREAM");
+            stop_siren_raw_stream();
+        }
+        break;
         case SIREN_REQUEST_MSG_SET_STATE: {
             siren_printf(SIREN_INFO, "read message SET_STATE");
             if (message->len == sizeof(int)) {
@@ -220,6 +277,18 @@ void SirenBase::responseThreadHandler() {
             */
         }
         break;
+        case SIREN_REQUEST_MSG_RELOAD_CONFIG: {
+            siren_printf(SIREN_INFO, "read message RELOAD_CONFIG");
+            reloadConfig(message);
+        }
+        break;
+        case SIREN_REQUEST_MSG_HEARTBEAT: {
+            //answered by process thread, so a stuck processor misses it too
+            PreprocessVoicePackage *voicePackage =
+                allocatePreprocessVoicePackage(SIREN_REQUEST_MSG_HEARTBEAT, 0, 0);
+            processQueue.push((void *)voicePackage);
+        }
+        break;
         case SIREN_REQUEST_MSG_DESTROY: {
             siren_printf(SIREN_INFO, "read message DESTROY all");
             destroy_siren();
@@ -252,6 +321,7 @@ void SirenBase::launchProcessThread() {
 
 void SirenBase::processThreadHandler() {
     siren_printf(SIREN_INFO, "process start");
+    //this thread only, in thread mode the process is the host app
 #ifdef CONFIG_USE_FIFO
     struct sched_param param;
     int maxpri;
@@ -259,18 +329,18 @@ void SirenBase::processThreadHandler() {
     maxpri = sched_get_priority_max(SCHED_FIFO);
     if (maxpri != -1) {
         param.sched_priority = maxpri;
-        if (sched_setscheduler(getpid(), SCHED_FIFO, &param) == -1) {
+        if (sched_setscheduler(syscall(SYS_gettid), SCHED_FIFO, &param) == -1) {
             siren_printf(SIREN_WARNING, "set priority to SCHED_FIFO %d failed", maxpri);
-            setpriority(PRIO_PROCESS, getpid(), -20);
+            setpriority(PRIO_PROCESS, syscall(SYS_gettid), -20);
         } else {
             siren_printf(SIREN_INFO, "set priority to SCHED_FIFO %d", maxpri);
         }
     } else {
         siren_printf(SIREN_WARNING, "get max priority for SCHED_FIFO failed");
-        setpriority(PRIO_PROCESS, getpid(), -20);
+        setpriority(PRIO_PROCESS, syscall(SYS_gettid), -20);
     }
 #else
-    setpriority(PRIO_PROCESS, getpid(), -20);
+    setpriority(PRIO_PROCESS, syscall(SYS_gettid), -20);
 #endif
     onStateChanged = [this](int state) {
         int *t = nullptr;
@@ -282,8 +352,10 @@ void SirenBase::processThreadHandler() {
         delete [](char *)msg;
     };
 
-    SirenAudioVBVProcessor audioProcessor(config, onStateChanged);
-    if (audioProcessor.init() != SIREN_STATUS_OK) {
+    processConfig.reset(new SirenConfig(config));
+    audioProcessor.reset(new SirenAudioVBVProcessor(*processConfig, onStateChanged));
+    if (audioProcessor->init() != SIREN_STATUS_OK) {
+        siren_timeline_mark("processor init failed");
         siren_printf(SIREN_ERROR, "siren processor init failed");
         processInitFailed = true;
         processThreadInit = false;
@@ -291,6 +363,7 @@ void SirenBase::processThreadHandler() {
         return;
     }
 
+    siren_timeline_mark("processor init done");
     processThreadInit = true;
     initCond.notify_one();
     std::vector<ProcessedVoiceResult*> voiceResult;
@@ -314,7 +387,7 @@ void SirenBase::processThreadHandler() {
         while(!spinlock.test_and_set(std::memory_order_acquire)){
             int iState = state.load(std::memory_order_consume);
             siren_printf(SIREN_INFO, "man set state to %d", iState);
-            audioProcessor.setSysState(iState, true);
+            audioProcessor->setSysState(iState, true);
         }
 
         //handle voice process
@@ -324,7 +397,7 @@ void SirenBase::processThreadHandler() {
             }
 
             //siren_printf(SIREN_INFO, "start one frame process");
-            audioProcessor.process(pVoicePackage, voiceResult);
+            audioProcessor->process(pVoicePackage, voiceResult);
             if (voiceResult.empty()) {
                 //siren_printf(SIREN_ERROR, "audio process with null result");
                 delete [] (char *)pVoicePackage;
@@ -337,18 +410,16 @@ void SirenBase::processThreadHandler() {
                 //        p->prop, p->size, p->hasVoice, p->hasSL, p->sl);
                 if (p->prop == SIREN_EVENT_SLEEP) {
                     siren_printf(SIREN_INFO, "set state SLEEP without callback");
-                    audioProcessor.setSysState(SIREN_STATE_SLEEP, false);
+                    audioProcessor->setSysState(SIREN_STATE_SLEEP, false);
                 }
-                Message *msg = allocateMessage(SIREN_RESPONSE_MSG_ON_VOICE_EVENT, sizeof(ProcessedVoiceResult) + p->size);
                 if (p->hasVoice) {
                     if (doProcRecording) {
                         procRecordingStream.write((char *)p->data, p->size);
                     }
                 }
 
-                memcpy(msg->data, (char *)p, sizeof(ProcessedVoiceResult) + p->size);
-                resultWriter.writeMessage(msg);
-                delete [] (char *)msg;
+                resultWriter.writeMessage(SIREN_RESPONSE_MSG_ON_VOICE_EVENT, (char *)p,
+                                          sizeof(ProcessedVoiceResult) + p->size);
                 delete [] (char *)p;
                 p = nullptr;
             }
@@ -362,7 +433,7 @@ void SirenBase::processThreadHandler() {
             int *t = (int *)pVoicePackage->data;
             int state = t[0];
             siren_printf(SIREN_INFO, "man set state to %d", state);
-            audioProcessor.setSysState(state, true);
+            audioProcessor->setSysState(state, true);
         }
         break;
         case SIREN_REQUEST_MSG_SET_STEER: {
@@ -370,24 +441,41 @@ void SirenBase::processThreadHandler() {
             float ho = t[0];
             float ver = t[1];
             siren_printf(SIREN_INFO, "set steer %f %f", ho, ver);
-            audioProcessor.setSysSteer(ho, ver);
+            audioProcessor->setSysSteer(ho, ver);
         }
         break;
         case SIREN_REQUEST_MSG_SYNC_VT_WORD_LIST: {
             Message* msg = (Message *)pVoicePackage->data;
-            std::vector<siren_vt_word> vt_words;
-            int ret = getVTWordFromMessage(msg, vt_words);
-            if (ret == 0 || ret == -2) {
-                audioProcessor.syncVTWord(vt_words);
+            //kept in wire format, turned into engine words only by processor
+            if (audioProcessor->syncVTWord(msg->data, msg->len)) {
+                //a rebuilt processor gets them again
+                syncedWords.assign(msg->data, msg->len);
+                hasSyncedWords = true;
             } else {
-                siren_printf(SIREN_ERROR, "sync vt word failed with %d", ret);
+                siren_printf(SIREN_ERROR, "sync vt word failed");
             }
             delete []msg;
         }
         break;
+        case SIREN_REQUEST_MSG_RELOAD_CONFIG: {
+            std::shared_ptr<SirenReloadTicket> *ticket = (std::shared_ptr<SirenReloadTicket> *)pVoicePackage->data;
+            int queued = RELOAD_TICKET_QUEUED;
+            if ((*ticket)->state.compare_exchange_strong(queued, RELOAD_TICKET_TAKEN)) {
+                (*ticket)->done.set_value(applyProcessorConfig(**ticket));
+            } else {
+                siren_printf(SIREN_WARNING, "skip reload cancelled by timeout");
+            }
+            delete ticket;
+        }
+        break;
+        case SIREN_REQUEST_MSG_HEARTBEAT: {
+            Message msg(SIREN_RESPONSE_MSG_ON_HEARTBEAT);
+            resultWriter.writeMessage(&msg);
+        }
+        break;
         case SIREN_REQUEST_MSG_DESTROY: {
             delete [] (char *)pVoicePackage;
-            audioProcessor.destroy();
+            audioProcessor->destroy();
             siren_printf(SIREN_INFO, "process thread exit");
             return;
         }
@@ -404,9 +492,19 @@ void SirenBase::waitingProcessInit() {
     });
 }
 
+bool SirenBase::initPreprocessor() {
+    recordConfig.reset(new SirenConfig(config));
+    preProcessor.reset(new SirenAudioPreProcessor(frameSize, *recordConfig));
+    if (preProcessor->init() != SIREN_STATUS_OK) {
+        siren_timeline_mark("preprocessor init failed");
+        return false;
+    }
+    siren_timeline_mark("preprocessor init done");
+    return true;
+}
+
 void SirenBase::loopRecording() {
-    SirenAudioPreProcessor preProcessor(frameSize, config);
-    if (preProcessor.init() != SIREN_STATUS_OK) {
+    if (preprocessInitFailed) {
         siren_printf(SIREN_ERROR, "siren preprocessor init failed");
         //tell process exit
         PreprocessVoicePackage *voicePackage = new PreprocessVoicePackage;
@@ -423,22 +521,55 @@ void SirenBase::loopRecording() {
     //std::ofstream testRecordingDebugStream;
     //testRecordingDebugStream.open("/data/debug1.pcm", std::ios::out | std::ios::binary);
 
+    siren_timeline_mark("siren base ready");
+    if (config.siren_process_mode == CONFIG_PROCESS_FORK) {
+        siren_timeline_dump("siren base");
+    }
     Message msg(SIREN_RESPONSE_MSG_ON_INIT_OK);
     resultWriter.writeMessage(&msg);
     while (1) {
         PreprocessVoicePackage *pPreVoicePackage = nullptr;
+        std::unique_ptr<SirenConfig> reload;
+        uint32_t reloadSeq = 0;
+        bool prepared = false;
         {
             std::unique_lock<decltype(recordingMutex)> l_(recordingMutex);
             recordingCond.wait(l_, [this] {
-                return recordingStart;
+                return recordingStart || prepareDone || (!preparing && pendingConfig != nullptr);
             });
+            if (prepareDone) {
+                prepareDone = false;
+                preparing = false;
+                prepared = true;
+            } else if (!preparing) {
+                reload = std::move(pendingConfig);
+                reloadSeq = pendingReloadSeq;
+            }
         }
 
         if (recordingExit.load(std::memory_order_acquire)) {
             siren_printf(SIREN_INFO, "base recording thread request exit");
+            finishPrepare();
             return ;
         }
 
+        if (prepared) {
+            prepareThread.join();
+            //between two frames, no frame sees half of the change
+            SirenConfig next(*preparedConfig);
+            applyConfig(next, preparedSeq);
+            finishPrepare();
+            continue;
+        }
+
+        if (reload != nullptr) {
+            //a processor rebuild loads models, frames keep coming meanwhile
+            if (!prepareProcessor(reload, reloadSeq)) {
+                applyConfig(*reload, reloadSeq);
+            }
+            continue;
+        }
+
         int status = 0;
         status = read(socket, frameBuffer, frameSize);
         //siren_printf(SIREN_INFO, "read %d byte", status);
@@ -446,7 +577,8 @@ void SirenBase::loopRecording() {
             siren_printf(SIREN_INFO, "read returns %d since %s", status, strerror(errno));
             if (recordingExit.load(std::memory_order_acquire)) {
                 siren_printf(SIREN_INFO, "base recording thread request exit");
-                preProcessor.destroy();
+                finishPrepare();
+                preProcessor->destroy();
                 return;
             } else {
                 siren_printf(SIREN_INFO, "base read from socket return %d", status);
@@ -456,7 +588,7 @@ void SirenBase::loopRecording() {
         }
 
         //do preprocess
-        preProcessor.preprocess(frameBuffer, &pPreVoicePackage);
+        preProcessor->preprocess(frameBuffer, &pPreVoicePackage);
         if (pPreVoicePackage == nullptr) {
             //may contain empty voice skip
             //siren_printf(SIREN_ERROR, "preprocess failed");
@@ -464,6 +596,20 @@ void SirenBase::loopRecording() {
         }
         //testRecordingDebugStream.write((char *)pPreVoicePackage->data, pPreVoicePackage->size);
 
+        siren_aec_stats_t aecStats;
+        if (preProcessor->getAecStats(&aecStats)) {
+            responseAecStats(aecStats);
+        }
+
+        if (rawStream != nullptr && rawStream->isStarted()) {
+            rawStream->feed(pPreVoicePackage);
+        }
+        if (!processStart.load(std::memory_order_acquire)) {
+            //only raw stream is on
+            delete [] (char *)pPreVoicePackage;
+            continue;
+        }
+
         status = processQueue.push((void *)pPreVoicePackage);
         if (status != 0) {
             siren_printf(SIREN_INFO, "push error %d", status);
@@ -473,8 +619,228 @@ void SirenBase::loopRecording() {
     siren_printf(SIREN_INFO, "siren recording exits now");
 }
 
+void SirenBase::responseConfigReloaded(bool ok, uint32_t seq) {
+    Message *msg = allocateMessage(SIREN_RESPONSE_MSG_ON_CALLBACK, sizeof(int) * 3);
+    int *t = (int *)msg->data;
+    t[0] = SIREN_CALLBACK_ON_CONFIG_RELOADED;
+    t[1] = ok ? 1 : 0;
+    t[2] = (int)seq;
+    resultWriter.writeMessage(msg);
+    delete [](char *)msg;
+}
+
+void SirenBase::responseAecStats(const siren_aec_stats_t &stats) {
+    siren_printf(SIREN_INFO, "aec far end delay %d drift %d align %d", stats.delay, stats.drift, stats.align);
+    Message *msg = allocateMessage(SIREN_RESPONSE_MSG_ON_CALLBACK, sizeof(int) + sizeof(siren_aec_stats_t));
+    int *t = (int *)msg->data;
+    t[0] = SIREN_CALLBACK_ON_AEC_DELAY;
+    memcpy(t + 1, &stats, sizeof(siren_aec_stats_t));
+    resultWriter.writeMessage(msg);
+    delete [](char *)msg;
+}
+
+void SirenBase::reloadConfig(Message *message) {
+    //sequence number of the reload, then the snapshot
+    uint32_t seq = 0;
+    if (message->len < (int)sizeof(seq)) {
+        siren_printf(SIREN_ERROR, "read RELOAD_CONFIG without sequence");
+        return;
+    }
+    memcpy(&seq, message->data, sizeof(seq));
+
+    std::unique_ptr<SirenConfig> next(new SirenConfig);
+    SirenConfigSource source;
+    memset(&source, 0, sizeof(source));
+    if (!decode_siren_config_snapshot(message->data + sizeof(seq), message->len - sizeof(seq),
+                                      source, *next)) {
+        siren_printf(SIREN_ERROR, "read RELOAD_CONFIG but config is broken");
+        responseConfigReloaded(false, seq);
+        return;
+    }
+
+    std::unique_lock<decltype(recordingMutex)> l_(recordingMutex);
+    //a reload not taken yet is replaced and never answered, its caller has timed out
+    pendingConfig = std::move(next);
+    pendingReloadSeq = seq;
+    recordingCond.notify_one();
+}
+
+bool SirenBase::prepareProcessor(std::unique_ptr<SirenConfig> &next, uint32_t seq) {
+    SirenConfigChange change;
+    diff_siren_config(*recordConfig, *next, change);
+    if (change.restart || (change.reload & CONFIG_RELOAD_PROCESSOR) == 0) {
+        return false;
+    }
+
+    preparedConfig = std::move(next);
+    preparedSeq = seq;
+    {
+        std::lock_guard<decltype(recordingMutex)> l_(recordingMutex);
+        preparing = true;
+    }
+    std::thread t([this] {
+        std::unique_ptr<SirenAudioVBVProcessor> processor(
+            new SirenAudioVBVProcessor(*preparedConfig, onStateChanged));
+        if (processor->init() != SIREN_STATUS_OK) {
+            siren_printf(SIREN_ERROR, "reload processor init failed");
+            processor->destroy();
+            processor.reset();
+        }
+
+        std::lock_guard<decltype(recordingMutex)> l_(recordingMutex);
+        preparedProcessor = std::move(processor);
+        prepareDone = true;
+        recordingCond.notify_one();
+    });
+    prepareThread = std::move(t);
+    return true;
+}
+
+void SirenBase::finishPrepare() {
+    if (prepareThread.joinable()) {
+        prepareThread.join();
+    }
+    //not handed to process thread if an earlier stage failed
+    if (preparedProcessor != nullptr) {
+        preparedProcessor->destroy();
+        preparedProcessor.reset();
+    }
+    preparedConfig.reset();
+}
+
+void SirenBase::applyConfig(const SirenConfig &next, uint32_t seq) {
+    std::vector<SirenReloadStage> stages = {
+        {"preprocessor", [this](const SirenConfig &c, const SirenConfigChange &change) {
+            return reloadPreprocessor(c, change);
+        }},
+        {"processor", [this](const SirenConfig &c, const SirenConfigChange &change) {
+            return reloadProcessor(c, change);
+        }},
+    };
+
+    SirenConfig current(*recordConfig);
+    SirenConfigChange change;
+    bool ok = apply_siren_config(stages, current, next, change);
+    //mics and their layout may have moved under raw stream
+    if (ok && rawStream != nullptr
+            && (change.reload & (CONFIG_RELOAD_PREPROCESSOR | CONFIG_RELOAD_PROCESSOR)) != 0) {
+        rawStream->reload(next);
+    }
+    siren_printf(SIREN_INFO, "reload %d keys %s", (int)change.keys.size(), ok ? "done" : "failed");
+    responseConfigReloaded(ok, seq);
+}
+
+bool SirenBase::reloadPreprocessor(const SirenConfig &next, const SirenConfigChange &change) {
+    if ((change.reload & CONFIG_RELOAD_PREPROCESSOR) == 0) {
+        *recordConfig = next;
+        return true;
+    }
+
+    //old one keeps running if the new one can not init
+    std::unique_ptr<SirenConfig> nextConfig(new SirenConfig(next));
+    std::unique_ptr<SirenAudioPreProcessor> nextPreProcessor(new SirenAudioPreProcessor(frameSize, *nextConfig));
+    if (nextPreProcessor->init() != SIREN_STATUS_OK) {
+        siren_printf(SIREN_ERROR, "reload preprocessor init failed");
+        nextPreProcessor->destroy();
+        return false;
+    }
+
+    preProcessor->destroy();
+    preProcessor = std::move(nextPreProcessor);
+    recordConfig = std::move(nextConfig);
+    return true;
+}
+
+bool SirenBase::reloadProcessor(const SirenConfig &next, const SirenConfigChange &change) {
+    std::shared_ptr<SirenReloadTicket> ticket = std::make_shared<SirenReloadTicket>();
+    ticket->config = next;
+    ticket->change = change;
+    if ((change.reload & CONFIG_RELOAD_PROCESSOR) != 0 && preparedConfig != nullptr) {
+        if (preparedProcessor == nullptr) {
+            //init failed while frames kept coming
+            return false;
+        }
+        ticket->processorConfig = std::move(preparedConfig);
+        ticket->processor = std::move(preparedProcessor);
+    }
+    std::future<bool> done = ticket->done.get_future();
+
+    //behind every frame preprocessed with the old config
+    PreprocessVoicePackage *voicePackage =
+        allocatePreprocessVoicePackage(SIREN_REQUEST_MSG_RELOAD_CONFIG,
+                                       0, sizeof(std::shared_ptr<SirenReloadTicket> *));
+    voicePackage->data = (char *)new std::shared_ptr<SirenReloadTicket>(ticket);
+    processQueue.push((void *)voicePackage);
+
+    //a prepared processor is only swapped in, one built there loads models
+    if (done.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+        int queued = RELOAD_TICKET_QUEUED;
+        if (ticket->state.compare_exchange_strong(queued, RELOAD_TICKET_CANCELLED)) {
+            //still queued, processor skips it and keeps the old config
+            siren_printf(SIREN_ERROR, "reload processor timeout");
+            return false;
+        }
+        //processor is applying it, the result must be known for rollback
+        siren_printf(SIREN_WARNING, "reload processor slow, wait for it");
+    }
+    return done.get();
+}
+
+bool SirenBase::applyProcessorConfig(SirenReloadTicket &ticket) {
+    if ((ticket.change.reload & CONFIG_RELOAD_PROCESSOR) == 0) {
+        *processConfig = ticket.config;
+        audioProcessor->reloadLive();
+        return true;
+    }
+
+    std::unique_ptr<SirenConfig> nextConfig = std::move(ticket.processorConfig);
+    std::unique_ptr<SirenAudioVBVProcessor> nextProcessor = std::move(ticket.processor);
+    if (nextProcessor == nullptr) {
+        nextConfig.reset(new SirenConfig(ticket.config));
+        nextProcessor.reset(new SirenAudioVBVProcessor(*nextConfig, onStateChanged));
+        if (nextProcessor->init() != SIREN_STATUS_OK) {
+            siren_printf(SIREN_ERROR, "reload processor init failed");
+            nextProcessor->destroy();
+            return false;
+        }
+    }
+
+    nextProcessor->setSysState(audioProcessor->getSysState(), false);
+    if (hasSyncedWords) {
+        nextProcessor->syncVTWord(syncedWords.data(), syncedWords.size());
+    }
+    audioProcessor->destroy();
+    audioProcessor = std::move(nextProcessor);
+    processConfig = std::move(nextConfig);
+    return true;
+}
+
+//page in model files the processor opens by path, while it inits
+static void prefetchModels(const SirenConfig &config) {
+    std::vector<std::string> paths;
+    paths.push_back(config.alg_config.alg_vt_dnnmod);
+    paths.push_back(config.alg_config.alg_vt_phomod);
+    for (size_t i = 0; i < config.alg_config.def_vt_configs.size(); i++) {
+        paths.push_back(config.alg_config.def_vt_configs[i].vt_nnet_path);
+    }
+
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (paths[i].empty()) {
+            continue;
+        }
+        int fd = open(paths[i].c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        //readahead in kernel, does not wait for the read
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        close(fd);
+    }
+    siren_timeline_mark("models prefetched");
+}
 
 void SirenBase::main() {
+    siren_timeline_mark("siren base start");
     if (config.debug_config.preprocessed_result_record) {
         std::string basePath("/pre_processed.pcm");
         siren_printf(SIREN_INFO, "recording path is %s", config.debug_config.recording_path.c_str());
@@ -505,10 +871,19 @@ void SirenBase::main() {
     }
 
 
+    prefetchModels(config);
+
     //launch response thread
     launchProcessThread();
+    //both stages load their models at the same time
+    preprocessInitFailed = !initPreprocessor();
     siren_printf(SIREN_INFO, "waiting process thread");
     waitingProcessInit();
+    rawStream.reset(new SirenRawStream(config, resultWriter));
+    if (!rawStream->init()) {
+        siren_printf(SIREN_ERROR, "raw stream init failed, only processed stream is on");
+        rawStream.reset();
+    }
     siren_printf(SIREN_INFO, "process thread started...");
     if (processInitFailed) {
         siren_printf(SIREN_ERROR, "process init failed");
@@ -517,8 +892,6 @@ void SirenBase::main() {
         resultWriter.writeMessage(&msg);
     }
 
-    //we need to known proxy response thread has started
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
     //start response thread
     launchResponseThread();
     loopRecording();
@@ -531,6 +904,10 @@ void SirenBase::main() {
     if (processThread.joinable()) {
         processThread.join();
     }
+
+    if (rawStream != nullptr) {
+        rawStream->destroy();
+    }
 }
 
 }
@@ -9,6 +9,7 @@
 #include <sys/epoll.h>
 #include <sys/resource.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <limits.h>
 #include <sys/eventfd.h>
@@ -18,6 +19,8 @@
 #include "isiren.h"
 #include "sutils.h"
 #include "siren_channel.h"
+#include "siren_event_pool.h"
+#include "siren_vt_wire.h"
 
 
 static void setnonblocking(int sock) {
@@ -60,118 +63,25 @@ Message* allocateMessage(int msg, int len) {
 }
 
 Message* allocateMessageFromVTWord(std::vector<siren_vt_word> &vt_words) {
-    if (vt_words.empty()) {
-        char *pBuffer = new char [sizeof(Message)];
-        if (pBuffer == nullptr) {
-            return nullptr;
-        }
-
-        memset (pBuffer, 0, sizeof(Message));
-        Message *pMessage = (Message *)pBuffer;
-        pMessage->magic[0] = 'a';
-        pMessage->magic[1] = 'a';
-        pMessage->magic[2] = 'b';
-        pMessage->magic[3] = 'b';
-        pMessage->len = 0;
-        pMessage->data = nullptr;
-        pMessage->msg = SIREN_REQUEST_MSG_SYNC_VT_WORD_LIST;
-        return pMessage;
-    }
-    int total_len = 0;
-
-    std::vector<int> packed_lens;
-    for (siren_vt_word vt_word : vt_words) {
-        //we have 3 string member
-        int vt_word_str_num = vt_word.vt_word.length();
-        int vt_phone_str_num = vt_word.vt_phone.length();
-        int vt_nnet_path_str_num = 0;
-        if (!vt_word.alg_config.nnet_path.empty()) {
-            vt_nnet_path_str_num = vt_word.alg_config.nnet_path.length();
-        }
-
-        //vt_type(int)
-        //vt_block_avg_score/vt_block_min_score/vt_classify_shield(float)
-        //vt_left_sil_det/vt_right_sil_det/vt_remote_check_with_aec
-        ///vt_remote_check_without_aec/vt_local_classify_check(bool)
-        //string size(int)
-        //string content
-        //including three '\0'
-        int other_num = sizeof(UnpackedVTConfig) + vt_word_str_num + vt_phone_str_num + vt_nnet_path_str_num + 3;
-        int round_up_len = other_num + (8 - other_num % 8);
-        //siren_printf(SIREN_INFO, "round from %d to %d", other_num, round_up_len);
-        packed_lens.push_back(round_up_len);
-        total_len += round_up_len;
-    }
-    total_len += 4 * sizeof(int);
-    //siren_printf(SIREN_INFO, "allocate unpackedVTConfig with len %d", total_len);
-
-    char *pBuffer = new char [sizeof(Message) + total_len];
-    if (pBuffer == nullptr) {
+    int len = SirenVTWireBuilder::measure(vt_words);
+    if (len < 0) {
+        siren_printf(SIREN_ERROR, "vt word list too long for wire");
         return nullptr;
     }
 
-    memset (pBuffer, 0, sizeof(Message) + total_len);
-    Message *pMessage = (Message *)pBuffer;
-    pMessage->magic[0] = 'a';
-    pMessage->magic[1] = 'a';
-    pMessage->magic[2] = 'b';
-    pMessage->magic[3] = 'b';
+    Message *pMessage = allocateMessage(SIREN_REQUEST_MSG_SYNC_VT_WORD_LIST, len);
+    if (pMessage == nullptr) {
+        return nullptr;
+    }
 
-    pMessage->msg = SIREN_REQUEST_MSG_SYNC_VT_WORD_LIST;
-    pMessage->len = total_len;
-    pMessage->data = pBuffer + sizeof(Message);
-    char *p = pMessage->data;
-    int num = vt_words.size();
-    memcpy(p, (char *)&num, sizeof(int));
-    p += sizeof(int) * 4;
-    char *k = p;
-    int j = 0;
-
-    for (siren_vt_word vt_word : vt_words) {
-        UnpackedVTConfig *unpackedVTConfig = (UnpackedVTConfig *)k;
-        p = k;
-        unpackedVTConfig->total_len = packed_lens[j];
-        k += packed_lens[j];
-        j++;
-
-        unpackedVTConfig->vt_block_avg_score = vt_word.alg_config.vt_block_avg_score;
-        unpackedVTConfig->vt_block_min_score = vt_word.alg_config.vt_block_min_score;
-        unpackedVTConfig->vt_classify_shield = vt_word.alg_config.vt_classify_shield;
-
-        unpackedVTConfig->vt_left_sil_det = vt_word.alg_config.vt_left_sil_det;
-        unpackedVTConfig->vt_right_sil_det = vt_word.alg_config.vt_right_sil_det;
-        unpackedVTConfig->vt_remote_check_with_aec = vt_word.alg_config.vt_remote_check_with_aec;
-        unpackedVTConfig->vt_remote_check_without_aec = vt_word.alg_config.vt_remote_check_without_aec;
-        unpackedVTConfig->vt_local_classify_check = vt_word.alg_config.vt_local_classify_check;
-
-        unpackedVTConfig->vt_type = vt_word.vt_type;
-        int vt_word_tmp_len = vt_word.vt_word.length();
-        int vt_phone_tmp_len = vt_word.vt_phone.length();
-        int nnet_path_tmp_len =  vt_word.alg_config.nnet_path.empty() ? 0 : vt_word.alg_config.nnet_path.length();
-
-        unpackedVTConfig->vt_word_size = vt_word_tmp_len;
-        unpackedVTConfig->vt_phone_size = vt_phone_tmp_len;
-        unpackedVTConfig->vt_nnet_path_size = nnet_path_tmp_len;
-
-        memcpy(p, unpackedVTConfig, sizeof(UnpackedVTConfig));
-        p += sizeof(UnpackedVTConfig);
-
-        memcpy(p, vt_word.vt_word.c_str(), vt_word_tmp_len);
-        p += vt_word_tmp_len;
-        *p = '\0';
-        p++;
-
-        memcpy(p, vt_word.vt_phone.c_str(), vt_phone_tmp_len);
-        p += vt_phone_tmp_len;
-        *p = '\0';
-        p++;
-
-        if (!vt_word.alg_config.nnet_path.empty()) {
-            memcpy(p, vt_word.alg_config.nnet_path.c_str(), nnet_path_tmp_len);
-            p += nnet_path_tmp_len;
-        }
-        *p = '\0';
-        p++;
+    SirenVTWireBuilder builder(pMessage->data, len);
+    for (const siren_vt_word &vt_word : vt_words) {
+        builder.add(vt_word);
+    }
+    if (builder.finish() != len) {
+        siren_printf(SIREN_ERROR, "build vt word list failed");
+        delete [](char *)pMessage;
+        return nullptr;
     }
 
     return pMessage;
@@ -193,79 +103,24 @@ int getVTWordFromMessage(Message *message, std::vector<siren_vt_word> &vt_words)
         return -2;
     }
 
-    int total_len = message->len;
-    char *p = message->data;
-    int num = -1;
-
-    memcpy((char *)&num, p, sizeof(int));
-    p += sizeof(int) * 4;
-    char *k = p;
-    //siren_printf(SIREN_INFO, "vt_words contains %d", num);
-
-    if (total_len < (int)sizeof(UnpackedVTConfig) * num) {
-        siren_printf(SIREN_ERROR, "len is %d cannot have so many configs", total_len);
-        return -6;
+    SirenVTWireParser parser(message->data, message->len);
+    if (parser.count() < 0) {
+        siren_printf(SIREN_ERROR, "bad vt word list header");
+        return -4;
     }
 
-    for (int i = 0; i < num; i++) {
+    SirenVTWireWord wire;
+    while (parser.next(wire)) {
         siren_vt_word vt;
-        UnpackedVTConfig *unpackedVTConfig = (UnpackedVTConfig *)k;
-        int total_len = unpackedVTConfig->total_len;
-        p = k;
-        k += total_len;
-
-        vt.vt_type = unpackedVTConfig->vt_type;
-        vt.use_default_config = false;
-        vt.alg_config.vt_classify_shield = unpackedVTConfig->vt_classify_shield;
-        vt.alg_config.vt_block_avg_score = unpackedVTConfig->vt_block_avg_score;
-        vt.alg_config.vt_block_min_score = unpackedVTConfig->vt_block_min_score;
-        vt.alg_config.vt_left_sil_det = unpackedVTConfig->vt_left_sil_det;
-        vt.alg_config.vt_right_sil_det = unpackedVTConfig->vt_right_sil_det;
-        vt.alg_config.vt_local_classify_check = unpackedVTConfig->vt_local_classify_check;
-        vt.alg_config.vt_remote_check_with_aec = unpackedVTConfig->vt_remote_check_with_aec;
-        vt.alg_config.vt_remote_check_without_aec = unpackedVTConfig->vt_remote_check_without_aec;
-
-        int vt_word_size = unpackedVTConfig->vt_word_size;
-        int vt_phone_size = unpackedVTConfig->vt_phone_size;
-        int vt_nnet_size = unpackedVTConfig->vt_nnet_path_size;
-
-        char *content;
-        p += sizeof(UnpackedVTConfig);
-        content = p;
-
-        //siren_printf(SIREN_INFO, "vt word size ->> %d", vt_word_size);
-        //siren_printf(SIREN_INFO, "vt phone size ->> %d", vt_phone_size);
-
-        if (*(content + vt_word_size) != '\0') {
-            siren_printf(SIREN_ERROR, "vt word end with %d need 0", *(content + vt_word_size));
-            return -4;
-        }
-        vt.vt_word = content;
-
-        p += vt_word_size + 1;
-        content = p;
-        if (*(content + vt_phone_size) != '\0') {
-            siren_printf(SIREN_ERROR, "vt phone end with %d need 0", *(content + vt_phone_size));
-            return -7;
-        }
-        vt.vt_phone = content;
-
-        if (vt_nnet_size == 0) {
-            vt.alg_config.nnet_path = "";
-        } else {
-            p += vt_phone_size + 1;
-            content = p;
-            if (*(content + vt_nnet_size) != '\0') {
-                siren_printf(SIREN_ERROR, "vt nnet path end with %d need 0", *(content + vt_phone_size));
-                return -5;
-            }
-            vt.alg_config.nnet_path = content;
-        }
-
-        //add vt config
+        toVTWord(wire, vt);
         vt_words.push_back(vt);
     }
 
+    if (parser.failed()) {
+        siren_printf(SIREN_ERROR, "bad vt word %d of %d", (int)vt_words.size(), parser.count());
+        return -5;
+    }
+
     return 0;
 }
 
@@ -287,7 +142,9 @@ SirenSocketReader::~SirenSocketReader() {
         close(epollFD);
     }
 
-    close(socket);
+    if (socket >= 0) {
+        close(socket);
+    }
 }
 
 void SirenSocketReader::prepareOnReadSideProcess() {
@@ -314,6 +171,7 @@ void SirenSocketReader::prepareOnReadSideProcess() {
     }
 
     setnonblocking(channel->sockets[1]);
+    socket = channel->sockets[1];
     isPrepareOnReadSide = true;
 }
 
@@ -334,7 +192,7 @@ static void dumpMessage(Message &temp) {
                  temp.magic[0], temp.magic[1], temp.magic[2], temp.magic[3], temp.len, temp.msg, temp.data);
 }
 
-int SirenSocketReader::pollMessage(Message **msg) {
+int SirenSocketReader::pollHeader(Message &temp) {
     if (!isPrepareOnReadSide) {
         siren_printf(SIREN_ERROR, "not prepare on read side");
         return SIREN_CHANNEL_NOT_PREPARE;
@@ -357,9 +215,15 @@ int SirenSocketReader::pollMessage(Message **msg) {
 #ifdef CONFIG_DEBUG_CHANNEL
         siren_printf(SIREN_INFO, "read message");
 #endif
-        Message temp;
-        Message *rmsg = nullptr;
-        read(channel->sockets[1], (char *)&temp, sizeof(Message));
+        int t = read(channel->sockets[1], (char *)&temp, sizeof(Message));
+        if (t < 0 && (errno == EAGAIN || errno == EINTR)) {
+            continue;
+        }
+        if (t <= 0) {
+            //writer side closed, forked peer is gone
+            siren_printf(SIREN_ERROR, "read header failed, peer %s", t == 0 ? "closed" : strerror(errno));
+            return SIREN_CHANNEL_ERROR;
+        }
         if (!checkMagic(temp.magic)) {
             siren_printf(SIREN_ERROR, "check magic failed!!");
             dumpMessage(temp);
@@ -368,47 +232,82 @@ int SirenSocketReader::pollMessage(Message **msg) {
 #ifdef CONFIG_DEBUG_CHANNEL
         siren_printf(SIREN_INFO, "read msg data len %d", temp.len);
 #endif
-        rmsg = allocateMessage(temp.msg, temp.len);
-        if (temp.len != 0) {
-            int readlen = temp.len;
-            char *offset = rmsg->data;
-            for (;;) {
-                int t = read(channel->sockets[1], offset, readlen);
-                if (t < 0) {
-                    if (errno == EAGAIN) {
+        return SIREN_CHANNEL_OK;
+    }
+}
+
+void SirenSocketReader::readData(Message *rmsg) {
+    if (rmsg->len != 0) {
+        int readlen = rmsg->len;
+        char *offset = rmsg->data;
+        for (;;) {
+            int t = read(channel->sockets[1], offset, readlen);
+            if (t < 0) {
+                if (errno == EAGAIN) {
 #ifdef CONFIG_DEBUG_CHANNEL
-                        continue;
+                    continue;
 #endif
-                    } else {
-                        siren_printf(SIREN_ERROR, "read error %s", strerror(errno));
-                    }
                 } else {
-                    if (t != readlen) {
-                        readlen = readlen - t;
-                        offset += t;
+                    siren_printf(SIREN_ERROR, "read error %s", strerror(errno));
+                    break;
+                }
+            } else if (t == 0) {
+                //peer gone in the middle of a message, next poll reports it
+                siren_printf(SIREN_ERROR, "read data failed, peer closed");
+                break;
+            } else {
+                if (t != readlen) {
+                    readlen = readlen - t;
+                    offset += t;
 #ifdef CONFIG_DEBUG_CHANNEL
-                        siren_printf(SIREN_INFO, "need read %d have read %d", readlen, t);
+                    siren_printf(SIREN_INFO, "need read %d have read %d", readlen, t);
 #endif
-                    } else {
-                        break;
-                    }
+                } else {
+                    break;
                 }
             }
         }
+    }
+}
+
+int SirenSocketReader::pollMessage(Message **msg) {
+    Message temp;
+    int status = pollHeader(temp);
+    if (status != SIREN_CHANNEL_OK) {
+        return status;
+    }
 
-        *msg = rmsg;
+    Message *rmsg = allocateMessage(temp.msg, temp.len);
+    readData(rmsg);
+    *msg = rmsg;
 
-        return SIREN_CHANNEL_OK;
+    return SIREN_CHANNEL_OK;
+}
+
+int SirenSocketReader::pollMessage(SirenEventBlock **block) {
+    Message temp;
+    int status = pollHeader(temp);
+    if (status != SIREN_CHANNEL_OK) {
+        return status;
     }
+
+    SirenEventBlock *rblock = SirenEventPool::instance().obtain(temp.msg, temp.len);
+    readData(rblock->message());
+    *block = rblock;
+
+    return SIREN_CHANNEL_OK;
 }
 
 SirenSocketWriter::~SirenSocketWriter() {
-    //close reader
-    close (channel->sockets[1]);
+    //reader end is closed on prepare, peer reads EOF once writer is gone
+    if (socket >= 0) {
+        close(socket);
+    }
 }
 
 void SirenSocketWriter::prepareOnWriteSideProcess() {
     close (channel->sockets[1]);
+    socket = channel->sockets[0];
     isPrepareOnWriteSide = true;
 }
 
@@ -425,9 +324,11 @@ int SirenSocketWriter::writeMessage(Message *msg) {
 
     std::lock_guard<decltype(writeGuard)> l_(writeGuard);
     //siren_printf(SIREN_INFO, "send message %d with len %d", msg->msg, msg->len);
-    int t = write (channel->sockets[0], msg, sizeof(Message) + msg->len);
+    //no SIGPIPE when peer process died, caller sees the error instead
+    int t = send (channel->sockets[0], msg, sizeof(Message) + msg->len, MSG_NOSIGNAL);
     if (t <= 0) {
         siren_printf(SIREN_ERROR, "write failed with %s", strerror(errno));
+        return SIREN_CHANNEL_ERROR;
     }
 
     if (t != (int)sizeof(Message) + msg->len) {
@@ -437,6 +338,39 @@ int SirenSocketWriter::writeMessage(Message *msg) {
     return SIREN_CHANNEL_OK;
 }
 
+int SirenSocketWriter::writeMessage(int msg, const char *data, int len) {
+    if (!isPrepareOnWriteSide) {
+        siren_printf(SIREN_ERROR, "not prepare on write side");
+        return SIREN_CHANNEL_NOT_PREPARE;
+    }
+
+    Message header(msg);
+    header.len = len;
+    struct iovec iov[2];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(Message);
+    iov[1].iov_base = (void *)data;
+    iov[1].iov_len = len;
+
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = iov;
+    mh.msg_iovlen = len == 0 ? 1 : 2;
+
+    std::lock_guard<decltype(writeGuard)> l_(writeGuard);
+    int t = sendmsg(channel->sockets[0], &mh, MSG_NOSIGNAL);
+    if (t <= 0) {
+        siren_printf(SIREN_ERROR, "write failed with %s", strerror(errno));
+        return SIREN_CHANNEL_ERROR;
+    }
+
+    if (t != (int)sizeof(Message) + len) {
+        siren_printf(SIREN_ERROR, "write %d, but expect %d",
+                     t, len);
+    }
+    return SIREN_CHANNEL_OK;
+}
+
 SirenSocketChannel::SirenSocketChannel(int rmem_, int wmem_) {
     rmem = rmem_;
     wmem = wmem_;
@@ -475,4 +409,28 @@ bool SirenSocketChannel::open() {
     return true;
 }
 
+void SirenSocketChannel::close() {
+    ::close(sockets[0]);
+    ::close(sockets[1]);
+}
+
+bool SirenSocketChannel::duplicate(SirenSocketChannel &to) {
+    to.sockets[0] = dup(sockets[0]);
+    to.sockets[1] = dup(sockets[1]);
+    if (to.sockets[0] < 0 || to.sockets[1] < 0) {
+        siren_printf(SIREN_ERROR, "dup socketpair failed since %s", strerror(errno));
+        if (to.sockets[0] >= 0) {
+            ::close(to.sockets[0]);
+        }
+        if (to.sockets[1] >= 0) {
+            ::close(to.sockets[1]);
+        }
+        return false;
+    }
+
+    to.rmem = rmem;
+    to.wmem = wmem;
+    return true;
+}
+
 }
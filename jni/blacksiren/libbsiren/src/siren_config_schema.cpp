@@ -0,0 +1,1047 @@
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <string>
+#include <vector>
+
+#include "sutils.h"
+#include "siren_config_schema.h"
+#include "json.h"
+
+namespace BlackSiren {
+
+#define CONFIG_FIELD(member) \
+    [](void *config) -> void * { return &static_cast<SirenConfig *>(config)->member; }
+#define VT_FIELD(member) \
+    [](void *config) -> void * { return &static_cast<DefVTConfig *>(config)->member; }
+
+#define REQUIRED true
+#define OPTIONAL false
+
+/* channel index of mic arrays, checked against mic_channel_num later */
+#define MIC_INDEX_MAX 63
+#define CPU_INDEX_MAX 63
+
+static const char * const ipc_names[] = {IPC_CHANNEL, IPC_DBUS, IPC_BINDER, IPC_SHARE_MEM, nullptr};
+static const char * const lan_names[] = {"zh", "en", nullptr};
+static const char * const process_mode_names[] = {PROCESS_MODE_FORK, PROCESS_MODE_THREAD, nullptr};
+
+/* CONFIG_RELOAD_PROCESS keys need siren restarted when changed */
+static const std::vector<SirenConfigKey> config_keys = {
+    {KEY_BASIC_CONFIG, KEY_MIC_NUM, CONFIG_TYPE_INT, REQUIRED, 1, 64, 0, nullptr, nullptr,
+        CONFIG_FIELD(mic_num), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_MIC_CHANNEL_NUM, CONFIG_TYPE_INT, REQUIRED, 1, 64, 0, nullptr, nullptr,
+        CONFIG_FIELD(mic_channel_num), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_MIC_SAMPLE_RATE, CONFIG_TYPE_INT, REQUIRED, 8000, 192000, 0, nullptr, nullptr,
+        CONFIG_FIELD(mic_sample_rate), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_MIC_AUDIO_BYTE, CONFIG_TYPE_INT, REQUIRED, 2, 4, 0, nullptr, nullptr,
+        CONFIG_FIELD(mic_audio_byte), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_MIC_FRAME_LENGTH, CONFIG_TYPE_INT, REQUIRED, 1, 1000, 0, nullptr, nullptr,
+        CONFIG_FIELD(mic_frame_length), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_SIREN_IPC, CONFIG_TYPE_ENUM, REQUIRED, 0, 0, 0, nullptr, ipc_names,
+        CONFIG_FIELD(siren_ipc), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_SIREN_CHANNEL_RMEM, CONFIG_TYPE_SIZE, REQUIRED, 4096, 1 << 30, 0, nullptr, nullptr,
+        CONFIG_FIELD(siren_recording_socket_rmem), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_SIREN_CHANNEL_WMEM, CONFIG_TYPE_SIZE, REQUIRED, 4096, 1 << 30, 0, nullptr, nullptr,
+        CONFIG_FIELD(siren_recording_socket_wmem), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_SIREN_PROCESS_MODE, CONFIG_TYPE_ENUM, OPTIONAL, 0, 0, CONFIG_PROCESS_FORK, nullptr,
+        process_mode_names, CONFIG_FIELD(siren_process_mode), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_SIREN_SUPERVISE, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 1, nullptr, nullptr,
+        CONFIG_FIELD(siren_supervise), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_SIREN_HEARTBEAT_TIMEOUT, CONFIG_TYPE_INT, OPTIONAL, 500, 60000, 2000, nullptr, nullptr,
+        CONFIG_FIELD(siren_heartbeat_timeout), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_SIREN_GAP_BUFFER, CONFIG_TYPE_INT, OPTIONAL, 0, 10000, 2000, nullptr, nullptr,
+        CONFIG_FIELD(siren_gap_buffer), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_SIREN_INPUT_ERR_RETRY_NUM, CONFIG_TYPE_INT, REQUIRED, 0, 1000, 0, nullptr, nullptr,
+        CONFIG_FIELD(siren_input_err_retry_num), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_SIREN_INPUT_ERR_RETRY_TIMEOUT, CONFIG_TYPE_INT, REQUIRED, 0, 60000, 0, nullptr, nullptr,
+        CONFIG_FIELD(siren_input_err_retry_timeout), CONFIG_RELOAD_PROCESS},
+    {KEY_BASIC_CONFIG, KEY_SIREN_MONITOR_UDP_PORT, CONFIG_TYPE_INT, REQUIRED, 0, 65535, 0, nullptr, nullptr,
+        CONFIG_FIELD(udp_port), CONFIG_RELOAD_PROCESS},
+
+    {KEY_ALG_CONFIG, KEY_ALG_USE_LEGACY_CONFIG_FILE, CONFIG_TYPE_BOOL, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_use_legacy_ssp_config_file), CONFIG_RELOAD_PROCESS},
+    {KEY_ALG_CONFIG, KEY_ALG_LEGACY_CONFIG_FILE_PATH, CONFIG_TYPE_STRING, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_legacy_dir), CONFIG_RELOAD_PROCESS},
+    {KEY_ALG_CONFIG, KEY_ALG_LAN, CONFIG_TYPE_ENUM, REQUIRED, 0, 0, 0, nullptr, lan_names,
+        CONFIG_FIELD(alg_config.alg_lan), CONFIG_RELOAD_PROCESS},
+    {KEY_ALG_CONFIG, KEY_ALG_RS_MICS, CONFIG_TYPE_INT_ARRAY, REQUIRED, 0, MIC_INDEX_MAX, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_rs_mics), CONFIG_RELOAD_PREPROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AEC, CONFIG_TYPE_BOOL, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_aec), CONFIG_RELOAD_PREPROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AEC_MICS, CONFIG_TYPE_INT_ARRAY, REQUIRED, 0, MIC_INDEX_MAX, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_aec_mics), CONFIG_RELOAD_PREPROCESSOR | CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AEC_REF_MICS, CONFIG_TYPE_INT_ARRAY, REQUIRED, 0, MIC_INDEX_MAX, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_aec_ref_mics), CONFIG_RELOAD_PREPROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AEC_SHIELD, CONFIG_TYPE_FLOAT, REQUIRED, 0, 1e6, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_aec_shield), CONFIG_RELOAD_PREPROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AEC_AFF_CPUS, CONFIG_TYPE_INT_ARRAY, REQUIRED, 0, CPU_INDEX_MAX, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_aec_aff_cpus), CONFIG_RELOAD_PREPROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AEC_MAT_AFF_CPUS, CONFIG_TYPE_INT_ARRAY, REQUIRED, 0, CPU_INDEX_MAX, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_aec_mat_aff_cpus), CONFIG_RELOAD_PREPROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AEC_MAX_DELAY, CONFIG_TYPE_INT, OPTIONAL, 0, 1000, 200, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_aec_max_delay), CONFIG_RELOAD_PREPROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_RAW_STREAM_SL_DIRECTION, CONFIG_TYPE_FLOAT, REQUIRED, 0, 360, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_raw_stream_sl_direction), CONFIG_RELOAD_PROCESS},
+    {KEY_ALG_CONFIG, KEY_ALG_RAW_STREAM_BF, CONFIG_TYPE_BOOL, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_raw_stream_bf), CONFIG_RELOAD_PROCESS},
+    {KEY_ALG_CONFIG, KEY_ALG_RAW_STREAM_AGC, CONFIG_TYPE_BOOL, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_raw_stream_agc), CONFIG_RELOAD_PROCESS},
+    {KEY_ALG_CONFIG, KEY_ALG_RS_ENABLE, CONFIG_TYPE_BOOL, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_rs_enable), CONFIG_RELOAD_PREPROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_VT_ENABLE, CONFIG_TYPE_BOOL, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_vt_enable), CONFIG_RELOAD_PROCESS},
+    {KEY_ALG_CONFIG, KEY_ALG_VAD_ENABLE, CONFIG_TYPE_BOOL, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_vad_enable), CONFIG_RELOAD_LIVE},
+    {KEY_ALG_CONFIG, KEY_ALG_VAD_MICS, CONFIG_TYPE_INT_ARRAY, REQUIRED, 0, MIC_INDEX_MAX, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_vad_mics), CONFIG_RELOAD_PROCESS},
+    {KEY_ALG_CONFIG, KEY_ALG_VAD_BASERANGE, CONFIG_TYPE_FLOAT, REQUIRED, 0, 100, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_vad_baserange), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_VAD_DYNRANGE_MIN, CONFIG_TYPE_FLOAT, REQUIRED, 0, 100, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_vad_dynrange_min), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_VAD_DYNRANGE_MAX, CONFIG_TYPE_FLOAT, REQUIRED, 0, 100, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_vad_dynrange_max), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_BF_SCALING, CONFIG_TYPE_FLOAT, OPTIONAL, 0, 100, 1.0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_bf_scaling), CONFIG_RELOAD_LIVE},
+    {KEY_ALG_CONFIG, KEY_ALG_BF_PREROLL_MS, CONFIG_TYPE_INT, OPTIONAL, 0, 5000, 2500, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_bf_preroll_ms), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_BF_PREROLL_DIRS, CONFIG_TYPE_INT, OPTIONAL, 0, 16, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_bf_preroll_dirs), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_VT_GATE, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_vt_gate), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_VT_GATE_ONSET_DB, CONFIG_TYPE_FLOAT, OPTIONAL, 1, 40, 9.0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_vt_gate_onset_db), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_VT_GATE_HANGOVER_MS, CONFIG_TYPE_INT, OPTIONAL, 0, 10000, 2000, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_vt_gate_hangover_ms), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_VT_GATE_LOOKBACK_MS, CONFIG_TYPE_INT, OPTIONAL, 0, 2000, 600, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_vt_gate_lookback_ms), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AGC, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 1, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_agc), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AGC_TARGET_DB, CONFIG_TYPE_FLOAT, OPTIONAL, -40, -3, -18.0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_agc_target_db), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AGC_MAX_GAIN_DB, CONFIG_TYPE_FLOAT, OPTIONAL, 0, 40, 24.0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_agc_max_gain_db), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AGC_MIN_GAIN_DB, CONFIG_TYPE_FLOAT, OPTIONAL, -40, 0, -12.0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_agc_min_gain_db), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AGC_LIMIT_DB, CONFIG_TYPE_FLOAT, OPTIONAL, -20, 0, -1.0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_agc_limit_db), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AGC_ATTACK_MS, CONFIG_TYPE_FLOAT, OPTIONAL, 1, 1000, 10.0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_agc_attack_ms), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AGC_RELEASE_MS, CONFIG_TYPE_FLOAT, OPTIONAL, 10, 5000, 300.0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_agc_release_ms), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_AGC_GATE_DB, CONFIG_TYPE_FLOAT, OPTIONAL, 0, 40, 10.0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_agc_gate_db), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_NS, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_ns), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_NS_SLEEP, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_ns_sleep), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_NS_FLOOR_DB, CONFIG_TYPE_FLOAT, OPTIONAL, -40, 0, -12.0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_ns_floor_db), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_NEED_I2S_DELAY_MICS, CONFIG_TYPE_INT_ARRAY, REQUIRED, 0, MIC_INDEX_MAX, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_need_i2s_delay_mics), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_I2S_DELAY_MICS, CONFIG_TYPE_DOUBLE_ARRAY, REQUIRED, 0, 1, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_i2s_delay_mics), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_MIC_POS, CONFIG_TYPE_POS_ARRAY, REQUIRED, -10, 10, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_mic_pos), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_SL_MICS, CONFIG_TYPE_INT_ARRAY, REQUIRED, 0, MIC_INDEX_MAX, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_sl_mics), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_BF_MICS, CONFIG_TYPE_INT_ARRAY, REQUIRED, 0, MIC_INDEX_MAX, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_bf_mics), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_OPUS_COMPRESS, CONFIG_TYPE_BOOL, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_opus_compress), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_VT_PHOMOD, CONFIG_TYPE_STRING, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_vt_phomod), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_VT_DNNMOD, CONFIG_TYPE_STRING, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_vt_dnnmod), CONFIG_RELOAD_PROCESSOR},
+    {KEY_ALG_CONFIG, KEY_ALG_RS_DELAY_ON_LEFT_RIGHT_CHANNEL, CONFIG_TYPE_BOOL, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.alg_rs_delay_on_left_right_channel), CONFIG_RELOAD_PREPROCESSOR},
+    {KEY_ALG_CONFIG, KEY_RAW_STREAM_CHANNEL_NUM, CONFIG_TYPE_INT, REQUIRED, 1, 64, 0, nullptr, nullptr,
+        CONFIG_FIELD(raw_stream_config.raw_stream_channel_num), CONFIG_RELOAD_PROCESS},
+    {KEY_ALG_CONFIG, KEY_RAW_STREAM_SAMPLE_RATE, CONFIG_TYPE_INT, REQUIRED, 8000, 192000, 0, nullptr, nullptr,
+        CONFIG_FIELD(raw_stream_config.raw_stream_sample_rate), CONFIG_RELOAD_PROCESS},
+    {KEY_ALG_CONFIG, KEY_RAW_STREAM_BYTE, CONFIG_TYPE_INT, REQUIRED, 1, 4, 0, nullptr, nullptr,
+        CONFIG_FIELD(raw_stream_config.raw_stream_byte), CONFIG_RELOAD_PROCESS},
+    {KEY_ALG_CONFIG, KEY_ALG_DEF_VT, CONFIG_TYPE_VT_ARRAY, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(alg_config.def_vt_configs), CONFIG_RELOAD_PROCESSOR},
+
+    {KEY_DEBUG_CONFIG, KEY_DEBUG_MIC_ARRAY_RECORD, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(debug_config.mic_array_record), CONFIG_RELOAD_PROCESS},
+    {KEY_DEBUG_CONFIG, KEY_DEBUG_PRE_RESULT_RECORD, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(debug_config.preprocessed_result_record), CONFIG_RELOAD_PROCESS},
+    {KEY_DEBUG_CONFIG, KEY_DEBUG_PROC_RESULT_RECORD, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(debug_config.processed_result_record), CONFIG_RELOAD_PROCESS},
+    {KEY_DEBUG_CONFIG, KEY_DEBUG_RS_RECORD, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(debug_config.rs_record), CONFIG_RELOAD_PREPROCESSOR},
+    {KEY_DEBUG_CONFIG, KEY_DEBUG_AEC_RECORD, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(debug_config.aec_record), CONFIG_RELOAD_PREPROCESSOR},
+    {KEY_DEBUG_CONFIG, KEY_DEBUG_BF_RECORD, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(debug_config.bf_record), CONFIG_RELOAD_LIVE},
+    {KEY_DEBUG_CONFIG, KEY_DEBUG_BF_RAW_RECORD, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(debug_config.bf_raw_record), CONFIG_RELOAD_LIVE},
+    {KEY_DEBUG_CONFIG, KEY_DEBUG_VAD_RECORD, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(debug_config.vad_record), CONFIG_RELOAD_LIVE},
+    {KEY_DEBUG_CONFIG, KEY_DEBUG_OPU_RECORD, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(debug_config.debug_opu_record), CONFIG_RELOAD_LIVE},
+    {KEY_DEBUG_CONFIG, KEY_DEBUG_RECORD_PATH, CONFIG_TYPE_STRING, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        CONFIG_FIELD(debug_config.recording_path), CONFIG_RELOAD_PROCESS},
+};
+
+/* keys of every alg_def_vt object */
+static const std::vector<SirenConfigKey> vt_config_keys = {
+    {nullptr, KEY_VT_TYPE, CONFIG_TYPE_INT, REQUIRED, 1, 4, 0, nullptr, nullptr,
+        VT_FIELD(vt_type), CONFIG_RELOAD_PROCESSOR},
+    {nullptr, KEY_VT_WORD, CONFIG_TYPE_STRING, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        VT_FIELD(vt_word), CONFIG_RELOAD_PROCESSOR},
+    {nullptr, KEY_VT_PHONE, CONFIG_TYPE_STRING, REQUIRED, 0, 0, 0, nullptr, nullptr,
+        VT_FIELD(vt_phone), CONFIG_RELOAD_PROCESSOR},
+    {nullptr, KEY_VT_AVG_SCORE, CONFIG_TYPE_FLOAT, OPTIONAL, -100, 100, 0, nullptr, nullptr,
+        VT_FIELD(vt_avg_score), CONFIG_RELOAD_PROCESSOR},
+    {nullptr, KEY_VT_MIN_SCORE, CONFIG_TYPE_FLOAT, OPTIONAL, -100, 100, 0, nullptr, nullptr,
+        VT_FIELD(vt_min_score), CONFIG_RELOAD_PROCESSOR},
+    {nullptr, KEY_VT_LEFT_SIL_DET, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        VT_FIELD(vt_left_sil_det), CONFIG_RELOAD_PROCESSOR},
+    {nullptr, KEY_VT_RIGHT_SIL_DET, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        VT_FIELD(vt_right_sil_det), CONFIG_RELOAD_PROCESSOR},
+    {nullptr, KEY_VT_REMOTE_CHECK_WITH_AEC, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        VT_FIELD(vt_remote_check_with_aec), CONFIG_RELOAD_PROCESSOR},
+    {nullptr, KEY_VT_REMOTE_CHECK_WITHOUT_AEC, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        VT_FIELD(vt_remote_check_without_aec), CONFIG_RELOAD_PROCESSOR},
+    {nullptr, KEY_VT_LOCAL_CLASSIFY_CHECK, CONFIG_TYPE_BOOL, OPTIONAL, 0, 0, 0, nullptr, nullptr,
+        VT_FIELD(vt_local_classify_check), CONFIG_RELOAD_PROCESSOR},
+    {nullptr, KEY_VT_CLASSIFY_SHIELD, CONFIG_TYPE_FLOAT, OPTIONAL, -100, 100, 0, nullptr, nullptr,
+        VT_FIELD(vt_classify_shield), CONFIG_RELOAD_PROCESSOR},
+    {nullptr, KEY_NNET_PATH, CONFIG_TYPE_STRING, OPTIONAL, 0, 0, 0, "", nullptr,
+        VT_FIELD(vt_nnet_path), CONFIG_RELOAD_PROCESSOR},
+};
+
+static const char * const config_sections[] = {KEY_BASIC_CONFIG, KEY_ALG_CONFIG, KEY_DEBUG_CONFIG};
+
+const std::vector<SirenConfigKey> &siren_config_keys() {
+    return config_keys;
+}
+
+const std::vector<SirenConfigKey> &siren_vt_config_keys() {
+    return vt_config_keys;
+}
+
+static bool same_section(const char *a, const char *b) {
+    return a == b || (a != nullptr && b != nullptr && !strcmp(a, b));
+}
+
+static std::string format(const char *fmt, ...) PRINTF_FORMAT(1, 2);
+
+static std::string format(const char *fmt, ...) {
+    char buf[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return buf;
+}
+
+static const char *type_name(int type) {
+    switch (type) {
+    case CONFIG_TYPE_BOOL:
+        return "bool";
+    case CONFIG_TYPE_INT:
+    case CONFIG_TYPE_SIZE:
+        return "int";
+    case CONFIG_TYPE_FLOAT:
+        return "number";
+    case CONFIG_TYPE_ENUM:
+    case CONFIG_TYPE_STRING:
+        return "string";
+    case CONFIG_TYPE_INT_ARRAY:
+        return "array of int";
+    case CONFIG_TYPE_DOUBLE_ARRAY:
+        return "array of number";
+    case CONFIG_TYPE_POS_ARRAY:
+        return "array of number arrays";
+    case CONFIG_TYPE_VT_ARRAY:
+        return "array of objects";
+    default:
+        return "unknown";
+    }
+}
+
+static size_t edit_distance(const char *a, const char *b) {
+    size_t la = strlen(a);
+    size_t lb = strlen(b);
+    std::vector<size_t> row(lb + 1);
+    for (size_t j = 0; j <= lb; j++) {
+        row[j] = j;
+    }
+    for (size_t i = 1; i <= la; i++) {
+        size_t diag = row[0];
+        row[0] = i;
+        for (size_t j = 1; j <= lb; j++) {
+            size_t up = row[j];
+            size_t cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1), diag + cost);
+            diag = up;
+        }
+    }
+    return row[lb];
+}
+
+/* same key in other section, or a close spelling in this one */
+static std::string suggest_key(const std::vector<SirenConfigKey> &keys, const char *section, const char *key) {
+    const SirenConfigKey *best = nullptr;
+    size_t best_distance = 3;
+    for (const SirenConfigKey &k : keys) {
+        if (!strcmp(k.key, key)) {
+            return format(", belongs to %s", k.section);
+        }
+        if (!same_section(k.section, section)) {
+            continue;
+        }
+        size_t distance = edit_distance(k.key, key);
+        if (distance < best_distance) {
+            best_distance = distance;
+            best = &k;
+        }
+    }
+    return best != nullptr ? format(", did you mean %s", best->key) : std::string();
+}
+
+static bool get_number(json_object *value, bool integer, double &number) {
+    json_type type = json_object_get_type(value);
+    if (type == json_type_int) {
+        number = (double)json_object_get_int64(value);
+        return true;
+    }
+    if (type == json_type_double && !integer) {
+        number = json_object_get_double(value);
+        return true;
+    }
+    return false;
+}
+
+static bool check_number(const SirenConfigKey &k, json_object *value, bool integer, double &number,
+                         const std::string &name, SirenConfigReport &report) {
+    if (!get_number(value, integer, number)) {
+        report.errors.push_back(format("%s: expect %s, got %s", name.c_str(),
+                                       integer ? "int" : "number", json_object_to_json_string(value)));
+        return false;
+    }
+    if (number < k.min || number > k.max) {
+        report.errors.push_back(format("%s: %s out of range [%g, %g]", name.c_str(),
+                                       json_object_to_json_string(value), k.min, k.max));
+        return false;
+    }
+    return true;
+}
+
+static void load_object(const std::vector<SirenConfigKey> &keys, const char *section,
+                        json_object *object, void *base, const std::string &prefix,
+                        SirenConfigReport &report);
+
+static void load_value(const SirenConfigKey &k, json_object *value, void *field,
+                       const std::string &name, SirenConfigReport &report) {
+    json_type type = json_object_get_type(value);
+    double number;
+
+    if (k.type >= CONFIG_TYPE_INT_ARRAY && type != json_type_array) {
+        report.errors.push_back(format("%s: expect %s", name.c_str(), type_name(k.type)));
+        return;
+    }
+
+    switch (k.type) {
+    case CONFIG_TYPE_BOOL:
+        if (type != json_type_boolean) {
+            report.errors.push_back(format("%s: expect bool, got %s", name.c_str(),
+                                           json_object_to_json_string(value)));
+            return;
+        }
+        *static_cast<bool *>(field) = json_object_get_boolean(value);
+        break;
+    case CONFIG_TYPE_INT:
+        if (check_number(k, value, true, number, name, report)) {
+            *static_cast<int *>(field) = (int)number;
+        }
+        break;
+    case CONFIG_TYPE_SIZE:
+        if (check_number(k, value, true, number, name, report)) {
+            *static_cast<unsigned long *>(field) = (unsigned long)number;
+        }
+        break;
+    case CONFIG_TYPE_FLOAT:
+        if (check_number(k, value, false, number, name, report)) {
+            *static_cast<float *>(field) = (float)number;
+        }
+        break;
+    case CONFIG_TYPE_ENUM:
+    case CONFIG_TYPE_STRING: {
+        if (type != json_type_string) {
+            report.errors.push_back(format("%s: expect string, got %s", name.c_str(),
+                                           json_object_to_json_string(value)));
+            return;
+        }
+        const char *s = json_object_get_string(value);
+        if (k.type == CONFIG_TYPE_STRING) {
+            *static_cast<std::string *>(field) = s;
+            break;
+        }
+        std::string choices;
+        for (int i = 0; k.names[i] != nullptr; i++) {
+            if (!strcmp(k.names[i], s)) {
+                *static_cast<int *>(field) = i;
+                return;
+            }
+            choices.append(i ? "|" : "").append(k.names[i]);
+        }
+        report.errors.push_back(format("%s: \"%s\" not one of %s", name.c_str(), s, choices.c_str()));
+        break;
+    }
+    case CONFIG_TYPE_INT_ARRAY: {
+        std::vector<int> &to = *static_cast<std::vector<int> *>(field);
+        int len = json_object_array_length(value);
+        to.clear();
+        for (int i = 0; i < len; i++) {
+            if (check_number(k, json_object_array_get_idx(value, i), true, number,
+                             format("%s[%d]", name.c_str(), i), report)) {
+                to.push_back((int)number);
+            }
+        }
+        break;
+    }
+    case CONFIG_TYPE_DOUBLE_ARRAY: {
+        std::vector<double> &to = *static_cast<std::vector<double> *>(field);
+        int len = json_object_array_length(value);
+        to.clear();
+        for (int i = 0; i < len; i++) {
+            if (check_number(k, json_object_array_get_idx(value, i), false, number,
+                             format("%s[%d]", name.c_str(), i), report)) {
+                to.push_back(number);
+            }
+        }
+        break;
+    }
+    case CONFIG_TYPE_POS_ARRAY: {
+        std::vector<MicPos> &to = *static_cast<std::vector<MicPos> *>(field);
+        int len = json_object_array_length(value);
+        to.clear();
+        for (int i = 0; i < len; i++) {
+            json_object *pos = json_object_array_get_idx(value, i);
+            if (json_object_get_type(pos) != json_type_array) {
+                report.errors.push_back(format("%s[%d]: expect array of number", name.c_str(), i));
+                continue;
+            }
+            MicPos mic;
+            int n = json_object_array_length(pos);
+            for (int j = 0; j < n; j++) {
+                if (check_number(k, json_object_array_get_idx(pos, j), false, number,
+                                 format("%s[%d][%d]", name.c_str(), i, j), report)) {
+                    mic.pos.push_back(number);
+                }
+            }
+            to.push_back(mic);
+        }
+        break;
+    }
+    case CONFIG_TYPE_VT_ARRAY: {
+        std::vector<DefVTConfig> &to = *static_cast<std::vector<DefVTConfig> *>(field);
+        int len = json_object_array_length(value);
+        to.clear();
+        for (int i = 0; i < len; i++) {
+            json_object *vt = json_object_array_get_idx(value, i);
+            std::string vt_name = format("%s[%d]", name.c_str(), i);
+            if (json_object_get_type(vt) != json_type_object) {
+                report.errors.push_back(format("%s: expect object", vt_name.c_str()));
+                continue;
+            }
+            DefVTConfig config;
+            load_object(vt_config_keys, nullptr, vt, &config, vt_name, report);
+            to.push_back(config);
+        }
+        break;
+    }
+    }
+}
+
+static void load_default(const SirenConfigKey &k, void *field) {
+    switch (k.type) {
+    case CONFIG_TYPE_BOOL:
+        *static_cast<bool *>(field) = k.def != 0;
+        break;
+    case CONFIG_TYPE_INT:
+    case CONFIG_TYPE_ENUM:
+        *static_cast<int *>(field) = (int)k.def;
+        break;
+    case CONFIG_TYPE_SIZE:
+        *static_cast<unsigned long *>(field) = (unsigned long)k.def;
+        break;
+    case CONFIG_TYPE_FLOAT:
+        *static_cast<float *>(field) = (float)k.def;
+        break;
+    case CONFIG_TYPE_STRING:
+        *static_cast<std::string *>(field) = k.def_str != nullptr ? k.def_str : "";
+        break;
+    case CONFIG_TYPE_INT_ARRAY:
+        static_cast<std::vector<int> *>(field)->clear();
+        break;
+    case CONFIG_TYPE_DOUBLE_ARRAY:
+        static_cast<std::vector<double> *>(field)->clear();
+        break;
+    case CONFIG_TYPE_POS_ARRAY:
+        static_cast<std::vector<MicPos> *>(field)->clear();
+        break;
+    case CONFIG_TYPE_VT_ARRAY:
+        static_cast<std::vector<DefVTConfig> *>(field)->clear();
+        break;
+    }
+}
+
+/* every member of object against keys of section, then what is missing */
+static void load_object(const std::vector<SirenConfigKey> &keys, const char *section,
+                        json_object *object, void *base, const std::string &prefix,
+                        SirenConfigReport &report) {
+    std::vector<bool> seen(keys.size(), false);
+
+    json_object_object_foreach(object, key, value) {
+        if (key == nullptr) {
+            continue;
+        }
+        size_t i = 0;
+        for (; i < keys.size(); i++) {
+            if (same_section(keys[i].section, section) && !strcmp(keys[i].key, key)) {
+                break;
+            }
+        }
+        std::string name = prefix + "." + key;
+        if (i == keys.size()) {
+            report.warnings.push_back(format("unknown key %s%s", name.c_str(),
+                                             suggest_key(keys, section, key).c_str()));
+            continue;
+        }
+        seen[i] = true;
+        load_value(keys[i], value, keys[i].field(base), name, report);
+    }
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (seen[i] || !same_section(keys[i].section, section)) {
+            continue;
+        }
+        if (keys[i].required) {
+            report.errors.push_back(format("%s.%s: missing", prefix.c_str(), keys[i].key));
+        } else {
+            load_default(keys[i], keys[i].field(base));
+        }
+    }
+}
+
+/* relations between keys the table can not say */
+static void check_config(const SirenConfig &config, SirenConfigReport &report) {
+    const AlgConfig &alg = config.alg_config;
+    /* lists of a disabled stage are left as they are in shipped configs */
+    struct {
+        const char *key;
+        const std::vector<int> *mics;
+        bool used;
+    } mic_lists[] = {
+        {KEY_ALG_RS_MICS, &alg.alg_rs_mics, true},
+        {KEY_ALG_AEC_MICS, &alg.alg_aec_mics, alg.alg_aec},
+        {KEY_ALG_AEC_REF_MICS, &alg.alg_aec_ref_mics, alg.alg_aec},
+        {KEY_ALG_VAD_MICS, &alg.alg_vad_mics, alg.alg_vad_enable},
+        {KEY_ALG_NEED_I2S_DELAY_MICS, &alg.alg_need_i2s_delay_mics, true},
+        {KEY_ALG_SL_MICS, &alg.alg_sl_mics, true},
+        {KEY_ALG_BF_MICS, &alg.alg_bf_mics, true},
+    };
+
+    if (config.mic_frame_length > 0 && 1000 % config.mic_frame_length != 0) {
+        report.errors.push_back(format("%s.%s: %d ms not divide a second", KEY_BASIC_CONFIG,
+                                       KEY_MIC_FRAME_LENGTH, config.mic_frame_length));
+    }
+    for (auto &list : mic_lists) {
+        for (size_t i = 0; list.used && i < list.mics->size(); i++) {
+            if ((*list.mics)[i] >= config.mic_channel_num) {
+                report.errors.push_back(format("%s.%s[%zu]: mic %d not less than %s %d", KEY_ALG_CONFIG,
+                                               list.key, i, (*list.mics)[i], KEY_MIC_CHANNEL_NUM,
+                                               config.mic_channel_num));
+            }
+        }
+    }
+    if (alg.alg_i2s_delay_mics.size() != alg.alg_need_i2s_delay_mics.size()) {
+        report.errors.push_back(format("%s.%s: %zu delays for %zu %s", KEY_ALG_CONFIG, KEY_ALG_I2S_DELAY_MICS,
+                                       alg.alg_i2s_delay_mics.size(), alg.alg_need_i2s_delay_mics.size(),
+                                       KEY_ALG_NEED_I2S_DELAY_MICS));
+    }
+    if (alg.alg_vad_dynrange_min > alg.alg_vad_dynrange_max) {
+        report.errors.push_back(format("%s.%s: %g above %s %g", KEY_ALG_CONFIG, KEY_ALG_VAD_DYNRANGE_MIN,
+                                       alg.alg_vad_dynrange_min, KEY_ALG_VAD_DYNRANGE_MAX,
+                                       alg.alg_vad_dynrange_max));
+    }
+}
+
+config_error_t parse_siren_config(const char *json, size_t len, SirenConfig &config,
+                                  SirenConfigReport &report) {
+    json_tokener *tokener = json_tokener_new();
+    if (tokener == nullptr) {
+        report.errors.push_back("alloc json tokener failed");
+        return CONFIG_ERROR_UNKNOWN;
+    }
+
+    json_object *root = json_tokener_parse_ex(tokener, json, (int)len);
+    enum json_tokener_error error = json_tokener_get_error(tokener);
+    size_t end = tokener->char_offset;
+    json_tokener_free(tokener);
+
+    if (root == nullptr || error != json_tokener_success) {
+        report.errors.push_back(format("json %s at offset %zu",
+                                       error == json_tokener_continue ? "truncated" : json_tokener_error_desc(error),
+                                       end));
+        json_object_put(root);
+        return CONFIG_ERROR_PARSE_FAIL;
+    }
+    while (end < len && (json[end] == ' ' || json[end] == '\t' || json[end] == '\n' || json[end] == '\r')) {
+        end++;
+    }
+    if (end < len && json[end] != '\0') {
+        report.errors.push_back(format("trailing data at offset %zu", end));
+    }
+    if (json_object_get_type(root) != json_type_object) {
+        report.errors.push_back("config is not a json object");
+        json_object_put(root);
+        return CONFIG_ERROR_PARSE_FAIL;
+    }
+
+    config = SirenConfig();
+    json_object_object_foreach(root, key, value) {
+        bool known = false;
+        for (const char *section : config_sections) {
+            known = known || !strcmp(key, section);
+        }
+        if (!known) {
+            report.warnings.push_back(format("unknown section %s", key));
+        }
+        SIREN_UNUSED(value);
+    }
+    for (const char *section : config_sections) {
+        json_object *object = nullptr;
+        if (TRUE != json_object_object_get_ex(root, section, &object)) {
+            report.errors.push_back(format("%s: missing", section));
+            continue;
+        }
+        if (json_object_get_type(object) != json_type_object) {
+            report.errors.push_back(format("%s: expect object", section));
+            continue;
+        }
+        load_object(config_keys, section, object, &config, section, report);
+    }
+    json_object_put(root);
+
+    if (report.errors.empty()) {
+        check_config(config, report);
+    }
+    finish_siren_config(config);
+    return report.errors.empty() ? CONFIG_OK : CONFIG_ERROR_PARSE_FAIL;
+}
+
+void finish_siren_config(SirenConfig &config) {
+    config.siren_use_share_mem = config.siren_ipc != CONFIG_IPC_CHANNEL;
+    config.alg_config.alg_use_legacy_vt_config_file = config.alg_config.alg_use_legacy_ssp_config_file;
+}
+
+#define SNAPSHOT_MAGIC 0x46435342 /* "BSCF" */
+
+struct SnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    /* changes when keys or their types change */
+    uint32_t schema;
+    uint32_t payload_size;
+    uint32_t checksum;
+    uint32_t reserved;
+    uint64_t source_device;
+    uint64_t source_inode;
+    uint64_t source_size;
+    int64_t source_mtime_sec;
+    int64_t source_mtime_nsec;
+};
+
+static uint32_t fnv1a(const void *data, size_t len, uint32_t hash = 2166136261u) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t schema_hash() {
+    static uint32_t hash = 0;
+    if (hash == 0) {
+        uint32_t h = 2166136261u;
+        for (const std::vector<SirenConfigKey> *keys : {&config_keys, &vt_config_keys}) {
+            for (const SirenConfigKey &k : *keys) {
+                if (k.section != nullptr) {
+                    h = fnv1a(k.section, strlen(k.section), h);
+                }
+                h = fnv1a(k.key, strlen(k.key) + 1, h);
+                h = fnv1a(&k.type, sizeof(k.type), h);
+            }
+        }
+        hash = h;
+    }
+    return hash;
+}
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(std::string &out) : out(out) {}
+
+    template <typename T>
+    void put(T value) {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void put_string(const std::string &s) {
+        put<uint32_t>(s.size());
+        out.append(s);
+    }
+
+private:
+    std::string &out;
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader(const char *data, size_t len) : p(data), end(data + len) {}
+
+    template <typename T>
+    bool get(T &value) {
+        if ((size_t)(end - p) < sizeof(T)) {
+            return false;
+        }
+        memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    bool get_string(std::string &s) {
+        uint32_t n;
+        if (!get(n) || (size_t)(end - p) < n) {
+            return false;
+        }
+        s.assign(p, n);
+        p += n;
+        return true;
+    }
+
+    /* count of n byte items that can follow */
+    bool get_count(uint32_t &count, size_t item) {
+        return get(count) && (size_t)(end - p) >= (size_t)count * item;
+    }
+
+    bool done() const {
+        return p == end;
+    }
+
+private:
+    const char *p;
+    const char *end;
+};
+
+static void encode_object(const std::vector<SirenConfigKey> &keys, const void *base, SnapshotWriter &w);
+
+static void encode_value(const SirenConfigKey &k, const void *field, SnapshotWriter &w) {
+    switch (k.type) {
+    case CONFIG_TYPE_BOOL:
+        w.put<uint8_t>(*static_cast<const bool *>(field) ? 1 : 0);
+        break;
+    case CONFIG_TYPE_INT:
+    case CONFIG_TYPE_ENUM:
+        w.put<int32_t>(*static_cast<const int *>(field));
+        break;
+    case CONFIG_TYPE_SIZE:
+        w.put<uint64_t>(*static_cast<const unsigned long *>(field));
+        break;
+    case CONFIG_TYPE_FLOAT:
+        w.put<float>(*static_cast<const float *>(field));
+        break;
+    case CONFIG_TYPE_STRING:
+        w.put_string(*static_cast<const std::string *>(field));
+        break;
+    case CONFIG_TYPE_INT_ARRAY: {
+        const std::vector<int> &v = *static_cast<const std::vector<int> *>(field);
+        w.put<uint32_t>(v.size());
+        for (int i : v) {
+            w.put<int32_t>(i);
+        }
+        break;
+    }
+    case CONFIG_TYPE_DOUBLE_ARRAY: {
+        const std::vector<double> &v = *static_cast<const std::vector<double> *>(field);
+        w.put<uint32_t>(v.size());
+        for (double d : v) {
+            w.put<double>(d);
+        }
+        break;
+    }
+    case CONFIG_TYPE_POS_ARRAY: {
+        const std::vector<MicPos> &v = *static_cast<const std::vector<MicPos> *>(field);
+        w.put<uint32_t>(v.size());
+        for (const MicPos &mic : v) {
+            w.put<uint32_t>(mic.pos.size());
+            for (long double d : mic.pos) {
+                w.put<double>((double)d);
+            }
+        }
+        break;
+    }
+    case CONFIG_TYPE_VT_ARRAY: {
+        const std::vector<DefVTConfig> &v = *static_cast<const std::vector<DefVTConfig> *>(field);
+        w.put<uint32_t>(v.size());
+        for (const DefVTConfig &vt : v) {
+            encode_object(vt_config_keys, &vt, w);
+        }
+        break;
+    }
+    }
+}
+
+static void encode_object(const std::vector<SirenConfigKey> &keys, const void *base, SnapshotWriter &w) {
+    for (const SirenConfigKey &k : keys) {
+        encode_value(k, k.field(const_cast<void *>(base)), w);
+    }
+}
+
+static bool decode_object(const std::vector<SirenConfigKey> &keys, void *base, SnapshotReader &r);
+
+static bool decode_value(const SirenConfigKey &k, void *field, SnapshotReader &r) {
+    uint32_t count;
+    switch (k.type) {
+    case CONFIG_TYPE_BOOL: {
+        uint8_t b;
+        if (!r.get(b)) {
+            return false;
+        }
+        *static_cast<bool *>(field) = b != 0;
+        return true;
+    }
+    case CONFIG_TYPE_INT:
+    case CONFIG_TYPE_ENUM: {
+        int32_t i;
+        if (!r.get(i)) {
+            return false;
+        }
+        *static_cast<int *>(field) = i;
+        return true;
+    }
+    case CONFIG_TYPE_SIZE: {
+        uint64_t u;
+        if (!r.get(u)) {
+            return false;
+        }
+        *static_cast<unsigned long *>(field) = (unsigned long)u;
+        return true;
+    }
+    case CONFIG_TYPE_FLOAT:
+        return r.get(*static_cast<float *>(field));
+    case CONFIG_TYPE_STRING:
+        return r.get_string(*static_cast<std::string *>(field));
+    case CONFIG_TYPE_INT_ARRAY: {
+        std::vector<int> &v = *static_cast<std::vector<int> *>(field);
+        if (!r.get_count(count, sizeof(int32_t))) {
+            return false;
+        }
+        v.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            int32_t n = 0;
+            r.get(n);
+            v[i] = n;
+        }
+        return true;
+    }
+    case CONFIG_TYPE_DOUBLE_ARRAY: {
+        std::vector<double> &v = *static_cast<std::vector<double> *>(field);
+        if (!r.get_count(count, sizeof(double))) {
+            return false;
+        }
+        v.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            r.get(v[i]);
+        }
+        return true;
+    }
+    case CONFIG_TYPE_POS_ARRAY: {
+        std::vector<MicPos> &v = *static_cast<std::vector<MicPos> *>(field);
+        if (!r.get_count(count, sizeof(uint32_t))) {
+            return false;
+        }
+        v.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t n;
+            if (!r.get_count(n, sizeof(double))) {
+                return false;
+            }
+            v[i].pos.resize(n);
+            for (uint32_t j = 0; j < n; j++) {
+                double d = 0;
+                r.get(d);
+                v[i].pos[j] = d;
+            }
+        }
+        return true;
+    }
+    case CONFIG_TYPE_VT_ARRAY: {
+        std::vector<DefVTConfig> &v = *static_cast<std::vector<DefVTConfig> *>(field);
+        /* each vt has at least its three strings */
+        if (!r.get_count(count, 3 * sizeof(uint32_t))) {
+            return false;
+        }
+        v.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            if (!decode_object(vt_config_keys, &v[i], r)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+static bool decode_object(const std::vector<SirenConfigKey> &keys, void *base, SnapshotReader &r) {
+    for (const SirenConfigKey &k : keys) {
+        if (!decode_value(k, k.field(base), r)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void encode_siren_config_snapshot(const SirenConfig &config, const SirenConfigSource &source,
+                                  std::string &snapshot) {
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    snapshot.assign(sizeof(header), '\0');
+
+    SnapshotWriter w(snapshot);
+    encode_object(config_keys, &config, w);
+
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SIREN_CONFIG_SNAPSHOT_VERSION;
+    header.schema = schema_hash();
+    header.payload_size = snapshot.size() - sizeof(header);
+    header.checksum = fnv1a(snapshot.data() + sizeof(header), header.payload_size);
+    header.source_device = source.device;
+    header.source_inode = source.inode;
+    header.source_size = source.size;
+    header.source_mtime_sec = source.mtime_sec;
+    header.source_mtime_nsec = source.mtime_nsec;
+    memcpy(&snapshot[0], &header, sizeof(header));
+}
+
+bool decode_siren_config_snapshot(const char *data, size_t len, const SirenConfigSource &source,
+                                  SirenConfig &config) {
+    SnapshotHeader header;
+    if (data == nullptr || len < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SIREN_CONFIG_SNAPSHOT_VERSION
+        || header.schema != schema_hash()) {
+        siren_printf(SIREN_INFO, "config snapshot of other version");
+        return false;
+    }
+    if (header.source_device != source.device || header.source_inode != source.inode
+        || header.source_size != source.size || header.source_mtime_sec != source.mtime_sec
+        || header.source_mtime_nsec != source.mtime_nsec) {
+        siren_printf(SIREN_INFO, "config changed since snapshot");
+        return false;
+    }
+    const char *payload = data + sizeof(header);
+    if (header.payload_size != len - sizeof(header)
+        || header.checksum != fnv1a(payload, header.payload_size)) {
+        siren_printf(SIREN_WARNING, "config snapshot corrupt");
+        return false;
+    }
+
+    SirenConfig decoded;
+    SnapshotReader r(payload, header.payload_size);
+    if (!decode_object(config_keys, &decoded, r) || !r.done()) {
+        siren_printf(SIREN_WARNING, "config snapshot not match schema");
+        return false;
+    }
+    finish_siren_config(decoded);
+    config = decoded;
+    return true;
+}
+
+static std::string value_string(const SirenConfigKey &k, const void *field) {
+    std::string s;
+    switch (k.type) {
+    case CONFIG_TYPE_BOOL:
+        return *static_cast<const bool *>(field) ? "true" : "false";
+    case CONFIG_TYPE_INT:
+        return format("%d", *static_cast<const int *>(field));
+    case CONFIG_TYPE_ENUM:
+        return k.names[*static_cast<const int *>(field)];
+    case CONFIG_TYPE_SIZE:
+        return format("%lu", *static_cast<const unsigned long *>(field));
+    case CONFIG_TYPE_FLOAT:
+        return format("%g", *static_cast<const float *>(field));
+    case CONFIG_TYPE_STRING:
+        return *static_cast<const std::string *>(field);
+    case CONFIG_TYPE_INT_ARRAY:
+        for (int i : *static_cast<const std::vector<int> *>(field)) {
+            s.append(format("%d ", i));
+        }
+        return s;
+    case CONFIG_TYPE_DOUBLE_ARRAY:
+        for (double d : *static_cast<const std::vector<double> *>(field)) {
+            s.append(format("%g ", d));
+        }
+        return s;
+    case CONFIG_TYPE_POS_ARRAY:
+        for (const MicPos &mic : *static_cast<const std::vector<MicPos> *>(field)) {
+            s.append("(");
+            for (long double d : mic.pos) {
+                s.append(format(" %g", (double)d));
+            }
+            s.append(" ) ");
+        }
+        return s;
+    case CONFIG_TYPE_VT_ARRAY:
+        for (const DefVTConfig &vt : *static_cast<const std::vector<DefVTConfig> *>(field)) {
+            s.append(vt.vt_word).append(format("(%d) ", vt.vt_type));
+        }
+        return s;
+    default:
+        return s;
+    }
+}
+
+void dump_siren_config(const SirenConfig &config) {
+    for (const SirenConfigKey &k : config_keys) {
+        std::string value = value_string(k, k.field(const_cast<SirenConfig *>(&config)));
+        siren_printf(SIREN_INFO, "%s.%s: %s", k.section, k.key, value.c_str());
+    }
+}
+
+void diff_siren_config(const SirenConfig &from, const SirenConfig &to, SirenConfigChange &change) {
+    change = SirenConfigChange();
+    for (const SirenConfigKey &k : config_keys) {
+        /* same encoding is same value, whatever the type */
+        std::string a;
+        std::string b;
+        SnapshotWriter wa(a);
+        SnapshotWriter wb(b);
+        encode_value(k, k.field(const_cast<SirenConfig *>(&from)), wa);
+        encode_value(k, k.field(const_cast<SirenConfig *>(&to)), wb);
+        if (a == b) {
+            continue;
+        }
+        change.keys.push_back(format("%s.%s", k.section, k.key));
+        if (k.reload == CONFIG_RELOAD_PROCESS) {
+            change.restart = true;
+        }
+        change.reload |= k.reload;
+    }
+}
+
+}
@@ -0,0 +1,197 @@
+#include <deque>
+#include <thread>
+#include <condition_variable>
+
+#include "sutils.h"
+#include "siren_event_hub.h"
+
+namespace BlackSiren {
+
+struct SirenEventHub::Subscriber : public std::enable_shared_from_this<Subscriber> {
+    Subscriber(siren_sub_t id_, const siren_subscriber_t &config_) :
+        id(id_),
+        config(config_) {}
+
+    bool takes(const voice_event_t &event) const;
+    void offer(SirenEventBlock *block);
+    void start();
+    void stop();
+    void run();
+
+    siren_sub_t id;
+    siren_subscriber_t config;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<SirenEventBlock *> queue;
+    bool stopping = false;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    std::thread thread;
+};
+
+bool SirenEventHub::Subscriber::takes(const voice_event_t &event) const {
+    if (config.events != 0) {
+        int bit = event.event - SIREN_EVENT_VAD_START;
+        if (bit < 0 || bit >= 32 || (config.events & (1u << bit)) == 0) {
+            return false;
+        }
+    }
+    return config.flags == 0 || (event.flag & config.flags) != 0;
+}
+
+void SirenEventHub::Subscriber::offer(SirenEventBlock *block) {
+    SirenEventBlock *drop = nullptr;
+    {
+        std::lock_guard<decltype(mutex)> l_(mutex);
+        if (stopping) {
+            return;
+        }
+        if ((int)queue.size() >= config.queue_len) {
+            dropped++;
+            if (config.drop_policy == SIREN_DROP_NEWEST) {
+                return;
+            }
+            drop = queue.front();
+            queue.pop_front();
+        }
+        block->pool->ref(block);
+        queue.push_back(block);
+        cond.notify_one();
+    }
+    if (drop != nullptr) {
+        drop->pool->unref(drop);
+    }
+}
+
+void SirenEventHub::Subscriber::start() {
+    //thread keeps subscriber alive, it may outlive the hub entry
+    std::shared_ptr<Subscriber> self = shared_from_this();
+    thread = std::thread([self] {
+        self->run();
+    });
+}
+
+void SirenEventHub::Subscriber::stop() {
+    {
+        std::lock_guard<decltype(mutex)> l_(mutex);
+        stopping = true;
+        cond.notify_one();
+    }
+    if (thread.get_id() == std::this_thread::get_id()) {
+        //unsubscribed from its own callback, thread ends after it returns
+        thread.detach();
+    } else if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void SirenEventHub::Subscriber::run() {
+    while (1) {
+        SirenEventBlock *block = nullptr;
+        {
+            std::unique_lock<decltype(mutex)> l_(mutex);
+            cond.wait(l_, [this] {
+                return stopping || !queue.empty();
+            });
+            if (stopping) {
+                break;
+            }
+            block = queue.front();
+            queue.pop_front();
+        }
+
+        config.voice_event_callback(config.token, &block->event);
+        block->pool->unref(block);
+        std::lock_guard<decltype(mutex)> l_(mutex);
+        delivered++;
+    }
+
+    std::lock_guard<decltype(mutex)> l_(mutex);
+    for (SirenEventBlock *block : queue) {
+        block->pool->unref(block);
+    }
+    queue.clear();
+}
+
+std::shared_ptr<const SirenEventHub::SubscriberList> SirenEventHub::snapshot() {
+    std::lock_guard<decltype(listMutex)> l_(listMutex);
+    return subscribers;
+}
+
+siren_sub_t SirenEventHub::subscribe(const siren_subscriber_t &subscriber) {
+    if (subscriber.voice_event_callback == nullptr || subscriber.queue_len < 1) {
+        siren_printf(SIREN_ERROR, "subscriber without callback or queue");
+        return -1;
+    }
+
+    std::lock_guard<decltype(listMutex)> l_(listMutex);
+    std::shared_ptr<Subscriber> sub = std::make_shared<Subscriber>(nextId++, subscriber);
+    sub->start();
+    std::shared_ptr<SubscriberList> next = std::make_shared<SubscriberList>(*subscribers);
+    next->push_back(sub);
+    subscribers = next;
+    siren_printf(SIREN_INFO, "subscriber %d events 0x%x flags 0x%x queue %d", sub->id,
+                 subscriber.events, subscriber.flags, subscriber.queue_len);
+    return sub->id;
+}
+
+bool SirenEventHub::unsubscribe(siren_sub_t id) {
+    std::shared_ptr<Subscriber> sub;
+    {
+        std::lock_guard<decltype(listMutex)> l_(listMutex);
+        std::shared_ptr<SubscriberList> next = std::make_shared<SubscriberList>();
+        for (const std::shared_ptr<Subscriber> &s : *subscribers) {
+            if (s->id == id) {
+                sub = s;
+            } else {
+                next->push_back(s);
+            }
+        }
+        subscribers = next;
+    }
+    if (sub == nullptr) {
+        return false;
+    }
+    sub->stop();
+    siren_printf(SIREN_INFO, "subscriber %d gone, delivered %llu dropped %llu", id,
+                 (unsigned long long)sub->delivered, (unsigned long long)sub->dropped);
+    return true;
+}
+
+bool SirenEventHub::getStats(siren_sub_t id, siren_subscriber_stats_t &stats) {
+    std::shared_ptr<const SubscriberList> list = snapshot();
+    for (const std::shared_ptr<Subscriber> &s : *list) {
+        if (s->id == id) {
+            std::lock_guard<decltype(s->mutex)> l_(s->mutex);
+            stats.delivered = s->delivered;
+            stats.dropped = s->dropped;
+            stats.queued = s->queue.size();
+            return true;
+        }
+    }
+    return false;
+}
+
+void SirenEventHub::clear() {
+    std::shared_ptr<const SubscriberList> list;
+    {
+        std::lock_guard<decltype(listMutex)> l_(listMutex);
+        list = subscribers;
+        subscribers = std::make_shared<SubscriberList>();
+    }
+    for (const std::shared_ptr<Subscriber> &s : *list) {
+        s->stop();
+    }
+}
+
+void SirenEventHub::publish(SirenEventBlock *block) {
+    std::shared_ptr<const SubscriberList> list = snapshot();
+    for (const std::shared_ptr<Subscriber> &s : *list) {
+        if (s->takes(block->event)) {
+            s->offer(block);
+        }
+    }
+}
+
+}
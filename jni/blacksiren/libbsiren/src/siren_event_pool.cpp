@@ -0,0 +1,144 @@
+#include <string.h>
+#include <new>
+
+#include "siren_channel.h"
+#include "siren_event_pool.h"
+
+namespace BlackSiren {
+
+SirenEventBlock *SirenEventBlock::fromData(void *data) {
+    return (SirenEventBlock *)((char *)data - sizeof(Message) - sizeof(SirenEventBlock));
+}
+
+SirenEventPool &SirenEventPool::instance() {
+    // never destroyed, blocks may be released during exit
+    static SirenEventPool *pool = new SirenEventPool;
+    return *pool;
+}
+
+SirenEventPool::SirenEventPool() :
+    allocated(0),
+    reused(0),
+    outstanding(0),
+    cached(0) {
+    for (int i = 0; i < SIZE_CLASSES; i++) {
+        freeList[i].reserve(MAX_CACHED_PER_CLASS);
+    }
+}
+
+SirenEventPool::~SirenEventPool() {
+    trim();
+}
+
+SirenEventBlock *SirenEventPool::obtain(int msg, int len) {
+    int total = sizeof(SirenEventBlock) + sizeof(Message) + len;
+    int sizeClass = 0;
+    while (sizeClass < SIZE_CLASSES && (1 << (MIN_SIZE_SHIFT + sizeClass)) < total) {
+        sizeClass++;
+    }
+
+    SirenEventBlock *block = nullptr;
+    {
+        std::lock_guard<decltype(poolMutex)> l_(poolMutex);
+        if (sizeClass < SIZE_CLASSES && !freeList[sizeClass].empty()) {
+            block = freeList[sizeClass].back();
+            freeList[sizeClass].pop_back();
+            cached--;
+            reused++;
+        } else {
+            allocated++;
+        }
+        outstanding++;
+    }
+
+    if (block == nullptr) {
+        int capacity = total;
+        if (sizeClass < SIZE_CLASSES) {
+            capacity = 1 << (MIN_SIZE_SHIFT + sizeClass);
+        } else {
+            sizeClass = -1;
+        }
+        block = (SirenEventBlock *)new char[capacity];
+        new (&block->refs) std::atomic<int>(0);
+        block->capacity = capacity;
+        block->sizeClass = sizeClass;
+        block->pool = this;
+    }
+
+    block->refs.store(1, std::memory_order_relaxed);
+    memset(&block->event, 0, sizeof(voice_event_t));
+
+    Message *pMessage = block->message();
+    new (pMessage) Message(msg);
+    pMessage->len = len;
+    if (len != 0) {
+        pMessage->data = (char *)pMessage + sizeof(Message);
+    }
+    return block;
+}
+
+void SirenEventPool::unref(SirenEventBlock *block) {
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    {
+        std::lock_guard<decltype(poolMutex)> l_(poolMutex);
+        outstanding--;
+        if (block->sizeClass >= 0 && freeList[block->sizeClass].size() < MAX_CACHED_PER_CLASS) {
+            freeList[block->sizeClass].push_back(block);
+            cached++;
+            return;
+        }
+    }
+    delete [] (char *)block;
+}
+
+void SirenEventPool::getStat(SirenEventPoolStat &stat) {
+    std::lock_guard<decltype(poolMutex)> l_(poolMutex);
+    stat.allocated = allocated;
+    stat.reused = reused;
+    stat.outstanding = outstanding;
+    stat.cached = cached;
+}
+
+void SirenEventPool::trim() {
+    std::vector<SirenEventBlock *> blocks;
+    {
+        std::lock_guard<decltype(poolMutex)> l_(poolMutex);
+        for (int i = 0; i < SIZE_CLASSES; i++) {
+            blocks.insert(blocks.end(), freeList[i].begin(), freeList[i].end());
+            freeList[i].clear();
+        }
+        cached = 0;
+    }
+    for (auto block : blocks) {
+        delete [] (char *)block;
+    }
+}
+
+}
+
+extern "C" {
+
+void siren_event_ref(voice_event_t *voice_event) {
+    BlackSiren::SirenEventBlock *block = BlackSiren::SirenEventBlock::fromEvent(voice_event);
+    block->pool->ref(block);
+}
+
+void siren_event_unref(voice_event_t *voice_event) {
+    BlackSiren::SirenEventBlock *block = BlackSiren::SirenEventBlock::fromEvent(voice_event);
+    block->pool->unref(block);
+}
+
+void siren_raw_ref(void *buff) {
+    BlackSiren::SirenEventBlock *block = BlackSiren::SirenEventBlock::fromData(buff);
+    block->pool->ref(block);
+}
+
+void siren_raw_unref(void *buff) {
+    BlackSiren::SirenEventBlock *block = BlackSiren::SirenEventBlock::fromData(buff);
+    block->pool->unref(block);
+}
+
+}
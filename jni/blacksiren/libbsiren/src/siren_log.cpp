@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include "sutils.h"
+#include "os.h"
+#include "log_ring.h"
+
+#ifndef ANDROID_LOG_TAG
+#define ANDROID_LOG_TAG "BlackSiren"
+#endif
+
+namespace BlackSiren {
+
+#ifndef CONFIG_NO_STDOUT_DEBUG
+
+using log_ring::LogRing;
+using log_ring::LogRecord;
+using log_ring::now_us;
+
+static std::mutex drain_mutex;
+static std::mutex rings_mutex;
+static LogRing *rings = nullptr;
+static std::atomic<bool> log_async(true);
+static std::atomic<bool> drain_started(false);
+static uint64_t dropped_total = 0;
+static log_ring::LogWaker waker;
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+
+#ifdef CONFIG_ANDROID_LOG
+static int siren_to_android_level(int level) {
+    if (level == SIREN_DEBUG) {
+        return ANDROID_LOG_DEBUG;
+    } else if (level == SIREN_INFO) {
+        return ANDROID_LOG_INFO;
+    } else if (level == SIREN_WARNING) {
+        return ANDROID_LOG_WARN;
+    } else if (level == SIREN_ERROR) {
+        return ANDROID_LOG_ERROR;
+    } else {
+        return ANDROID_LOG_INFO;
+    }
+}
+#endif
+
+/* invoked with drain_mutex locked */
+static void write_log(int level, uint64_t time_us, const char *text) {
+#ifdef CONFIG_ANDROID_LOG
+    __android_log_write(siren_to_android_level(level), ANDROID_LOG_TAG, text);
+#endif
+    SIREN_UNUSED(level);
+    printf("[%ld.%06u]: %s\n", (long)(time_us / 1000000),
+            (unsigned int)(time_us % 1000000), text);
+}
+
+/* write recorded logs of all threads in time order */
+static bool drain_logs() {
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    LogRing *head = nullptr;
+    uint32_t count = 0;
+    char text[LOG_RING_MAX_LENGTH];
+
+    {
+        std::lock_guard<std::mutex> rings_lock(rings_mutex);
+        head = rings;
+    }
+
+    /* rings only removed here, safe to iterate without lock */
+    count = log_ring::drain(head, [](const LogRecord &rec, const char *line) {
+        write_log(rec.level, rec.time_us, line);
+    });
+
+    for (LogRing *ring = head; ring != nullptr; ring = ring->next) {
+        uint32_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            dropped_total += dropped;
+            snprintf(text, sizeof(text), "%u logs dropped, ring full", dropped);
+            write_log(SIREN_WARNING, now_us(), text);
+            count++;
+        }
+    }
+    if (count > 0) {
+        fflush(stdout);
+    }
+
+    /* free rings of exited threads */
+    std::lock_guard<std::mutex> rings_lock(rings_mutex);
+    log_ring::free_orphans(&rings);
+    return count > 0;
+}
+
+static bool rings_pending() {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    return log_ring::pending(rings);
+}
+
+static void drain_thread() {
+    /* thread created by SCHED_FIFO thread inherit the policy */
+    struct sched_param param;
+    param.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+
+    /* woken by logging thread when idle, no polling */
+    while (true) {
+        if (drain_logs()) {
+            waker.pause();
+        } else {
+            waker.sleep(rings_pending);
+        }
+    }
+}
+
+static void orphan_ring(void *ring) {
+    reinterpret_cast<LogRing *>(ring)->orphaned.store(true, std::memory_order_release);
+}
+
+/*
+ * siren forks the processing process, only forking thread exists in child,
+ * restart drain thread on next log, rings of other threads are orphaned
+ */
+static void fork_child() {
+    new (&drain_mutex) std::mutex();
+    new (&rings_mutex) std::mutex();
+    LogRing *self = reinterpret_cast<LogRing *>(pthread_getspecific(ring_key));
+    for (LogRing *ring = rings; ring != nullptr; ring = ring->next) {
+        /* pending logs written by parent process */
+        ring->tail.store(ring->head.load());
+        if (ring != self) {
+            ring->orphaned.store(true, std::memory_order_relaxed);
+        }
+    }
+    waker.reinit();
+    drain_started = false;
+}
+
+static void flush_at_exit() {
+    while (drain_logs());
+}
+
+static void create_ring_key() {
+    waker.init();
+    pthread_key_create(&ring_key, orphan_ring);
+    pthread_atfork(nullptr, nullptr, fork_child);
+}
+
+static LogRing* thread_ring() {
+    pthread_once(&ring_key_once, create_ring_key);
+    LogRing *ring = reinterpret_cast<LogRing *>(pthread_getspecific(ring_key));
+    if (ring != nullptr && drain_started.load(std::memory_order_relaxed)) {
+        return ring;
+    }
+
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    if (ring == nullptr) {
+        ring = new (std::nothrow) LogRing();
+        if (ring == nullptr) {
+            return nullptr;
+        }
+        pthread_setspecific(ring_key, ring);
+        ring->next = rings;
+        rings = ring;
+    }
+    if (!drain_started) {
+        static bool exit_registered = false;
+        drain_started = true;
+        std::thread(drain_thread).detach();
+        if (!exit_registered) {
+            exit_registered = true;
+            atexit(flush_at_exit);
+        }
+    }
+    return ring;
+}
+
+void siren_log(int level, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    if (!log_async.load(std::memory_order_relaxed)) {
+        char text[LOG_RING_MAX_LENGTH];
+        vsnprintf(text, sizeof(text), fmt, ap);
+        std::lock_guard<std::mutex> lock(drain_mutex);
+        write_log(level, now_us(), text);
+        va_end(ap);
+        return;
+    }
+
+    LogRing *ring = thread_ring();
+    if (ring == nullptr) {
+        va_end(ap);
+        return;
+    }
+    log_ring::record(ring, waker, (uint8_t)level, nullptr, fmt, ap);
+    va_end(ap);
+}
+
+void siren_log_set_async(bool async) {
+    if (!async) {
+        siren_log_flush();
+    }
+    log_async.store(async);
+}
+
+void siren_log_flush() {
+    while (drain_logs());
+}
+
+uint64_t siren_log_dropped() {
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    return dropped_total;
+}
+
+#else /* CONFIG_NO_STDOUT_DEBUG */
+
+void siren_log_set_async(bool async) {
+    SIREN_UNUSED(async);
+}
+
+void siren_log_flush() {
+}
+
+uint64_t siren_log_dropped() {
+    return 0;
+}
+
+#endif
+
+}
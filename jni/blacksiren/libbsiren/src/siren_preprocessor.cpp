@@ -30,7 +30,11 @@ int SirenPreprocessorImpl::init() {
         aecRecord = false;
     }
 
-    r2ssp_ssp_init();
+    {
+        std::lock_guard<std::mutex> l_(r2sspGlobalMutex());
+        r2sspAcquire();
+        r2sspHeld = true;
+    }
 
     micinfo.m_pMicInfo_in = new r2_mic_info;
     micinfo.m_pMicInfo_in->iMicNum = config.mic_num;
@@ -131,13 +135,32 @@ int SirenPreprocessorImpl::init() {
         siren_printf(SIREN_ERROR, "not support such input");
         return -1;
     }
+    //every stage but aec takes any length, aec holds back enough of its
+    //16ms frame to give out each 10ms hop at once
+    r2frm_plan plan(R2_AUDIO_SAMPLE_RATE / 1000 * config.mic_frame_length);
+    plan.add("in", 1);
+    if (config.alg_config.alg_rs_enable) {
+        plan.add("rs", 1);
+    }
+    plan.add("rdc", 1);
+    int aecUnit = -1;
+    if (doAEC) {
+        aecUnit = plan.add("aec", R2_AUDIO_SAMPLE_RATE / 1000 * R2_AUDIO_AEC_FRAME_MS);
+    }
+    plan.add("out", 1);
+    char planDump[256];
+    plan.dump(planDump, sizeof(planDump));
+    siren_printf(SIREN_INFO, "preprocessor framing: %s", planDump);
+
     unit.m_pMem_in = new r2mem_i(config.mic_num, in_type, micinfo.m_pMicInfo_in);
     if(config.alg_config.alg_rs_enable){
         unit.m_pMem_rs = new r2mem_rs2(config.mic_num, config.mic_sample_rate, micinfo.m_pMicInfo_rs, false);
     }
     unit.m_pMem_rdc = new r2mem_rdc(micinfo.m_pMicInfo_rs, nullptr, 16000);
     if(doAEC) {
-        unit.m_pMem_aec = new r2mem_aec(config.mic_num, micinfo.m_pMicInfo_aec, micinfo.m_pMicInfo_aec_ref, micinfo.m_pCpuInfo_aec);
+        unit.m_pMem_aec = new r2mem_aec(config.mic_num, micinfo.m_pMicInfo_aec, micinfo.m_pMicInfo_aec_ref, micinfo.m_pCpuInfo_aec,
+                                        config.alg_config.alg_aec_max_delay * R2_AUDIO_SAMPLE_RATE / 1000,
+                                        plan.m_iHop, plan.getLookahead(aecUnit));
     }
     unit.m_pMem_out = new r2mem_o(config.mic_num, r2_out_float_32, micinfo.m_pMicInfo_aec);
     unit.m_pMem_buff = new r2mem_buff();
@@ -226,6 +249,22 @@ void SirenPreprocessorImpl::getResult(char *pDataOut, int lenOut) {
     //debugStream.write(pDataOut, lenOut);
 }
 
+bool SirenPreprocessorImpl::getAecStats(siren_aec_stats_t *stats) {
+    if (!doAEC || unit.m_pMem_aec->m_pDelay == nullptr || !unit.m_pMem_aec->m_bDelayChanged) {
+        return false;
+    }
+    unit.m_pMem_aec->m_bDelayChanged = 0;
+
+    r2aecdelay *delay = unit.m_pMem_aec->m_pDelay;
+    stats->delay = delay->m_iDelay;
+    stats->first_delay = delay->m_iDelayFirst;
+    stats->drift = delay->m_iDelay - delay->m_iDelayFirst;
+    stats->align = delay->m_iAlign;
+    stats->changes = delay->m_iChanges;
+    stats->confidence = delay->m_fConfidence;
+    return true;
+}
+
 void SirenPreprocessorImpl::destroy() {
     if (micinfo.m_pMicInfo_in != nullptr) {
         if (micinfo.m_pMicInfo_in->pMicIdLst != nullptr) {
@@ -283,7 +322,11 @@ void SirenPreprocessorImpl::destroy() {
 
     if(iByteWidth == 2) delete m_pData;
 
-    r2ssp_ssp_exit();
+    if (r2sspHeld) {
+        std::lock_guard<std::mutex> l_(r2sspGlobalMutex());
+        r2sspRelease();
+        r2sspHeld = false;
+    }
 }
 
 
@@ -2,9 +2,11 @@
 #include "siren_config.h"
 #include "sutils.h"
 #include "siren_alg_legacy_helper.h"
+#include "siren_vt_wire.h"
 
 #include <fstream>
 #include <vector>
+#include <chrono>
 
 #include "NNVadIntf.h"
 #include "r2ssp.h"
@@ -181,7 +183,11 @@ int SirenProcessorImpl::init() {
     VAD_SysInit();
     siren_printf(SIREN_INFO, "VAD INIT OK!");
 
-    r2ssp_ssp_init();
+    {
+        std::lock_guard<std::mutex> l_(r2sspGlobalMutex());
+        r2sspAcquire();
+        r2sspHeld = true;
+    }
     siren_printf(SIREN_INFO, "R2SSP INIT OK!");
 
     //load default vt words
@@ -258,10 +264,25 @@ int SirenProcessorImpl::init() {
     unit.m_pMmem_bf = new r2mem_bf(mic_num, micinfo.mic_pos,
                                    micinfo.mic_i2s_delay, micinfo.m_pMicInfo_bf);
 
+    unit.m_pMem_bfpre = new r2mem_bfpre(mic_num, micinfo.mic_pos,
+                                        micinfo.mic_i2s_delay, micinfo.m_pMicInfo_bf,
+                                        config.alg_config.alg_bf_preroll_dirs,
+                                        config.alg_config.alg_bf_preroll_ms * R2_AUDIO_SAMPLE_RATE / 1000);
+
     unit.m_pMem_vad2 = new r2mem_vad2(config.alg_config.alg_vad_baserange,
                                       config.alg_config.alg_vad_dynrange_min,
                                       config.alg_config.alg_vad_dynrange_max);
 
+    if (config.alg_config.alg_vt_gate) {
+        unit.m_pMem_gate = new r2mem_gate(mic_num, micinfo.m_pMicInfo_in,
+                                          config.alg_config.alg_vt_gate_lookback_ms * R2_AUDIO_SAMPLE_RATE / 1000,
+                                          config.alg_config.alg_vt_gate_onset_db,
+                                          config.alg_config.alg_vt_gate_hangover_ms * R2_AUDIO_SAMPLE_RATE / 1000);
+        siren_printf(SIREN_INFO, "vt gate onset %f db hangover %d ms lookback %d ms",
+                     config.alg_config.alg_vt_gate_onset_db, config.alg_config.alg_vt_gate_hangover_ms,
+                     config.alg_config.alg_vt_gate_lookback_ms);
+    }
+
     //use opus
     if (config.alg_config.alg_opus_compress) {
         unit.m_pMem_cod = new r2mem_cod(r2ad_cod_opu);
@@ -269,6 +290,22 @@ int SirenProcessorImpl::init() {
         unit.m_pMem_cod = new r2mem_cod(r2ad_cod_pcm);
     }
 
+    if (config.alg_config.alg_agc) {
+        unit.m_pMem_agc = new r2mem_agc(agcParam(config.alg_config));
+        unit.m_pMem_cod->m_bNorm_Am = false;
+        siren_printf(SIREN_INFO, "agc target %f db gain %f to %f db limit %f db",
+                     config.alg_config.alg_agc_target_db, config.alg_config.alg_agc_min_gain_db,
+                     config.alg_config.alg_agc_max_gain_db, config.alg_config.alg_agc_limit_db);
+    }
+
+    if (config.alg_config.alg_ns) {
+        //fftw planning is not thread safe
+        std::lock_guard<std::mutex> l_(r2sspGlobalMutex());
+        unit.m_pMem_ns = new r2mem_ns(config.alg_config.alg_ns_floor_db);
+        siren_printf(SIREN_INFO, "ns floor %f db in sleep %s", config.alg_config.alg_ns_floor_db,
+                     config.alg_config.alg_ns_sleep ? "on" : "off");
+    }
+
     //set default word
     unit.m_pMem_vbv3->SetWords(micinfo.m_pWordLst, micinfo.currentWordNum);
     memset (&allocator, 0, sizeof(TinyAllocator));
@@ -293,6 +330,36 @@ int SirenProcessorImpl::init() {
 }
 
 
+void SirenProcessorImpl::reloadRecording(bool enable, bool &recording, std::ofstream &stream,
+                                         const std::string &path) {
+    if (enable == recording) {
+        return;
+    }
+
+    if (!enable) {
+        stream.close();
+        recording = false;
+        siren_printf(SIREN_INFO, "stop recording %s", path.c_str());
+        return;
+    }
+
+    stream.open(path, std::ios::out | std::ios::binary);
+    if (!stream.good()) {
+        siren_printf(SIREN_WARNING, "cannot open file %s", path.c_str());
+        stream.close();
+        return;
+    }
+    recording = true;
+    siren_printf(SIREN_INFO, "start recording %s", path.c_str());
+}
+
+void SirenProcessorImpl::reloadRecording() {
+    reloadRecording(config.debug_config.bf_record, bf_record, bfRecordingStream, bfRecordingPath);
+    reloadRecording(config.debug_config.bf_raw_record, bf_raw_record, bfRawRecordingStream, bfRawRecordingPath);
+    reloadRecording(config.debug_config.vad_record, vad_record, vadRecordingStream, vadRecordingPath);
+    reloadRecording(config.debug_config.debug_opu_record, opu_record, opuRecordingStream, opuRecordingPath);
+}
+
 void SirenProcessorImpl::destroy() {
     if (micinfo.mic_pos != nullptr) {
         delete []micinfo.mic_pos;
@@ -336,6 +403,11 @@ void SirenProcessorImpl::destroy() {
         unit.m_pMmem_bf = nullptr;
     }
 
+    if (unit.m_pMem_bfpre != nullptr) {
+        delete unit.m_pMem_bfpre;
+        unit.m_pMem_bfpre = nullptr;
+    }
+
     if (unit.m_pMem_vad2 != nullptr) {
         delete unit.m_pMem_vad2;
         unit.m_pMem_vad2 = nullptr;
@@ -346,7 +418,29 @@ void SirenProcessorImpl::destroy() {
         unit.m_pMem_vbv3 = nullptr;
     }
 
-    r2ssp_ssp_exit();
+    if (unit.m_pMem_gate != nullptr) {
+        delete unit.m_pMem_gate;
+        unit.m_pMem_gate = nullptr;
+    }
+
+    if (unit.m_pMem_agc != nullptr) {
+        delete unit.m_pMem_agc;
+        unit.m_pMem_agc = nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> l_(r2sspGlobalMutex());
+        if (unit.m_pMem_ns != nullptr) {
+            siren_printf(SIREN_INFO, "ns ran %lld hops bypassed %lld",
+                         unit.m_pMem_ns->m_iHop_Active, unit.m_pMem_ns->m_iHop_Bypass);
+            delete unit.m_pMem_ns;
+            unit.m_pMem_ns = nullptr;
+        }
+        if (r2sspHeld) {
+            r2sspRelease();
+            r2sspHeld = false;
+        }
+    }
     VAD_SysExit();
 
 
@@ -391,6 +485,7 @@ void SirenProcessorImpl::process(char *datain, int lenin, int aecflag, int awake
         if (fixErrorMic(errorMics)) {
             delete unit.m_pMem_vbv3;
             delete unit.m_pMmem_bf;
+            delete unit.m_pMem_bfpre;
 
             unit.m_pMem_vbv3 = new r2mem_vbv3(config.mic_num, micinfo.mic_pos,
                                               micinfo.mic_i2s_delay, micinfo.m_pMicInfo_bf,
@@ -399,14 +494,33 @@ void SirenProcessorImpl::process(char *datain, int lenin, int aecflag, int awake
 
             unit.m_pMmem_bf = new r2mem_bf(config.mic_num, micinfo.mic_pos,
                                            micinfo.mic_i2s_delay, micinfo.m_pMicInfo_bf);
+            unit.m_pMem_bfpre = new r2mem_bfpre(config.mic_num, micinfo.mic_pos,
+                                                micinfo.mic_i2s_delay, micinfo.m_pMicInfo_bf,
+                                                config.alg_config.alg_bf_preroll_dirs,
+                                                config.alg_config.alg_bf_preroll_ms * R2_AUDIO_SAMPLE_RATE / 1000);
             unit.m_pMem_vbv3->SetWords(micinfo.m_pWordLst, micinfo.currentWordNum);
         }
     }
 
     state.updateAndDumpStatus(len_mul, aecflag, awakeflag, sleepflag, asrflag);
 
+    //in sleep a silent hop is only kept by the gate, bf and vbv run over
+    //what it kept once sound starts
+    int vbv_catchup = 0;
+    if (unit.m_pMem_gate != nullptr) {
+        bool busy = asr || state.vadStart || state.dataOutput || unit.m_pMem_vbv3->m_bPre;
+        int gate = unit.m_pMem_gate->process(data_mul, len_mul, busy);
+        if (gate == r2gate_closed) {
+            return;
+        }
+        if (gate == r2gate_onset) {
+            vbv_catchup = catchUpGate(aec, awake, sleep, hotword);
+        }
+    }
+
     //bf
     unit.m_pMmem_bf->process(data_mul, len_mul, data_sig, len_sig);
+    unit.m_pMem_bfpre->process(data_mul, len_mul, data_sig, len_sig);
 
     if (config.alg_config.alg_bf_scaling == 0.0f) {
         config.alg_config.alg_bf_scaling = 1.0f;
@@ -429,7 +543,7 @@ void SirenProcessorImpl::process(char *datain, int lenin, int aecflag, int awake
 
     //vbv
     int vbv_result = unit.m_pMem_vbv3->Process(data_mul, len_mul,
-                     state.dataOutput, aec, awake, sleep, hotword);
+                     state.dataOutput, aec, awake, sleep, hotword) | vbv_catchup;
 
     if ((vbv_result & R2_VT_WORD_CANCEL) != 0) {
         assert((vbv_result & R2_VT_WORD_PRE) != 0);
@@ -458,8 +572,9 @@ void SirenProcessorImpl::process(char *datain, int lenin, int aecflag, int awake
         memset(slinfo, 0, sizeof(float) * 3);
         //save last bf we will try to focus on pre direction
         memcpy(slinfo, unit.m_pMmem_bf->m_fSlInfo, sizeof(float) * 3);
-        unit.m_pMmem_bf->steer(unit.m_pMem_vbv3->m_pWordDetInfo->fWordSlInfo[0],
-                               unit.m_pMem_vbv3->m_pWordDetInfo->fWordSlInfo[1]);
+        float ho = unit.m_pMem_vbv3->m_pWordDetInfo->fWordSlInfo[0];
+        float ver = unit.m_pMem_vbv3->m_pWordDetInfo->fWordSlInfo[1];
+        unit.m_pMmem_bf->steer(ho, ver);
 
         //reset
         int start = unit.m_pMem_vbv3->m_pWordDetInfo->iWordPos_Start;
@@ -468,16 +583,24 @@ void SirenProcessorImpl::process(char *datain, int lenin, int aecflag, int awake
         //go front 200ms
         start += 20 * state.frmSize;
 
-        if (start > allocator.colNoNew) {
-            allocator.colNoNew = start * 2;
-            R2_SAFE_DEL_AR2(allocator.dataNoNew);
-            allocator.dataNoNew = R2_SAFE_NEW_AR2(allocator.dataNoNew, float, config.mic_num, allocator.colNoNew);
-        }
-
-        unit.m_pMem_vbv3->GetLastAudio(allocator.dataNoNew,
-                                       start, 0);
         if(!sleepNoCmd){
-            unit.m_pMmem_bf->process(allocator.dataNoNew, start, data_sig, len_sig);
+            //take the word from kept beams, beamform it again only when
+            //none of them points near it
+            auto preStart = std::chrono::steady_clock::now();
+            int preroll = unit.m_pMem_bfpre->fetch(ho, ver, start, data_sig);
+            if (preroll == r2bfpre_miss) {
+                if (start > allocator.colNoNew) {
+                    allocator.colNoNew = start * 2;
+                    R2_SAFE_DEL_AR2(allocator.dataNoNew);
+                    allocator.dataNoNew = R2_SAFE_NEW_AR2(allocator.dataNoNew, float, config.mic_num, allocator.colNoNew);
+                }
+
+                unit.m_pMem_vbv3->GetLastAudio(allocator.dataNoNew,
+                                               start, 0);
+                unit.m_pMmem_bf->process(allocator.dataNoNew, start, data_sig, len_sig);
+            } else {
+                len_sig = start;
+            }
             data_sig += 15 * state.frmSize;
             len_sig -= 15 * state.frmSize;
             for (int i = 0; i < len_sig; i++) {
@@ -487,10 +610,29 @@ void SirenProcessorImpl::process(char *datain, int lenin, int aecflag, int awake
                     data_sig[i] = data_sig[i] / abs(config.alg_config.alg_bf_scaling);
                 }
             }
+            siren_printf(SIREN_INFO, "bf preroll %d samples by %s in %lld us, select %d interpolate %d miss %d",
+                         start, preroll == r2bfpre_select ? "select" :
+                         (preroll == r2bfpre_interpolate ? "interpolate" : "beamform"),
+                         (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - preStart).count(),
+                         unit.m_pMem_bfpre->m_iCount[r2bfpre_select],
+                         unit.m_pMem_bfpre->m_iCount[r2bfpre_interpolate],
+                         unit.m_pMem_bfpre->m_iCount[r2bfpre_miss]);
         }
+        unit.m_pMem_bfpre->steer(ho, ver);
         forceStart = 1;
     }
 
+    //ns before vad, in sleep it only tracks noise unless asked to run
+    if (unit.m_pMem_ns != nullptr) {
+        //preroll replaced the audio with history
+        if (pre && !sleepNoCmd) {
+            unit.m_pMem_ns->cut();
+        }
+        unit.m_pMem_ns->process(data_sig, len_sig, !asr && !config.alg_config.alg_ns_sleep,
+                                data_sig, len_sig);
+    }
+
     //siren_printf(SIREN_INFO, "vad2 process");
     int vad2 = unit.m_pMem_vad2->process(data_sig, len_sig, 0,
                                          0, forceStart, data_sig, len_sig);
@@ -511,6 +653,9 @@ void SirenProcessorImpl::process(char *datain, int lenin, int aecflag, int awake
         state.canceled = false;
         state.awke = false;
         unit.m_pMem_cod->reset();
+        if (unit.m_pMem_agc != nullptr) {
+            unit.m_pMem_agc->reset();
+        }
         if (awakePre) {
             state.awke = true;
 //            if(state.dataOutput && !sleepNoCmd){
@@ -562,6 +707,15 @@ void SirenProcessorImpl::process(char *datain, int lenin, int aecflag, int awake
         }
     }
 
+    if (unit.m_pMem_agc != nullptr) {
+        //level between utterances only feeds noise floor
+        if (state.vadStart) {
+            unit.m_pMem_agc->process(data_sig, len_sig, data_sig, len_sig);
+        } else {
+            unit.m_pMem_agc->track(data_sig, len_sig);
+        }
+    }
+
     if (state.vadStart) {
         unit.m_pMem_cod->process(data_sig, len_sig);
         if (!pre) {
@@ -670,6 +824,37 @@ void SirenProcessorImpl::process(char *datain, int lenin, int aecflag, int awake
 
 
 
+int SirenProcessorImpl::catchUpGate(bool aec, bool awake, bool sleep, bool hotword) {
+    auto begin = std::chrono::steady_clock::now();
+    int len = unit.m_pMem_gate->kept();
+    if (len > allocator.colNoNew) {
+        allocator.colNoNew = len * 2;
+        R2_SAFE_DEL_AR2(allocator.dataNoNew);
+        allocator.dataNoNew = R2_SAFE_NEW_AR2(allocator.dataNoNew, float, config.mic_num, allocator.colNoNew);
+    }
+    len = unit.m_pMem_gate->fetch(allocator.dataNoNew, len);
+    if (len <= 0) {
+        return 0;
+    }
+
+    //only history of bf, bfpre and vbv is of use, not what bf gives
+    float *data_sig = nullptr;
+    int len_sig = 0;
+    unit.m_pMmem_bf->process(allocator.dataNoNew, len, data_sig, len_sig);
+    unit.m_pMem_bfpre->process(allocator.dataNoNew, len, data_sig, len_sig);
+    int result = unit.m_pMem_vbv3->Process(allocator.dataNoNew, len,
+                 state.dataOutput, aec, awake, sleep, hotword);
+
+    long long closed = unit.m_pMem_gate->m_iLen_Closed;
+    long long total = closed + unit.m_pMem_gate->m_iLen_Open;
+    siren_printf(SIREN_INFO, "vt gate onset %d caught up %d samples in %lld us, closed %lld%% so far",
+                 unit.m_pMem_gate->m_iOnset, len,
+                 (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - begin).count(),
+                 total > 0 ? closed * 100 / total : 0);
+    return result;
+}
+
 void SirenProcessorImpl::setState(r2v_sys_state awake_state) {
     if (awake_state == r2ssp_state_sleep && state.awke) {
         state.awke = false; 
@@ -693,6 +878,7 @@ void SirenProcessorImpl::setState(r2v_sys_state awake_state) {
 void SirenProcessorImpl::setSLSteer(float ho, float ver) {
     if (unit.m_pMmem_bf != nullptr) {
         unit.m_pMmem_bf->steer(ho, ver);
+        unit.m_pMem_bfpre->steer(ho, ver);
     }
 }
 
@@ -857,13 +1043,33 @@ float SirenProcessorImpl::getLastFrameThreshold() {
     return unit.m_pMem_vad2->getenergy_Threshold();
 }
 
-void SirenProcessorImpl::syncVTWord(std::vector<siren_vt_word> &words) {
+bool SirenProcessorImpl::getGateStats(float &closed, int &onsets) {
+    if (unit.m_pMem_gate == nullptr) {
+        return false;
+    }
+    long long total = unit.m_pMem_gate->m_iLen_Closed + unit.m_pMem_gate->m_iLen_Open;
+    closed = total > 0 ? (float)unit.m_pMem_gate->m_iLen_Closed / total : 0.0f;
+    onsets = unit.m_pMem_gate->m_iOnset;
+    return true;
+}
+
+bool SirenProcessorImpl::syncVTWord(const char *wire, int len) {
+    //check whole list before current words are dropped
+    SirenVTWireParser check(wire, len);
+    SirenVTWireWord word;
+    while (check.next(word)) {
+    }
+    if (check.count() < 0 || check.failed()) {
+        siren_printf(SIREN_ERROR, "malformed vt word list of %d bytes", len);
+        return false;
+    }
+
     int defaultVTWordNum = config.alg_config.def_vt_configs.size();
-    defaultVTWordNum += words.empty() ? 0 : words.size();
-    siren_printf(SIREN_INFO, "sync vt word num: %d", defaultVTWordNum);
+    defaultVTWordNum += check.count();
+    siren_printf(SIREN_INFO, "sync vt word num: %d from %d bytes", defaultVTWordNum, len);
     micinfo.currentWordNum = defaultVTWordNum;
     if (micinfo.m_pWordLst != nullptr) {
-        delete micinfo.m_pWordLst;
+        delete []micinfo.m_pWordLst;
         micinfo.m_pWordLst = nullptr;
     }
     micinfo.m_pWordLst = new WordInfo[micinfo.currentWordNum];
@@ -927,56 +1133,19 @@ void SirenProcessorImpl::syncVTWord(std::vector<siren_vt_word> &words) {
         }
     }
 
-    for (siren_vt_word word : words) {
-        micinfo.m_pWordLst[i].iWordType = (WordType)word.vt_type;
-        strcpy(micinfo.m_pWordLst[i].pWordContent_UTF8, word.vt_word.c_str());
-        strcpy(micinfo.m_pWordLst[i].pWordContent_PHONE, word.vt_phone.c_str());
-
-        micinfo.m_pWordLst[i].fBlockAvgScore = word.alg_config.vt_block_avg_score;
-        micinfo.m_pWordLst[i].fBlockMinScore = word.alg_config.vt_block_min_score;
-
-        micinfo.m_pWordLst[i].bLeftSilDet = word.alg_config.vt_left_sil_det;
-        micinfo.m_pWordLst[i].bRightSilDet = word.alg_config.vt_right_sil_det;
-
-        micinfo.m_pWordLst[i].bRemoteAsrCheckWithAec = word.alg_config.vt_remote_check_with_aec;
-        micinfo.m_pWordLst[i].bRemoteAsrCheckWithNoAec = word.alg_config.vt_remote_check_without_aec;
-
-        micinfo.m_pWordLst[i].bLocalClassifyCheck = word.alg_config.vt_local_classify_check;
-        micinfo.m_pWordLst[i].fClassifyShield = word.alg_config.vt_classify_shield;
-
-        bool nnet_valid = false;
-        if (!word.alg_config.nnet_path.empty()) {
-            strcpy(micinfo.m_pWordLst[i].pLocalClassifyNnetPath, word.alg_config.nnet_path.c_str());
-            nnet_valid = true;
-        } else {
-            nnet_valid = false;
-        }
-
-        siren_printf(SIREN_INFO, "load word%d", i);
-        siren_printf(SIREN_INFO, "word content: %s", micinfo.m_pWordLst[i].pWordContent_UTF8);
-        siren_printf(SIREN_INFO, "phone: %s", micinfo.m_pWordLst[i].pWordContent_PHONE);
-        siren_printf(SIREN_INFO, "block avg score %f", micinfo.m_pWordLst[i].fBlockAvgScore);
-        siren_printf(SIREN_INFO, "block min score %f", micinfo.m_pWordLst[i].fBlockMinScore);
-        siren_printf(SIREN_INFO, "left sil det %s", micinfo.m_pWordLst[i].bLeftSilDet ? "true" : "false");
-        siren_printf(SIREN_INFO, "right sil det %s", micinfo.m_pWordLst[i].bRightSilDet ? "true" : "false");
-        siren_printf(SIREN_INFO, "remote asr check with aec %s",
-                     micinfo.m_pWordLst[i].bRemoteAsrCheckWithAec ? "true" : "false");
-        siren_printf(SIREN_INFO, "remote asr check without aec %s",
-                     micinfo.m_pWordLst[i].bRemoteAsrCheckWithNoAec ? "true" : "false");
-        siren_printf(SIREN_INFO, "local classify check %s", micinfo.m_pWordLst[i].bLocalClassifyCheck ? "true" : "false");
-        siren_printf(SIREN_INFO, "classify shield %f", micinfo.m_pWordLst[i].fClassifyShield);
-
-        if (nnet_valid) {
-            siren_printf(SIREN_INFO, "nnet valid path %s",
-                         micinfo.m_pWordLst[i].pLocalClassifyNnetPath);
-        } else {
-            siren_printf(SIREN_INFO, "neet invalid maybe useless");
-        }
+    SirenVTWireParser parser(wire, len);
+    while (parser.next(word)) {
+        toWordInfo(word, micinfo.m_pWordLst[i]);
+        siren_printf(SIREN_INFO, "load word%d %s type %d avg %f min %f shield %f flags 0x%x phone %d bytes nnet %s",
+                     i, micinfo.m_pWordLst[i].pWordContent_UTF8, word.type, word.avg_score, word.min_score,
+                     word.classify_shield, word.flags, word.phone_len,
+                     word.nnet_path_len > 0 ? micinfo.m_pWordLst[i].pLocalClassifyNnetPath : "none");
         i++;
     }
 
     siren_printf(SIREN_INFO, "sync %d words", i);
     unit.m_pMem_vbv3->SetWords(micinfo.m_pWordLst, micinfo.currentWordNum);
+    return true;
 }
 
 int SirenProcessorImpl::getVTInfo(std::string &vt_word, int &start, int &end, float &energy) {
@@ -4,6 +4,10 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <signal.h>
+#include <poll.h>
+#include <libgen.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
 
 #include <cstdio>
 #include <errno.h>
@@ -24,9 +28,16 @@
 #include "siren_proxy.h"
 #include "siren_config.h"
 #include "siren_alg.h"
+#include "siren_event_pool.h"
+#include "siren_config_schema.h"
+#include "siren_timeline.h"
+#include "siren_vt_wire.h"
 
 namespace BlackSiren {
 
+//respawned siren base loads models again before it answers
+static const int SIREN_SPAWN_INIT_TIMEOUT = 30;
+
 RecordingThread::RecordingThread(SirenProxy *siren) :
     pSiren(siren),
     recordingStart(false),
@@ -45,6 +56,10 @@ RecordingThread::RecordingThread(SirenProxy *siren) :
     errorRetry = config.siren_input_err_retry_num;
     retryTimeout = config.siren_input_err_retry_timeout;
 
+    if (config.siren_supervise && config.siren_process_mode == CONFIG_PROCESS_FORK) {
+        gap.init(frameSize, config.siren_gap_buffer / config.mic_frame_length);
+    }
+
     if (config.debug_config.mic_array_record) {
         std::string basePath("/mic_array.pcm");
         micRecording .assign(config.debug_config.recording_path).append(basePath);
@@ -118,6 +133,18 @@ bool RecordingThread::start() {
     return true;
 }
 
+bool RecordingThread::reopen() {
+    std::lock_guard<decltype(socketMutex)> l_(socketMutex);
+    close(sockets[0]);
+    if (sockets[1] >= 0) {
+        close(sockets[1]);
+    }
+    //frames go to gap until new siren base is up
+    sockets[0] = -1;
+    sockets[1] = -1;
+    return init();
+}
+
 void RecordingThread::pause() {
     siren_printf(SIREN_INFO, "stop recording thread");
     {
@@ -141,11 +168,64 @@ void RecordingThread::stop() {
     }
 }
 
+int RecordingThread::readFrame(char **frame) {
+    siren_input_if_t *input = pSiren->input_callback;
+    if (input->acquire_input_frame != nullptr) {
+        //frame stays in input buffer, no copy before socket write
+        return input->acquire_input_frame(pSiren->token, frame, frameSize);
+    }
+
+    *frame = frameBuffer;
+    return input->read_input(pSiren->token, frameBuffer, frameSize);
+}
+
+void RecordingThread::releaseFrame(char *frame) {
+    siren_input_if_t *input = pSiren->input_callback;
+    if (frame != nullptr && frame != frameBuffer && input->release_input_frame != nullptr) {
+        input->release_input_frame(pSiren->token, frameSize);
+    }
+}
+
+void RecordingThread::keepFrame(SirenSupervisor *supervisor, const char *frame) {
+    if (gap.push(frame)) {
+        supervisor->onGapFrames(1, 0);
+    } else {
+        supervisor->onGapFrames(0, 1);
+    }
+}
+
+void RecordingThread::sendFrame(const char *frame) {
+    std::lock_guard<decltype(socketMutex)> l_(socketMutex);
+    SirenSupervisor *supervisor = pSiren->supervisor.get();
+    if (supervisor != nullptr && supervisor->isDown()) {
+        keepFrame(supervisor, frame);
+        return;
+    }
+
+    //frames kept while siren base restarted go first
+    int len = 0;
+    while (!gap.empty() && (len = send(sockets[0], gap.front(), frameSize, MSG_NOSIGNAL)) >= 0) {
+        gap.pop();
+    }
+    if (len >= 0) {
+        len = send(sockets[0], frame, frameSize, MSG_NOSIGNAL);
+    }
+
+    //siren_printf(SIREN_INFO, "recording write return %d", len);
+    if (len < 0) {
+        siren_printf(SIREN_ERROR, "write error on socket with %s", strerror(errno));
+        if (supervisor != nullptr) {
+            keepFrame(supervisor, frame);
+        }
+    }
+}
+
 void RecordingThread::recordingFn() {
     bool first = true;
     bool inputStart = false;
     while (1) {
         int len = 0;
+        char *frame = nullptr;
         {
             std::unique_lock<decltype(termMutex)> lock(termMutex);
             if (recordingTerm) {
@@ -182,13 +262,16 @@ void RecordingThread::recordingFn() {
                 return;
             }
 
-            len = pSiren->input_callback->read_input(pSiren->token, frameBuffer, frameSize);
-            if (doMicRecording) {
-                micRecordingStream.write(frameBuffer, frameSize);
+            len = readFrame(&frame);
+            if (len == 0 && doMicRecording) {
+                micRecordingStream.write(frame, frameSize);
             }
 
             //
             if (!recordingStart) {
+                if (len == 0) {
+                    releaseFrame(frame);
+                }
                 continue;
             }
         }
@@ -211,18 +294,26 @@ void RecordingThread::recordingFn() {
         }
 
         //send to other side
-        len = write(sockets[0], frameBuffer, frameSize);
-        //siren_printf(SIREN_INFO, "recording write return %d", len);
-        if (len < 0) {
-            siren_printf(SIREN_ERROR, "write error on socket with %s", strerror(errno));
-            //pause();
-            continue;
-        }
-
+        sendFrame(frame);
+        releaseFrame(frame);
     }
 }
 
+static void runSirenBase(SirenConfig config, SirenSocketChannel *request,
+                         SirenSocketChannel *response, int socket) {
+    //reader for reponse
+    SirenSocketReader reader(request);
+    SirenSocketWriter writer(response);
+
+    reader.prepareOnReadSideProcess();
+    writer.prepareOnWriteSideProcess();
+
+    SirenBase base(config, socket, reader, writer);
+    base.init_siren(nullptr, nullptr, nullptr);
+}
+
 siren_status_t SirenProxy::init_siren(void *token, const char *path, siren_input_if_t *input) {
+    siren_timeline_begin();
     global_config = new SirenConfigurationManager(path);
     if (global_config == nullptr) {
         siren_printf(SIREN_ERROR, "alloc config manager failed");
@@ -232,6 +323,7 @@ siren_status_t SirenProxy::init_siren(void *token, const char *path, siren_input
     siren_status_t result = SIREN_STATUS_OK;
     result = global_config->parseConfigFile();
     SirenConfig& config = global_config->getConfigFile();
+    siren_timeline_mark("config parsed");
     input_callback = input;
     this->token = token;
 
@@ -270,10 +362,48 @@ siren_status_t SirenProxy::init_siren(void *token, const char *path, siren_input
     }
 
     waitingInit = false;
-    set_sig_child_handler();
-    //fork true siren
-    siren_pid = fork();
-    if (siren_pid < 0) {
+    sirenInThread = config.siren_process_mode == CONFIG_PROCESS_THREAD;
+    if (sirenInThread) {
+        //no fork and no exec cost, siren base shares this process
+        int socket = recordingThread->dupReader();
+        if (socket < 0 || !requestChannel.duplicate(baseRequestChannel)
+                || !responseChannel.duplicate(baseResponseChannel)) {
+            siren_printf(SIREN_ERROR, "dup channels for siren thread failed");
+            delete global_config;
+            global_config = nullptr;
+            clearThread();
+            return SIREN_STATUS_ERROR;
+        }
+        sirenThread = std::thread(runSirenBase, config, &baseRequestChannel, &baseResponseChannel, socket);
+        //no child to wait or kill, this pid is the host
+        siren_pid = -1;
+    } else if (config.siren_supervise) {
+        //supervisor reaps siren itself, a SIGCHLD reaper would let its pid be reused
+        SirenSupervisorConfig supervisorConfig;
+        supervisorConfig.heartbeatTimeout = config.siren_heartbeat_timeout;
+        supervisorConfig.heartbeatInterval = config.siren_heartbeat_timeout / 4;
+        SirenSupervisor::Child child;
+        child.spawn = [this] {
+            return spawnSiren();
+        };
+        child.reap = [this] {
+            reapSiren();
+        };
+        child.heartbeat = [this] {
+            requestQueue.push(allocateMessage(SIREN_REQUEST_MSG_HEARTBEAT, 0));
+        };
+        child.replay = [this] {
+            replaySiren();
+        };
+        supervisor.reset(new SirenSupervisor(supervisorConfig, child));
+        siren_pid = fork();
+    } else {
+        set_sig_child_handler();
+        //fork true siren
+        siren_pid = fork();
+    }
+    siren_timeline_mark("siren base launched");
+    if (!sirenInThread && siren_pid < 0) {
         siren_printf(SIREN_ERROR, "fork siren failed...");
         delete global_config;
         delete recordingThread;
@@ -282,22 +412,19 @@ siren_status_t SirenProxy::init_siren(void *token, const char *path, siren_input
     } else if (siren_pid == 0) {
         //gose for siren
         unset_sig_child_handler();
-        //reader for reponse
-        SirenSocketReader reader(&requestChannel);
-        SirenSocketWriter writer(&responseChannel);
-
-        reader.prepareOnReadSideProcess();
-        writer.prepareOnWriteSideProcess();
-
-        int socket = recordingThread->getReader();
-        SirenBase base(config, socket, reader, writer);
-        base.init_siren(nullptr, nullptr, nullptr);
+        runSirenBase(config, &requestChannel, &responseChannel, recordingThread->getReader());
         siren_printf(SIREN_ERROR, "siren exit..");
         exit(0);
         //in parent
     } else {
+        if (!sirenInThread) {
+            //siren base gone means write error, not a full socket
+            recordingThread->getWriter();
+        }
+
         //load phoneme list
         phonemeGen.loadPhoneme();
+        siren_timeline_mark("phoneme loaded");
 
         launchRequestThread();
         launchResponseThread();
@@ -306,6 +433,10 @@ siren_status_t SirenProxy::init_siren(void *token, const char *path, siren_input
         waitingRequestResponseThread();
         siren_printf(SIREN_INFO, "response thread init done");
 
+        //open input while siren base loads models
+        input_callback->init_input(token);
+        siren_timeline_mark("input init");
+
         //detach recording thread
         std::thread t(&RecordingThread::recordingFn, recordingThread);
         recordingThread->setThread(t);
@@ -320,8 +451,11 @@ siren_status_t SirenProxy::init_siren(void *token, const char *path, siren_input
             });
 
             siren_printf(SIREN_INFO, "siren base init done");
+            siren_timeline_mark("siren base init done");
             if (sirenBaseInitFailed) {
-                stopRequestThread(true);
+                //siren thread waits for destroy to return, a forked
+                //siren base may be gone already
+                stopRequestThread(!sirenInThread);
                 //waiting response thread exit;
                 siren_printf(SIREN_INFO, "waiting request thread exit");
                 if (responseThread.joinable()) {
@@ -330,10 +464,21 @@ siren_status_t SirenProxy::init_siren(void *token, const char *path, siren_input
 
                 siren_printf(SIREN_INFO, "waiting recording thread exit");
                 recordingThread->stop();
+
+                if (sirenInThread && sirenThread.joinable()) {
+                    siren_printf(SIREN_INFO, "waiting siren thread exit");
+                    sirenThread.join();
+                }
+
+                //input was opened while siren base loaded
+                input_callback->release_input(token);
+            } else if (supervisor) {
+                supervisor->start();
             }
         }
         siren_printf(SIREN_INFO, "siren init done");
-        input_callback->init_input(token);
+        siren_timeline_mark("siren init done");
+        siren_timeline_dump("siren proxy");
         allocated_from_thread = true;
     }
     return result;
@@ -370,8 +515,9 @@ void SirenProxy::requestThreadHandler() {
         requestWriter.writeMessage(req);
         //siren_printf(SIREN_INFO, "proxy request thread write msg %d to siren", req->msg);
 
+        int msg = req->msg;
         delete [] (char *)req;
-        if (req->msg == SIREN_REQUEST_MSG_DESTROY) {
+        if (msg == SIREN_REQUEST_MSG_DESTROY) {
             return;
         }
     }
@@ -386,6 +532,11 @@ void SirenProxy::requestThreadHandler() {
 }
 
 void SirenProxy::stopRequestThread(bool onInit) {
+    //a destroy left in queue would stop next request thread at once
+    if (!requestThread.joinable()) {
+        return;
+    }
+
     int msg;
     if (onInit) {
         msg = SIREN_REQUEST_MSG_DESTROY_ON_INIT;
@@ -410,7 +561,9 @@ void SirenProxy::launchRequestThread() {
 void SirenProxy::responseThreadHandler() {
     SirenSocketReader responseReader(&responseChannel);
     responseReader.prepareOnReadSideProcess();
+    SirenEventPool &eventPool = SirenEventPool::instance();
     while (1) {
+        SirenEventBlock *block = nullptr;
         Message *msg = nullptr;
         int status = SIREN_CHANNEL_OK;
         bool destroy = false;
@@ -421,17 +574,30 @@ void SirenProxy::responseThreadHandler() {
             launchCond.notify_one();
         }
 
-        if ((status = responseReader.pollMessage(&msg)) != SIREN_CHANNEL_OK) {
+        if ((status = responseReader.pollMessage(&block)) != SIREN_CHANNEL_OK) {
             siren_printf(SIREN_ERROR, "proxy response thread poll message failed with %d, response thread exit", status);
-            std::this_thread::sleep_for(std::chrono::microseconds(100));
-            //continue;
+            //a lost forked siren was reaped by SIGCHLD handler
+            log_sig_child_reaped();
+            {
+                //siren base died before it told init result
+                std::unique_lock<decltype(initMutex)> l_(initMutex);
+                if (!waitingInit) {
+                    waitingInit = true;
+                    sirenBaseInitFailed = true;
+                    initCond.notify_one();
+                }
+            }
+            if (supervisor) {
+                supervisor->onChildLost();
+            }
             return;
         }
 
-        if (msg == nullptr) {
+        if (block == nullptr) {
             siren_printf(SIREN_ERROR, "proxy response read null msg");
             continue;
         }
+        msg = block->message();
 
         switch (msg->msg) {
         case SIREN_RESPONSE_MSG_ON_INIT_OK: {
@@ -449,7 +615,7 @@ void SirenProxy::responseThreadHandler() {
                 sirenBaseInitFailed = true;
                 initCond.notify_one();
 
-                delete [] (char *)msg;
+                eventPool.unref(block);
                 return;
             }
         }
@@ -468,8 +634,9 @@ void SirenProxy::responseThreadHandler() {
                     pProcessedVoiceResult->data = pData;
                 }
 
-                voice_event_t *voice_event = new voice_event_t;
-                memset((char *)voice_event, 0, sizeof(voice_event_t));
+                //event and voice data share the message block, callback
+                //may keep it by siren_event_ref instead of copying
+                voice_event_t *voice_event = &block->event;
 
                 voice_event->event = (siren_event_t)pProcessedVoiceResult->prop;
                 voice_event->length = pProcessedVoiceResult->size;
@@ -489,15 +656,22 @@ void SirenProxy::responseThreadHandler() {
                     voice_event->vt.energy = pProcessedVoiceResult->vt_energy;
                     voice_event->buff = pProcessedVoiceResult->data;
                 }
+                //subscribers queue it first, proc_callback runs here
+                eventHub.publish(block);
                 proc_callback->voice_event_callback(token, voice_event);
-                delete voice_event;
             } else {
                 siren_printf(SIREN_ERROR, "read voice result nullptr");
             }
         }
         break;
         case SIREN_RESPONSE_MSG_ON_RAW_VOICE: {
-        } break;
+            //pcm stays in the message block, callback may keep it by
+            //siren_raw_ref instead of copying
+            if (rawStreamStart && raw_callback != nullptr && msg->len > 0) {
+                raw_callback->raw_voice_callback(token, msg->len, msg->data);
+            }
+        }
+        break;
         case SIREN_RESPONSE_MSG_ON_CALLBACK: {
             int *t = nullptr;
             t = (int *)msg->data;
@@ -513,6 +687,30 @@ void SirenProxy::responseThreadHandler() {
                 stateChangeCallback(token, prevState);
             }
             break;
+            case SIREN_CALLBACK_ON_CONFIG_RELOADED: {
+                std::unique_lock<decltype(reloadResultMutex)> l_(reloadResultMutex);
+                uint32_t seq = (uint32_t)t[2];
+                if (reloadLost && seq == lostReloadSeq) {
+                    //late reply of a reload given up on, siren runs what it says
+                    siren_printf(SIREN_WARNING, "reload %u answered after timeout", seq);
+                    if (t[1] != 0) {
+                        global_config->getConfigFile() = lostReloadConfig;
+                    }
+                    reloadLost = false;
+                } else if (seq == reloadSeq && !reloadDone) {
+                    reloadResult = t[1] != 0;
+                    reloadDone = true;
+                    reloadCond.notify_one();
+                } else {
+                    siren_printf(SIREN_WARNING, "ignore reply of reload %u", seq);
+                }
+            }
+            break;
+            case SIREN_CALLBACK_ON_AEC_DELAY: {
+                std::lock_guard<decltype(aecStatsMutex)> l_(aecStatsMutex);
+                memcpy(&aecStats, t + 1, sizeof(siren_aec_stats_t));
+            }
+            break;
             }
         }
         break;
@@ -521,11 +719,17 @@ void SirenProxy::responseThreadHandler() {
             destroy = true;
         }
         break;
+        case SIREN_RESPONSE_MSG_ON_HEARTBEAT: {
+            if (supervisor) {
+                supervisor->onHeartbeat();
+            }
+        }
+        break;
         default: {
         }
         }
 
-        delete [] (char *)msg;
+        eventPool.unref(block);
         if (destroy) {
             break;
         }
@@ -544,13 +748,26 @@ void SirenProxy::launchResponseThread() {
     responseThread = std::move(t);
 }
 
+bool SirenProxy::startInput() {
+    if (procStreamStart || rawStreamStart) {
+        return true;
+    }
+    return recordingThread->start();
+}
+
+void SirenProxy::pauseInput() {
+    if (!procStreamStart && !rawStreamStart) {
+        recordingThread->pause();
+    }
+}
+
 siren_status_t SirenProxy::start_siren_process_stream(siren_proc_callback_t *callback) {
     if (procStreamStart) {
         siren_printf(SIREN_ERROR, "already start...");
         return SIREN_STATUS_ERROR;
     } else {
         proc_callback = callback;
-        if (!recordingThread->start()) {
+        if (!startInput()) {
             proc_callback = nullptr;
             siren_printf(SIREN_ERROR, "start failed...");
             return SIREN_STATUS_ERROR;
@@ -562,8 +779,24 @@ siren_status_t SirenProxy::start_siren_process_stream(siren_proc_callback_t *cal
     }
     return SIREN_STATUS_OK;
 }
+
 siren_status_t SirenProxy::start_siren_raw_stream(siren_raw_stream_callback_t *callback) {
-    return SIREN_STATUS_ERROR;
+    if (rawStreamStart) {
+        siren_printf(SIREN_ERROR, "raw stream already start...");
+        return SIREN_STATUS_ERROR;
+    }
+
+    raw_callback = callback;
+    if (!startInput()) {
+        raw_callback = nullptr;
+        siren_printf(SIREN_ERROR, "raw stream start failed...");
+        return SIREN_STATUS_ERROR;
+    }
+
+    rawStreamStart = true;
+    Message *req = allocateMessage(SIREN_REQUEST_MSG_START_RAW_STREAM, 0);
+    requestQueue.push((void *)req);
+    return SIREN_STATUS_OK;
 }
 
 
@@ -577,21 +810,35 @@ void SirenProxy::stop_siren_process_stream() {
 
     Message *req = allocateMessage(SIREN_REQUEST_MSG_STOP_PROCESS_STREAM, 0);
     requestQueue.push((void *)req);
-    recordingThread->pause();
+    pauseInput();
 }
 
 void SirenProxy::stop_siren_raw_stream() {
+    if (!rawStreamStart) {
+        siren_printf(SIREN_INFO, "raw stream already stop..");
+        return;
+    }
+    rawStreamStart = false;
 
+    Message *req = allocateMessage(SIREN_REQUEST_MSG_STOP_RAW_STREAM, 0);
+    requestQueue.push((void *)req);
+    pauseInput();
 }
 
 void SirenProxy::stop_siren_stream() {
-
+    stop_siren_process_stream();
+    stop_siren_raw_stream();
 }
 
 void SirenProxy::set_siren_state(siren_state_t state, siren_state_changed_callback_t *callback) {
     Message *req = allocateMessage(SIREN_REQUEST_MSG_SET_STATE, sizeof(int));
     int *state_ = (int *)req->data;
     state_[0] = (int)state;
+    {
+        std::lock_guard<decltype(replayMutex)> l_(replayMutex);
+        hasState = true;
+        lastState = state;
+    }
     if (callback != nullptr) {
         stateChangeCallback = callback->state_changed_callback;
         requestQueue.push(req);
@@ -615,6 +862,12 @@ void SirenProxy::set_siren_steer(float ho, float var) {
     float *degrees = (float *)req->data;
     degrees[0] = ho;
     degrees[1] = var;
+    {
+        std::lock_guard<decltype(replayMutex)> l_(replayMutex);
+        hasSteer = true;
+        lastHo = ho;
+        lastVer = var;
+    }
     requestQueue.push(req);
 }
 
@@ -658,6 +911,7 @@ siren_vt_t SirenProxy::add_vt_word(siren_vt_word *word, bool use_default_setting
         siren_printf(SIREN_ERROR, "vt phone is empty!");
     }
 
+    std::lock_guard<decltype(vtMutex)> l_(vtMutex);
     std::vector<siren_vt_word>::iterator it;
 
     bool has = hasVTWord(word->vt_word.c_str(), it);
@@ -701,7 +955,14 @@ siren_vt_t SirenProxy::add_vt_word(siren_vt_word *word, bool use_default_setting
         word->alg_config.nnet_path = "";
     }
 
+    //a word wire can not carry would fail every later sync too
+    if (SirenVTWireBuilder::measure(*word) < 0) {
+        siren_printf(SIREN_ERROR, "vt word %s too long", word->vt_word.c_str());
+        return SIREN_VT_ERROR;
+    }
+
     vt_words.push_back(*word);
+    vtSynced = true;
     /* TODO
     Message *req = allocateMessage(SIREN_REQUEST_MSG_SYNC_VT_WORD_LIST, sizeof(float) * 2);
     requestQueue.push(req);
@@ -724,6 +985,7 @@ siren_vt_t SirenProxy::remove_vt_word(const char *word) {
         return SIREN_VT_ERROR;
     }
 
+    std::lock_guard<decltype(vtMutex)> l_(vtMutex);
     if (vt_words.empty()) {
         siren_printf(SIREN_ERROR, "words empty");
         return SIREN_VT_ERROR;
@@ -736,6 +998,7 @@ siren_vt_t SirenProxy::remove_vt_word(const char *word) {
         return SIREN_VT_NO_EXIT;
     }
     vt_words.erase(it);
+    vtSynced = true;
     Message *req = allocateMessageFromVTWord(vt_words);
     if (req == nullptr) {
         siren_printf(SIREN_ERROR, "allocate sync vt word msg failed");
@@ -751,6 +1014,7 @@ int SirenProxy::get_vt_word(siren_vt_word **words) {
         return -1;
     }
 
+    std::lock_guard<decltype(vtMutex)> l_(vtMutex);
     if (stored_words != nullptr) {
         delete []stored_words;
     }
@@ -766,6 +1030,10 @@ int SirenProxy::get_vt_word(siren_vt_word **words) {
 }
 
 void SirenProxy::destroy_siren() {
+    watch_config(false);
+    if (supervisor) {
+        supervisor->stop();
+    }
     unset_sig_child_handler();
     //stop recording thread
     recordingThread->stop();
@@ -784,11 +1052,306 @@ void SirenProxy::destroy_siren() {
         responseThread.join();
     }
 
+    //no event comes after response thread
+    eventHub.clear();
+
     siren_printf(SIREN_INFO, "waiting siren exit");
-    waitpid(siren_pid, nullptr, 0);
+    if (sirenInThread) {
+        if (sirenThread.joinable()) {
+            sirenThread.join();
+        }
+    } else if (siren_pid > 0) {
+        waitpid(siren_pid, nullptr, 0);
+    }
+    supervisor.reset();
     siren_printf(SIREN_INFO, "now we can exit...");
 }
 
+bool SirenProxy::spawnSiren() {
+    SirenConfig config;
+    {
+        //reload_config swaps current config under it
+        std::lock_guard<decltype(reloadResultMutex)> l_(reloadResultMutex);
+        config = global_config->getConfigFile();
+        //respawned siren runs exactly it
+        reloadLost = false;
+    }
+
+    {
+        std::lock_guard<decltype(initMutex)> l_(initMutex);
+        waitingInit = false;
+        sirenBaseInitFailed = false;
+    }
+    {
+        std::lock_guard<decltype(launchMutex)> l_(launchMutex);
+        requestResponseLaunch = false;
+    }
+
+    //channels of lost siren base were closed with its proxy threads
+    if (!requestChannel.open()) {
+        return false;
+    }
+    if (!responseChannel.open()) {
+        requestChannel.close();
+        return false;
+    }
+    if (!recordingThread->reopen()) {
+        requestChannel.close();
+        responseChannel.close();
+        return false;
+    }
+
+    int pid = fork();
+    if (pid < 0) {
+        siren_printf(SIREN_ERROR, "fork siren failed with %s", strerror(errno));
+        requestChannel.close();
+        responseChannel.close();
+        return false;
+    } else if (pid == 0) {
+        runSirenBase(config, &requestChannel, &responseChannel, recordingThread->getReader());
+        siren_printf(SIREN_ERROR, "siren exit..");
+        exit(0);
+    }
+
+    siren_pid = pid;
+    recordingThread->getWriter();
+    launchRequestThread();
+    launchResponseThread();
+    waitingRequestResponseThread();
+
+    std::unique_lock<decltype(initMutex)> l_(initMutex);
+    if (!initCond.wait_for(l_, std::chrono::seconds(SIREN_SPAWN_INIT_TIMEOUT), [this] {
+        return waitingInit;
+    })) {
+        siren_printf(SIREN_ERROR, "respawned siren init timeout");
+        return false;
+    }
+    return !sirenBaseInitFailed;
+}
+
+void SirenProxy::reapSiren() {
+    if (siren_pid > 0) {
+        //hung siren never reads destroy, exited one is just waited
+        kill(siren_pid, SIGKILL);
+        waitpid(siren_pid, nullptr, 0);
+        siren_pid = -1;
+    }
+
+    stopRequestThread(true);
+    //poll of response thread fails once siren is gone
+    if (responseThread.joinable()) {
+        responseThread.join();
+    }
+}
+
+void SirenProxy::replaySiren() {
+    {
+        std::lock_guard<decltype(vtMutex)> l_(vtMutex);
+        if (vtSynced) {
+            Message *req = allocateMessageFromVTWord(vt_words);
+            if (req != nullptr) {
+                requestQueue.push(req);
+            }
+        }
+    }
+
+    std::lock_guard<decltype(replayMutex)> l_(replayMutex);
+    if (hasState) {
+        Message *req = allocateMessage(SIREN_REQUEST_MSG_SET_STATE, sizeof(int));
+        ((int *)req->data)[0] = (int)lastState;
+        requestQueue.push(req);
+    }
+
+    if (hasSteer) {
+        Message *req = allocateMessage(SIREN_REQUEST_MSG_SET_STEER, sizeof(float) * 2);
+        float *degrees = (float *)req->data;
+        degrees[0] = lastHo;
+        degrees[1] = lastVer;
+        requestQueue.push(req);
+    }
+
+    if (procStreamStart) {
+        requestQueue.push(allocateMessage(SIREN_REQUEST_MSG_START_PROCESS_STREAM, 0));
+    }
+    if (rawStreamStart) {
+        requestQueue.push(allocateMessage(SIREN_REQUEST_MSG_START_RAW_STREAM, 0));
+    }
+    siren_printf(SIREN_INFO, "replay siren state to respawned siren");
+}
+
+void SirenProxy::get_supervisor_stats(siren_supervisor_stats_t *stats) {
+    memset(stats, 0, sizeof(siren_supervisor_stats_t));
+    if (supervisor) {
+        supervisor->getStats(stats);
+    }
+}
+
+void SirenProxy::get_aec_stats(siren_aec_stats_t *stats) {
+    std::lock_guard<decltype(aecStatsMutex)> l_(aecStatsMutex);
+    *stats = aecStats;
+}
+
+siren_status_t SirenProxy::reload_config() {
+    std::lock_guard<decltype(reloadMutex)> l_(reloadMutex);
+    if (global_config == nullptr) {
+        return SIREN_STATUS_ERROR;
+    }
+
+    SirenConfig next;
+    if (global_config->reloadConfigFile(next) != CONFIG_OK) {
+        siren_printf(SIREN_ERROR, "reload config failed, keep current config");
+        return SIREN_STATUS_CONFIG_ERROR;
+    }
+
+    SirenConfig current;
+    bool lost;
+    {
+        std::lock_guard<decltype(reloadResultMutex)> l_(reloadResultMutex);
+        current = global_config->getConfigFile();
+        lost = reloadLost;
+    }
+    SirenConfigChange change;
+    diff_siren_config(current, next, change);
+    //siren may run a timed out reload, the full snapshot is sent to be sure
+    if (change.keys.empty() && !lost) {
+        siren_printf(SIREN_INFO, "reload config without change");
+        return SIREN_STATUS_OK;
+    }
+
+    if (change.restart) {
+        for (size_t i = 0; i < change.keys.size(); i++) {
+            siren_printf(SIREN_WARNING, "reload changed %s", change.keys[i].c_str());
+        }
+        siren_printf(SIREN_WARNING, "reload config need siren restart, keep current config");
+        return SIREN_STATUS_NEED_RESTART;
+    }
+
+    //snapshot is the wire format, no file behind it
+    SirenConfigSource source;
+    memset(&source, 0, sizeof(source));
+    std::string snapshot;
+    encode_siren_config_snapshot(next, source, snapshot);
+
+    std::unique_lock<decltype(reloadResultMutex)> l2_(reloadResultMutex);
+    uint32_t seq = ++reloadSeq;
+    Message *req = allocateMessage(SIREN_REQUEST_MSG_RELOAD_CONFIG, sizeof(seq) + snapshot.size());
+    memcpy(req->data, &seq, sizeof(seq));
+    memcpy(req->data + sizeof(seq), snapshot.data(), snapshot.size());
+    reloadDone = false;
+    requestQueue.push(req);
+    if (!reloadCond.wait_for(l2_, std::chrono::seconds(15), [this] {
+        return reloadDone;
+    })) {
+        //siren keeps it and may still apply it, its late reply tells
+        siren_printf(SIREN_ERROR, "reload config %u timeout", seq);
+        reloadLost = true;
+        lostReloadSeq = seq;
+        lostReloadConfig = next;
+        return SIREN_STATUS_ERROR;
+    }
+
+    //answered in order, siren runs either this one or what it ran before
+    reloadLost = false;
+    if (!reloadResult) {
+        siren_printf(SIREN_ERROR, "siren rolled back reload config");
+        return SIREN_STATUS_ERROR;
+    }
+
+    global_config->getConfigFile() = next;
+    siren_printf(SIREN_INFO, "reload config with %d keys", (int)change.keys.size());
+    return SIREN_STATUS_OK;
+}
+
+siren_status_t SirenProxy::watch_config(bool watch) {
+    std::lock_guard<decltype(watchMutex)> l_(watchMutex);
+    if (!watch) {
+        if (watchThread.joinable()) {
+            uint64_t one = 1;
+            if (write(watchStopFd, &one, sizeof(one)) < 0) {
+                siren_printf(SIREN_ERROR, "wake watch thread failed with %s", strerror(errno));
+            }
+            watchThread.join();
+            close(watchStopFd);
+            watchStopFd = -1;
+        }
+        return SIREN_STATUS_OK;
+    }
+
+    if (watchThread.joinable()) {
+        return SIREN_STATUS_OK;
+    }
+
+    if (global_config == nullptr) {
+        return SIREN_STATUS_ERROR;
+    }
+
+    //editors replace the file, so watch its directory
+    std::string path = global_config->getConfigPath();
+    std::vector<char> dir(path.begin(), path.end());
+    std::vector<char> base(path.begin(), path.end());
+    dir.push_back('\0');
+    base.push_back('\0');
+    watchStopFd = eventfd(0, EFD_CLOEXEC);
+    if (watchStopFd < 0) {
+        siren_printf(SIREN_ERROR, "watch eventfd failed with %s", strerror(errno));
+        return SIREN_STATUS_ERROR;
+    }
+    watchThread = std::thread(&SirenProxy::watchThreadHandler, this,
+                              std::string(dirname(dir.data())), std::string(basename(base.data())));
+    return SIREN_STATUS_OK;
+}
+
+void SirenProxy::watchThreadHandler(std::string dir, std::string name) {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        siren_printf(SIREN_ERROR, "inotify init failed with %s", strerror(errno));
+        return;
+    }
+
+    if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        siren_printf(SIREN_ERROR, "watch %s failed with %s", dir.c_str(), strerror(errno));
+        close(fd);
+        return;
+    }
+
+    siren_printf(SIREN_INFO, "watch config %s in %s", name.c_str(), dir.c_str());
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+    while (true) {
+        struct pollfd pfd[2] = {{fd, POLLIN, 0}, {watchStopFd, POLLIN, 0}};
+        //sleep until the file or stop, a change waits for the quiet
+        //time after last write before reload
+        int ret = poll(pfd, 2, changed ? 200 : -1);
+        if (ret < 0 && errno != EINTR) {
+            siren_printf(SIREN_ERROR, "poll inotify failed with %s", strerror(errno));
+            break;
+        }
+
+        if (ret > 0 && (pfd[1].revents & POLLIN)) {
+            break;
+        }
+
+        if (ret <= 0) {
+            if (changed) {
+                changed = false;
+                reload_config();
+            }
+            continue;
+        }
+
+        ssize_t len = read(fd, buffer, sizeof(buffer));
+        for (ssize_t i = 0; i < len; ) {
+            struct inotify_event *event = (struct inotify_event *)(buffer + i);
+            if (event->len > 0 && name == event->name) {
+                changed = true;
+            }
+            i += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    close(fd);
+}
+
 void SirenProxy::monitorThreadHandler() {
     while (1) {
         UDPMessage msg;
@@ -862,4 +1425,20 @@ siren_status_t SirenProxy::broadcast_siren_event(char *data, int len) {
 }
 
 
+siren_status_t SirenProxy::get_input_format(siren_input_format_t *format) {
+    if (global_config == nullptr) {
+        siren_printf(SIREN_ERROR, "siren not init");
+        return SIREN_STATUS_ERROR;
+    }
+
+    SirenConfig config = global_config->getConfigFile();
+    format->channels = config.mic_channel_num;
+    format->sample_rate = config.mic_sample_rate;
+    format->sample_bytes = config.mic_audio_byte;
+    /* same as RecordingThread reads */
+    format->frame_bytes = config.mic_channel_num * config.mic_sample_rate * config.mic_audio_byte
+        / (1000 / config.mic_frame_length);
+    return SIREN_STATUS_OK;
+}
+
 }
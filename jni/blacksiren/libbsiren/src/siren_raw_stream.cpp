@@ -0,0 +1,380 @@
+#include <sys/resource.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+
+#include <chrono>
+
+#include "sutils.h"
+#include "isiren.h"
+#include "siren_raw_stream.h"
+#include "siren_alg_legacy_helper.h"
+
+#include "r2ssp.h"
+#include "legacy/r2mem_agc.h"
+#include "legacy/r2prs.h"
+
+namespace BlackSiren {
+
+//raw_stream_channel_num at most
+#define SIREN_RAW_CHANNEL_MAX 64
+
+//what the raw thread runs, rebuilt as a whole on reload
+struct SirenRawStreamUnits {
+    ~SirenRawStreamUnits();
+
+    float *micPos = nullptr;
+    float *micDelay = nullptr;
+    r2_mic_info *micInfoIn = nullptr;
+    r2_mic_info *micInfoBf = nullptr;
+
+    r2mem_i *in = nullptr;
+    //steered to alg_raw_stream_sl_direction, null taps preprocessed mics
+    r2mem_bf *bf = nullptr;
+    float bfScaling = 1.0f;
+    //mic ids taken without bf
+    std::vector<int> mics;
+    std::vector<r2mem_agc *> agc;
+
+    r2prs *rs = nullptr;
+    int rsLen = 0;
+    float **rsOut = nullptr;
+
+    int channels = 0;
+    int sampleBytes = 2;
+};
+
+SirenRawStreamUnits::~SirenRawStreamUnits() {
+    delete in;
+    delete bf;
+    for (r2mem_agc *p : agc) {
+        delete p;
+    }
+    delete rs;
+    if (rsOut != nullptr) {
+        for (int i = 0; i < channels; i++) {
+            delete [] rsOut[i];
+        }
+        delete [] rsOut;
+    }
+
+    if (micInfoIn != nullptr) {
+        delete [] micInfoIn->pMicIdLst;
+        delete micInfoIn;
+    }
+    if (micInfoBf != nullptr) {
+        delete [] micInfoBf->pMicIdLst;
+        delete micInfoBf;
+    }
+    delete [] micPos;
+    delete [] micDelay;
+
+    std::lock_guard<std::mutex> l_(r2sspGlobalMutex());
+    r2sspRelease();
+}
+
+static r2_mic_info *newMicInfo(const std::vector<int> &mics) {
+    r2_mic_info *info = new r2_mic_info;
+    info->iMicNum = mics.size();
+    info->pMicIdLst = new int[mics.size()];
+    for (int i = 0; i < (int)mics.size(); i++) {
+        info->pMicIdLst[i] = mics[i];
+    }
+    return info;
+}
+
+static std::unique_ptr<SirenRawStreamUnits> newUnits(const SirenConfig &config) {
+    const AlgConfig &alg = config.alg_config;
+    const RawStreamConfig &raw = config.raw_stream_config;
+    int micNum = config.mic_num;
+    if (alg.alg_aec_mics.empty() || (alg.alg_raw_stream_bf && alg.alg_sl_mics.empty())) {
+        siren_printf(SIREN_ERROR, "raw stream has no mics to take");
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> l_(r2sspGlobalMutex());
+        r2sspAcquire();
+    }
+    std::unique_ptr<SirenRawStreamUnits> units(new SirenRawStreamUnits);
+    units->micPos = new float[micNum * 3];
+    units->micDelay = new float[micNum];
+    memset(units->micPos, 0, sizeof(float) * micNum * 3);
+    memset(units->micDelay, 0, sizeof(float) * micNum);
+    for (int i = 0; i < micNum && i < (int)alg.alg_mic_pos.size(); i++) {
+        for (int j = 0; j < 3; j++) {
+            units->micPos[i * 3 + j] = alg.alg_mic_pos[i].pos[j];
+        }
+    }
+    for (int i = 0; i < (int)alg.alg_need_i2s_delay_mics.size(); i++) {
+        int mic = alg.alg_need_i2s_delay_mics[i];
+        if (mic < micNum && i < (int)alg.alg_i2s_delay_mics.size()) {
+            units->micDelay[mic] = alg.alg_i2s_delay_mics[i];
+        }
+    }
+
+    //preprocessed frames are interleaved in alg_aec_mics order
+    units->micInfoIn = newMicInfo(alg.alg_aec_mics);
+    units->in = new r2mem_i(micNum, r2_in_float_32, units->micInfoIn);
+
+    if (alg.alg_raw_stream_bf) {
+        units->micInfoBf = newMicInfo(alg.alg_sl_mics);
+        units->bf = new r2mem_bf(micNum, units->micPos, units->micDelay, units->micInfoBf);
+        //degrees as given by r2mem_bf::getinfo_sl, which is half a turn off
+        float azimuth = alg.alg_raw_stream_sl_direction * 3.1415926f / 180.0f + 3.1415926f;
+        units->bf->steer(azimuth, 0.0f);
+        units->bfScaling = alg.alg_bf_scaling == 0.0f ? 1.0f : alg.alg_bf_scaling;
+        units->channels = 1;
+        if (raw.raw_stream_channel_num != 1) {
+            siren_printf(SIREN_WARNING, "raw stream bf gives 1 channel, not %d", raw.raw_stream_channel_num);
+        }
+    } else {
+        int n = raw.raw_stream_channel_num;
+        if (n > (int)alg.alg_aec_mics.size()) {
+            siren_printf(SIREN_WARNING, "raw stream has %d mics, not %d",
+                         (int)alg.alg_aec_mics.size(), n);
+            n = alg.alg_aec_mics.size();
+        }
+        units->mics.assign(alg.alg_aec_mics.begin(), alg.alg_aec_mics.begin() + n);
+        units->channels = n;
+    }
+
+    int hop = R2_AUDIO_SAMPLE_RATE / 1000 * config.mic_frame_length;
+    if (alg.alg_raw_stream_agc) {
+        for (int i = 0; i < units->channels; i++) {
+            units->agc.push_back(new r2mem_agc(agcParam(alg)));
+        }
+    }
+
+    if (raw.raw_stream_sample_rate != R2_AUDIO_SAMPLE_RATE) {
+        units->rs = new r2prs(units->channels, R2_AUDIO_SAMPLE_RATE, raw.raw_stream_sample_rate, nullptr);
+        units->rsLen = units->rs->getOutLenMax(hop);
+        units->rsOut = new float*[units->channels];
+        for (int i = 0; i < units->channels; i++) {
+            units->rsOut[i] = new float[units->rsLen];
+        }
+    }
+    units->sampleBytes = raw.raw_stream_byte;
+
+    siren_printf(SIREN_INFO, "raw stream %s, %d channels, agc %s, %d hz, %d bytes",
+                 units->bf != nullptr ? "after bf" : "after preprocess", units->channels,
+                 units->agc.empty() ? "off" : "on", raw.raw_stream_sample_rate, units->sampleBytes);
+    return units;
+}
+
+//floats are at 16 bit scale
+static int clampSample(float value, float scale, int lo, int hi) {
+    float v = roundf(value * scale);
+    if (v <= (float)lo) {
+        return lo;
+    }
+    if (v >= (float)hi) {
+        return hi;
+    }
+    return (int)v;
+}
+
+static void convertSamples(float **chan, int channels, int len, int bytes, char *dst) {
+    for (int i = 0; i < len; i++) {
+        for (int c = 0; c < channels; c++) {
+            float x = chan[c][i];
+            switch (bytes) {
+            case 1:
+                //8 bit pcm is unsigned
+                *(uint8_t *)dst = (uint8_t)(clampSample(x, 1.0f / 256.0f, -128, 127) + 128);
+                break;
+            case 2: {
+                int16_t v = (int16_t)clampSample(x, 1.0f, -32768, 32767);
+                memcpy(dst, &v, sizeof(v));
+            }
+            break;
+            case 3: {
+                int v = clampSample(x, 256.0f, -8388608, 8388607);
+                dst[0] = (char)(v & 0xff);
+                dst[1] = (char)((v >> 8) & 0xff);
+                dst[2] = (char)((v >> 16) & 0xff);
+            }
+            break;
+            default: {
+                //float can not hold INT32_MAX, clamp below it
+                int32_t v = clampSample(x, 65536.0f, -2147483520, 2147483520);
+                memcpy(dst, &v, sizeof(v));
+            }
+            }
+            dst += bytes;
+        }
+    }
+}
+
+SirenRawStream::SirenRawStream(const SirenConfig &config_, SirenSocketWriter &writer_) :
+    config(config_),
+    writer(writer_),
+    queue(MAX_PENDING * 2, nullptr),
+    pending(0),
+    started(false),
+    sent(0),
+    dropped(0) {
+}
+
+SirenRawStream::~SirenRawStream() {
+    destroy();
+}
+
+bool SirenRawStream::init() {
+    units = newUnits(config);
+    if (units == nullptr) {
+        return false;
+    }
+    thread = std::thread(&SirenRawStream::threadHandler, this);
+    return true;
+}
+
+void SirenRawStream::destroy() {
+    if (!thread.joinable()) {
+        return;
+    }
+    started.store(false, std::memory_order_release);
+    PreprocessVoicePackage *voicePackage = allocatePreprocessVoicePackage(SIREN_REQUEST_MSG_DESTROY, 0, 0);
+    queue.push((void *)voicePackage);
+    thread.join();
+    siren_printf(SIREN_INFO, "raw stream sent %llu frames, dropped %llu",
+                 (unsigned long long)getSent(), (unsigned long long)getDropped());
+}
+
+void SirenRawStream::start() {
+    siren_printf(SIREN_INFO, "raw stream start");
+    started.store(true, std::memory_order_release);
+}
+
+void SirenRawStream::stop() {
+    siren_printf(SIREN_INFO, "raw stream stop");
+    started.store(false, std::memory_order_release);
+}
+
+void SirenRawStream::feed(const PreprocessVoicePackage *voicePackage) {
+    //behind, drop the new frame rather than hold recording thread
+    if (pending.load(std::memory_order_acquire) >= MAX_PENDING) {
+        uint64_t n = dropped.fetch_add(1, std::memory_order_relaxed) + 1;
+        if ((n & (n - 1)) == 0) {
+            siren_printf(SIREN_WARNING, "raw stream behind, %llu frames dropped", (unsigned long long)n);
+        }
+        return;
+    }
+
+    PreprocessVoicePackage *copied = allocatePreprocessVoicePackage(voicePackage->msg,
+                                     voicePackage->aec, voicePackage->size);
+    memcpy(copied->data, voicePackage->data, voicePackage->size);
+    pending.fetch_add(1, std::memory_order_acq_rel);
+    queue.push((void *)copied);
+}
+
+void SirenRawStream::reload(const SirenConfig &next) {
+    PreprocessVoicePackage *voicePackage =
+        allocatePreprocessVoicePackage(SIREN_REQUEST_MSG_RELOAD_CONFIG, 0, sizeof(SirenConfig *));
+    voicePackage->data = (char *)new SirenConfig(next);
+    queue.push((void *)voicePackage);
+}
+
+void SirenRawStream::threadHandler() {
+    //below recording and process thread, it is the one to fall behind
+    prctl(PR_SET_NAME, "siren_raw");
+    setpriority(PRIO_PROCESS, syscall(SYS_gettid), 10);
+
+    while (1) {
+        PreprocessVoicePackage *voicePackage = nullptr;
+        if (queue.pop((void **)&voicePackage, nullptr) == ERR_OVERFLOW) {
+            siren_printf(SIREN_WARNING, "raw queue overflow");
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        if (voicePackage == nullptr) {
+            continue;
+        }
+
+        switch (voicePackage->msg) {
+        case SIREN_REQUEST_MSG_DATA_PROCESS: {
+            pending.fetch_sub(1, std::memory_order_acq_rel);
+            if (isStarted()) {
+                processFrame(voicePackage);
+            }
+        }
+        break;
+        case SIREN_REQUEST_MSG_RELOAD_CONFIG: {
+            SirenConfig *next = (SirenConfig *)voicePackage->data;
+            std::unique_ptr<SirenRawStreamUnits> nextUnits = newUnits(*next);
+            if (nextUnits != nullptr) {
+                units = std::move(nextUnits);
+                config = *next;
+            } else {
+                siren_printf(SIREN_ERROR, "raw stream keeps old config");
+            }
+            delete next;
+        }
+        break;
+        case SIREN_REQUEST_MSG_DESTROY: {
+            delete [] (char *)voicePackage;
+            units.reset();
+            return;
+        }
+        }
+        delete [] (char *)voicePackage;
+    }
+}
+
+void SirenRawStream::processFrame(PreprocessVoicePackage *voicePackage) {
+    float **dataMul = nullptr;
+    int len = 0;
+    units->in->process(voicePackage->data, voicePackage->size, dataMul, len);
+    if (len <= 0) {
+        return;
+    }
+
+    int channels = units->channels;
+    float *chan[SIREN_RAW_CHANNEL_MAX];
+    if (units->bf != nullptr) {
+        float *sig = nullptr;
+        int lenSig = 0;
+        units->bf->process(dataMul, len, sig, lenSig);
+        len = lenSig;
+        //same level as bf of processed stream
+        for (int i = 0; i < len; i++) {
+            sig[i] = units->bfScaling > 0 ? sig[i] * units->bfScaling : sig[i] / -units->bfScaling;
+        }
+        chan[0] = sig;
+    } else {
+        for (int i = 0; i < channels; i++) {
+            chan[i] = dataMul[units->mics[i]];
+        }
+    }
+
+    for (int i = 0; i < (int)units->agc.size(); i++) {
+        int lenAgc = 0;
+        units->agc[i]->process(chan[i], len, chan[i], lenAgc);
+    }
+
+    if (units->rs != nullptr) {
+        if (units->rs->getOutLenMax(len) > units->rsLen) {
+            siren_printf(SIREN_ERROR, "raw stream frame of %d samples is too long", len);
+            return;
+        }
+        len = units->rs->process((const float **)chan, len, units->rsOut);
+        for (int i = 0; i < channels; i++) {
+            chan[i] = units->rsOut[i];
+        }
+    }
+    if (len <= 0) {
+        return;
+    }
+
+    int bytes = len * channels * units->sampleBytes;
+    if ((int)out.size() < bytes) {
+        out.resize(bytes);
+    }
+    convertSamples(chan, channels, len, units->sampleBytes, out.data());
+    writer.writeMessage(SIREN_RESPONSE_MSG_ON_RAW_VOICE, out.data(), bytes);
+    sent.fetch_add(1, std::memory_order_relaxed);
+}
+
+}
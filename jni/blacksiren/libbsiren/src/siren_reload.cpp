@@ -0,0 +1,43 @@
+#include <string>
+#include <vector>
+
+#include "sutils.h"
+#include "siren_reload.h"
+
+namespace BlackSiren {
+
+bool apply_siren_config(const std::vector<SirenReloadStage> &stages, const SirenConfig &from,
+                        const SirenConfig &to, SirenConfigChange &change) {
+    diff_siren_config(from, to, change);
+    for (const std::string &key : change.keys) {
+        siren_printf(SIREN_INFO, "reload config: %s changed", key.c_str());
+    }
+    if (change.keys.empty()) {
+        return true;
+    }
+    if (change.restart) {
+        siren_printf(SIREN_ERROR, "reload config: need siren restarted");
+        return false;
+    }
+
+    size_t applied = 0;
+    for (; applied < stages.size(); applied++) {
+        if (!stages[applied].reload(to, change)) {
+            siren_printf(SIREN_ERROR, "reload config: %s failed", stages[applied].name);
+            break;
+        }
+    }
+    if (applied == stages.size()) {
+        return true;
+    }
+
+    while (applied-- > 0) {
+        siren_printf(SIREN_INFO, "reload config: %s rollback", stages[applied].name);
+        if (!stages[applied].reload(from, change)) {
+            siren_printf(SIREN_ERROR, "reload config: %s rollback failed", stages[applied].name);
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,191 @@
+#include <string.h>
+
+#include "sutils.h"
+#include "siren_supervisor.h"
+
+namespace BlackSiren {
+
+static int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int SirenSupervisor::backoff(const SirenSupervisorConfig &config, int failures) {
+    int64_t delay = config.backoffMin;
+    for (int i = 0; i < failures && delay < config.backoffMax; i++) {
+        delay *= 2;
+    }
+    return delay > config.backoffMax ? config.backoffMax : (int)delay;
+}
+
+void SirenSupervisor::start() {
+    std::lock_guard<decltype(mutex)> l_(mutex);
+    if (thread.joinable()) {
+        return;
+    }
+    stopping = false;
+    lost = false;
+    failures = 0;
+    spawnTime = Clock::now();
+    lastHeartbeat.store(nowMs(), std::memory_order_release);
+    thread = std::thread(&SirenSupervisor::supervisorFn, this);
+}
+
+void SirenSupervisor::stop() {
+    {
+        std::lock_guard<decltype(mutex)> l_(mutex);
+        stopping = true;
+        cond.notify_one();
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void SirenSupervisor::onHeartbeat() {
+    lastHeartbeat.store(nowMs(), std::memory_order_release);
+}
+
+void SirenSupervisor::onChildLost() {
+    std::lock_guard<decltype(mutex)> l_(mutex);
+    lost = true;
+    cond.notify_one();
+}
+
+void SirenSupervisor::onGapFrames(uint64_t kept, uint64_t dropped) {
+    std::lock_guard<decltype(statsMutex)> l_(statsMutex);
+    stats.gap_frames += kept;
+    stats.dropped_frames += dropped;
+}
+
+void SirenSupervisor::getStats(siren_supervisor_stats_t *out) {
+    std::lock_guard<decltype(statsMutex)> l_(statsMutex);
+    *out = stats;
+}
+
+bool SirenSupervisor::waitFor(int ms) {
+    std::unique_lock<decltype(mutex)> l_(mutex);
+    cond.wait_for(l_, std::chrono::milliseconds(ms), [this] {
+        return stopping;
+    });
+    return !stopping;
+}
+
+void SirenSupervisor::respawn(bool hang) {
+    down.store(true, std::memory_order_release);
+    {
+        std::lock_guard<decltype(statsMutex)> l_(statsMutex);
+        if (hang) {
+            stats.hangs++;
+        } else {
+            stats.crashes++;
+        }
+    }
+
+    //a child that ran long enough is not part of a crash loop
+    int aliveMs = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - spawnTime).count();
+    if (aliveMs >= config.stableTime) {
+        failures = 0;
+    }
+
+    while (1) {
+        //old child and its proxy threads are gone after reap, so a lost
+        //reported from now on is of the new child
+        child.reap();
+        {
+            std::lock_guard<decltype(mutex)> l_(mutex);
+            lost = false;
+        }
+
+        int delay = backoff(config, failures);
+        siren_printf(SIREN_WARNING, "siren %s, respawn in %d ms", hang ? "hangs" : "exits", delay);
+        if (!waitFor(delay)) {
+            return;
+        }
+
+        spawnTime = Clock::now();
+        lastHeartbeat.store(nowMs(), std::memory_order_release);
+        if (child.spawn()) {
+            break;
+        }
+
+        siren_printf(SIREN_ERROR, "siren respawn failed");
+        failures++;
+        std::lock_guard<decltype(statsMutex)> l_(statsMutex);
+        stats.spawn_failures++;
+    }
+
+    failures++;
+    child.replay();
+    {
+        std::lock_guard<decltype(statsMutex)> l_(statsMutex);
+        stats.restarts++;
+    }
+    lastHeartbeat.store(nowMs(), std::memory_order_release);
+    down.store(false, std::memory_order_release);
+    siren_printf(SIREN_INFO, "siren respawned");
+}
+
+void SirenSupervisor::supervisorFn() {
+    while (1) {
+        bool childLost = false;
+        {
+            std::unique_lock<decltype(mutex)> l_(mutex);
+            cond.wait_for(l_, std::chrono::milliseconds(config.heartbeatInterval), [this] {
+                return stopping || lost;
+            });
+            if (stopping) {
+                return;
+            }
+            childLost = lost;
+        }
+
+        bool hang = nowMs() - lastHeartbeat.load(std::memory_order_acquire) > config.heartbeatTimeout;
+        if (childLost || hang) {
+            respawn(!childLost);
+            continue;
+        }
+
+        child.heartbeat();
+    }
+}
+
+void SirenFrameGap::init(int frameSize_, int frames) {
+    frameSize = frameSize_;
+    capacity = frames;
+    head = 0;
+    count = 0;
+    buffer.assign((size_t)frameSize * capacity, 0);
+}
+
+bool SirenFrameGap::push(const char *frame) {
+    if (capacity == 0) {
+        return false;
+    }
+
+    bool kept = true;
+    if (count == capacity) {
+        //speech at the end of the gap matters more than at its start
+        head = (head + 1) % capacity;
+        count--;
+        kept = false;
+    }
+    int tail = (head + count) % capacity;
+    memcpy(&buffer[(size_t)tail * frameSize], frame, frameSize);
+    count++;
+    return kept;
+}
+
+const char *SirenFrameGap::front() {
+    return count == 0 ? nullptr : &buffer[(size_t)head * frameSize];
+}
+
+void SirenFrameGap::pop() {
+    if (count == 0) {
+        return;
+    }
+    head = (head + 1) % capacity;
+    count--;
+}
+
+}
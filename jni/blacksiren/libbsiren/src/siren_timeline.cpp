@@ -0,0 +1,48 @@
+#include <time.h>
+#include <mutex>
+
+#include "sutils.h"
+#include "siren_timeline.h"
+
+namespace BlackSiren {
+
+//few marks at startup only, lock is fine
+static std::mutex timelineMutex;
+static int64_t timelineBase = 0;
+static std::vector<SirenTimelineStep> timeline;
+
+static int64_t monotonic_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void siren_timeline_begin() {
+    std::lock_guard<decltype(timelineMutex)> l_(timelineMutex);
+    timeline.clear();
+    timeline.reserve(SIREN_TIMELINE_MAX_STEPS);
+    timelineBase = monotonic_us();
+}
+
+void siren_timeline_mark(const char *step) {
+    int64_t now = monotonic_us();
+    std::lock_guard<decltype(timelineMutex)> l_(timelineMutex);
+    if (timeline.size() >= SIREN_TIMELINE_MAX_STEPS) {
+        return;
+    }
+    timeline.push_back({step, now - timelineBase});
+}
+
+std::vector<SirenTimelineStep> siren_timeline_steps() {
+    std::lock_guard<decltype(timelineMutex)> l_(timelineMutex);
+    return timeline;
+}
+
+void siren_timeline_dump(const char *who) {
+    std::vector<SirenTimelineStep> steps = siren_timeline_steps();
+    for (size_t i = 0; i < steps.size(); i++) {
+        siren_printf(SIREN_INFO, "%s startup %8.3f ms %s", who, steps[i].us / 1000.0, steps[i].step);
+    }
+}
+
+}
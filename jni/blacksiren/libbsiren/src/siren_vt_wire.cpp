@@ -0,0 +1,203 @@
+#include <string.h>
+
+#include "siren_vt_wire.h"
+#include "legacy/zvtapi.h"
+
+static_assert(SIREN_VT_WIRE_WORD_MAX < sizeof(WordInfo::pWordContent_UTF8), "vt word longer than WordInfo");
+static_assert(SIREN_VT_WIRE_PHONE_MAX < sizeof(WordInfo::pWordContent_PHONE), "vt phone longer than WordInfo");
+static_assert(SIREN_VT_WIRE_NNET_PATH_MAX < sizeof(WordInfo::pLocalClassifyNnetPath), "nnet path longer than WordInfo");
+
+namespace BlackSiren {
+
+static inline void putU16(char *p, int v) {
+    uint16_t u = (uint16_t)v;
+    memcpy(p, &u, sizeof(u));
+}
+
+static inline int getU16(const char *p) {
+    uint16_t u;
+    memcpy(&u, p, sizeof(u));
+    return u;
+}
+
+static inline void putF32(char *p, float v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline float getF32(const char *p) {
+    float v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+int SirenVTWireBuilder::measure(const siren_vt_word &word) {
+    if (word.vt_word.size() > SIREN_VT_WIRE_WORD_MAX
+            || word.vt_phone.size() > SIREN_VT_WIRE_PHONE_MAX
+            || word.alg_config.nnet_path.size() > SIREN_VT_WIRE_NNET_PATH_MAX) {
+        return -1;
+    }
+    return SIREN_VT_WIRE_WORD_SIZE + word.vt_word.size() + word.vt_phone.size()
+           + word.alg_config.nnet_path.size();
+}
+
+int SirenVTWireBuilder::measure(const std::vector<siren_vt_word> &words) {
+    if (words.size() > 0xffff) {
+        return -1;
+    }
+    int total = SIREN_VT_WIRE_HEADER_SIZE;
+    for (const siren_vt_word &word : words) {
+        int size = measure(word);
+        if (size < 0) {
+            return -1;
+        }
+        total += size;
+    }
+    return total;
+}
+
+bool SirenVTWireBuilder::add(const siren_vt_word &word) {
+    int size = measure(word);
+    if (failed || size < 0 || used + size > len || num == 0xffff) {
+        failed = true;
+        return false;
+    }
+
+    const siren_vt_alg_config &alg = word.alg_config;
+    int flags = (alg.vt_left_sil_det ? SIREN_VT_WIRE_LEFT_SIL_DET : 0)
+                | (alg.vt_right_sil_det ? SIREN_VT_WIRE_RIGHT_SIL_DET : 0)
+                | (alg.vt_remote_check_with_aec ? SIREN_VT_WIRE_REMOTE_CHECK_WITH_AEC : 0)
+                | (alg.vt_remote_check_without_aec ? SIREN_VT_WIRE_REMOTE_CHECK_WITHOUT_AEC : 0)
+                | (alg.vt_local_classify_check ? SIREN_VT_WIRE_LOCAL_CLASSIFY_CHECK : 0);
+
+    char *p = buff + used;
+    p[0] = (char)word.vt_type;
+    p[1] = (char)flags;
+    putF32(p + 2, alg.vt_block_avg_score);
+    putF32(p + 6, alg.vt_block_min_score);
+    putF32(p + 10, alg.vt_classify_shield);
+    putU16(p + 14, word.vt_word.size());
+    putU16(p + 16, word.vt_phone.size());
+    putU16(p + 18, alg.nnet_path.size());
+    p += SIREN_VT_WIRE_WORD_SIZE;
+
+    memcpy(p, word.vt_word.data(), word.vt_word.size());
+    p += word.vt_word.size();
+    memcpy(p, word.vt_phone.data(), word.vt_phone.size());
+    p += word.vt_phone.size();
+    memcpy(p, alg.nnet_path.data(), alg.nnet_path.size());
+
+    used += size;
+    num++;
+    return true;
+}
+
+int SirenVTWireBuilder::finish() {
+    if (failed || len < SIREN_VT_WIRE_HEADER_SIZE) {
+        return -1;
+    }
+    buff[0] = SIREN_VT_WIRE_VERSION;
+    buff[1] = 0;
+    putU16(buff + 2, num);
+    return used;
+}
+
+SirenVTWireParser::SirenVTWireParser(const char *buff_, int len_) :
+    buff(buff_),
+    len(len_),
+    pos(SIREN_VT_WIRE_HEADER_SIZE),
+    num(-1) {
+    if (buff == nullptr || len < SIREN_VT_WIRE_HEADER_SIZE || buff[0] != SIREN_VT_WIRE_VERSION) {
+        bad = true;
+        return;
+    }
+    num = getU16(buff + 2);
+    if (num == 0 && len != SIREN_VT_WIRE_HEADER_SIZE) {
+        bad = true;
+    }
+}
+
+bool SirenVTWireParser::next(SirenVTWireWord &word) {
+    if (bad || parsed == num) {
+        return false;
+    }
+
+    const char *p = buff + pos;
+    if (len - pos < SIREN_VT_WIRE_WORD_SIZE) {
+        bad = true;
+        return false;
+    }
+    int word_len = getU16(p + 14);
+    int phone_len = getU16(p + 16);
+    int nnet_path_len = getU16(p + 18);
+    if (word_len > SIREN_VT_WIRE_WORD_MAX || phone_len > SIREN_VT_WIRE_PHONE_MAX
+            || nnet_path_len > SIREN_VT_WIRE_NNET_PATH_MAX
+            || len - pos - SIREN_VT_WIRE_WORD_SIZE < word_len + phone_len + nnet_path_len) {
+        bad = true;
+        return false;
+    }
+
+    word.type = (unsigned char)p[0];
+    word.flags = (unsigned char)p[1];
+    word.avg_score = getF32(p + 2);
+    word.min_score = getF32(p + 6);
+    word.classify_shield = getF32(p + 10);
+    p += SIREN_VT_WIRE_WORD_SIZE;
+    word.word = p;
+    word.word_len = word_len;
+    p += word_len;
+    word.phone = p;
+    word.phone_len = phone_len;
+    p += phone_len;
+    word.nnet_path = p;
+    word.nnet_path_len = nnet_path_len;
+
+    pos += SIREN_VT_WIRE_WORD_SIZE + word_len + phone_len + nnet_path_len;
+    parsed++;
+    //bytes left after last word mean list and header disagree
+    if (parsed == num && pos != len) {
+        bad = true;
+        return false;
+    }
+    return true;
+}
+
+void toVTWord(const SirenVTWireWord &wire, siren_vt_word &word) {
+    word.vt_type = wire.type;
+    word.vt_word.assign(wire.word, wire.word_len);
+    word.vt_pinyin.clear();
+    word.vt_phone.assign(wire.phone, wire.phone_len);
+    word.use_default_config = false;
+
+    siren_vt_alg_config &alg = word.alg_config;
+    alg.vt_block_avg_score = wire.avg_score;
+    alg.vt_block_min_score = wire.min_score;
+    alg.vt_classify_shield = wire.classify_shield;
+    alg.vt_left_sil_det = (wire.flags & SIREN_VT_WIRE_LEFT_SIL_DET) != 0;
+    alg.vt_right_sil_det = (wire.flags & SIREN_VT_WIRE_RIGHT_SIL_DET) != 0;
+    alg.vt_remote_check_with_aec = (wire.flags & SIREN_VT_WIRE_REMOTE_CHECK_WITH_AEC) != 0;
+    alg.vt_remote_check_without_aec = (wire.flags & SIREN_VT_WIRE_REMOTE_CHECK_WITHOUT_AEC) != 0;
+    alg.vt_local_classify_check = (wire.flags & SIREN_VT_WIRE_LOCAL_CLASSIFY_CHECK) != 0;
+    alg.nnet_path.assign(wire.nnet_path, wire.nnet_path_len);
+}
+
+void toWordInfo(const SirenVTWireWord &wire, WordInfo &info) {
+    info.iWordType = (WordType)wire.type;
+    //only strings are written, not the whole arrays
+    memcpy(info.pWordContent_UTF8, wire.word, wire.word_len);
+    info.pWordContent_UTF8[wire.word_len] = '\0';
+    memcpy(info.pWordContent_PHONE, wire.phone, wire.phone_len);
+    info.pWordContent_PHONE[wire.phone_len] = '\0';
+    memcpy(info.pLocalClassifyNnetPath, wire.nnet_path, wire.nnet_path_len);
+    info.pLocalClassifyNnetPath[wire.nnet_path_len] = '\0';
+
+    info.fBlockAvgScore = wire.avg_score;
+    info.fBlockMinScore = wire.min_score;
+    info.fClassifyShield = wire.classify_shield;
+    info.bLeftSilDet = (wire.flags & SIREN_VT_WIRE_LEFT_SIL_DET) != 0;
+    info.bRightSilDet = (wire.flags & SIREN_VT_WIRE_RIGHT_SIL_DET) != 0;
+    info.bRemoteAsrCheckWithAec = (wire.flags & SIREN_VT_WIRE_REMOTE_CHECK_WITH_AEC) != 0;
+    info.bRemoteAsrCheckWithNoAec = (wire.flags & SIREN_VT_WIRE_REMOTE_CHECK_WITHOUT_AEC) != 0;
+    info.bLocalClassifyCheck = (wire.flags & SIREN_VT_WIRE_LOCAL_CLASSIFY_CHECK) != 0;
+}
+
+}
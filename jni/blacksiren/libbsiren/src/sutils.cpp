@@ -12,19 +12,74 @@
 #include <sys/wait.h>
 #include <errno.h>
 
+#include <atomic>
+#include <mutex>
+
 #include "../include/sutils.h"
 #include "../include/os.h"
 
 namespace BlackSiren {
 
+//children reaped by the handler, logged later by log_sig_child_reaped
+//since a handler landing on a logging thread must not log itself
+#define SIG_CHILD_REAPED_SLOTS 16
+
+struct SigChildReaped {
+    std::atomic<int> ready;
+    pid_t pid;
+    int status;
+};
+
+static SigChildReaped sig_child_reaped[SIG_CHILD_REAPED_SLOTS];
+static std::atomic<uint32_t> sig_child_head(0);
+static std::atomic<uint32_t> sig_child_tail(0);
+static std::atomic<uint32_t> sig_child_dropped(0);
+static std::mutex sig_child_log_mutex;
+
 static void sig_child_handler(int sig) {
-    siren_printf(SIREN_INFO, "received sig %d", sig);
+    (void)sig;
     pid_t pid;
     int status;
 
     int saved_errno = errno;
 
     while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        uint32_t head = sig_child_head.load(std::memory_order_relaxed);
+        bool full = false;
+        do {
+            if (head - sig_child_tail.load(std::memory_order_acquire) >= SIG_CHILD_REAPED_SLOTS) {
+                full = true;
+                break;
+            }
+        } while (!sig_child_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed));
+        if (full) {
+            sig_child_dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        SigChildReaped &reaped = sig_child_reaped[head % SIG_CHILD_REAPED_SLOTS];
+        reaped.pid = pid;
+        reaped.status = status;
+        reaped.ready.store(1, std::memory_order_release);
+    }
+
+    errno = saved_errno;
+}
+
+void log_sig_child_reaped() {
+    std::lock_guard<std::mutex> l_(sig_child_log_mutex);
+    uint32_t tail = sig_child_tail.load(std::memory_order_relaxed);
+    while (tail != sig_child_head.load(std::memory_order_acquire)) {
+        SigChildReaped &reaped = sig_child_reaped[tail % SIG_CHILD_REAPED_SLOTS];
+        if (!reaped.ready.load(std::memory_order_acquire)) {
+            //claimed, handler still writing it
+            break;
+        }
+        pid_t pid = reaped.pid;
+        int status = reaped.status;
+        reaped.ready.store(0, std::memory_order_relaxed);
+        sig_child_tail.store(++tail, std::memory_order_release);
+
         if (WIFEXITED(status)) {
             if (WEXITSTATUS(status)) {
                 siren_printf(SIREN_INFO, "Process %d exited cleanly (%d)", pid, WEXITSTATUS(status));
@@ -39,7 +94,10 @@ static void sig_child_handler(int sig) {
         }
     }
 
-    errno = saved_errno;
+    uint32_t dropped = sig_child_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        siren_printf(SIREN_WARNING, "%u reaped children not logged", dropped);
+    }
 }
 
 void set_sig_child_handler() {
@@ -62,24 +120,9 @@ void unset_sig_child_handler() {
     if (err < 0) {
         siren_printf(SIREN_ERROR, "Error settings SIGCHLD handler: %s", strerror(errno));
     }
+    log_sig_child_reaped();
 }
 
-#ifdef CONFIG_ANDROID_LOG
-static int siren_to_android_level(int level) {
-    if (level == SIREN_DEBUG) {
-        return ANDROID_LOG_DEBUG;
-    } else if (level == SIREN_INFO) {
-        return ANDROID_LOG_INFO;
-    } else if (level == SIREN_WARNING) {
-        return ANDROID_LOG_WARN;
-    } else if (level == SIREN_ERROR) {
-        return ANDROID_LOG_ERROR;
-    } else {
-        return ANDROID_LOG_INFO;
-    }
-}
-#endif
-
 void siren_debug_print_timestamp() {
     /* Fix: use os file to make it ok to porting to other OSs
      */
@@ -88,22 +131,5 @@ void siren_debug_print_timestamp() {
     printf ("[%ld.%06u]: ", (long) tv.sec, (unsigned int) tv.usec);
 }
 
-void siren_printf(int level, const char *fmt, ...) {
-    va_list ap;
-
-    va_start(ap, fmt);
-    {
-#ifdef CONFIG_ANDROID_LOG
-        __android_log_vprint(
-            siren_to_android_level(level),
-            ANDROID_LOG_TAG, fmt, ap);
-#endif
-        SIREN_UNUSED(level);
-        siren_debug_print_timestamp();
-        vprintf(fmt, ap);
-        printf("\n");
-    }
-    va_end(ap);
-}
 
 }
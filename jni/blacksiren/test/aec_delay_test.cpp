@@ -0,0 +1,346 @@
+// Test far end delay estimation r2aecdelay on plain linux with synthetic
+// echo: speech like bursts played through a short room response at a
+// known offset, under near end noise. Checks lock time and accuracy for
+// echo behind and ahead of reference, a step in the offset, slow clock
+// drift, no lock without playback, then echo return loss enhancement of a
+// plain nlms canceller with and without alignment, and cost per frame.
+//
+// Recorded echo can be replayed through it, 16k mono s16 files of mic and
+// of reference, delay track and erle are printed instead of checked.
+//
+// build (in jni/blacksiren):
+//   g++ -std=c++11 -O2 -Ilibbsiren/include -o aec_delay_test
+//   test/aec_delay_test.cpp libbsiren/src/legacy/r2aecdelay.cpp
+// run:
+//   ./aec_delay_test [mic.pcm ref.pcm]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+#include "legacy/r2aecdelay.h"
+
+using std::vector;
+using std::chrono::steady_clock;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static const int RATE = 16000;
+static const int FRAME = 256;
+static const int MAX_DELAY = RATE / 1000 * 200;
+static const int ROOM_TAPS = 64;
+
+static float urand() {
+    return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+// noise in syllable sized bursts with pauses, like tts playback
+static vector<float> speech(int len, float level) {
+    vector<float> out(len, 0.0f);
+    int i = 0;
+    while (i < len) {
+        int on = RATE / 1000 * (80 + rand() % 220);
+        int off = RATE / 1000 * (30 + rand() % 150);
+        float amp = level * (0.3f + 0.7f * (urand() + 1.0f) / 2.0f);
+        float lp = 0.0f;
+        for (int k = 0; k < on && i < len; k++, i++) {
+            lp = 0.7f * lp + 0.3f * urand();
+            float ramp = k < 160 ? k / 160.0f : (on - k < 160 ? (on - k) / 160.0f : 1.0f);
+            out[i] = amp * ramp * lp;
+        }
+        i += off;
+    }
+    return out;
+}
+
+// echo of ref at delay(n), through a decaying room response, plus noise.
+// negative delay means mic hears it before reference shows it
+template <typename F>
+static vector<float> echo(const vector<float> &ref, F delay, float noise) {
+    static vector<float> room;
+    if (room.empty()) {
+        for (int k = 0; k < ROOM_TAPS; k++) {
+            room.push_back(0.6f * expf(-k / 12.0f) * (k == 0 ? 1.0f : urand()));
+        }
+    }
+    vector<float> mic(ref.size(), 0.0f);
+    for (int n = 0; n < (int)mic.size(); n++) {
+        float s = 0.0f;
+        int d = delay(n);
+        for (int k = 0; k < ROOM_TAPS; k++) {
+            int m = n - d - k;
+            if (m >= 0 && m < (int)ref.size()) {
+                s += room[k] * ref[m];
+            }
+        }
+        mic[n] = s + noise * urand();
+    }
+    return mic;
+}
+
+struct Track {
+    vector<int> delay;
+    vector<int> align;
+    vector<int> locked;
+    int changes = 0;
+    int first = 0;
+};
+
+// mic and ref through r2aecdelay in place, frame by frame
+static Track run(vector<float> &mic, vector<float> &ref) {
+    r2aecdelay dly(1, 1, FRAME, MAX_DELAY);
+    Track t;
+    for (int n = 0; n + FRAME <= (int)mic.size(); n += FRAME) {
+        dly.process(&mic[n], &ref[n]);
+        t.delay.push_back(dly.m_iDelay);
+        t.align.push_back(dly.m_iAlign);
+        t.locked.push_back(dly.m_bLocked);
+    }
+    t.changes = dly.m_iChanges;
+    t.first = dly.m_iDelayFirst;
+    return t;
+}
+
+// first frame from which delay stays within tol of expect, -1 if never
+static int settle(const Track &t, int from, int to, int expect, int tol) {
+    int frame = -1;
+    for (int i = from; i < to && i < (int)t.delay.size(); i++) {
+        if (t.locked[i] && abs(t.delay[i] - expect) <= tol) {
+            if (frame < 0) {
+                frame = i;
+            }
+        } else {
+            frame = -1;
+        }
+    }
+    return frame;
+}
+
+static double frames_ms(int frames) {
+    return frames * 1000.0 * FRAME / RATE;
+}
+
+static void test_fixed(int delay) {
+    vector<float> ref = speech(RATE * 10, 8000.0f);
+    vector<float> mic = echo(ref, [delay](int) {
+        return delay;
+    }, 30.0f);
+    Track t = run(mic, ref);
+
+    int frames = (int)t.delay.size();
+    int at = settle(t, 0, frames, delay, 48);
+    printf("fixed %5.1f ms: locked after %.0f ms, estimate %d, align %d\n",
+           delay * 1000.0 / RATE, at < 0 ? -1.0 : frames_ms(at), t.delay[frames - 1], t.align[frames - 1]);
+    CHECK(at >= 0 && frames_ms(at) < 3000.0);
+    if (delay > R2AECDELAY_MARGIN) {
+        CHECK(t.align[frames - 1] > 0);
+    } else if (delay < 0) {
+        CHECK(t.align[frames - 1] < 0);
+    } else {
+        CHECK(t.align[frames - 1] == 0);
+    }
+}
+
+static void test_step() {
+    const int before = RATE / 1000 * 80, after = RATE / 1000 * 130;
+    const int len = RATE * 16;
+    vector<float> ref = speech(len, 8000.0f);
+    vector<float> mic = echo(ref, [=](int n) {
+        return n < len / 2 ? before : after;
+    }, 30.0f);
+    Track t = run(mic, ref);
+
+    int frames = (int)t.delay.size();
+    int at = settle(t, frames / 2, frames, after, 48);
+    int relock = at - frames / 2;
+    printf("step 80 -> 130 ms: relocked after %.0f ms, drift %d samples, %d changes\n",
+           at < 0 ? -1.0 : frames_ms(relock), t.delay[frames - 1] - t.first, t.changes);
+    CHECK(at >= 0 && frames_ms(relock) < 4000.0);
+    CHECK(abs(t.first - before) <= 48);
+    CHECK(abs(t.delay[frames - 1] - t.first - (after - before)) <= 64);
+}
+
+static void test_drift() {
+    //ten samples per second, 625ppm, worse than any board clock
+    const int len = RATE * 30;
+    const int start = RATE / 1000 * 60;
+    vector<float> ref = speech(len, 8000.0f);
+    vector<float> mic = echo(ref, [=](int n) {
+        return start + n / (RATE / 10);
+    }, 30.0f);
+    Track t = run(mic, ref);
+
+    //estimate only moves by more than one envelope point
+    int worst = 0;
+    for (int i = (int)t.delay.size() / 4; i < (int)t.delay.size(); i++) {
+        int truth = start + i * FRAME / (RATE / 10);
+        worst = abs(t.delay[i] - truth) > worst ? abs(t.delay[i] - truth) : worst;
+    }
+    int truthEnd = start + len / (RATE / 10);
+    printf("drift %d samples in 30s: tracked within %d samples, reported drift %d\n",
+           truthEnd - start, worst, t.delay.back() - t.first);
+    CHECK(worst <= 96);
+}
+
+static void test_no_playback() {
+    //near end talker, reference silent
+    vector<float> ref(RATE * 10, 0.0f);
+    vector<float> mic = speech(RATE * 10, 8000.0f);
+    Track t = run(mic, ref);
+    CHECK(!t.locked.back());
+    CHECK(t.align.back() == 0);
+}
+
+// nlms over ROOM_TAPS + margin, erle of the last seconds and time to 10db
+static void nlms_erle(const vector<float> &mic, const vector<float> &ref, double &erle, double &convergeMs) {
+    const int taps = 256;
+    const float mu = 0.5f;
+    vector<float> w(taps, 0.0f);
+    double power = 0.0;
+    for (int k = 0; k < taps; k++) {
+        power += (double)ref[k] * ref[k];
+    }
+    int tail = (int)mic.size() * 2 / 3;
+    double micE = 0.0, errE = 0.0;
+    double blockMic = 0.0, blockErr = 0.0;
+    convergeMs = -1.0;
+    for (int n = taps; n < (int)mic.size(); n++) {
+        const float *x = &ref[n - taps + 1];
+        float y = 0.0f;
+        for (int k = 0; k < taps; k++) {
+            y += w[k] * x[k];
+        }
+        power += (double)ref[n] * ref[n] - (double)ref[n - taps] * ref[n - taps];
+        float e = mic[n] - y;
+        float g = mu * e / (float)(power + 1e3);
+        for (int k = 0; k < taps; k++) {
+            w[k] += g * x[k];
+        }
+        if (n >= tail) {
+            micE += (double)mic[n] * mic[n];
+            errE += (double)e * e;
+        }
+        blockMic += (double)mic[n] * mic[n];
+        blockErr += (double)e * e;
+        if ((n + 1) % (RATE / 10) == 0) {
+            if (convergeMs < 0.0 && blockErr > 0.0 && 10.0 * log10(blockMic / blockErr) > 10.0) {
+                convergeMs = (n + 1) * 1000.0 / RATE;
+            }
+            blockMic = blockErr = 0.0;
+        }
+    }
+    erle = 10.0 * log10(micE / (errE + 1e-30));
+}
+
+static void test_erle() {
+    const int delay = RATE / 1000 * 90;
+    vector<float> ref = speech(RATE * 20, 8000.0f);
+    vector<float> mic = echo(ref, [=](int) {
+        return delay;
+    }, 10.0f);
+
+    double rawErle, rawMs, alignErle, alignMs;
+    nlms_erle(mic, ref, rawErle, rawMs);
+    vector<float> amic(mic), aref(ref);
+    run(amic, aref);
+    nlms_erle(amic, aref, alignErle, alignMs);
+
+    printf("erle at 90 ms, 16 ms nlms: %.1f db unaligned, %.1f db aligned, 10 db after %.0f ms\n",
+           rawErle, alignErle, alignMs);
+    CHECK(rawErle < 3.0);
+    CHECK(alignErle > 20.0);
+    CHECK(alignMs > 0.0 && alignMs < 4000.0);
+}
+
+static void bench() {
+    const int mics = 8;
+    r2aecdelay dly(mics, 2, FRAME, MAX_DELAY);
+    vector<float> mic(mics * FRAME), ref(2 * FRAME);
+    for (int i = 0; i < (int)mic.size(); i++) {
+        mic[i] = urand() * 1000.0f;
+    }
+    for (int i = 0; i < (int)ref.size(); i++) {
+        ref[i] = urand() * 1000.0f;
+    }
+    //10s of audio
+    int frames = RATE * 10 / FRAME;
+    steady_clock::time_point begin = steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        dly.process(mic.data(), ref.data());
+    }
+    double sec = std::chrono::duration<double>(steady_clock::now() - begin).count();
+    printf("bench %d mics 2 refs, %d lags: %.4f ms per 16ms frame\n", mics, dly.m_iLagNum, sec * 1000.0 / frames);
+}
+
+static vector<float> load(const char *path) {
+    vector<float> out;
+    FILE *fp = fopen(path, "rb");
+    if (fp == nullptr) {
+        printf("can not open %s\n", path);
+        return out;
+    }
+    short s;
+    while (fread(&s, sizeof(s), 1, fp) == 1) {
+        out.push_back(s);
+    }
+    fclose(fp);
+    return out;
+}
+
+static int replay(const char *micPath, const char *refPath) {
+    vector<float> mic = load(micPath), ref = load(refPath);
+    size_t len = mic.size() < ref.size() ? mic.size() : ref.size();
+    if (len < FRAME) {
+        return 1;
+    }
+    mic.resize(len);
+    ref.resize(len);
+
+    double rawErle, rawMs, alignErle, alignMs;
+    nlms_erle(mic, ref, rawErle, rawMs);
+    vector<float> amic(mic), aref(ref);
+    Track t = run(amic, aref);
+    nlms_erle(amic, aref, alignErle, alignMs);
+
+    for (int i = 0, last = 1 << 30; i < (int)t.delay.size(); i++) {
+        if (t.locked[i] && t.delay[i] != last) {
+            printf("%8.0f ms: delay %d samples, align %d\n", frames_ms(i), t.delay[i], t.align[i]);
+            last = t.delay[i];
+        }
+    }
+    printf("drift %d samples, %d changes, erle %.1f db unaligned, %.1f db aligned\n",
+           t.delay.back() - t.first, t.changes, rawErle, alignErle);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3) {
+        return replay(argv[1], argv[2]);
+    }
+
+    srand(1);
+    test_fixed(RATE / 1000 * 80);
+    test_fixed(RATE / 1000 * 2);
+    test_fixed(-RATE / 1000 * 40);
+    test_step();
+    test_drift();
+    test_no_playback();
+    test_erle();
+    bench();
+
+    if (failures != 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
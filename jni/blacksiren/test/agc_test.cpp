@@ -0,0 +1,215 @@
+// Test agc of upload path on plain linux: syllable like bursts over a
+// steady noise at input levels 48db apart come out within a few db of
+// each other and of alg_agc_target_db, no output peak goes over the
+// limit, a sudden loud burst after quiet speech is limited at once,
+// noise floor settles on the noise, gain holds over pauses and reset
+// starts an utterance from unity gain. Ends with cpu of one 10ms frame.
+//
+// build (in jni/blacksiren), add -DR2AGC_NO_SIMD for the scalar kernels:
+//   g++ -std=c++11 -O2 -Itest/stub -Ilibbsiren/include -Ilibbsiren/include/legacy
+//   -Ilibbsiren/prebuilt/support/include -o agc_test test/agc_test.cpp
+//   libbsiren/src/legacy/r2mem_agc.cpp libbsiren/src/legacy/r2math.cpp
+// run:
+//   ./agc_test
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+#include "legacy/r2mem_agc.h"
+
+using std::vector;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static const int FRAME = R2_AUDIO_SAMPLE_RATE / 1000 * R2_AUDIO_FRAME_MS;
+static const float FULL = 32768.0f;
+
+static float db2amp(float db) {
+    return FULL * powf(10.0f, db / 20.0f);
+}
+
+static float noise(unsigned &seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return ((seed >> 8) / 8388608.0f - 1.0f) * 1.732f;
+}
+
+// speech like: 180ms voiced bursts (two partials under a hann) with 120ms
+// pauses, rms of a burst at speechDb, white noise at noiseDb throughout
+struct Utterance {
+    vector<float> pcm;
+    //sample ranges of bursts
+    vector<int> on;
+};
+
+static Utterance makeUtterance(float speechDb, float noiseDb, float seconds, unsigned seed) {
+    Utterance u;
+    int n = (int)(seconds * R2_AUDIO_SAMPLE_RATE);
+    int burst = R2_AUDIO_SAMPLE_RATE * 180 / 1000;
+    int period = R2_AUDIO_SAMPLE_RATE * 300 / 1000;
+    u.pcm.resize(n);
+    //hann has rms sqrt(3/8), the two partials together rms sqrt(1/2)
+    float amp = db2amp(speechDb) / sqrtf(0.375f * 0.5f);
+    for (int i = 0; i < n; i++) {
+        float x = noise(seed) * db2amp(noiseDb);
+        int k = i % period;
+        if (k < burst) {
+            float w = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * k / burst);
+            float f0 = 140.0f + 20.0f * ((i / period) % 3);
+            x += amp * w * (0.7071f * sinf(2.0f * (float)M_PI * f0 * i / R2_AUDIO_SAMPLE_RATE)
+                            + 0.7071f * sinf(2.0f * (float)M_PI * 3.1f * f0 * i / R2_AUDIO_SAMPLE_RATE));
+        }
+        u.pcm[i] = x;
+    }
+    for (int start = 0; start < n; start += period) {
+        u.on.push_back(start);
+        u.on.push_back(r2_min(start + burst, n));
+    }
+    return u;
+}
+
+//runs pcm through agc in frames like processor does
+static vector<float> runAgc(r2mem_agc &agc, const vector<float> &pcm) {
+    vector<float> out(pcm.size());
+    for (size_t i = 0; i + FRAME <= pcm.size(); i += FRAME) {
+        float *po = nullptr;
+        int len = 0;
+        agc.process((float *)&pcm[i], FRAME, po, len);
+        for (int j = 0; j < len; j++) {
+            out[i + j] = po[j];
+        }
+    }
+    return out;
+}
+
+//rms over bursts after a settling time
+static float burstDb(const Utterance &u, const vector<float> &out, float settleS) {
+    double en = 0.0;
+    long n = 0;
+    int settle = (int)(settleS * R2_AUDIO_SAMPLE_RATE);
+    for (size_t b = 0; b + 1 < u.on.size(); b += 2) {
+        for (int i = r2_max(u.on[b], settle); i < u.on[b + 1]; i++) {
+            en += (double)out[i] * out[i];
+            n++;
+        }
+    }
+    return n > 0 ? 10.0f * log10f((float)(en / n) / (FULL * FULL) + 1e-12f) : -120.0f;
+}
+
+static float peakDb(const vector<float> &out) {
+    float peak = 0.0f;
+    for (float x : out) {
+        peak = r2_max(peak, fabsf(x));
+    }
+    return 20.0f * log10f(peak / FULL + 1e-12f);
+}
+
+static void testLevels(const r2agc_param &param) {
+    //quietest comes out under target by what max gain can not make up
+    const float inDb[] = {-48.0f, -42.0f, -36.0f, -30.0f, -24.0f, -18.0f, -12.0f, -6.0f, 0.0f};
+    float lo = 100.0f, hi = -100.0f;
+    printf("burst in db -> out db (target %.0f, gain %.0f..%.0f, limit %.0f)\n",
+           param.fTargetDb, param.fMinGainDb, param.fMaxGainDb, param.fLimitDb);
+    for (float db : inDb) {
+        Utterance u = makeUtterance(db, db - 30.0f, 4.0f, 7);
+        r2mem_agc agc(param);
+        //noise before speech as processor tracks it between utterances
+        Utterance pre = makeUtterance(-200.0f, db - 30.0f, 1.0f, 3);
+        agc.track(pre.pcm.data(), pre.pcm.size());
+        agc.reset();
+        vector<float> out = runAgc(agc, u.pcm);
+        float outDb = burstDb(u, out, 1.5f);
+        float peak = peakDb(out);
+        printf("  %6.1f -> %6.1f, peak %5.1f, floor %6.1f (noise %6.1f)\n", db, outDb, peak,
+               agc.getfloor_db(), db - 30.0f);
+        CHECK(peak <= param.fLimitDb + 0.01f);
+        CHECK(fabsf(agc.getfloor_db() - (db - 30.0f)) < 4.0f);
+        //what gain range can reach, envelope follows short term level
+        //so bursts sit a few db under target
+        float want = r2_min(r2_max(param.fTargetDb, db + param.fMinGainDb), db + param.fMaxGainDb);
+        CHECK(fabsf(outDb - want) < 4.0f);
+        //spread only where gain is not at an end of its range
+        if (db + param.fMaxGainDb > param.fTargetDb && db + param.fMinGainDb < param.fTargetDb) {
+            lo = r2_min(lo, outDb);
+            hi = r2_max(hi, outDb);
+        }
+    }
+    printf("  spread inside gain range %.1f db\n", hi - lo);
+    CHECK(hi - lo < 3.0f);
+}
+
+static void testLimiter(const r2agc_param &param) {
+    //quiet speech drives gain to max, then a full scale burst
+    Utterance quiet = makeUtterance(-45.0f, -80.0f, 2.0f, 11);
+    Utterance loud = makeUtterance(-3.0f, -80.0f, 0.6f, 13);
+    vector<float> pcm(quiet.pcm);
+    pcm.insert(pcm.end(), loud.pcm.begin(), loud.pcm.end());
+
+    r2mem_agc agc(param);
+    vector<float> out = runAgc(agc, pcm);
+    float peak = peakDb(out);
+    printf("-3 db burst after -45 db speech: output peak %.2f db, limit %.1f db\n",
+           peak, param.fLimitDb);
+    CHECK(peak <= param.fLimitDb + 0.01f);
+}
+
+static void testHoldAndReset(const r2agc_param &param) {
+    Utterance u = makeUtterance(-40.0f, -75.0f, 3.0f, 5);
+    r2mem_agc agc(param);
+    runAgc(agc, u.pcm);
+    float gain = agc.getgain_db();
+
+    //1s of noise alone, gain holds
+    Utterance pause = makeUtterance(-200.0f, -75.0f, 1.0f, 9);
+    runAgc(agc, pause.pcm);
+    printf("gain after speech %.1f db, after 1s pause %.1f db\n", gain, agc.getgain_db());
+    CHECK(gain > 15.0f);
+    CHECK(fabsf(agc.getgain_db() - gain) < 1.0f);
+
+    agc.reset();
+    CHECK(fabsf(agc.getgain_db()) < 0.01f);
+    CHECK(fabsf(agc.getfloor_db() + 75.0f) < 4.0f);
+}
+
+static void benchFrame(const r2agc_param &param) {
+    Utterance u = makeUtterance(-30.0f, -60.0f, 10.0f, 17);
+    r2mem_agc agc(param);
+    int frames = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < 20; r++) {
+        for (size_t i = 0; i + FRAME <= u.pcm.size(); i += FRAME) {
+            float *po = nullptr;
+            int len = 0;
+            agc.process(&u.pcm[i], FRAME, po, len);
+            frames++;
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(t1 - t0).count() / frames;
+    printf("agc %.3f us per %dms frame, %.3f%% of a core\n", us, R2_AUDIO_FRAME_MS,
+           us * 100.0 / (R2_AUDIO_FRAME_MS * 1000.0));
+}
+
+int main() {
+    r2agc_param param;
+    testLevels(param);
+    testLimiter(param);
+    testHoldAndReset(param);
+    benchFrame(param);
+
+    if (failures != 0) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,152 @@
+// Wake to first vad data of beamformed preroll: a noise source is played
+// to a 6 mic circle for some seconds while r2mem_bf and r2mem_bfpre run
+// over it in 10ms hops, then a wake from each direction around is served
+// the old way (copy the word back out of history, reset the bf and
+// beamform it again) and from r2mem_bfpre. Prints time of both, how
+// r2mem_bfpre served it, correlation of its audio with the beamformed
+// again one, and what keeping the beams costs per hop.
+//
+// build (in jni/blacksiren, libbsiren built for linux with its prebuilt
+// libs, e.g. libbsiren/prebuilt/support/libs/linux/arm64):
+//   g++ -std=c++11 -O2 -Ilibbsiren/include -Ilibbsiren/include/legacy
+//   -Ilibbsiren/prebuilt/support/include -o bf_preroll_bench
+//   test/bf_preroll_bench.cpp -Lout -lbsiren -lr2ssp -lpthread
+// run:
+//   ./bf_preroll_bench [dirs] [word ms]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+#include "r2ssp.h"
+#include "legacy/r2mem_bf.h"
+#include "legacy/r2mem_bfpre.h"
+
+using std::vector;
+using std::chrono::steady_clock;
+
+static const int RATE = 16000;
+static const int HOP = RATE / 100;
+static const int MICS = 6;
+static const float RADIUS = 0.035f;
+static const float SOUND = 343.0f;
+static const float PI = 3.1415926f;
+
+static double usSince(steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::micro>(steady_clock::now() - t0).count();
+}
+
+static double correlate(const float *a, const float *b, int len) {
+    double ab = 0.0, aa = 0.0, bb = 0.0;
+    for (int i = 0; i < len; i++) {
+        ab += a[i] * b[i];
+        aa += a[i] * a[i];
+        bb += b[i] * b[i];
+    }
+    return ab / sqrt(aa * bb + 1e-20);
+}
+
+int main(int argc, char **argv) {
+    int dirs = argc > 1 ? atoi(argv[1]) : 6;
+    int wordMs = argc > 2 ? atoi(argv[2]) : 1200;
+    int seconds = 6;
+    int total = RATE * seconds;
+    //word and the 200ms siren takes before it
+    int span = (wordMs + 200) * RATE / 1000;
+
+    r2ssp_ssp_init();
+
+    float pos[MICS * 3];
+    float delay[MICS];
+    for (int m = 0; m < MICS; m++) {
+        pos[m * 3] = RADIUS * cosf(2.0f * PI * m / MICS);
+        pos[m * 3 + 1] = RADIUS * sinf(2.0f * PI * m / MICS);
+        pos[m * 3 + 2] = 0.0f;
+        delay[m] = 0.0f;
+    }
+    r2_mic_info *info = r2_getdefaultmicinfo(MICS);
+
+    //noise from 60 degrees, fractional delay by linear interpolation
+    float srcAz = PI / 3.0f;
+    vector<float> src(total + 64);
+    srand(7);
+    for (auto &s : src) {
+        s = (rand() / (float)RAND_MAX - 0.5f) * 20000.0f;
+    }
+    vector<vector<float>> mic(MICS, vector<float>(total));
+    for (int m = 0; m < MICS; m++) {
+        float d = 32.0f - (pos[m * 3] * cosf(srcAz) + pos[m * 3 + 1] * sinf(srcAz)) / SOUND * RATE;
+        int di = (int)floorf(d);
+        float df = d - di;
+        for (int n = 0; n < total; n++) {
+            int k = n + 64 - di;
+            mic[m][n] = src[k] * (1.0f - df) + src[k - 1] * df;
+        }
+    }
+
+    r2mem_bf bf(MICS, pos, delay, info);
+    r2mem_bfpre pre(MICS, pos, delay, info, dirs, 2500 * RATE / 1000);
+
+    float *hop[MICS];
+    double keepUs = 0.0;
+    for (int n = 0; n + HOP <= total; n += HOP) {
+        for (int m = 0; m < MICS; m++) {
+            hop[m] = mic[m].data() + n;
+        }
+        float *sig = nullptr;
+        int sigLen = 0;
+        bf.process(hop, HOP, sig, sigLen);
+        auto t0 = steady_clock::now();
+        pre.process(hop, HOP, sig, sigLen);
+        keepUs += usSince(t0);
+    }
+    int hops = total / HOP;
+
+    const char *how[] = {"beamform", "select", "interpolate"};
+    float **history = R2_SAFE_NEW_AR2(history, float, MICS, span);
+    vector<float> again(span);
+    double againSum = 0.0, preSum = 0.0;
+    int wakes = 0;
+    printf("%d dirs, word %dms, keeping beams %.1fus per hop\n", dirs, wordMs, keepUs / hops);
+    printf("wake az   again us   preroll us   served by    corr\n");
+    for (int az = 0; az < 360; az += 15) {
+        float ho = az * PI / 180.0f;
+
+        //old way, word out of history then beamformed again
+        auto t0 = steady_clock::now();
+        for (int m = 0; m < MICS; m++) {
+            memcpy(history[m], mic[m].data() + total - span, sizeof(float) * span);
+        }
+        bf.reset();
+        bf.steer(ho, 0.0f);
+        float *sig = nullptr;
+        int sigLen = 0;
+        bf.process(history, span, sig, sigLen);
+        double againUs = usSince(t0);
+        memcpy(again.data(), sig, sizeof(float) * sigLen);
+
+        t0 = steady_clock::now();
+        float *out = nullptr;
+        int served = pre.fetch(ho, 0.0f, span, out);
+        double preUs = usSince(t0);
+
+        //first 150ms is dropped by siren, so is the bf warming up
+        int skip = 15 * HOP;
+        double corr = served == r2bfpre_miss ? 1.0 :
+                      correlate(out + skip, again.data() + skip, span - skip);
+        printf("%6d %10.1f %12.1f   %-12s %5.3f\n", az, againUs, preUs, how[served], corr);
+        againSum += againUs;
+        preSum += served == r2bfpre_miss ? againUs + preUs : preUs;
+        wakes++;
+    }
+    printf("mean wake to vad data: beamform again %.1fus, preroll %.1fus\n",
+           againSum / wakes, preSum / wakes);
+
+    R2_SAFE_DEL_AR2(history);
+    r2_free_micinfo(info);
+    r2ssp_ssp_exit();
+    return 0;
+}
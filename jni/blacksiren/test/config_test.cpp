@@ -0,0 +1,518 @@
+// Test siren config schema on plain linux: shipped configs load clean,
+// malformed configs report every problem, binary snapshot round trips
+// and is refused when corrupt, stale or of other schema, the
+// configuration manager picks the snapshot up, and reload classifies
+// changed keys, applies stages in order and rolls back on failure.
+// Ends with parse vs snapshot load time.
+//
+// build (in jni/blacksiren):
+//   gcc -c -O2 -Ilibjsonc/include libjsonc/src/*.c
+//   g++ -std=c++11 -O2 -DCONFIG_SIREN_LOG_LEVEL=3 -DCONFIG_BACKUP_FILE_PATH=\"/nonexist\"
+//   -I../include -Ilibbsiren/include -Ilibjsonc/include -o config_test test/config_test.cpp
+//   libbsiren/src/siren_config_schema.cpp libbsiren/src/siren_config.cpp
+//   libbsiren/src/siren_reload.cpp libbsiren/src/siren_log.cpp *.o -lpthread
+// run:
+//   ./config_test ../../assets/etc/blacksiren_*.json
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+
+#include "siren_config.h"
+#include "siren_config_schema.h"
+#include "siren_reload.h"
+#include "json.h"
+
+using namespace BlackSiren;
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static string read_file(const char *path) {
+    std::ifstream istream(path);
+    std::stringstream ss;
+    ss << istream.rdbuf();
+    return ss.str();
+}
+
+static bool has(const vector<string> &messages, const char *part) {
+    for (const string &m : messages) {
+        if (m.find(part) != string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_report(const SirenConfigReport &report) {
+    for (const string &m : report.errors) {
+        printf("    error: %s\n", m.c_str());
+    }
+    for (const string &m : report.warnings) {
+        printf("    warning: %s\n", m.c_str());
+    }
+}
+
+static config_error_t parse(const string &json, SirenConfig &config, SirenConfigReport &report) {
+    report = SirenConfigReport();
+    return parse_siren_config(json.c_str(), json.size(), config, report);
+}
+
+static json_object *section(json_object *root, const char *name) {
+    json_object *object = nullptr;
+    json_object_object_get_ex(root, name, &object);
+    return object;
+}
+
+// base config edited by f, then parsed
+template <typename F>
+static config_error_t parse_edited(const string &base, F f, SirenConfig &config,
+                                   SirenConfigReport &report) {
+    json_object *root = json_tokener_parse(base.c_str());
+    f(root);
+    string json = json_object_to_json_string(root);
+    json_object_put(root);
+    return parse(json, config, report);
+}
+
+static void test_shipped(const vector<string> &paths) {
+    for (const string &path : paths) {
+        SirenConfig config;
+        SirenConfigReport report;
+        config_error_t error = parse(read_file(path.c_str()), config, report);
+        printf("%s: %zu errors %zu warnings\n", path.c_str(), report.errors.size(), report.warnings.size());
+        print_report(report);
+        CHECK(error == CONFIG_OK);
+        CHECK(report.errors.empty());
+        CHECK(report.warnings.empty());
+        CHECK(config.mic_num > 0);
+        CHECK(config.alg_config.alg_bf_scaling > 0);
+        CHECK(config.alg_config.alg_use_legacy_vt_config_file == config.alg_config.alg_use_legacy_ssp_config_file);
+        CHECK(config.siren_use_share_mem == (config.siren_ipc != CONFIG_IPC_CHANNEL));
+    }
+}
+
+static void test_malformed(const string &base) {
+    SirenConfig config;
+    SirenConfigReport report;
+
+    CHECK(parse(base.substr(0, base.size() / 2), config, report) == CONFIG_ERROR_PARSE_FAIL);
+    CHECK(has(report.errors, "truncated"));
+
+    CHECK(parse(base + "}", config, report) == CONFIG_ERROR_PARSE_FAIL);
+    CHECK(has(report.errors, "trailing"));
+
+    CHECK(parse("[1, 2]", config, report) == CONFIG_ERROR_PARSE_FAIL);
+    CHECK(has(report.errors, "not a json object"));
+
+    // every problem in one pass
+    CHECK(parse_edited(base, [](json_object *root) {
+        json_object_object_add(section(root, KEY_BASIC_CONFIG), KEY_MIC_NUM, json_object_new_string("8"));
+        json_object_object_add(section(root, KEY_BASIC_CONFIG), KEY_MIC_SAMPLE_RATE, json_object_new_int(1));
+        json_object_object_add(section(root, KEY_ALG_CONFIG), KEY_ALG_LAN, json_object_new_string("cn"));
+        json_object_object_add(section(root, KEY_ALG_CONFIG), KEY_ALG_AEC, json_object_new_int(1));
+    }, config, report) == CONFIG_ERROR_PARSE_FAIL);
+    print_report(report);
+    CHECK(report.errors.size() == 4);
+    CHECK(has(report.errors, "basic_config.mic_num: expect int, got \"8\""));
+    CHECK(has(report.errors, "basic_config.mic_sample_rate: 1 out of range"));
+    CHECK(has(report.errors, "alg_config.alg_lan: \"cn\" not one of zh|en"));
+    CHECK(has(report.errors, "alg_config.alg_aec: expect bool"));
+
+    // unknown keys only warn
+    CHECK(parse_edited(base, [](json_object *root) {
+        json_object_object_add(section(root, KEY_BASIC_CONFIG), "mic_nmu", json_object_new_int(8));
+        json_object_object_add(section(root, KEY_BASIC_CONFIG), KEY_ALG_AEC, json_object_new_boolean(true));
+        json_object_object_add(section(root, KEY_DEBUG_CONFIG), "no_such_thing", json_object_new_int(1));
+        json_object_object_add(root, "extra_config", json_object_new_object());
+    }, config, report) == CONFIG_OK);
+    print_report(report);
+    CHECK(report.warnings.size() == 4);
+    CHECK(has(report.warnings, "basic_config.mic_nmu, did you mean mic_num"));
+    CHECK(has(report.warnings, "basic_config.alg_aec, belongs to alg_config"));
+    CHECK(has(report.warnings, "unknown key debug_config.no_such_thing"));
+    CHECK(has(report.warnings, "unknown section extra_config"));
+
+    CHECK(parse_edited(base, [](json_object *root) {
+        json_object_object_del(section(root, KEY_ALG_CONFIG), KEY_ALG_AEC);
+        json_object_object_del(root, KEY_DEBUG_CONFIG);
+    }, config, report) == CONFIG_ERROR_PARSE_FAIL);
+    CHECK(has(report.errors, "alg_config.alg_aec: missing"));
+    CHECK(has(report.errors, "debug_config: missing"));
+
+    CHECK(parse_edited(base, [](json_object *root) {
+        json_object *mics = json_object_new_array();
+        json_object_array_add(mics, json_object_new_int(0));
+        json_object_array_add(mics, json_object_new_string("1"));
+        json_object_object_add(section(root, KEY_ALG_CONFIG), KEY_ALG_VAD_MICS, mics);
+        json_object *pos = json_object_new_array();
+        json_object_array_add(pos, json_object_new_double(100.0));
+        json_object *positions = json_object_new_array();
+        json_object_array_add(positions, pos);
+        json_object_object_add(section(root, KEY_ALG_CONFIG), KEY_ALG_MIC_POS, positions);
+    }, config, report) == CONFIG_ERROR_PARSE_FAIL);
+    print_report(report);
+    CHECK(has(report.errors, "alg_config.alg_vad_mics[1]: expect int"));
+    CHECK(has(report.errors, "alg_config.alg_mic_pos[0][0]: 100 out of range"));
+
+    // relations between keys
+    CHECK(parse_edited(base, [](json_object *root) {
+        json_object *mics = json_object_new_array();
+        json_object_array_add(mics, json_object_new_int(3));
+        json_object_object_add(section(root, KEY_BASIC_CONFIG), KEY_MIC_CHANNEL_NUM, json_object_new_int(3));
+        json_object_object_add(section(root, KEY_ALG_CONFIG), KEY_ALG_BF_MICS, mics);
+        json_object_object_add(section(root, KEY_ALG_CONFIG), KEY_ALG_I2S_DELAY_MICS, json_object_new_array());
+        json_object_object_add(section(root, KEY_ALG_CONFIG), KEY_ALG_NEED_I2S_DELAY_MICS, json_object_new_array());
+        json_object_array_add(section(section(root, KEY_ALG_CONFIG), KEY_ALG_NEED_I2S_DELAY_MICS),
+                              json_object_new_int(0));
+        json_object_object_add(section(root, KEY_BASIC_CONFIG), KEY_MIC_FRAME_LENGTH, json_object_new_int(3));
+    }, config, report) == CONFIG_ERROR_PARSE_FAIL);
+    print_report(report);
+    CHECK(has(report.errors, "alg_config.alg_bf_mics[0]: mic 3 not less than mic_channel_num 3"));
+    CHECK(has(report.errors, "alg_config.alg_i2s_delay_mics: 0 delays for 1"));
+    CHECK(has(report.errors, "basic_config.mic_frame_length: 3 ms not divide a second"));
+
+    // defaults of optional keys, int taken for float
+    CHECK(parse_edited(base, [](json_object *root) {
+        json_object_object_del(section(root, KEY_ALG_CONFIG), KEY_ALG_BF_SCALING);
+        json_object_object_del(section(root, KEY_DEBUG_CONFIG), KEY_DEBUG_BF_RECORD);
+        json_object_object_add(section(root, KEY_ALG_CONFIG), KEY_ALG_AEC_SHIELD, json_object_new_int(150));
+        json_object_object_add(section(root, KEY_BASIC_CONFIG), KEY_SIREN_IPC, json_object_new_string(IPC_CHANNEL));
+    }, config, report) == CONFIG_OK);
+    CHECK(config.alg_config.alg_bf_scaling == 1.0f);
+    CHECK(!config.debug_config.bf_record);
+    CHECK(config.alg_config.alg_aec_shield == 150.0f);
+    CHECK(!config.siren_use_share_mem);
+
+    CHECK(parse_edited(base, [](json_object *root) {
+        json_object *vt = json_object_new_object();
+        json_object_object_add(vt, KEY_VT_TYPE, json_object_new_int(1));
+        json_object_object_add(vt, KEY_VT_PHONE, json_object_new_string("r o4 q i2"));
+        json_object_object_add(vt, KEY_VT_AVG_SCORE, json_object_new_double(4.2));
+        json_object *vts = json_object_new_array();
+        json_object_array_add(vts, vt);
+        json_object_array_add(vts, json_object_new_int(1));
+        json_object_object_add(section(root, KEY_ALG_CONFIG), KEY_ALG_DEF_VT, vts);
+    }, config, report) == CONFIG_ERROR_PARSE_FAIL);
+    print_report(report);
+    CHECK(has(report.errors, "alg_config.alg_def_vt[0].vt_word: missing"));
+    CHECK(has(report.errors, "alg_config.alg_def_vt[1]: expect object"));
+}
+
+static SirenConfigSource source_of(uint64_t size, int64_t mtime) {
+    SirenConfigSource source;
+    source.device = 1;
+    source.inode = 2;
+    source.size = size;
+    source.mtime_sec = mtime;
+    source.mtime_nsec = 3;
+    return source;
+}
+
+static void test_snapshot(const string &base) {
+    SirenConfig config;
+    SirenConfigReport report;
+    CHECK(parse_edited(base, [](json_object *root) {
+        json_object *vt = json_object_new_object();
+        json_object_object_add(vt, KEY_VT_TYPE, json_object_new_int(1));
+        json_object_object_add(vt, KEY_VT_WORD, json_object_new_string("ruoqi"));
+        json_object_object_add(vt, KEY_VT_PHONE, json_object_new_string("r o4 q i2"));
+        json_object_object_add(vt, KEY_VT_LEFT_SIL_DET, json_object_new_boolean(true));
+        json_object *vts = json_object_new_array();
+        json_object_array_add(vts, vt);
+        json_object_object_add(section(root, KEY_ALG_CONFIG), KEY_ALG_DEF_VT, vts);
+    }, config, report) == CONFIG_OK);
+
+    SirenConfigSource source = source_of(base.size(), 1500000000);
+    string snapshot;
+    encode_siren_config_snapshot(config, source, snapshot);
+
+    SirenConfig loaded;
+    CHECK(decode_siren_config_snapshot(snapshot.data(), snapshot.size(), source, loaded));
+    string again;
+    encode_siren_config_snapshot(loaded, source, again);
+    CHECK(again == snapshot);
+    CHECK(loaded.alg_config.def_vt_configs.size() == 1);
+    CHECK(loaded.alg_config.def_vt_configs[0].vt_word == "ruoqi");
+    CHECK(loaded.alg_config.def_vt_configs[0].vt_left_sil_det);
+    CHECK(loaded.alg_config.alg_mic_pos.size() == config.alg_config.alg_mic_pos.size());
+    CHECK(loaded.siren_use_share_mem == config.siren_use_share_mem);
+    CHECK(loaded.debug_config.recording_path == config.debug_config.recording_path);
+
+    // header: magic, version, schema, size, checksum
+    for (size_t offset : {0, 4, 8, 12, 16}) {
+        string bad = snapshot;
+        bad[offset] ^= 1;
+        CHECK(!decode_siren_config_snapshot(bad.data(), bad.size(), source, loaded));
+    }
+    string corrupt = snapshot;
+    corrupt[snapshot.size() / 2] ^= 0x40;
+    CHECK(!decode_siren_config_snapshot(corrupt.data(), corrupt.size(), source, loaded));
+
+    CHECK(!decode_siren_config_snapshot(snapshot.data(), snapshot.size() - 1, source, loaded));
+    CHECK(!decode_siren_config_snapshot(snapshot.data(), 10, source, loaded));
+    string longer = snapshot + "x";
+    CHECK(!decode_siren_config_snapshot(longer.data(), longer.size(), source, loaded));
+
+    CHECK(!decode_siren_config_snapshot(snapshot.data(), snapshot.size(), source_of(base.size() + 1, 1500000000),
+                                        loaded));
+    CHECK(!decode_siren_config_snapshot(snapshot.data(), snapshot.size(), source_of(base.size(), 1500000001),
+                                        loaded));
+    CHECK(loaded.alg_config.def_vt_configs.size() == 1);
+}
+
+static void write_file(const string &path, const string &contents) {
+    std::ofstream ostream(path.c_str(), std::ios::binary);
+    ostream << contents;
+}
+
+static void test_manager(const string &base) {
+    char dir[] = "/tmp/config_test_XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    string config_path = string(dir) + "/blacksiren.json";
+    string snapshot_path = string(dir) + "/" CONFIG_SNAPSHOT_FILE;
+    write_file(config_path, base);
+
+    SirenConfigurationManager first(config_path.c_str());
+    first.setSnapshotPath(snapshot_path);
+    CHECK(first.parseConfigFile() == CONFIG_OK);
+    struct stat st;
+    CHECK(stat(snapshot_path.c_str(), &st) == 0);
+
+    // a snapshot that says otherwise proves the second start used it
+    struct stat config_st;
+    stat(config_path.c_str(), &config_st);
+    SirenConfigSource source;
+    source.device = config_st.st_dev;
+    source.inode = config_st.st_ino;
+    source.size = config_st.st_size;
+    source.mtime_sec = config_st.st_mtim.tv_sec;
+    source.mtime_nsec = config_st.st_mtim.tv_nsec;
+    SirenConfig marked = first.getConfigFile();
+    marked.debug_config.recording_path = "/from/snapshot";
+    string snapshot;
+    encode_siren_config_snapshot(marked, source, snapshot);
+    write_file(snapshot_path, snapshot);
+
+    SirenConfigurationManager second(config_path.c_str());
+    second.setSnapshotPath(snapshot_path);
+    CHECK(second.parseConfigFile() == CONFIG_OK);
+    CHECK(second.getConfigFile().debug_config.recording_path == "/from/snapshot");
+
+    // edited config is parsed again and the snapshot replaced
+    sleep(1);
+    write_file(config_path, base + "\n");
+    SirenConfigurationManager third(config_path.c_str());
+    third.setSnapshotPath(snapshot_path);
+    CHECK(third.parseConfigFile() == CONFIG_OK);
+    CHECK(third.getConfigFile().debug_config.recording_path == first.getConfigFile().debug_config.recording_path);
+    CHECK(read_file(snapshot_path.c_str()) != snapshot);
+
+    unlink(snapshot_path.c_str());
+    unlink(config_path.c_str());
+    rmdir(dir);
+}
+
+static bool changed(const SirenConfigChange &change, const char *key) {
+    for (const string &k : change.keys) {
+        if (k.find(key) != string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void test_diff(const string &base) {
+    SirenConfig from;
+    SirenConfigReport report;
+    CHECK(parse(base, from, report) == CONFIG_OK);
+
+    SirenConfigChange change;
+    diff_siren_config(from, from, change);
+    CHECK(change.keys.empty());
+    CHECK(change.reload == 0);
+    CHECK(!change.restart);
+
+    SirenConfig to = from;
+    to.alg_config.alg_bf_scaling += 0.5;
+    change = SirenConfigChange();
+    diff_siren_config(from, to, change);
+    CHECK(change.keys.size() == 1);
+    CHECK(changed(change, KEY_ALG_BF_SCALING));
+    CHECK(change.reload == CONFIG_RELOAD_LIVE);
+    CHECK(!change.restart);
+
+    to.alg_config.alg_vad_baserange += 1;
+    change = SirenConfigChange();
+    diff_siren_config(from, to, change);
+    CHECK(change.keys.size() == 2);
+    CHECK(change.reload == (CONFIG_RELOAD_LIVE | CONFIG_RELOAD_PROCESSOR));
+
+    to = from;
+    to.alg_config.alg_aec_mics.push_back(0);
+    change = SirenConfigChange();
+    diff_siren_config(from, to, change);
+    CHECK(changed(change, KEY_ALG_AEC_MICS));
+    CHECK(change.reload == (CONFIG_RELOAD_PREPROCESSOR | CONFIG_RELOAD_PROCESSOR));
+
+    to.mic_num += 1;
+    change = SirenConfigChange();
+    diff_siren_config(from, to, change);
+    CHECK(changed(change, KEY_MIC_NUM));
+    CHECK(change.restart);
+}
+
+// fake stage recording every call as name:scaling
+struct FakeStage {
+    string name;
+    vector<string> *calls;
+    bool fail;
+
+    SirenReloadStage stage() {
+        return {name.c_str(), [this](const SirenConfig &config, const SirenConfigChange &) {
+            calls->push_back(name + ":" + std::to_string((int)config.alg_config.alg_bf_scaling));
+            return !fail;
+        }};
+    }
+};
+
+static void test_apply(const string &base) {
+    SirenConfig from;
+    SirenConfigReport report;
+    CHECK(parse(base, from, report) == CONFIG_OK);
+    from.alg_config.alg_bf_scaling = 1;
+    SirenConfig to = from;
+    to.alg_config.alg_bf_scaling = 2;
+
+    vector<string> calls;
+    FakeStage pre = {"pre", &calls, false};
+    FakeStage proc = {"proc", &calls, false};
+    SirenConfigChange change;
+    CHECK(apply_siren_config({pre.stage(), proc.stage()}, from, to, change));
+    CHECK((calls == vector<string>{"pre:2", "proc:2"}));
+
+    // failed stage keeps its own config, the ones before go back
+    calls.clear();
+    FakeStage last = {"last", &calls, true};
+    change = SirenConfigChange();
+    CHECK(!apply_siren_config({pre.stage(), proc.stage(), last.stage()}, from, to, change));
+    CHECK((calls == vector<string>{"pre:2", "proc:2", "last:2", "proc:1", "pre:1"}));
+
+    calls.clear();
+    proc.fail = true;
+    change = SirenConfigChange();
+    CHECK(!apply_siren_config({pre.stage(), proc.stage()}, from, to, change));
+    CHECK((calls == vector<string>{"pre:2", "proc:2", "pre:1"}));
+
+    calls.clear();
+    change = SirenConfigChange();
+    CHECK(apply_siren_config({pre.stage(), proc.stage()}, from, from, change));
+    CHECK(calls.empty());
+
+    calls.clear();
+    to.mic_num += 1;
+    change = SirenConfigChange();
+    CHECK(!apply_siren_config({pre.stage(), proc.stage()}, from, to, change));
+    CHECK(change.restart);
+    CHECK(calls.empty());
+}
+
+static void test_reload_file(const string &base) {
+    char dir[] = "/tmp/config_test_XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    string config_path = string(dir) + "/blacksiren.json";
+    write_file(config_path, base);
+
+    SirenConfigurationManager manager(config_path.c_str());
+    manager.setSnapshotPath("");
+    CHECK(manager.parseConfigFile() == CONFIG_OK);
+    SirenConfig current = manager.getConfigFile();
+
+    // broken edit fails and leaves running config alone
+    write_file(config_path, base.substr(0, base.size() / 2));
+    SirenConfig next;
+    CHECK(manager.reloadConfigFile(next) != CONFIG_OK);
+    SirenConfigChange change;
+    diff_siren_config(current, manager.getConfigFile(), change);
+    CHECK(change.keys.empty());
+
+    SirenConfig edited;
+    SirenConfigReport report;
+    string json;
+    parse_edited(base, [&json](json_object *root) {
+        json_object_object_add(section(root, KEY_ALG_CONFIG), KEY_ALG_BF_SCALING, json_object_new_double(3.5));
+        json = json_object_to_json_string(root);
+    }, edited, report);
+    write_file(config_path, json);
+    CHECK(manager.reloadConfigFile(next) == CONFIG_OK);
+    change = SirenConfigChange();
+    diff_siren_config(current, next, change);
+    CHECK(change.keys.size() == 1);
+    CHECK(changed(change, KEY_ALG_BF_SCALING));
+    CHECK(change.reload == CONFIG_RELOAD_LIVE);
+
+    unlink(config_path.c_str());
+    rmdir(dir);
+}
+
+static void bench(const string &base) {
+    const int rounds = 2000;
+    SirenConfig config;
+    SirenConfigReport report;
+    parse(base, config, report);
+    SirenConfigSource source = source_of(base.size(), 1);
+    string snapshot;
+    encode_siren_config_snapshot(config, source, snapshot);
+
+    steady_clock::time_point begin = steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        parse(base, config, report);
+    }
+    double parse_us = std::chrono::duration<double, std::micro>(steady_clock::now() - begin).count() / rounds;
+
+    begin = steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        decode_siren_config_snapshot(snapshot.data(), snapshot.size(), source, config);
+    }
+    double decode_us = std::chrono::duration<double, std::micro>(steady_clock::now() - begin).count() / rounds;
+
+    printf("json %zu bytes parse %.1f us, snapshot %zu bytes load %.1f us\n",
+           base.size(), parse_us, snapshot.size(), decode_us);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("usage: %s config.json...\n", argv[0]);
+        return 2;
+    }
+    vector<string> paths(argv + 1, argv + argc);
+    string base = read_file(argv[1]);
+
+    test_shipped(paths);
+    test_malformed(base);
+    test_snapshot(base);
+    test_manager(base);
+    test_diff(base);
+    test_apply(base);
+    test_reload_file(base);
+    bench(base);
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
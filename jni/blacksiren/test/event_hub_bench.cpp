@@ -0,0 +1,316 @@
+// Fan out of processed events on plain linux: a stream of vad data with
+// a vt event now and then, every 0.5ms, is published from event blocks, as proxy
+// response thread does, to 1 to 8 consumers. Once chained the way apps
+// did it (one callback copying data to every consumer queue) and once
+// through SirenEventHub. Prints publisher time per event and delay to
+// consumers for both, then runs fast subscribers next to a slow one and
+// a vt only one, and checks the fast ones get every event while the slow
+// one drops its own, filters hold and no block is left behind.
+//
+// build (in jni/blacksiren):
+//   g++ -std=c++11 -O2 -DCONFIG_SIREN_LOG_LEVEL=3 -I../include -Ilibbsiren/include
+//   -o event_hub_bench test/event_hub_bench.cpp libbsiren/src/siren_event_hub.cpp
+//   libbsiren/src/siren_event_pool.cpp libbsiren/src/siren_channel.cpp
+//   libbsiren/src/siren_log.cpp libbsiren/src/siren_vt_wire.cpp -lpthread
+// run:
+//   ./event_hub_bench [events]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "isiren.h"
+#include "siren_channel.h"
+#include "siren_event_pool.h"
+#include "siren_event_hub.h"
+
+using namespace BlackSiren;
+using std::vector;
+using std::chrono::steady_clock;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+//10ms of 16k 16 bit vad data
+static const int DATA_LEN = 320;
+//one vt in this many events
+static const int VT_EVERY = 500;
+//events come 20 times faster than real time, delay is not queueing of a burst
+static const int PACE_US = 500;
+
+static double nowUs() {
+    return std::chrono::duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void pace(steady_clock::time_point begin, int i) {
+    std::this_thread::sleep_until(begin + std::chrono::microseconds((long)PACE_US * i));
+}
+
+static double percentile(vector<double> v, double p) {
+    if (v.empty()) {
+        return 0.0;
+    }
+    std::sort(v.begin(), v.end());
+    return v[(size_t)((v.size() - 1) * p)];
+}
+
+//event block as proxy response thread builds it, publish time in data
+static SirenEventBlock *makeEvent(int i) {
+    SirenEventBlock *block = SirenEventPool::instance().obtain(SIREN_RESPONSE_MSG_ON_VOICE_EVENT, DATA_LEN);
+    char *data = block->message()->data;
+    memset(data, i & 0xff, DATA_LEN);
+    double t = nowUs();
+    memcpy(data, &t, sizeof(t));
+    voice_event_t *event = &block->event;
+    event->length = DATA_LEN;
+    event->buff = data;
+    if (i % VT_EVERY == VT_EVERY - 1) {
+        event->event = SIREN_EVENT_WAKE_PRE;
+        event->flag = VT_MASK;
+    } else {
+        event->event = SIREN_EVENT_VAD_DATA;
+        event->flag = VOICE_MASK;
+    }
+    return block;
+}
+
+struct Consumer {
+    std::atomic<long> got{0};
+    std::atomic<long> bytes{0};
+    int delayUs = 0;
+    std::mutex mutex;
+    vector<double> delays;
+
+    void take(const void *buff, int len) {
+        double t;
+        memcpy(&t, buff, sizeof(t));
+        {
+            std::lock_guard<std::mutex> l_(mutex);
+            delays.push_back(nowUs() - t);
+        }
+        long sum = 0;
+        const unsigned char *p = (const unsigned char *)buff;
+        for (int i = 0; i < len; i += 64) {
+            sum += p[i];
+        }
+        bytes += sum > 0 ? len : 0;
+        if (delayUs > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(delayUs));
+        }
+        got++;
+    }
+};
+
+static void onHubEvent(void *token, voice_event_t *event) {
+    ((Consumer *)token)->take(event->buff, event->length);
+}
+
+//what apps chained on siren_proc_callback_t: a copy for every consumer
+//queue, each consumer on its own thread
+struct ChainedQueue {
+    Consumer *consumer;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<vector<char>> queue;
+    bool stopping = false;
+    std::thread thread;
+
+    void run() {
+        while (1) {
+            vector<char> data;
+            {
+                std::unique_lock<std::mutex> l_(mutex);
+                cond.wait(l_, [this] {
+                    return stopping || !queue.empty();
+                });
+                if (queue.empty()) {
+                    return;
+                }
+                data.swap(queue.front());
+                queue.pop_front();
+            }
+            consumer->take(data.data(), data.size());
+        }
+    }
+};
+
+struct Result {
+    double publishUs;
+    double delayP50;
+    double delayP99;
+};
+
+static Result runChained(int subs, int events) {
+    vector<Consumer> consumers(subs);
+    vector<ChainedQueue> queues(subs);
+    for (int s = 0; s < subs; s++) {
+        queues[s].consumer = &consumers[s];
+        queues[s].thread = std::thread(&ChainedQueue::run, &queues[s]);
+    }
+
+    double publish = 0.0;
+    steady_clock::time_point begin = steady_clock::now();
+    for (int i = 0; i < events; i++) {
+        pace(begin, i);
+        SirenEventBlock *block = makeEvent(i);
+        double t0 = nowUs();
+        for (int s = 0; s < subs; s++) {
+            const char *data = (const char *)block->event.buff;
+            std::lock_guard<std::mutex> l_(queues[s].mutex);
+            queues[s].queue.emplace_back(data, data + block->event.length);
+            queues[s].cond.notify_one();
+        }
+        publish += nowUs() - t0;
+        SirenEventPool::instance().unref(block);
+    }
+
+    vector<double> delays;
+    for (int s = 0; s < subs; s++) {
+        {
+            std::lock_guard<std::mutex> l_(queues[s].mutex);
+            queues[s].stopping = true;
+            queues[s].cond.notify_one();
+        }
+        queues[s].thread.join();
+        CHECK(consumers[s].got == events);
+        delays.insert(delays.end(), consumers[s].delays.begin(), consumers[s].delays.end());
+    }
+    return {publish / events, percentile(delays, 0.5), percentile(delays, 0.99)};
+}
+
+static siren_subscriber_t subscriber(Consumer *consumer, uint32_t events, int flags, int queueLen, int policy) {
+    siren_subscriber_t sub;
+    memset(&sub, 0, sizeof(sub));
+    sub.voice_event_callback = onHubEvent;
+    sub.token = consumer;
+    sub.events = events;
+    sub.flags = flags;
+    sub.queue_len = queueLen;
+    sub.drop_policy = policy;
+    return sub;
+}
+
+static void waitDrained(SirenEventHub &hub, const vector<siren_sub_t> &ids) {
+    for (siren_sub_t id : ids) {
+        siren_subscriber_stats_t stats;
+        while (hub.getStats(id, stats) && stats.queued > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    //last callback may still run after queue is empty
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+static Result runHub(int subs, int events) {
+    SirenEventHub hub;
+    vector<Consumer> consumers(subs);
+    vector<siren_sub_t> ids;
+    for (int s = 0; s < subs; s++) {
+        siren_subscriber_t sub = subscriber(&consumers[s], 0, 0, events, SIREN_DROP_OLDEST);
+        ids.push_back(hub.subscribe(sub));
+    }
+
+    double publish = 0.0;
+    steady_clock::time_point begin = steady_clock::now();
+    for (int i = 0; i < events; i++) {
+        pace(begin, i);
+        SirenEventBlock *block = makeEvent(i);
+        double t0 = nowUs();
+        hub.publish(block);
+        publish += nowUs() - t0;
+        SirenEventPool::instance().unref(block);
+    }
+    waitDrained(hub, ids);
+    hub.clear();
+
+    vector<double> delays;
+    for (int s = 0; s < subs; s++) {
+        CHECK(consumers[s].got == events);
+        delays.insert(delays.end(), consumers[s].delays.begin(), consumers[s].delays.end());
+    }
+    return {publish / events, percentile(delays, 0.5), percentile(delays, 0.99)};
+}
+
+//fast ones next to one taking 1ms an event with a short queue
+static void runSlow(int events) {
+    SirenEventHub hub;
+    Consumer fast[3], slow, vt;
+    slow.delayUs = 1000;
+    vector<siren_sub_t> ids;
+    for (Consumer &c : fast) {
+        ids.push_back(hub.subscribe(subscriber(&c, 0, 0, events, SIREN_DROP_OLDEST)));
+    }
+    siren_sub_t slowId = hub.subscribe(subscriber(&slow, 0, 0, 8, SIREN_DROP_NEWEST));
+    ids.push_back(hub.subscribe(subscriber(&vt, SIREN_EVENT_BIT(SIREN_EVENT_WAKE_PRE), VT_MASK,
+                                           4, SIREN_DROP_OLDEST)));
+    CHECK(hub.subscribe(subscriber(&vt, 0, 0, 0, SIREN_DROP_OLDEST)) == -1);
+
+    double publish = 0.0, publishMax = 0.0;
+    steady_clock::time_point begin = steady_clock::now();
+    for (int i = 0; i < events; i++) {
+        pace(begin, i);
+        SirenEventBlock *block = makeEvent(i);
+        double t0 = nowUs();
+        hub.publish(block);
+        double us = nowUs() - t0;
+        publish += us;
+        publishMax = std::max(publishMax, us);
+        SirenEventPool::instance().unref(block);
+    }
+    waitDrained(hub, ids);
+
+    siren_subscriber_stats_t stats;
+    CHECK(hub.getStats(slowId, stats));
+    printf("with a slow subscriber: publish mean %.2fus max %.1fus, fast got %ld %ld %ld of %d, "
+           "slow got %ld dropped %llu, vt got %ld\n",
+           publish / events, publishMax, fast[0].got.load(), fast[1].got.load(), fast[2].got.load(),
+           events, slow.got.load(), (unsigned long long)stats.dropped, vt.got.load());
+    for (Consumer &c : fast) {
+        CHECK(c.got == events);
+    }
+    CHECK(stats.dropped > 0);
+    CHECK(hub.unsubscribe(slowId));
+    CHECK(!hub.unsubscribe(slowId));
+    CHECK(vt.got == events / VT_EVERY);
+    hub.clear();
+}
+
+int main(int argc, char **argv) {
+    int events = argc > 1 ? atoi(argv[1]) : 4000;
+
+    SirenEventPoolStat before;
+    SirenEventPool::instance().getStat(before);
+
+    printf("subs   chained publish  p50 delay  p99 delay |  hub publish  p50 delay  p99 delay (us)\n");
+    for (int subs = 1; subs <= 8; subs++) {
+        Result chained = runChained(subs, events);
+        Result hub = runHub(subs, events);
+        printf("%4d %17.2f %10.1f %10.1f | %12.2f %10.1f %10.1f\n", subs,
+               chained.publishUs, chained.delayP50, chained.delayP99,
+               hub.publishUs, hub.delayP50, hub.delayP99);
+    }
+    runSlow(events);
+
+    SirenEventPoolStat after;
+    SirenEventPool::instance().getStat(after);
+    CHECK(after.outstanding == before.outstanding);
+
+    if (failures == 0) {
+        printf("OK\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,270 @@
+// Test framing of the preprocessor chain on plain linux: r2frm_plan
+// lookahead math, r2frm_ring wrap and offsets, then a 16ms block unit
+// driven in 10ms hops the old way (collect a block, give out whole hops of
+// what came out) and through rings primed with the planned lookahead.
+// Prints latency of every sample and length and cost of every hop for
+// both, and checks the ring way gives each hop out at once, the same
+// delay for every sample.
+//
+// build (in jni/blacksiren):
+//   g++ -std=c++11 -O2 -Ilibbsiren/include -o frame_plan_test
+//   test/frame_plan_test.cpp libbsiren/src/legacy/r2frm.cpp
+// run:
+//   ./frame_plan_test
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+#include "legacy/r2frm.h"
+
+using std::vector;
+using std::chrono::steady_clock;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static const int HOP = 160;
+static const int BLOCK = 256;
+static const int CN = 2;
+static const int HOPS = 2000;
+
+static void testPlan() {
+    r2frm_plan plan(HOP);
+    CHECK(plan.add("in", 1) == 0);
+    int aec = plan.add("aec", BLOCK);
+    CHECK(aec == 1);
+    plan.add("out", 1);
+    CHECK(plan.getLookahead(0) == 0);
+    CHECK(plan.getLookahead(aec) == 224);
+    CHECK(plan.getLookahead(7) == 0);
+    CHECK(plan.getLatency() == 224);
+    CHECK(plan.getCommonHop() == 1280);
+
+    r2frm_plan even(320);
+    CHECK(even.getLookahead(even.add("blk", 160)) == 0);
+    CHECK(even.add("bad", 0) == -1);
+
+    char buf[256];
+    plan.dump(buf, sizeof(buf));
+    printf("plan: %s\n", buf);
+}
+
+static void testRing() {
+    r2frm_ring ring(2, 8);
+    float a[12], b[12];
+    for (int i = 0; i < 12; i++) {
+        a[i] = (float)i;
+        b[i] = (float)(100 + i);
+    }
+    //channels swapped through the id list
+    float *src[2] = {a, b};
+    int ids[2] = {1, 0};
+    CHECK(ring.put(src, ids, 2, 6) == 6);
+    CHECK(ring.size() == 6 && ring.space() == 2);
+
+    float o0[12], o1[12];
+    float *dst[2] = {o0, o1};
+    CHECK(ring.get(dst, nullptr, 0, 4) == 4);
+    CHECK(o0[0] == 102.0f && o0[3] == 105.0f && o1[0] == 2.0f);
+
+    //wraps around the end, and is clamped to space
+    CHECK(ring.put(src, nullptr, 0, 10) == 6);
+    CHECK(ring.size() == 8);
+    CHECK(ring.peek(dst, nullptr, 1, 20) == 8);
+    CHECK(o0[1] == 106.0f && o0[2] == 107.0f && o0[3] == 0.0f && o0[8] == 5.0f);
+    CHECK(o1[3] == 100.0f && o1[8] == 105.0f);
+    CHECK(ring.drop(3) == 3 && ring.size() == 5);
+    //newest samples, oldest of them first
+    CHECK(ring.last(dst, nullptr, 0, 4) == 4 && ring.size() == 5);
+    CHECK(o0[0] == 2.0f && o0[3] == 5.0f && o1[0] == 102.0f && o1[3] == 105.0f);
+
+    ring.reset();
+    CHECK(ring.putZero(5) == 5);
+    CHECK(ring.get(dst, nullptr, 0, 5) == 5 && o1[4] == 0.0f && ring.size() == 0);
+}
+
+//block unit standing in for aec, passes samples on after some work
+static volatile float sink;
+static void processBlock(float **data) {
+    float acc = 0.0f;
+    for (int c = 0; c < CN; c++) {
+        for (int k = 0; k < 2048; k++) {
+            acc += sinf(data[c][k % BLOCK] + (float)k);
+        }
+    }
+    sink = acc;
+}
+
+struct Stats {
+    vector<int> lens;
+    vector<double> costs;
+    double latSum = 0.0;
+    long latNum = 0;
+    int latMin = 1 << 30;
+    int latMax = 0;
+    bool order = true;
+
+    //samples carry their index plus one, zero is priming
+    void take(const float *out, int len, long clock, long &next) {
+        lens.push_back(len);
+        for (int j = 0; j < len; j++) {
+            if (out[j] == 0.0f) {
+                continue;
+            }
+            long idx = (long)out[j] - 1;
+            order = order && idx == next;
+            next = idx + 1;
+            int lat = (int)(clock + j - idx);
+            latSum += lat;
+            latNum++;
+            latMin = lat < latMin ? lat : latMin;
+            latMax = lat > latMax ? lat : latMax;
+        }
+    }
+
+    void print(const char *name) {
+        int lenMin = lens[0], lenMax = lens[0];
+        double costSum = 0.0, costMax = 0.0, costVar = 0.0;
+        for (size_t i = 0; i < lens.size(); i++) {
+            lenMin = lens[i] < lenMin ? lens[i] : lenMin;
+            lenMax = lens[i] > lenMax ? lens[i] : lenMax;
+            costSum += costs[i];
+            costMax = costs[i] > costMax ? costs[i] : costMax;
+        }
+        double costMean = costSum / costs.size();
+        for (double c : costs) {
+            costVar += (c - costMean) * (c - costMean);
+        }
+        printf("%-6s latency min %d mean %.1f max %d samples, hop out %d..%d, "
+               "hop cost mean %.1fus max %.1fus sd %.1fus\n",
+               name, latMin, latSum / latNum, latMax, lenMin, lenMax,
+               costMean, costMax, sqrt(costVar / costs.size()));
+    }
+};
+
+static void fillHop(vector<vector<float>> &in, int k) {
+    for (int c = 0; c < CN; c++) {
+        for (int j = 0; j < HOP; j++) {
+            in[c][j] = (float)(k * HOP + j + 1);
+        }
+    }
+}
+
+//what r2mem_aec did before: collect a block, give out whole hops of what
+//is done and keep the rest for the next call
+static Stats runOld() {
+    Stats stats;
+    vector<vector<float>> in(CN, vector<float>(HOP));
+    vector<vector<float>> blk(CN, vector<float>(BLOCK));
+    vector<vector<float>> out(CN, vector<float>(HOP * 8));
+    float *blkp[CN];
+    for (int c = 0; c < CN; c++) {
+        blkp[c] = blk[c].data();
+    }
+    int inLen = 0, outLen = 0;
+    long next = 0;
+    for (int k = 0; k < HOPS; k++) {
+        fillHop(in, k);
+        auto t0 = steady_clock::now();
+        int left = outLen % HOP;
+        for (int c = 0; c < CN; c++) {
+            memmove(out[c].data(), out[c].data() + outLen - left, sizeof(float) * left);
+        }
+        outLen = left;
+        int cur = 0;
+        while (cur < HOP) {
+            int ll = BLOCK - inLen < HOP - cur ? BLOCK - inLen : HOP - cur;
+            for (int c = 0; c < CN; c++) {
+                memcpy(blk[c].data() + inLen, in[c].data() + cur, sizeof(float) * ll);
+            }
+            cur += ll;
+            inLen += ll;
+            if (inLen == BLOCK) {
+                processBlock(blkp);
+                for (int c = 0; c < CN; c++) {
+                    memcpy(out[c].data() + outLen, blk[c].data(), sizeof(float) * BLOCK);
+                }
+                outLen += BLOCK;
+                inLen = 0;
+            }
+        }
+        int emit = outLen / HOP * HOP;
+        stats.costs.push_back(std::chrono::duration<double, std::micro>(steady_clock::now() - t0).count());
+        stats.take(out[0].data(), emit, (long)k * HOP, next);
+    }
+    return stats;
+}
+
+//what r2mem_aec does now: rings in and out, out primed with lookahead
+static Stats runRing(int lookahead) {
+    Stats stats;
+    vector<vector<float>> in(CN, vector<float>(HOP));
+    vector<vector<float>> blk(CN, vector<float>(BLOCK));
+    vector<vector<float>> out(CN, vector<float>(HOP + lookahead + BLOCK));
+    float *inp[CN], *blkp[CN], *outp[CN];
+    for (int c = 0; c < CN; c++) {
+        inp[c] = in[c].data();
+        blkp[c] = blk[c].data();
+        outp[c] = out[c].data();
+    }
+    r2frm_ring ringIn(CN, BLOCK);
+    r2frm_ring ringOut(CN, lookahead + BLOCK * 2);
+    ringOut.putZero(lookahead);
+    int owe = 0;
+    long next = 0;
+    for (int k = 0; k < HOPS; k++) {
+        fillHop(in, k);
+        auto t0 = steady_clock::now();
+        int cur = 0, outLen = 0;
+        while (cur < HOP) {
+            int ll = ringIn.put(inp, nullptr, cur, HOP - cur);
+            cur += ll;
+            if (ringIn.size() == BLOCK) {
+                ringIn.get(blkp, nullptr, 0, BLOCK);
+                processBlock(blkp);
+                ringOut.put(blkp, nullptr, 0, BLOCK);
+            }
+            int want = ll + owe;
+            int got = ringOut.get(outp, nullptr, outLen, want);
+            owe = want - got;
+            outLen += got;
+        }
+        stats.costs.push_back(std::chrono::duration<double, std::micro>(steady_clock::now() - t0).count());
+        stats.take(out[0].data(), outLen, (long)k * HOP, next);
+    }
+    return stats;
+}
+
+int main() {
+    testPlan();
+    testRing();
+
+    r2frm_plan plan(HOP);
+    int lookahead = plan.getLookahead(plan.add("aec", BLOCK));
+
+    Stats before = runOld();
+    Stats after = runRing(lookahead);
+    before.print("before");
+    after.print("after");
+
+    CHECK(before.order && after.order);
+    for (int len : after.lens) {
+        CHECK(len == HOP);
+    }
+    CHECK(after.latMin == lookahead && after.latMax == lookahead);
+    CHECK(after.latNum == (long)HOPS * HOP - lookahead);
+
+    if (failures == 0) {
+        printf("OK\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
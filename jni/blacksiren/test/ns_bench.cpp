@@ -0,0 +1,170 @@
+// Ns in front of vad on a recording: a bf debug recording (bf_record,
+// float32 of one channel at 16 bit scale) goes through r2mem_vad2 as the
+// processor feeds it, once straight and once through r2mem_ns. Against a
+// label file of speech segments it prints vad begins, false starts (a
+// begin outside any segment) and segments vad never began in, then the
+// level change ns makes outside segments (noise) and inside them (speech
+// with noise), and cpu of ns per 10ms frame with fftw of the device.
+//
+// build (in jni/blacksiren, libbsiren built for linux with its prebuilt
+// libs, e.g. libbsiren/prebuilt/support/libs/linux/arm64):
+//   g++ -std=c++11 -O2 -Ilibbsiren/include -Ilibbsiren/include/legacy
+//   -Ilibbsiren/prebuilt/support/include -o ns_bench test/ns_bench.cpp
+//   -Lout -lbsiren -lr2ssp -lpthread
+// run:
+//   ./ns_bench bf_debug.pcm labels.txt [floor db]
+// labels.txt holds one speech segment per line, start and end in seconds.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+
+#include "NNVadIntf.h"
+#include "legacy/r2mem_vad2.h"
+#include "legacy/r2mem_ns.h"
+
+using std::vector;
+
+//a begin this long before a segment is still of it, vad looks back
+static const double LEAD_S = 0.3;
+
+struct Segment {
+    double start;
+    double end;
+};
+
+struct Run {
+    double nsCpuS;
+    long frames;
+    vector<double> begins;
+    //energy in and out of ns, outside and inside segments
+    double noiseIn;
+    double noiseOut;
+    double speechIn;
+    double speechOut;
+};
+
+static double threadCpuS() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool inside(const vector<Segment> &labels, double t, double lead) {
+    for (const Segment &s : labels) {
+        if (t >= s.start - lead && t <= s.end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void runVad(const vector<float> &pcm, const vector<Segment> &labels, bool ns, float floorDb, Run &run) {
+    int hop = R2_AUDIO_SAMPLE_RATE / 1000 * R2_AUDIO_FRAME_MS;
+    r2mem_vad2 vad(1.25f, 3.5f, 6.0f);
+    r2mem_ns *pNs = ns ? new r2mem_ns(floorDb) : nullptr;
+    run = Run();
+
+    for (size_t i = 0; i + hop <= pcm.size(); i += hop) {
+        float *data = (float *)&pcm[i];
+        int len = hop;
+        if (pNs != nullptr) {
+            double t0 = threadCpuS();
+            pNs->process(data, len, false, data, len);
+            run.nsCpuS += threadCpuS() - t0;
+            //output is a hop late, compare with the hop before
+            if (i >= (size_t)hop) {
+                bool speech = inside(labels, (double)(i - hop) / R2_AUDIO_SAMPLE_RATE, 0.0);
+                for (int j = 0; j < len; j++) {
+                    double x = pcm[i - hop + j];
+                    double y = data[j];
+                    (speech ? run.speechIn : run.noiseIn) += x * x;
+                    (speech ? run.speechOut : run.noiseOut) += y * y;
+                }
+            }
+        }
+        int vad2 = vad.process(data, len, 0, 0, 0, data, len);
+        run.frames++;
+        if (vad2 & r2vad_audio_begin) {
+            run.begins.push_back(run.frames * R2_AUDIO_FRAME_MS / 1000.0);
+        }
+    }
+
+    delete pNs;
+}
+
+static void report(const char *name, const Run &run, const vector<Segment> &labels) {
+    int falseStarts = 0;
+    for (double b : run.begins) {
+        falseStarts += inside(labels, b, LEAD_S) ? 0 : 1;
+    }
+    int missed = 0;
+    for (const Segment &s : labels) {
+        bool hit = false;
+        for (double b : run.begins) {
+            hit = hit || (b >= s.start - LEAD_S && b <= s.end);
+        }
+        missed += hit ? 0 : 1;
+    }
+    double hours = run.frames * R2_AUDIO_FRAME_MS / 3600000.0;
+    printf("%-6s vad begins %5d, false starts %5d (%.1f per hour), segments missed %d of %zu\n",
+           name, (int)run.begins.size(), falseStarts, falseStarts / hours, missed, labels.size());
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        printf("usage: %s bf_debug.pcm labels.txt [floor db]\n", argv[0]);
+        return 2;
+    }
+    float floorDb = argc > 3 ? atof(argv[3]) : -12.0f;
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (fp == nullptr) {
+        printf("cannot open %s\n", argv[1]);
+        return 1;
+    }
+    vector<float> pcm;
+    float buf[4096];
+    size_t n;
+    while ((n = fread(buf, sizeof(float), 4096, fp)) > 0) {
+        pcm.insert(pcm.end(), buf, buf + n);
+    }
+    fclose(fp);
+
+    vector<Segment> labels;
+    fp = fopen(argv[2], "r");
+    if (fp == nullptr) {
+        printf("cannot open %s\n", argv[2]);
+        return 1;
+    }
+    Segment s;
+    while (fscanf(fp, "%lf %lf", &s.start, &s.end) == 2) {
+        labels.push_back(s);
+    }
+    fclose(fp);
+    std::sort(labels.begin(), labels.end(), [](const Segment &a, const Segment &b) {
+        return a.start < b.start;
+    });
+
+    VAD_SysInit();
+    Run off, on;
+    runVad(pcm, labels, false, floorDb, off);
+    runVad(pcm, labels, true, floorDb, on);
+    VAD_SysExit();
+
+    printf("%.2f hours, %zu segments, ns floor %.1f db\n",
+           off.frames * R2_AUDIO_FRAME_MS / 3600000.0, labels.size(), floorDb);
+    report("ns off", off, labels);
+    report("ns on", on, labels);
+    double noiseDb = 10.0 * log10((on.noiseOut + 1e-9) / (on.noiseIn + 1e-9));
+    double speechDb = 10.0 * log10((on.speechOut + 1e-9) / (on.speechIn + 1e-9));
+    printf("ns level outside segments %.1f db, inside %.1f db, snr better by about %.1f db\n",
+           noiseDb, speechDb, speechDb - noiseDb);
+    double us = on.nsCpuS * 1e6 / on.frames;
+    printf("ns %.3f us per %dms frame, %.3f%% of a core\n", us, R2_AUDIO_FRAME_MS,
+           us * 100.0 / (R2_AUDIO_FRAME_MS * 1000.0));
+    return 0;
+}
@@ -0,0 +1,374 @@
+// Test ns of bf output on plain linux: bypass is the input one hop late
+// to the sample, output is as long as whole hops in whatever chunks input
+// comes, a floor of 0db makes active hops the same delayed input so
+// switching between bypass and active leaves no seam, noise tracked in
+// bypass is there when ns starts, and syllable like bursts over fan noise
+// (hum and low pass noise) come out with a better snr. Ends with cpu of
+// one 10ms frame active and bypassed.
+//
+// fftw is not on the host, the test brings a radix 2 fft under the fftwf
+// names ns uses, so cpu is of that fft and not of fftw on the device.
+//
+// build (in jni/blacksiren), add -DR2NS_NO_SIMD for the scalar kernels:
+//   g++ -std=c++11 -O2 -Itest/stub -Ilibbsiren/include -Ilibbsiren/include/legacy
+//   -Ilibbsiren/prebuilt/support/include -o ns_test test/ns_test.cpp
+//   libbsiren/src/legacy/r2mem_ns.cpp libbsiren/src/legacy/r2math.cpp
+// run:
+//   ./ns_test
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <complex>
+#include <vector>
+#include <chrono>
+
+#include "legacy/r2mem_ns.h"
+
+using std::vector;
+
+typedef std::complex<float> cpx;
+
+struct fftwf_plan_s {
+    int n;
+    bool forward;
+    float *real;
+    fftwf_complex *spec;
+    vector<cpx> buf;
+};
+
+void *fftwf_malloc(size_t n) {
+    return malloc(n);
+}
+
+void fftwf_free(void *p) {
+    free(p);
+}
+
+fftwf_plan fftwf_plan_dft_r2c_1d(int n, float *in, fftwf_complex *out, unsigned) {
+    return new fftwf_plan_s{n, true, in, out, vector<cpx>(n)};
+}
+
+fftwf_plan fftwf_plan_dft_c2r_1d(int n, fftwf_complex *in, float *out, unsigned) {
+    return new fftwf_plan_s{n, false, out, in, vector<cpx>(n)};
+}
+
+void fftwf_destroy_plan(fftwf_plan p) {
+    delete p;
+}
+
+//in place radix 2, unnormalized like fftw
+static void fft(vector<cpx> &a, bool forward) {
+    int n = a.size();
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(a[i], a[j]);
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        float ang = (forward ? -2.0f : 2.0f) * (float)M_PI / len;
+        cpx wl(cosf(ang), sinf(ang));
+        for (int i = 0; i < n; i += len) {
+            cpx w(1.0f, 0.0f);
+            for (int k = 0; k < len / 2; k++) {
+                cpx u = a[i + k];
+                cpx v = a[i + k + len / 2] * w;
+                a[i + k] = u + v;
+                a[i + k + len / 2] = u - v;
+                w *= wl;
+            }
+        }
+    }
+}
+
+void fftwf_execute(const fftwf_plan p) {
+    int n = p->n;
+    if (p->forward) {
+        for (int i = 0; i < n; i++) {
+            p->buf[i] = cpx(p->real[i], 0.0f);
+        }
+        fft(p->buf, true);
+        for (int k = 0; k <= n / 2; k++) {
+            p->spec[k][0] = p->buf[k].real();
+            p->spec[k][1] = p->buf[k].imag();
+        }
+    } else {
+        for (int k = 0; k <= n / 2; k++) {
+            p->buf[k] = cpx(p->spec[k][0], p->spec[k][1]);
+        }
+        for (int k = n / 2 + 1; k < n; k++) {
+            p->buf[k] = std::conj(p->buf[n - k]);
+        }
+        fft(p->buf, false);
+        for (int i = 0; i < n; i++) {
+            p->real[i] = p->buf[i].real();
+        }
+    }
+}
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static const int HOP = R2_AUDIO_SAMPLE_RATE / 1000 * R2_AUDIO_FRAME_MS;
+static const float FULL = 32768.0f;
+
+static float db2amp(float db) {
+    return FULL * powf(10.0f, db / 20.0f);
+}
+
+static float noise(unsigned &seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return ((seed >> 8) / 8388608.0f - 1.0f) * 1.732f;
+}
+
+// speech like: 180ms voiced bursts (harmonics of a gliding f0 under a
+// hann) with 120ms pauses, rms of a burst at speechDb
+static vector<float> makeSpeech(float speechDb, float seconds, vector<int> &on) {
+    int n = (int)(seconds * R2_AUDIO_SAMPLE_RATE);
+    int burst = R2_AUDIO_SAMPLE_RATE * 180 / 1000;
+    int period = R2_AUDIO_SAMPLE_RATE * 300 / 1000;
+    vector<float> pcm(n, 0.0f);
+    const float partial[] = {1.0f, 0.7f, 0.5f, 0.35f, 0.25f, 0.2f, 0.15f, 0.1f};
+    float en = 0.0f;
+    for (float a : partial) {
+        en += a * a / 2.0f;
+    }
+    //hann has rms sqrt(3/8)
+    float amp = db2amp(speechDb) / sqrtf(0.375f * en);
+    for (int i = 0; i < n; i++) {
+        int k = i % period;
+        if (k < burst) {
+            float w = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * k / burst);
+            float f0 = 130.0f + 30.0f * ((i / period) % 3) + 40.0f * k / burst;
+            float x = 0.0f;
+            for (int h = 0; h < 8; h++) {
+                x += partial[h] * sinf(2.0f * (float)M_PI * f0 * (h + 1) * k / R2_AUDIO_SAMPLE_RATE);
+            }
+            pcm[i] = amp * w * x;
+        }
+    }
+    for (int start = 0; start < n; start += period) {
+        on.push_back(start);
+        on.push_back(r2_min(start + burst, n));
+    }
+    return pcm;
+}
+
+// fan: hum at blade rate and harmonics over low pass noise, rms at noiseDb
+static vector<float> makeFan(float noiseDb, float seconds, unsigned seed) {
+    int n = (int)(seconds * R2_AUDIO_SAMPLE_RATE);
+    vector<float> pcm(n);
+    double en = 0.0;
+    float lp = 0.0f;
+    for (int i = 0; i < n; i++) {
+        lp += 0.15f * (noise(seed) - lp);
+        float t = (float)i / R2_AUDIO_SAMPLE_RATE;
+        pcm[i] = 2.0f * lp + 0.3f * sinf(2.0f * (float)M_PI * 120.0f * t)
+                 + 0.2f * sinf(2.0f * (float)M_PI * 240.0f * t) + 0.1f * sinf(2.0f * (float)M_PI * 360.0f * t);
+        en += (double)pcm[i] * pcm[i];
+    }
+    float scale = db2amp(noiseDb) / sqrtf((float)(en / n));
+    for (float &x : pcm) {
+        x *= scale;
+    }
+    return pcm;
+}
+
+//runs pcm through ns in chunks of len, bypass per hop index
+template <typename F>
+static vector<float> runNs(r2mem_ns &ns, const vector<float> &pcm, int len, F bypass) {
+    vector<float> out;
+    int hops = 0;
+    for (size_t i = 0; i + len <= pcm.size(); i += len) {
+        float *po = nullptr;
+        int lo = 0;
+        ns.process((float *)&pcm[i], len, bypass(hops), po, lo);
+        out.insert(out.end(), po, po + lo);
+        hops += lo / HOP;
+    }
+    return out;
+}
+
+static void testBypass() {
+    unsigned seed = 3;
+    vector<float> pcm(HOP * 50);
+    for (float &x : pcm) {
+        x = noise(seed) * 8000.0f;
+    }
+    r2mem_ns ns(-12.0f);
+    vector<float> out = runNs(ns, pcm, HOP, [](int) { return true; });
+    CHECK(out.size() == pcm.size());
+    bool same = true;
+    for (size_t i = 0; i < out.size(); i++) {
+        float want = i < (size_t)HOP ? 0.0f : pcm[i - HOP];
+        same = same && out[i] == want;
+    }
+    CHECK(same);
+    CHECK(ns.m_iHop_Bypass == 50 && ns.m_iHop_Active == 0);
+}
+
+static void testChunks() {
+    unsigned seed = 5;
+    vector<float> pcm(HOP * 40);
+    for (float &x : pcm) {
+        x = noise(seed) * 8000.0f;
+    }
+    r2mem_ns ns(0.0f);
+    const int chunk[] = {100, 37, HOP, 3 * HOP + 11, 1, HOP - 1, 250};
+    size_t in = 0, out = 0;
+    int c = 0;
+    while (in + chunk[c % 7] <= pcm.size()) {
+        int len = chunk[c % 7];
+        float *po = nullptr;
+        int lo = 0;
+        ns.process(&pcm[in], len, false, po, lo);
+        in += len;
+        out += lo;
+        CHECK(out == in / HOP * HOP);
+        c++;
+    }
+}
+
+static void testSeamless() {
+    unsigned seed = 7;
+    vector<float> pcm(HOP * 200);
+    for (size_t i = 0; i < pcm.size(); i++) {
+        pcm[i] = noise(seed) * 4000.0f + 6000.0f * sinf(2.0f * (float)M_PI * 440.0f * i / R2_AUDIO_SAMPLE_RATE);
+    }
+    //0db floor is unity gain, active hops only add fft round off
+    r2mem_ns ns(0.0f);
+    vector<float> out = runNs(ns, pcm, HOP, [](int h) { return (h / 7) % 2 == 1 || h % 13 == 0; });
+    float worst = 0.0f;
+    for (size_t i = HOP; i < out.size(); i++) {
+        worst = r2_max(worst, fabsf(out[i] - pcm[i - HOP]));
+    }
+    printf("bypass/active switching at unity gain: worst error %.4f of 32768\n", worst);
+    CHECK(worst < 0.5f);
+    CHECK(ns.m_iHop_Active > 50 && ns.m_iHop_Bypass > 50);
+}
+
+//energy ratio out/in in db over samples picked by inside, out is a hop late
+template <typename F>
+static float attenuation(const vector<float> &in, const vector<float> &out, int from, F inside) {
+    double ei = 0.0, eo = 0.0;
+    for (size_t i = from; i + HOP < out.size(); i++) {
+        if (inside(i)) {
+            ei += (double)in[i] * in[i];
+            eo += (double)out[i + HOP] * out[i + HOP];
+        }
+    }
+    return 10.0f * log10f((float)(eo / (ei + 1e-9)) + 1e-12f);
+}
+
+//speech loses more as snr falls, at most maxLossDb
+static void testSnr(float snrDb, float maxLossDb) {
+    vector<int> on;
+    vector<float> speech = makeSpeech(-26.0f, 8.0f, on);
+    vector<float> fan = makeFan(-26.0f - snrDb, 8.0f, 11);
+    vector<float> noisy(speech.size());
+    for (size_t i = 0; i < noisy.size(); i++) {
+        noisy[i] = speech[i] + fan[i];
+    }
+    vector<char> burst(noisy.size(), 0), pause(noisy.size(), 0);
+    int margin = R2_AUDIO_SAMPLE_RATE * 30 / 1000;
+    for (size_t b = 0; b + 1 < on.size(); b += 2) {
+        for (int i = on[b] + margin; i < on[b + 1] - margin; i++) {
+            burst[i] = 1;
+        }
+        int next = b + 2 < on.size() ? on[b + 2] : (int)noisy.size();
+        for (int i = on[b + 1] + margin; i < next - margin; i++) {
+            pause[i] = 1;
+        }
+    }
+
+    r2mem_ns ns(-12.0f);
+    vector<float> out = runNs(ns, noisy, HOP, [](int) { return false; });
+    int settle = R2_AUDIO_SAMPLE_RATE;
+    //noise alone in pauses, then speech left in bursts once the noise,
+    //taken down as in pauses, is taken out of them
+    float nAtt = attenuation(noisy, out, settle, [&](size_t i) { return pause[i] != 0; });
+    double es = 0.0, en = 0.0, eo = 0.0;
+    for (size_t i = settle; i + HOP < out.size(); i++) {
+        if (burst[i] != 0) {
+            es += (double)speech[i] * speech[i];
+            en += (double)fan[i] * fan[i];
+            eo += (double)out[i + HOP] * out[i + HOP];
+        }
+    }
+    double left = eo - en * pow(10.0, nAtt / 10.0);
+    float sAtt = 10.0f * log10f((float)(r2_max(left, 1e-9) / es));
+    printf("snr %4.1f db: speech %5.1f db, noise %5.1f db, snr better by %.1f db\n",
+           snrDb, sAtt, nAtt, sAtt - nAtt);
+    CHECK(sAtt > -maxLossDb);
+    CHECK(nAtt < -8.0f);
+    CHECK(sAtt - nAtt > 6.0f);
+}
+
+static void testBypassTrack() {
+    vector<float> fan = makeFan(-40.0f, 4.0f, 13);
+    r2mem_ns ns(-12.0f);
+    //3s bypassed as in sleep, then active
+    int bypassHops = 3 * R2_AUDIO_SAMPLE_RATE / HOP;
+    vector<float> out = runNs(ns, fan, HOP, [&](int h) { return h < bypassHops; });
+    //first 200ms after ns starts
+    int from = bypassHops * HOP;
+    int to = from + R2_AUDIO_SAMPLE_RATE / 5;
+    float nAtt = attenuation(fan, out, from, [&](size_t i) { return (int)i < to; });
+    printf("noise tracked in bypass: first 200ms active %.1f db\n", nAtt);
+    CHECK(nAtt < -8.0f);
+}
+
+static void benchFrame() {
+    vector<int> on;
+    vector<float> speech = makeSpeech(-26.0f, 10.0f, on);
+    vector<float> fan = makeFan(-36.0f, 10.0f, 17);
+    for (size_t i = 0; i < speech.size(); i++) {
+        speech[i] += fan[i];
+    }
+    for (int bypass = 0; bypass < 2; bypass++) {
+        r2mem_ns ns(-12.0f);
+        int frames = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < 5; r++) {
+            for (size_t i = 0; i + HOP <= speech.size(); i += HOP) {
+                float *po = nullptr;
+                int len = 0;
+                ns.process(&speech[i], HOP, bypass != 0, po, len);
+                frames++;
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        double us = std::chrono::duration<double, std::micro>(t1 - t0).count() / frames;
+        printf("ns %s %.3f us per %dms frame, %.3f%% of a core\n", bypass ? "bypassed" : "active",
+               us, R2_AUDIO_FRAME_MS, us * 100.0 / (R2_AUDIO_FRAME_MS * 1000.0));
+    }
+}
+
+int main() {
+    testBypass();
+    testChunks();
+    testSeamless();
+    testSnr(15.0f, 1.0f);
+    testSnr(5.0f, 2.5f);
+    testSnr(0.0f, 4.5f);
+    testBypassTrack();
+    benchFrame();
+
+    if (failures != 0) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
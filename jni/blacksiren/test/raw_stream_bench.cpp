@@ -0,0 +1,257 @@
+// Cost of raw stream next to processed stream: siren runs as thread on
+// noise given at real time pace, with processed stream only, then with
+// raw stream after preprocess and after bf as well. Prints cpu of siren
+// threads and of the raw thread per second of audio, raw frames got and
+// their delay from input, how late input was read and processed events,
+// so what raw stream takes from processed stream is seen side by side.
+//
+// build (in jni/blacksiren, libbsiren built for linux with its prebuilt
+// libs, e.g. libbsiren/prebuilt/support/libs/linux/arm64):
+//   g++ -std=c++11 -O2 -Ilibbsiren/include -Ilibjsonc/include
+//   -o raw_stream_bench test/raw_stream_bench.cpp -Lout -lbsiren -ljson-c -lpthread
+// run:
+//   ./raw_stream_bench /system/etc/blacksiren.json [seconds]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include "siren.h"
+#include "siren_config_if.h"
+#include "json.h"
+
+using namespace BlackSiren;
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+
+static const int FRAME_MS = 10;
+
+struct Run {
+    std::mutex mutex;
+    steady_clock::time_point begin;
+    //read time of every input frame, raw frame k is of input frame k
+    vector<steady_clock::time_point> reads;
+    vector<double> lateMs;
+    vector<double> rawMs;
+    std::atomic<long> rawBytes;
+    std::atomic<int> events;
+};
+
+static Run *run = nullptr;
+
+static int init_input(void *) {
+    return 0;
+}
+
+static void release_input(void *) {
+}
+
+static int start_input(void *) {
+    return 0;
+}
+
+static void stop_input(void *) {
+}
+
+//noise at real time pace
+static int read_input(void *, char *buff, int len) {
+    steady_clock::time_point due;
+    {
+        std::lock_guard<std::mutex> l_(run->mutex);
+        due = run->begin + std::chrono::milliseconds(FRAME_MS * run->reads.size());
+    }
+    std::this_thread::sleep_until(due);
+    steady_clock::time_point now = steady_clock::now();
+    for (int i = 0; i < len; i++) {
+        buff[i] = (char)(rand() >> 7);
+    }
+    std::lock_guard<std::mutex> l_(run->mutex);
+    run->reads.push_back(now);
+    run->lateMs.push_back(std::chrono::duration<double, std::milli>(now - due).count());
+    return 0;
+}
+
+static void on_err_input(void *) {
+}
+
+static void on_voice_event(void *, voice_event_t *) {
+    run->events++;
+}
+
+static void on_raw_voice(void *, int length, void *) {
+    steady_clock::time_point now = steady_clock::now();
+    run->rawBytes += length;
+    std::lock_guard<std::mutex> l_(run->mutex);
+    size_t k = run->rawMs.size();
+    if (k < run->reads.size()) {
+        run->rawMs.push_back(std::chrono::duration<double, std::milli>(now - run->reads[k]).count());
+    }
+}
+
+// config in thread mode with alg_raw_stream_bf set, as temp file
+static bool write_bench_config(const char *path, bool bf, const string &out) {
+    json_object *root = json_object_from_file(path);
+    if (root == nullptr) {
+        printf("parse %s failed\n", path);
+        return false;
+    }
+    json_object *basic = nullptr;
+    json_object *alg = nullptr;
+    if (!json_object_object_get_ex(root, KEY_BASIC_CONFIG, &basic)
+            || !json_object_object_get_ex(root, KEY_ALG_CONFIG, &alg)) {
+        printf("%s has no %s or %s\n", path, KEY_BASIC_CONFIG, KEY_ALG_CONFIG);
+        json_object_put(root);
+        return false;
+    }
+    json_object_object_add(basic, KEY_SIREN_PROCESS_MODE, json_object_new_string(PROCESS_MODE_THREAD));
+    json_object_object_add(alg, KEY_ALG_RAW_STREAM_BF, json_object_new_boolean(bf));
+    bool ok = json_object_to_file(out.c_str(), root) == 0;
+    json_object_put(root);
+    return ok;
+}
+
+// cpu ticks of threads of this process, of raw thread and of the others
+static void thread_ticks(long &raw, long &others) {
+    raw = 0;
+    others = 0;
+    DIR *dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        string base = string("/proc/self/task/") + entry->d_name;
+        char comm[64] = {0};
+        FILE *fp = fopen((base + "/comm").c_str(), "r");
+        if (fp == nullptr) {
+            continue;
+        }
+        if (fgets(comm, sizeof(comm), fp) == nullptr) {
+            comm[0] = 0;
+        }
+        fclose(fp);
+
+        char stat[1024] = {0};
+        fp = fopen((base + "/stat").c_str(), "r");
+        if (fp == nullptr) {
+            continue;
+        }
+        size_t n = fread(stat, 1, sizeof(stat) - 1, fp);
+        fclose(fp);
+        stat[n] = 0;
+        //utime and stime are fields 14 and 15, after the ')' ending comm
+        char *p = strrchr(stat, ')');
+        long utime = 0, stime = 0;
+        if (p == nullptr || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %ld %ld",
+                                   &utime, &stime) != 2) {
+            continue;
+        }
+        if (strncmp(comm, "siren_raw", 9) == 0) {
+            raw += utime + stime;
+        } else {
+            others += utime + stime;
+        }
+    }
+    closedir(dir);
+}
+
+static double percentile(vector<double> v, double p) {
+    if (v.empty()) {
+        return 0.0;
+    }
+    std::sort(v.begin(), v.end());
+    return v[(size_t)((v.size() - 1) * p)];
+}
+
+static bool bench(const char *name, const string &config, siren_input_if_t *input, bool raw, int seconds) {
+    Run r;
+    r.rawBytes = 0;
+    r.events = 0;
+    r.begin = steady_clock::now();
+    run = &r;
+
+    siren_t siren = init_siren(nullptr, config.c_str(), input);
+    if (siren == 0) {
+        printf("init siren failed\n");
+        return false;
+    }
+
+    siren_proc_callback_t proc;
+    proc.voice_event_callback = on_voice_event;
+    siren_raw_stream_callback_t rawCallback;
+    rawCallback.raw_voice_callback = on_raw_voice;
+
+    long raw0, others0, raw1, others1;
+    thread_ticks(raw0, others0);
+    {
+        std::lock_guard<std::mutex> l_(r.mutex);
+        r.begin = steady_clock::now();
+    }
+    //raw first, so it gets every input frame from the first one
+    if (raw) {
+        start_siren_raw_stream(siren, &rawCallback);
+    }
+    start_siren_process_stream(siren, &proc);
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    thread_ticks(raw1, others1);
+    stop_siren_stream(siren);
+    destroy_siren(siren);
+
+    long tick = sysconf(_SC_CLK_TCK);
+    int fed = 0;
+    {
+        std::lock_guard<std::mutex> l_(r.mutex);
+        fed = r.reads.size();
+    }
+    double audio = fed * FRAME_MS / 1000.0;
+    printf("%-11s cpu %6.1f ms/s raw %6.1f ms/s, raw frames %5d of %5d (%ld bytes), "
+           "raw delay p50 %5.2f p99 %5.2f ms, read late p99 %5.2f ms, events %d\n",
+           name, (others1 - others0) * 1000.0 / tick / audio, (raw1 - raw0) * 1000.0 / tick / audio,
+           (int)r.rawMs.size(), fed, r.rawBytes.load(), percentile(r.rawMs, 0.5), percentile(r.rawMs, 0.99),
+           percentile(r.lateMs, 0.99), r.events.load());
+    run = nullptr;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("usage: %s config.json [seconds]\n", argv[0]);
+        return 2;
+    }
+    int seconds = argc > 2 ? atoi(argv[2]) : 30;
+
+    siren_input_if_t input;
+    memset(&input, 0, sizeof(input));
+    input.init_input = init_input;
+    input.release_input = release_input;
+    input.start_input = start_input;
+    input.stop_input = stop_input;
+    input.read_input = read_input;
+    input.on_err_input = on_err_input;
+
+    string pre("/tmp/raw_stream_bench_pre.json");
+    string bf("/tmp/raw_stream_bench_bf.json");
+    if (!write_bench_config(argv[1], false, pre) || !write_bench_config(argv[1], true, bf)) {
+        return 1;
+    }
+
+    bool ok = bench("processed", pre, &input, false, seconds)
+              && bench("+raw pre", pre, &input, true, seconds)
+              && bench("+raw bf", bf, &input, true, seconds);
+    unlink(pre.c_str());
+    unlink(bf.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// Test in-tree polyphase resampler r2prs on plain linux: for every mic
+// rate to 16k, tones in pass band come out with high SNR, tones above
+// 8k are gone, a channel delayed by half a sample matches the delayed
+// tone, output length follows the ratio over odd block sizes. Ends with
+// throughput of 8 channels in 10ms blocks per ratio.
+//
+// build (in jni/blacksiren), add -DR2PRS_NO_SIMD for the scalar kernel:
+//   g++ -std=c++11 -O2 -Ilibbsiren/include -o resampler_test
+//   test/resampler_test.cpp libbsiren/src/legacy/r2prs.cpp
+// run:
+//   ./resampler_test
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+#include "legacy/r2prs.h"
+
+using std::vector;
+using std::chrono::steady_clock;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static const int RATE_OUT = 16000;
+static const int RATES_IN[] = {48000, 44100, 32000, 96000, 8000};
+
+// resample one second of a tone through 10ms blocks, first channel plain,
+// second channel delayed by fDelay
+static void run_tone(int iSrIn, float fFreq, float fDelay, vector<float> &out0, vector<float> &out1,
+                     float &fLatency) {
+    float pDelay[2] = {0.0f, fDelay};
+    r2prs rs(2, iSrIn, RATE_OUT, pDelay);
+    fLatency = rs.getLatency();
+
+    int iBlock = iSrIn / 100;
+    vector<float> in(iBlock), o0(rs.getOutLenMax(iBlock)), o1(rs.getOutLenMax(iBlock));
+    out0.clear();
+    out1.clear();
+    for (int b = 0; b < 100; b++) {
+        for (int i = 0; i < iBlock; i++) {
+            in[i] = 0.5f * sinf(2.0f * M_PI * fFreq * (b * iBlock + i) / iSrIn);
+        }
+        const float *pIn[2] = {in.data(), in.data()};
+        float *pOut[2] = {o0.data(), o1.data()};
+        int n = rs.process(pIn, iBlock, pOut);
+        out0.insert(out0.end(), o0.begin(), o0.begin() + n);
+        out1.insert(out1.end(), o1.begin(), o1.begin() + n);
+    }
+}
+
+// output m is input at (m * in / out) - latency - delay, in input samples
+static double snr_db(const vector<float> &out, int iSrIn, float fFreq, float fLatency, float fDelay) {
+    double sig = 0.0, err = 0.0;
+    //skip filter warm up and leave the end
+    for (size_t m = RATE_OUT / 10; m < out.size() - RATE_OUT / 10; m++) {
+        double t = (double)m * iSrIn / RATE_OUT - fLatency - fDelay;
+        double ref = 0.5 * sin(2.0 * M_PI * fFreq * t / iSrIn);
+        sig += ref * ref;
+        err += (out[m] - ref) * (out[m] - ref);
+    }
+    return 10.0 * log10(sig / (err + 1e-30));
+}
+
+static double rms_db(const vector<float> &out) {
+    double e = 0.0;
+    int n = 0;
+    for (size_t m = RATE_OUT / 10; m < out.size(); m++, n++) {
+        e += out[m] * out[m];
+    }
+    //relative to the 0.5 amplitude tone put in
+    return 10.0 * log10(e / n / 0.125 + 1e-30);
+}
+
+static void test_tones() {
+    for (int iSrIn : RATES_IN) {
+        vector<float> out0, out1;
+        float fLatency = 0.0f;
+        double worstSnr = 1000.0, worstAlias = -1000.0;
+
+        //pass band
+        const float passFreqs[] = {100.0f, 1000.0f, 3000.0f, 6000.0f};
+        for (float f : passFreqs) {
+            if (f >= iSrIn / 2) {
+                continue;
+            }
+            run_tone(iSrIn, f, 0.5f, out0, out1, fLatency);
+            CHECK((int)out0.size() == RATE_OUT);
+            double s0 = snr_db(out0, iSrIn, f, fLatency, 0.0f);
+            double s1 = snr_db(out1, iSrIn, f, fLatency, 0.5f);
+            worstSnr = s0 < worstSnr ? s0 : worstSnr;
+            worstSnr = s1 < worstSnr ? s1 : worstSnr;
+        }
+
+        //above output nyquist, only when input has it
+        const float stopFreqs[] = {8500.0f, 12000.0f, 20000.0f};
+        for (float f : stopFreqs) {
+            if (f >= iSrIn / 2) {
+                continue;
+            }
+            run_tone(iSrIn, f, 0.0f, out0, out1, fLatency);
+            double a = rms_db(out0);
+            worstAlias = a > worstAlias ? a : worstAlias;
+        }
+
+        printf("%6d -> %d: pass band snr >= %.1f db, alias <= %.1f db, latency %.1f samples\n",
+               iSrIn, RATE_OUT, worstSnr, iSrIn > RATE_OUT ? worstAlias : 0.0, fLatency);
+        CHECK(worstSnr > 60.0);
+        CHECK(worstAlias < -60.0);
+    }
+}
+
+static void test_block_sizes() {
+    //odd block sizes, output total follows the ratio
+    r2prs rs(1, 44100, RATE_OUT, NULL);
+    vector<float> in(1000, 0.0f), out(rs.getOutLenMax(1000));
+    const float *pIn[1] = {in.data()};
+    float *pOut[1] = {out.data()};
+    long total = 0, consumed = 0;
+    const int blocks[] = {1, 7, 441, 999, 3, 160, 882};
+    for (int r = 0; r < 100; r++) {
+        for (int b : blocks) {
+            int n = rs.process(pIn, b, pOut);
+            CHECK(n <= rs.getOutLenMax(b));
+            total += n;
+            consumed += b;
+        }
+    }
+    long expect = consumed * RATE_OUT / 44100;
+    CHECK(total >= expect && total <= expect + 1);
+
+    //reset starts over
+    rs.reset();
+    CHECK(rs.process(pIn, 441, pOut) == 160);
+}
+
+static void bench() {
+    const int channels = 8;
+    for (int iSrIn : RATES_IN) {
+        r2prs rs(channels, iSrIn, RATE_OUT, NULL);
+        int iBlock = iSrIn / 100;
+        vector<vector<float> > in(channels, vector<float>(iBlock)), out(channels, vector<float>(rs.getOutLenMax(iBlock)));
+        const float *pIn[channels];
+        float *pOut[channels];
+        for (int c = 0; c < channels; c++) {
+            for (int i = 0; i < iBlock; i++) {
+                in[c][i] = (float)((i * 7919 + c * 104729) % 2001 - 1000) / 1000.0f;
+            }
+            pIn[c] = in[c].data();
+            pOut[c] = out[c].data();
+        }
+
+        //10s of audio
+        steady_clock::time_point begin = steady_clock::now();
+        for (int b = 0; b < 1000; b++) {
+            rs.process(pIn, iBlock, pOut);
+        }
+        double sec = std::chrono::duration<double>(steady_clock::now() - begin).count();
+        printf("bench %6d -> %d, %d ch, %d taps: %.3f ms per 10ms block, %.0fx real time\n",
+               iSrIn, RATE_OUT, channels, rs.m_iTaps, sec * 1000.0 / 1000, 10.0 / sec);
+    }
+}
+
+int main() {
+    test_tones();
+    test_block_sizes();
+    bench();
+
+    if (failures != 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
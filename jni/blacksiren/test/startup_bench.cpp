@@ -0,0 +1,158 @@
+// Cold start of siren in each siren_process_mode: init_siren is run
+// again and again with the given config switched to fork and to thread
+// mode, and time until siren is ready is printed with the startup
+// timeline of the proxy (and of siren base in thread mode, forked siren
+// base logs its own). -c drops page cache before every start, needs root.
+//
+// build (in jni/blacksiren, libbsiren built for linux with its prebuilt
+// libs, e.g. libbsiren/prebuilt/support/libs/linux/arm64):
+//   g++ -std=c++11 -O2 -Ilibbsiren/include -Ilibjsonc/include
+//   -o startup_bench test/startup_bench.cpp -Lout -lbsiren -ljson-c -lpthread
+// run:
+//   ./startup_bench [-c] [-n runs] /system/etc/blacksiren.json
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "siren.h"
+#include "siren_config_if.h"
+#include "siren_timeline.h"
+#include "json.h"
+
+using namespace BlackSiren;
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+
+static int init_input(void *) {
+    return 0;
+}
+
+static void release_input(void *) {
+}
+
+static int start_input(void *) {
+    return 0;
+}
+
+static void stop_input(void *) {
+}
+
+static int read_input(void *, char *buff, int len) {
+    memset(buff, 0, len);
+    return 0;
+}
+
+static void on_err_input(void *) {
+}
+
+static void drop_caches() {
+    sync();
+    FILE *fp = fopen("/proc/sys/vm/drop_caches", "w");
+    if (fp == nullptr) {
+        printf("drop caches failed, not root?\n");
+        return;
+    }
+    fputs("3", fp);
+    fclose(fp);
+}
+
+// config with basic_config.siren_process_mode set, as temp file
+static bool write_mode_config(const char *path, const char *mode, const string &out) {
+    json_object *root = json_object_from_file(path);
+    if (root == nullptr) {
+        printf("parse %s failed\n", path);
+        return false;
+    }
+    json_object *basic = nullptr;
+    if (!json_object_object_get_ex(root, KEY_BASIC_CONFIG, &basic)) {
+        printf("%s has no %s\n", path, KEY_BASIC_CONFIG);
+        json_object_put(root);
+        return false;
+    }
+    json_object_object_add(basic, KEY_SIREN_PROCESS_MODE, json_object_new_string(mode));
+    bool ok = json_object_to_file(out.c_str(), root) == 0;
+    json_object_put(root);
+    return ok;
+}
+
+static double run_once(const string &config, siren_input_if_t *input, bool verbose) {
+    steady_clock::time_point begin = steady_clock::now();
+    siren_t siren = init_siren(nullptr, config.c_str(), input);
+    double ms = std::chrono::duration<double, std::milli>(steady_clock::now() - begin).count();
+    if (siren == 0) {
+        printf("init siren failed\n");
+        return -1;
+    }
+
+    if (verbose) {
+        vector<SirenTimelineStep> steps = siren_timeline_steps();
+        for (const SirenTimelineStep &step : steps) {
+            printf("    %9.3f ms  %s\n", step.us / 1000.0, step.step);
+        }
+    }
+    destroy_siren(siren);
+    return ms;
+}
+
+int main(int argc, char **argv) {
+    bool cold = false;
+    int runs = 5;
+    int opt;
+    while ((opt = getopt(argc, argv, "cn:")) != -1) {
+        if (opt == 'c') {
+            cold = true;
+        } else if (opt == 'n') {
+            runs = atoi(optarg);
+        } else {
+            printf("usage: %s [-c] [-n runs] config.json\n", argv[0]);
+            return 2;
+        }
+    }
+    if (optind >= argc || runs < 1) {
+        printf("usage: %s [-c] [-n runs] config.json\n", argv[0]);
+        return 2;
+    }
+
+    siren_input_if_t input;
+    memset(&input, 0, sizeof(input));
+    input.init_input = init_input;
+    input.release_input = release_input;
+    input.start_input = start_input;
+    input.stop_input = stop_input;
+    input.read_input = read_input;
+    input.on_err_input = on_err_input;
+
+    const char *modes[] = {PROCESS_MODE_FORK, PROCESS_MODE_THREAD};
+    for (const char *mode : modes) {
+        string config = string("/tmp/startup_bench_") + mode + ".json";
+        if (!write_mode_config(argv[optind], mode, config)) {
+            return 1;
+        }
+
+        vector<double> times;
+        for (int i = 0; i < runs; i++) {
+            if (cold) {
+                drop_caches();
+            }
+            double ms = run_once(config, &input, i == 0);
+            if (ms < 0) {
+                return 1;
+            }
+            times.push_back(ms);
+        }
+        unlink(config.c_str());
+
+        double first = times[0];
+        std::sort(times.begin(), times.end());
+        printf("%-6s %s: first %.1f ms, median %.1f ms, min %.1f ms over %d runs\n", mode,
+               cold ? "cold" : "warm", first, times[times.size() / 2], times.front(), runs);
+    }
+    return 0;
+}
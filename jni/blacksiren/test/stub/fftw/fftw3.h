@@ -0,0 +1,7 @@
+/* host builds of tests: r2math.h takes fftw/ off arm, fftw3.h of prebuilt */
+#ifndef TEST_STUB_FFTW_FFTW3_H
+#define TEST_STUB_FFTW_FFTW3_H
+
+#include <fftw3.h>
+
+#endif
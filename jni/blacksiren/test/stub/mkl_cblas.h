@@ -0,0 +1,8 @@
+/* host builds of tests: r2math.h takes mkl off arm, cblas of blis in its place */
+#ifndef TEST_STUB_MKL_CBLAS_H
+#define TEST_STUB_MKL_CBLAS_H
+
+#include <blis/blis.h>
+#include <blis/cblas.h>
+
+#endif
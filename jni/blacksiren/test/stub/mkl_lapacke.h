@@ -0,0 +1,5 @@
+/* host builds of tests: r2math.h takes mkl off arm, no lapack is used */
+#ifndef TEST_STUB_MKL_LAPACKE_H
+#define TEST_STUB_MKL_LAPACKE_H
+
+#endif
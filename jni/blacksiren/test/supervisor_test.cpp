@@ -0,0 +1,284 @@
+// Test siren supervisor on plain linux with a fake siren base: a forked
+// child answers heartbeats over SirenSocketChannel and is told to abort
+// or to stop answering after a few of them. Supervisor must find both,
+// respawn with growing backoff through a failed spawn, replay to every
+// respawned child and count it all. Also checks frame gap overflow.
+//
+// build (in jni/blacksiren):
+//   g++ -std=c++11 -O2 -DCONFIG_SIREN_LOG_LEVEL=3 -I../include -Ilibbsiren/include
+//   -o supervisor_test test/supervisor_test.cpp libbsiren/src/siren_supervisor.cpp
+//   libbsiren/src/siren_channel.cpp libbsiren/src/siren_event_pool.cpp
+//   libbsiren/src/siren_log.cpp libbsiren/src/siren_vt_wire.cpp -lpthread
+// run:
+//   ./supervisor_test
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <chrono>
+
+#include "isiren.h"
+#include "siren_channel.h"
+#include "siren_supervisor.h"
+
+using namespace BlackSiren;
+using std::vector;
+using std::chrono::steady_clock;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+enum {
+    CHILD_OK = 0,
+    CHILD_CRASH,
+    CHILD_HANG,
+    CHILD_SPAWN_FAIL,
+};
+
+// heartbeats answered before the injected fault
+static const int FAULT_AFTER = 3;
+
+static void childMain(SirenSocketChannel *request, SirenSocketChannel *response, int fault) {
+    SirenSocketReader reader(request);
+    SirenSocketWriter writer(response);
+    reader.prepareOnReadSideProcess();
+    writer.prepareOnWriteSideProcess();
+
+    int beats = 0;
+    while (1) {
+        Message *msg = nullptr;
+        if (reader.pollMessage(&msg) != SIREN_CHANNEL_OK) {
+            _exit(0);
+        }
+        if (msg->msg == SIREN_REQUEST_MSG_HEARTBEAT) {
+            if (beats++ == FAULT_AFTER) {
+                if (fault == CHILD_CRASH) {
+                    abort();
+                } else if (fault == CHILD_HANG) {
+                    for (;;) {
+                        pause();
+                    }
+                }
+            }
+            Message reply(SIREN_RESPONSE_MSG_ON_HEARTBEAT);
+            writer.writeMessage(&reply);
+        }
+        delete [] (char *)msg;
+    }
+}
+
+// proxy side of fake siren base, as SirenProxy does it
+class FakeSiren {
+public:
+    explicit FakeSiren(const vector<int> &plan_) : plan(plan_) {}
+
+    SirenSupervisor *supervisor = nullptr;
+    int replays = 0;
+    vector<steady_clock::time_point> reapTimes;
+    vector<steady_clock::time_point> spawnTimes;
+
+    bool spawn() {
+        spawnTimes.push_back(steady_clock::now());
+        int fault = spawns < (int)plan.size() ? plan[spawns] : CHILD_OK;
+        spawns++;
+        if (fault == CHILD_SPAWN_FAIL) {
+            return false;
+        }
+
+        request.reset(new SirenSocketChannel);
+        response.reset(new SirenSocketChannel);
+        if (!request->open() || !response->open()) {
+            return false;
+        }
+
+        pid = fork();
+        if (pid == 0) {
+            childMain(request.get(), response.get(), fault);
+        }
+
+        std::lock_guard<std::mutex> l_(writerMutex);
+        writer.reset(new SirenSocketWriter(request.get()));
+        writer->prepareOnWriteSideProcess();
+        readerThread = std::thread(&FakeSiren::readerFn, this);
+        return true;
+    }
+
+    void reap() {
+        reapTimes.push_back(steady_clock::now());
+        if (pid > 0) {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            pid = -1;
+        }
+        {
+            std::lock_guard<std::mutex> l_(writerMutex);
+            writer.reset();
+        }
+        if (readerThread.joinable()) {
+            readerThread.join();
+        }
+    }
+
+    void heartbeat() {
+        std::lock_guard<std::mutex> l_(writerMutex);
+        if (writer) {
+            Message msg(SIREN_REQUEST_MSG_HEARTBEAT);
+            writer->writeMessage(&msg);
+        }
+    }
+
+private:
+    void readerFn() {
+        SirenSocketReader reader(response.get());
+        reader.prepareOnReadSideProcess();
+        while (1) {
+            Message *msg = nullptr;
+            if (reader.pollMessage(&msg) != SIREN_CHANNEL_OK) {
+                supervisor->onChildLost();
+                return;
+            }
+            if (msg->msg == SIREN_RESPONSE_MSG_ON_HEARTBEAT) {
+                supervisor->onHeartbeat();
+            }
+            delete [] (char *)msg;
+        }
+    }
+
+    vector<int> plan;
+    int spawns = 0;
+    pid_t pid = -1;
+    std::unique_ptr<SirenSocketChannel> request;
+    std::unique_ptr<SirenSocketChannel> response;
+    std::mutex writerMutex;
+    std::unique_ptr<SirenSocketWriter> writer;
+    std::thread readerThread;
+};
+
+static int ms(steady_clock::time_point from, steady_clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+}
+
+static void test_backoff() {
+    SirenSupervisorConfig config;
+    config.backoffMin = 20;
+    config.backoffMax = 160;
+    CHECK(SirenSupervisor::backoff(config, 0) == 20);
+    CHECK(SirenSupervisor::backoff(config, 1) == 40);
+    CHECK(SirenSupervisor::backoff(config, 3) == 160);
+    CHECK(SirenSupervisor::backoff(config, 100) == 160);
+}
+
+static void test_respawn() {
+    SirenSupervisorConfig config;
+    config.heartbeatInterval = 50;
+    config.heartbeatTimeout = 300;
+    config.backoffMin = 20;
+    config.backoffMax = 160;
+
+    FakeSiren fake({CHILD_CRASH, CHILD_HANG, CHILD_SPAWN_FAIL, CHILD_OK});
+    SirenSupervisor::Child child;
+    child.spawn = [&fake] {
+        return fake.spawn();
+    };
+    child.reap = [&fake] {
+        fake.reap();
+    };
+    child.heartbeat = [&fake] {
+        fake.heartbeat();
+    };
+    child.replay = [&fake] {
+        fake.replays++;
+    };
+
+    SirenSupervisor supervisor(config, child);
+    fake.supervisor = &supervisor;
+    CHECK(fake.spawn());
+    supervisor.start();
+
+    siren_supervisor_stats_t stats;
+    steady_clock::time_point begin = steady_clock::now();
+    do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        supervisor.getStats(&stats);
+    } while (stats.restarts < 2 && ms(begin, steady_clock::now()) < 10000);
+
+    //healthy child keeps answering, nothing more happens
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    supervisor.getStats(&stats);
+    CHECK(!supervisor.isDown());
+    CHECK(stats.crashes == 1);
+    CHECK(stats.hangs == 1);
+    CHECK(stats.spawn_failures == 1);
+    CHECK(stats.restarts == 2);
+    CHECK(fake.replays == 2);
+
+    //spawn 0 by test, then after crash, after hang, failed one, last one
+    CHECK(fake.spawnTimes.size() == 4);
+    CHECK(fake.reapTimes.size() == 3);
+    if (fake.spawnTimes.size() == 4 && fake.reapTimes.size() == 3) {
+        int crashDelay = ms(fake.reapTimes[0], fake.spawnTimes[1]);
+        int hangDelay = ms(fake.reapTimes[1], fake.spawnTimes[2]);
+        int failDelay = ms(fake.reapTimes[2], fake.spawnTimes[3]);
+        printf("respawn delays %d %d %d ms\n", crashDelay, hangDelay, failDelay);
+        CHECK(crashDelay >= 20);
+        CHECK(hangDelay >= 40);
+        CHECK(failDelay >= 80);
+        CHECK(crashDelay < hangDelay && hangDelay < failDelay);
+    }
+
+    supervisor.stop();
+    fake.reap();
+}
+
+static void test_gap() {
+    SirenFrameGap gap;
+    gap.init(sizeof(int), 3);
+    CHECK(gap.empty());
+    CHECK(gap.front() == nullptr);
+
+    int kept = 0;
+    for (int i = 1; i <= 5; i++) {
+        kept += gap.push((const char *)&i) ? 1 : 0;
+    }
+    CHECK(kept == 3);
+    CHECK(gap.size() == 3);
+
+    //oldest dropped, order kept
+    for (int i = 3; i <= 5; i++) {
+        int frame = 0;
+        memcpy(&frame, gap.front(), sizeof(int));
+        CHECK(frame == i);
+        gap.pop();
+    }
+    CHECK(gap.empty());
+
+    SirenFrameGap none;
+    int frame = 0;
+    CHECK(!none.push((const char *)&frame));
+}
+
+int main() {
+    test_backoff();
+    test_gap();
+    test_respawn();
+
+    if (failures != 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
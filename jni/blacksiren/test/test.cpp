@@ -153,7 +153,7 @@ void on_voice_event(void *token, voice_event_t *event) {
 }
 
 void test_init() {
-    siren_input_if_t input_callback;
+    siren_input_if_t input_callback = {};
     input_callback.init_input = init_input_stream;
     input_callback.release_input = release_input_stream;
     input_callback.start_input = start_input_stream;
@@ -172,7 +172,7 @@ void test_init() {
 
 
 void test_recording() {
-    siren_input_if_t input_callback;
+    siren_input_if_t input_callback = {};
     siren_proc_callback_t proc_callback;
 
     input_callback.init_input = init_input_stream;
@@ -269,7 +269,7 @@ void on_siren_state_changed_fn(void *token, int current) {
 
 void test_xmos() {
 
-    siren_input_if_t input_callback;
+    siren_input_if_t input_callback = {};
     siren_proc_callback_t proc_callback;
     siren_state_changed_callback_t state_changed_callback;
     siren_net_callback_t net_callback;
@@ -395,7 +395,7 @@ void test_download() {
 }
 
 void test_send() {
-    siren_input_if_t input_callback;
+    siren_input_if_t input_callback = {};
     siren_proc_callback_t proc_callback;
     siren_state_changed_callback_t state_changed_callback;
     state_changed_callback.state_changed_callback = on_siren_state_changed_fn;
@@ -430,7 +430,7 @@ void dump_vt_word(siren_vt_word &vt_word) {
 }
 
 void test_vt() {
-    siren_input_if_t input_callback;
+    siren_input_if_t input_callback = {};
     input_callback.init_input = init_input_stream;
     input_callback.release_input = release_input_stream;
     input_callback.start_input = start_input_stream;
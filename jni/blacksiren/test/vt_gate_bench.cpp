@@ -0,0 +1,194 @@
+// Vt gate on a long recording: the processor is run over a preprocess
+// debug recording (debug_pre_result_record, float32 over alg_aec_mics)
+// in sleep, once with alg_vt_gate off and once on. Prints cpu of the
+// processor per hour of audio, part of time the gate was closed, and
+// wakes against a label file of wake word starts: false rejects of each
+// run, wakes the gate lost that the ungated run got, and false accepts
+// per hour. A recording of hours with sparse speech shows the saving.
+//
+// build (in jni/blacksiren, libbsiren built for linux with its prebuilt
+// libs, e.g. libbsiren/prebuilt/support/libs/linux/arm64):
+//   g++ -std=c++11 -O2 -Ilibbsiren/include -Ilibbsiren/include/legacy
+//   -Ilibbsiren/prebuilt/support/include -Ilibjsonc/include -o vt_gate_bench
+//   test/vt_gate_bench.cpp -Lout -lbsiren -lr2ssp -ljson-c -lpthread
+// run:
+//   ./vt_gate_bench /system/etc/blacksiren.json pre_debug.pcm labels.txt [onset db]
+// labels.txt holds one wake word start in seconds per line.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+
+#include "siren_config.h"
+#include "siren_processor.h"
+
+using namespace BlackSiren;
+using std::vector;
+
+//a wake this long after a label start is of that label
+static const double MATCH_S = 3.0;
+
+struct Run {
+    double cpuS;
+    double audioS;
+    float closed;
+    int onsets;
+    vector<double> wakes;
+};
+
+static double threadCpuS() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool runProcessor(SirenConfig config, bool gate, float onsetDb, const char *pcm, Run &run) {
+    config.alg_config.alg_vt_gate = gate;
+    config.alg_config.alg_vt_gate_onset_db = onsetDb;
+    config.debug_config.bf_record = false;
+    config.debug_config.bf_raw_record = false;
+    config.debug_config.vad_record = false;
+    config.debug_config.debug_opu_record = false;
+
+    FILE *fp = fopen(pcm, "rb");
+    if (fp == nullptr) {
+        printf("cannot open %s\n", pcm);
+        return false;
+    }
+
+    SirenProcessorImpl processor(config);
+    if (processor.init() != 0) {
+        printf("init processor failed\n");
+        fclose(fp);
+        return false;
+    }
+
+    int hop = R2_AUDIO_SAMPLE_RATE / 1000 * R2_AUDIO_FRAME_MS;
+    int bytes = hop * config.alg_config.alg_aec_mics.size() * sizeof(float);
+    vector<char> frame(bytes);
+    long frames = 0;
+    run.cpuS = 0.0;
+    run.wakes.clear();
+
+    while (fread(frame.data(), 1, bytes, fp) == (size_t)bytes) {
+        double t0 = threadCpuS();
+        //sleep and never asr, as SirenAudioVBVProcessor calls it before a wake
+        processor.process(frame.data(), bytes, 0, 1, 0, 0, 0);
+        r2ad_msg_block **msgs = nullptr;
+        int num = 0;
+        processor.getMsgs(msgs, num);
+        run.cpuS += threadCpuS() - t0;
+        frames++;
+        for (int i = 0; i < num; i++) {
+            if (msgs[i]->iMsgId == r2ad_awake_nocmd || msgs[i]->iMsgId == r2ad_awake_cmd) {
+                run.wakes.push_back(frames * R2_AUDIO_FRAME_MS / 1000.0);
+            }
+        }
+    }
+    fclose(fp);
+
+    run.audioS = frames * R2_AUDIO_FRAME_MS / 1000.0;
+    run.closed = 0.0f;
+    run.onsets = 0;
+    processor.getGateStats(run.closed, run.onsets);
+    processor.destroy();
+    return true;
+}
+
+static bool matched(const vector<double> &wakes, double label) {
+    for (double w : wakes) {
+        if (w >= label && w <= label + MATCH_S) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int falseAccepts(const vector<double> &wakes, const vector<double> &labels) {
+    int count = 0;
+    for (double w : wakes) {
+        bool hit = false;
+        for (double l : labels) {
+            if (w >= l && w <= l + MATCH_S) {
+                hit = true;
+                break;
+            }
+        }
+        count += hit ? 0 : 1;
+    }
+    return count;
+}
+
+static int missed(const Run &run, const vector<double> &labels) {
+    int count = 0;
+    for (double l : labels) {
+        count += matched(run.wakes, l) ? 0 : 1;
+    }
+    return count;
+}
+
+static void report(const char *name, const Run &run, const vector<double> &labels) {
+    int miss = missed(run, labels);
+    double hours = run.audioS / 3600.0;
+    printf("%-9s cpu %7.1f s per audio hour (%5.2f%% of a core), closed %5.1f%% onsets %5d, "
+           "wakes %4d, frr %5.2f%% (%d of %zu), fa %5.2f per hour\n",
+           name, run.cpuS / hours, run.cpuS * 100.0 / run.audioS, run.closed * 100.0, run.onsets,
+           (int)run.wakes.size(),
+           labels.empty() ? 0.0 : miss * 100.0 / labels.size(), miss, labels.size(),
+           falseAccepts(run.wakes, labels) / hours);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        printf("usage: %s config.json pre_debug.pcm labels.txt [onset db]\n", argv[0]);
+        return 2;
+    }
+
+    SirenConfigurationManager manager(argv[1]);
+    if (manager.parseConfigFile() != CONFIG_OK) {
+        printf("parse %s failed\n", argv[1]);
+        return 1;
+    }
+    SirenConfig config = manager.getConfigFile();
+    float onsetDb = argc > 4 ? atof(argv[4]) : config.alg_config.alg_vt_gate_onset_db;
+
+    vector<double> labels;
+    FILE *fp = fopen(argv[3], "r");
+    if (fp == nullptr) {
+        printf("cannot open %s\n", argv[3]);
+        return 1;
+    }
+    double t;
+    while (fscanf(fp, "%lf", &t) == 1) {
+        labels.push_back(t);
+    }
+    fclose(fp);
+    std::sort(labels.begin(), labels.end());
+
+    Run off, on;
+    if (!runProcessor(config, false, onsetDb, argv[2], off)
+            || !runProcessor(config, true, onsetDb, argv[2], on)) {
+        return 1;
+    }
+
+    printf("%.2f hours, %zu labels, gate onset %.1f db hangover %d ms lookback %d ms\n",
+           off.audioS / 3600.0, labels.size(), onsetDb, config.alg_config.alg_vt_gate_hangover_ms,
+           config.alg_config.alg_vt_gate_lookback_ms);
+    report("gate off", off, labels);
+    report("gate on", on, labels);
+
+    //labels the ungated run woke on and the gated one did not
+    int lost = 0;
+    for (double l : labels) {
+        if (matched(off.wakes, l) && !matched(on.wakes, l)) {
+            lost++;
+        }
+    }
+    printf("cpu saved %.1f%%, wakes lost by gate %d, frr difference %+.2f%%\n",
+           off.cpuS > 0 ? (off.cpuS - on.cpuS) * 100.0 / off.cpuS : 0.0, lost,
+           labels.empty() ? 0.0 : (missed(on, labels) - missed(off, labels)) * 100.0 / labels.size());
+    return 0;
+}
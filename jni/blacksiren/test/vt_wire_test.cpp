@@ -0,0 +1,319 @@
+// Test vt word wire format on plain linux: words round trip through the
+// proxy message and into WordInfo, an empty list means remove all, words
+// too long for WordInfo are refused when built, and cut, corrupt or
+// padded lists are refused when parsed. Ends with bytes on the wire and
+// time to sync 50 words against the old packed list and WordInfo array.
+//
+// build (in jni/blacksiren):
+//   g++ -std=c++11 -O2 -I../include -Ilibbsiren/include -Ilibbsiren/include/legacy
+//   -Ilibbsiren/prebuilt/support/include -o vt_wire_test test/vt_wire_test.cpp
+//   libbsiren/src/siren_vt_wire.cpp libbsiren/src/siren_channel.cpp
+//   libbsiren/src/siren_event_pool.cpp libbsiren/src/siren_log.cpp -lpthread
+// run:
+//   ./vt_wire_test
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "isiren.h"
+#include "siren_channel.h"
+#include "siren_vt_wire.h"
+#include "zvtapi.h"
+
+using namespace BlackSiren;
+using std::string;
+using std::vector;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static siren_vt_word makeWord(int i, const string &word, const string &phone, const string &nnet) {
+    siren_vt_word w;
+    w.vt_type = i % 3;
+    w.vt_word = word;
+    w.vt_pinyin = "ruo4qi2";
+    w.vt_phone = phone;
+    w.use_default_config = false;
+    w.alg_config.vt_block_avg_score = 4.2f + i;
+    w.alg_config.vt_block_min_score = 2.7f + i;
+    w.alg_config.vt_left_sil_det = i & 1;
+    w.alg_config.vt_right_sil_det = (i & 2) != 0;
+    w.alg_config.vt_remote_check_with_aec = (i & 4) != 0;
+    w.alg_config.vt_remote_check_without_aec = (i & 8) != 0;
+    w.alg_config.vt_local_classify_check = (i & 16) != 0;
+    w.alg_config.vt_classify_shield = -0.3f * i;
+    w.alg_config.nnet_path = nnet;
+    return w;
+}
+
+static bool sameWord(const siren_vt_word &a, const siren_vt_word &b) {
+    const siren_vt_alg_config &x = a.alg_config;
+    const siren_vt_alg_config &y = b.alg_config;
+    return a.vt_type == b.vt_type && a.vt_word == b.vt_word && a.vt_phone == b.vt_phone
+           && x.vt_block_avg_score == y.vt_block_avg_score
+           && x.vt_block_min_score == y.vt_block_min_score
+           && x.vt_left_sil_det == y.vt_left_sil_det && x.vt_right_sil_det == y.vt_right_sil_det
+           && x.vt_remote_check_with_aec == y.vt_remote_check_with_aec
+           && x.vt_remote_check_without_aec == y.vt_remote_check_without_aec
+           && x.vt_local_classify_check == y.vt_local_classify_check
+           && x.vt_classify_shield == y.vt_classify_shield && x.nnet_path == y.nnet_path;
+}
+
+// words of a list, -1 if parser refused it
+static int parseAll(const char *buff, int len) {
+    SirenVTWireParser parser(buff, len);
+    SirenVTWireWord word;
+    int n = 0;
+    while (parser.next(word)) {
+        n++;
+    }
+    return parser.count() < 0 || parser.failed() ? -1 : n;
+}
+
+static vector<siren_vt_word> fiftyWords() {
+    vector<siren_vt_word> words;
+    for (int i = 0; i < 50; i++) {
+        string phone;
+        for (int j = 0; j < 4; j++) {
+            phone += "sil ch_" + std::to_string(i) + " en_" + std::to_string(j) + " ";
+        }
+        words.push_back(makeWord(i, "若琪" + std::to_string(i), phone,
+                                 i % 5 == 0 ? "/system/workdir_asr_cn/final.rq.nnet" : ""));
+    }
+    return words;
+}
+
+// bytes old allocateMessageFromVTWord put on the wire: 16 byte header,
+// then a 37 byte packed config, its strings with '\0' and padding to 8
+static int oldWireBytes(const vector<siren_vt_word> &words) {
+    int total = 16;
+    for (const siren_vt_word &w : words) {
+        int len = 37 + w.vt_word.size() + 1 + w.vt_phone.size() + 1 + w.alg_config.nnet_path.size() + 1;
+        total += (len + 7) / 8 * 8;
+    }
+    return total;
+}
+
+static void testRoundTrip() {
+    vector<siren_vt_word> words;
+    words.push_back(makeWord(0, "若琪", "sil r uo4 q i2 sil", ""));
+    words.push_back(makeWord(31, "小若小若", "sil x iao3 r uo4 x iao3 r uo4 sil", "/data/nnet/final.nnet"));
+    words.push_back(makeWord(5, "hey", "", ""));
+
+    Message *msg = allocateMessageFromVTWord(words);
+    CHECK(msg != nullptr);
+    if (msg == nullptr) {
+        return;
+    }
+    CHECK(msg->msg == SIREN_REQUEST_MSG_SYNC_VT_WORD_LIST);
+    CHECK(msg->len == SirenVTWireBuilder::measure(words));
+
+    vector<siren_vt_word> back;
+    CHECK(getVTWordFromMessage(msg, back) == 0);
+    CHECK(back.size() == words.size());
+    for (size_t i = 0; i < back.size() && i < words.size(); i++) {
+        CHECK(sameWord(words[i], back[i]));
+        CHECK(!back[i].use_default_config);
+    }
+
+    //what the processor fills, strings ended right after their bytes
+    WordInfo *infos = new WordInfo[words.size()];
+    memset(infos, 'x', sizeof(WordInfo) * words.size());
+    SirenVTWireParser parser(msg->data, msg->len);
+    SirenVTWireWord wire;
+    int i = 0;
+    while (parser.next(wire)) {
+        toWordInfo(wire, infos[i]);
+        const siren_vt_word &w = words[i];
+        CHECK(infos[i].iWordType == w.vt_type);
+        CHECK(strcmp(infos[i].pWordContent_UTF8, w.vt_word.c_str()) == 0);
+        CHECK(strcmp(infos[i].pWordContent_PHONE, w.vt_phone.c_str()) == 0);
+        CHECK(strcmp(infos[i].pLocalClassifyNnetPath, w.alg_config.nnet_path.c_str()) == 0);
+        CHECK(infos[i].fBlockAvgScore == w.alg_config.vt_block_avg_score);
+        CHECK(infos[i].fBlockMinScore == w.alg_config.vt_block_min_score);
+        CHECK(infos[i].fClassifyShield == w.alg_config.vt_classify_shield);
+        CHECK(infos[i].bLeftSilDet == w.alg_config.vt_left_sil_det);
+        CHECK(infos[i].bRightSilDet == w.alg_config.vt_right_sil_det);
+        CHECK(infos[i].bRemoteAsrCheckWithAec == w.alg_config.vt_remote_check_with_aec);
+        CHECK(infos[i].bRemoteAsrCheckWithNoAec == w.alg_config.vt_remote_check_without_aec);
+        CHECK(infos[i].bLocalClassifyCheck == w.alg_config.vt_local_classify_check);
+        i++;
+    }
+    CHECK(!parser.failed());
+    CHECK(i == (int)words.size());
+    delete []infos;
+    delete [](char *)msg;
+}
+
+static void testEmptyAndLimits() {
+    //remove all is a header only
+    vector<siren_vt_word> none;
+    Message *msg = allocateMessageFromVTWord(none);
+    CHECK(msg != nullptr);
+    if (msg != nullptr) {
+        CHECK(msg->len == SIREN_VT_WIRE_HEADER_SIZE);
+        CHECK(parseAll(msg->data, msg->len) == 0);
+        delete [](char *)msg;
+    }
+
+    //longest strings WordInfo holds pass and end inside its arrays
+    vector<siren_vt_word> longest;
+    longest.push_back(makeWord(1, string(SIREN_VT_WIRE_WORD_MAX, 'w'), string(SIREN_VT_WIRE_PHONE_MAX, 'p'),
+                               string(SIREN_VT_WIRE_NNET_PATH_MAX, 'n')));
+    msg = allocateMessageFromVTWord(longest);
+    CHECK(msg != nullptr);
+    if (msg != nullptr) {
+        SirenVTWireParser parser(msg->data, msg->len);
+        SirenVTWireWord wire;
+        CHECK(parser.next(wire));
+        WordInfo *info = new WordInfo;
+        toWordInfo(wire, *info);
+        CHECK(strlen(info->pWordContent_UTF8) == SIREN_VT_WIRE_WORD_MAX);
+        CHECK(strlen(info->pWordContent_PHONE) == SIREN_VT_WIRE_PHONE_MAX);
+        CHECK(strlen(info->pLocalClassifyNnetPath) == SIREN_VT_WIRE_NNET_PATH_MAX);
+        delete info;
+        delete [](char *)msg;
+    }
+
+    //one byte more than WordInfo holds refuses whole list
+    const char *what[] = {"word", "phone", "nnet"};
+    for (int k = 0; k < 3; k++) {
+        vector<siren_vt_word> tooLong;
+        tooLong.push_back(makeWord(0, "若琪", "sil", ""));
+        tooLong.push_back(makeWord(1, string(SIREN_VT_WIRE_WORD_MAX + (k == 0), 'w'),
+                                   string(SIREN_VT_WIRE_PHONE_MAX + (k == 1), 'p'),
+                                   string(SIREN_VT_WIRE_NNET_PATH_MAX + (k == 2), 'n')));
+        CHECK(SirenVTWireBuilder::measure(tooLong) < 0);
+        msg = allocateMessageFromVTWord(tooLong);
+        if (msg != nullptr) {
+            printf("FAIL too long %s taken\n", what[k]);
+            failures++;
+            delete [](char *)msg;
+        }
+    }
+
+    //builder refuses to run past its buffer
+    char small[32];
+    SirenVTWireBuilder builder(small, sizeof(small));
+    CHECK(!builder.add(makeWord(0, "若琪", "sil r uo4 q i2 sil", "")));
+    CHECK(builder.finish() < 0);
+}
+
+static void testMalformed() {
+    vector<siren_vt_word> words = fiftyWords();
+    int len = SirenVTWireBuilder::measure(words);
+    vector<char> buff(len + 1);
+    SirenVTWireBuilder builder(buff.data(), len);
+    for (const siren_vt_word &w : words) {
+        builder.add(w);
+    }
+    CHECK(builder.finish() == len);
+    CHECK(parseAll(buff.data(), len) == 50);
+
+    //every cut is refused
+    int taken = 0;
+    for (int cut = 0; cut < len; cut++) {
+        taken += parseAll(buff.data(), cut) >= 0 ? 1 : 0;
+    }
+    CHECK(taken == 0);
+
+    //bytes after last word
+    CHECK(parseAll(buff.data(), len + 1) < 0);
+
+    //other version, nullptr
+    vector<char> bad(buff);
+    bad[0] = SIREN_VT_WIRE_VERSION + 1;
+    CHECK(parseAll(bad.data(), len) < 0);
+    CHECK(parseAll(nullptr, len) < 0);
+
+    //count more or less than words
+    bad = buff;
+    bad[2] = 51;
+    CHECK(parseAll(bad.data(), len) < 0);
+    bad[2] = 49;
+    CHECK(parseAll(bad.data(), len) < 0);
+
+    //a length past WordInfo or past end of list
+    const int lenAt[] = {14, 16, 18};
+    for (int k = 0; k < 3; k++) {
+        bad = buff;
+        uint16_t huge = 0xffff;
+        memcpy(bad.data() + SIREN_VT_WIRE_HEADER_SIZE + lenAt[k], &huge, sizeof(huge));
+        CHECK(parseAll(bad.data(), len) < 0);
+    }
+
+    //a message of garbage
+    Message *msg = allocateMessage(SIREN_REQUEST_MSG_SYNC_VT_WORD_LIST, 64);
+    memset(msg->data, 0x5a, 64);
+    vector<siren_vt_word> back;
+    CHECK(getVTWordFromMessage(msg, back) < 0);
+    delete [](char *)msg;
+}
+
+static void benchFifty() {
+    vector<siren_vt_word> words = fiftyWords();
+    const int rounds = 2000;
+
+    int wireBytes = SirenVTWireBuilder::measure(words);
+    int oldBytes = oldWireBytes(words);
+    size_t infoBytes = sizeof(WordInfo) * words.size();
+    printf("50 words: wire %d bytes, old packed list %d bytes, WordInfo array %zu bytes\n",
+           wireBytes, oldBytes, infoBytes);
+
+    WordInfo *infos = new WordInfo[words.size()];
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        //proxy side
+        Message *msg = allocateMessageFromVTWord(words);
+        //processor side
+        SirenVTWireParser parser(msg->data, msg->len);
+        SirenVTWireWord wire;
+        int i = 0;
+        while (parser.next(wire)) {
+            toWordInfo(wire, infos[i++]);
+        }
+        CHECK(i == 50);
+        delete [](char *)msg;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    //old way: strings copied to a siren_vt_word vector, then strcpy into WordInfo
+    for (int r = 0; r < rounds; r++) {
+        vector<siren_vt_word> copied(words);
+        for (size_t i = 0; i < copied.size(); i++) {
+            strcpy(infos[i].pWordContent_UTF8, copied[i].vt_word.c_str());
+            strcpy(infos[i].pWordContent_PHONE, copied[i].vt_phone.c_str());
+            strcpy(infos[i].pLocalClassifyNnetPath, copied[i].alg_config.nnet_path.c_str());
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    delete []infos;
+
+    double wireUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / rounds;
+    double oldUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / rounds;
+    printf("sync 50 words: wire build+parse+fill %.1f us, old copy+strcpy (no packing) %.1f us\n",
+           wireUs, oldUs);
+}
+
+int main() {
+    testRoundTrip();
+    testEmptyAndLimits();
+    testMalformed();
+    benchFifty();
+
+    if (failures != 0) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
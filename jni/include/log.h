@@ -17,8 +17,6 @@
 #ifndef ANDROID_LOG_H
 #define ANDROID_LOG_H
 
-#include <android/log.h>
-
 #ifndef LOG_TAG
 #define LOG_TAG "openvoice_process"
 #endif
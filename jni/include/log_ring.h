@@ -0,0 +1,498 @@
+// Per-thread lock-free log rings shared by the speech sdk log (log.cc)
+// and the siren log (siren_log.cpp). A log is recorded as format string
+// pointer and raw args (strings copied), a drain thread merges the rings
+// in time order and formats the records. Both libraries include this
+// header, each keeps its own rings, sinks and drain thread.
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <atomic>
+
+// slots of per-thread ring, power of 2
+#define LOG_RING_SLOTS 256
+#define LOG_RING_ARGS_SIZE 224
+#define LOG_RING_MAX_LENGTH 1024
+#define LOG_RING_MAX_SPEC 32
+// drain interval if eventfd not available
+#define LOG_RING_POLL_INTERVAL 10
+// pause of drain thread after logs written, more logs are drained in a
+// batch and logging thread seldom has to wake drain thread when busy
+#define LOG_RING_BATCH_INTERVAL 1
+
+namespace log_ring {
+
+typedef struct {
+	uint64_t time_us;
+	const char* tag;
+	const char* fmt;
+	uint8_t level;
+	// args not fully recorded
+	uint8_t truncated;
+	uint16_t length;
+	char args[LOG_RING_ARGS_SIZE];
+} LogRecord;
+
+// single producer (owner thread), single consumer (drain)
+struct LogRing {
+	LogRing() : head(0), tail(0), dropped(0), orphaned(false),
+		writing(false), next(NULL) {
+	}
+
+	LogRecord records[LOG_RING_SLOTS];
+	std::atomic<uint32_t> head;
+	std::atomic<uint32_t> tail;
+	std::atomic<uint32_t> dropped;
+	// owner thread exited
+	std::atomic<bool> orphaned;
+	// owner thread recording, log from signal handler is dropped
+	volatile bool writing;
+	LogRing* next;
+};
+
+enum ArgType {
+	ARG_NONE,
+	ARG_INT,
+	ARG_LONG,
+	ARG_LLONG,
+	ARG_SIZE,
+	ARG_DOUBLE,
+	ARG_PTR,
+	ARG_STR,
+	// not supported, stop recording args
+	ARG_INVALID
+};
+
+typedef struct {
+	const char* begin;
+	uint32_t length;
+	uint32_t stars;
+	ArgType type;
+} FormatSpec;
+
+inline uint64_t now_us() {
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// find next conversion spec of 'fmt'
+// return pointer after the spec, NULL if no more spec
+inline const char* next_spec(const char* fmt, FormatSpec& spec) {
+	const char* p = strchr(fmt, '%');
+	if (p == NULL)
+		return NULL;
+	spec.begin = p++;
+	spec.stars = 0;
+	while (*p && strchr("-+ #0", *p))
+		++p;
+	if (*p == '*') {
+		++spec.stars;
+		++p;
+	}
+	while (*p >= '0' && *p <= '9')
+		++p;
+	if (*p == '.') {
+		++p;
+		if (*p == '*') {
+			++spec.stars;
+			++p;
+		}
+		while (*p >= '0' && *p <= '9')
+			++p;
+	}
+	int longs = 0;
+	bool size = false;
+	bool invalid = false;
+	while (*p && strchr("hlLjzqt", *p)) {
+		if (*p == 'l')
+			++longs;
+		else if (*p == 'q' || *p == 'j')
+			longs = 2;
+		else if (*p == 'z' || *p == 't')
+			size = true;
+		else if (*p == 'L')
+			invalid = true;
+		++p;
+	}
+	switch (*p) {
+	case '%':
+		spec.type = ARG_NONE;
+		break;
+	case 'd': case 'i': case 'u': case 'o':
+	case 'x': case 'X': case 'c':
+		if (size)
+			spec.type = ARG_SIZE;
+		else if (longs >= 2)
+			spec.type = ARG_LLONG;
+		else if (longs == 1)
+			spec.type = ARG_LONG;
+		else
+			spec.type = ARG_INT;
+		break;
+	case 'f': case 'F': case 'e': case 'E':
+	case 'g': case 'G': case 'a': case 'A':
+		spec.type = ARG_DOUBLE;
+		break;
+	case 'p':
+		spec.type = ARG_PTR;
+		break;
+	case 's':
+		spec.type = ARG_STR;
+		break;
+	default:
+		invalid = true;
+		break;
+	}
+	if (*p)
+		++p;
+	if (invalid || p - spec.begin >= LOG_RING_MAX_SPEC)
+		spec.type = ARG_INVALID;
+	spec.length = p - spec.begin;
+	return p;
+}
+
+inline bool put_u64(LogRecord& rec, uint64_t v) {
+	if (rec.length + sizeof(v) > LOG_RING_ARGS_SIZE)
+		return false;
+	memcpy(rec.args + rec.length, &v, sizeof(v));
+	rec.length += sizeof(v);
+	return true;
+}
+
+inline uint64_t get_u64(const LogRecord& rec, uint32_t& pos) {
+	uint64_t v = 0;
+	if (pos + sizeof(v) <= rec.length)
+		memcpy(&v, rec.args + pos, sizeof(v));
+	pos += sizeof(v);
+	return v;
+}
+
+inline bool put_str(LogRecord& rec, const char* s) {
+	if (s == NULL)
+		s = "(null)";
+	uint32_t space = LOG_RING_ARGS_SIZE - rec.length;
+	if (space == 0)
+		return false;
+	size_t len = strlen(s);
+	bool full = len < space;
+	if (!full)
+		len = space - 1;
+	memcpy(rec.args + rec.length, s, len);
+	rec.args[rec.length + len] = '\0';
+	rec.length += len + 1;
+	return full;
+}
+
+// record args as raw values, strings copied
+inline void encode_args(LogRecord& rec, const char* fmt, va_list ap) {
+	FormatSpec spec;
+	const char* p = fmt;
+	uint32_t i;
+	bool ok = true;
+
+	rec.length = 0;
+	while (ok && (p = next_spec(p, spec)) != NULL) {
+		if (spec.type == ARG_NONE)
+			continue;
+		if (spec.type == ARG_INVALID) {
+			ok = false;
+			break;
+		}
+		for (i = 0; ok && i < spec.stars; ++i)
+			ok = put_u64(rec, (int64_t)va_arg(ap, int));
+		if (!ok)
+			break;
+		switch (spec.type) {
+		case ARG_INT:
+			ok = put_u64(rec, (int64_t)va_arg(ap, int));
+			break;
+		case ARG_LONG:
+			ok = put_u64(rec, (int64_t)va_arg(ap, long));
+			break;
+		case ARG_LLONG:
+			ok = put_u64(rec, (uint64_t)va_arg(ap, long long));
+			break;
+		case ARG_SIZE:
+			ok = put_u64(rec, (uint64_t)va_arg(ap, size_t));
+			break;
+		case ARG_DOUBLE: {
+			double d = va_arg(ap, double);
+			uint64_t v;
+			memcpy(&v, &d, sizeof(v));
+			ok = put_u64(rec, v);
+			break;
+		}
+		case ARG_PTR:
+			ok = put_u64(rec, (uintptr_t)va_arg(ap, void*));
+			break;
+		case ARG_STR:
+			ok = put_str(rec, va_arg(ap, const char*));
+			break;
+		default:
+			break;
+		}
+	}
+	rec.truncated = ok ? 0 : 1;
+}
+
+template <typename T>
+inline int format_arg(char* out, size_t size, const char* spec,
+		uint32_t stars, const int* star_args, T v) {
+	if (stars == 0)
+		return snprintf(out, size, spec, v);
+	if (stars == 1)
+		return snprintf(out, size, spec, star_args[0], v);
+	return snprintf(out, size, spec, star_args[0], star_args[1], v);
+}
+
+// format record same as vsnprintf(fmt, args)
+inline void decode_record(const LogRecord& rec, char* out, size_t size) {
+	FormatSpec spec;
+	const char* p = rec.fmt;
+	const char* next;
+	char spec_str[LOG_RING_MAX_SPEC];
+	int star_args[2];
+	uint32_t pos = 0;
+	uint32_t i;
+	size_t len = 0;
+	int r;
+
+	out[0] = '\0';
+	while (len + 1 < size) {
+		next = next_spec(p, spec);
+		size_t literal = next ? (size_t)(spec.begin - p) : strlen(p);
+		if (literal > size - len - 1)
+			literal = size - len - 1;
+		memcpy(out + len, p, literal);
+		len += literal;
+		out[len] = '\0';
+		if (next == NULL)
+			break;
+		p = next;
+		if (spec.type == ARG_NONE) {
+			if (len + 1 < size)
+				out[len++] = '%';
+			out[len] = '\0';
+			continue;
+		}
+		if (spec.type == ARG_INVALID || pos >= rec.length)
+			break;
+		memcpy(spec_str, spec.begin, spec.length);
+		spec_str[spec.length] = '\0';
+		for (i = 0; i < spec.stars; ++i)
+			star_args[i] = (int)get_u64(rec, pos);
+		uint64_t v = 0;
+		if (spec.type != ARG_STR)
+			v = get_u64(rec, pos);
+		switch (spec.type) {
+		case ARG_INT:
+			r = format_arg(out + len, size - len, spec_str, spec.stars,
+					star_args, (int)v);
+			break;
+		case ARG_LONG:
+			r = format_arg(out + len, size - len, spec_str, spec.stars,
+					star_args, (long)v);
+			break;
+		case ARG_LLONG:
+			r = format_arg(out + len, size - len, spec_str, spec.stars,
+					star_args, (long long)v);
+			break;
+		case ARG_SIZE:
+			r = format_arg(out + len, size - len, spec_str, spec.stars,
+					star_args, (size_t)v);
+			break;
+		case ARG_DOUBLE: {
+			double d;
+			memcpy(&d, &v, sizeof(d));
+			r = format_arg(out + len, size - len, spec_str, spec.stars,
+					star_args, d);
+			break;
+		}
+		case ARG_PTR:
+			r = format_arg(out + len, size - len, spec_str, spec.stars,
+					star_args, (void*)(uintptr_t)v);
+			break;
+		case ARG_STR: {
+			const char* s = rec.args + pos;
+			pos += strlen(s) + 1;
+			r = format_arg(out + len, size - len, spec_str, spec.stars,
+					star_args, s);
+			break;
+		}
+		default:
+			r = 0;
+			break;
+		}
+		if (r > 0)
+			len += r;
+		if (len >= size) {
+			len = size - 1;
+			break;
+		}
+	}
+	if (rec.truncated && len + 4 < size)
+		strcpy(out + len, "...");
+}
+
+// wakes drain thread when a ring goes non-empty, drain thread sleeps
+// in read() of an eventfd instead of polling rings. Logging thread
+// writes the eventfd only if drain thread is about to sleep, at most
+// once per sleep, write() of eventfd is lock-free and signal safe.
+class LogWaker {
+public:
+	LogWaker() : fd_(-1), sleeping_(false) {
+	}
+
+	void init() {
+		fd_ = eventfd(0, EFD_CLOEXEC);
+		sleeping_.store(false);
+	}
+
+	// eventfd shared with parent process after fork, child needs its own
+	void reinit() {
+		if (fd_ >= 0)
+			close(fd_);
+		init();
+	}
+
+	// invoked by logging thread after record published
+	void wake() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!sleeping_.load(std::memory_order_relaxed)
+				|| !sleeping_.exchange(false))
+			return;
+		uint64_t one = 1;
+		ssize_t r = ::write(fd_, &one, sizeof(one));
+		(void)r;
+	}
+
+	// invoked by drain thread after logs written
+	void pause() {
+		usleep(LOG_RING_BATCH_INTERVAL * 1000);
+	}
+
+	// invoked by drain thread when rings drained,
+	// 'pending' checks rings again after sleeping_ published,
+	// so a record published meanwhile is seen here or wakes us
+	template <typename Pending>
+	void sleep(Pending pending) {
+		uint64_t v;
+		if (fd_ < 0) {
+			usleep(LOG_RING_POLL_INTERVAL * 1000);
+			return;
+		}
+		sleeping_.store(true);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (pending()) {
+			sleeping_.store(false);
+			return;
+		}
+		while (::read(fd_, &v, sizeof(v)) < 0 && errno == EINTR);
+	}
+
+private:
+	int fd_;
+	std::atomic<bool> sleeping_;
+};
+
+// record a log to 'ring' of caller thread
+// return false if ring full or recording interrupted by signal handler
+inline bool record(LogRing* ring, LogWaker& waker, uint8_t level,
+		const char* tag, const char* fmt, va_list ap) {
+	uint32_t h = ring->head.load(std::memory_order_relaxed);
+	if (ring->writing
+			|| h - ring->tail.load(std::memory_order_acquire)
+			>= LOG_RING_SLOTS) {
+		ring->dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	ring->writing = true;
+	LogRecord& rec = ring->records[h & (LOG_RING_SLOTS - 1)];
+	rec.time_us = now_us();
+	rec.tag = tag;
+	rec.fmt = fmt;
+	rec.level = level;
+	encode_args(rec, fmt, ap);
+	ring->head.store(h + 1, std::memory_order_release);
+	ring->writing = false;
+	waker.wake();
+	return true;
+}
+
+inline bool pending(LogRing* rings) {
+	LogRing* ring;
+	for (ring = rings; ring; ring = ring->next) {
+		if (ring->tail.load(std::memory_order_relaxed)
+				!= ring->head.load(std::memory_order_acquire))
+			return true;
+	}
+	return false;
+}
+
+// ring holding the oldest record, NULL if all rings empty
+inline LogRing* oldest(LogRing* rings) {
+	LogRing* ring;
+	LogRing* found = NULL;
+	uint64_t found_time = 0;
+	uint32_t t;
+	for (ring = rings; ring; ring = ring->next) {
+		t = ring->tail.load(std::memory_order_relaxed);
+		if (t == ring->head.load(std::memory_order_acquire))
+			continue;
+		uint64_t time = ring->records[t & (LOG_RING_SLOTS - 1)].time_us;
+		if (found == NULL || time < found_time) {
+			found = ring;
+			found_time = time;
+		}
+	}
+	return found;
+}
+
+// write records of all 'rings' in time order with
+// 'write(const LogRecord&, const char* text)'
+// return number of records written
+template <typename Writer>
+inline uint32_t drain(LogRing* rings, Writer write) {
+	LogRing* ring;
+	uint32_t t;
+	uint32_t count = 0;
+	char text[LOG_RING_MAX_LENGTH];
+
+	while ((ring = oldest(rings)) != NULL) {
+		t = ring->tail.load(std::memory_order_relaxed);
+		const LogRecord& rec = ring->records[t & (LOG_RING_SLOTS - 1)];
+		decode_record(rec, text, sizeof(text));
+		write(rec, text);
+		ring->tail.store(t + 1, std::memory_order_release);
+		++count;
+	}
+	return count;
+}
+
+// unlink and free rings of exited threads which are drained
+// return number of rings freed
+inline uint32_t free_orphans(LogRing** rings) {
+	LogRing** prev = rings;
+	LogRing* ring;
+	uint32_t count = 0;
+	while ((ring = *prev) != NULL) {
+		if (ring->orphaned.load(std::memory_order_acquire)
+				&& ring->tail.load(std::memory_order_relaxed)
+				== ring->head.load(std::memory_order_acquire)) {
+			*prev = ring->next;
+			delete ring;
+			++count;
+		} else
+			prev = &ring->next;
+	}
+	return count;
+}
+
+} // namespace log_ring
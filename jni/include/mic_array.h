@@ -14,6 +14,22 @@ __BEGIN_DECLS
 
 #define MIC_ARRAY_HARDWARE_MODULE_ID "mic_array"
 
+/* config_stream commands */
+/* cmd_buff: unsigned int, bytes per read, before start_stream */
+#define MIC_ARRAY_CMD_SET_FRAME_SIZE 1
+/* cmd_buff: struct mic_array_stat_t */
+#define MIC_ARRAY_CMD_GET_STAT 2
+
+struct mic_array_stat_t {
+    /* reads acquired */
+    unsigned long long frames;
+    /* handed out pointing into dma ring */
+    unsigned long long direct;
+    /* copied to bounce buffer */
+    unsigned long long bounced;
+    unsigned long long xruns;
+};
+
 struct mic_array_device_t {
 
     struct pcm *pcm;
@@ -27,11 +43,16 @@ struct mic_array_device_t {
     int (*get_stream_buff_size) (struct mic_array_device_t *dev);
     int (*start_stream) (struct mic_array_device_t *dev);
     int (*stop_stream) (struct mic_array_device_t *dev);
+    /* stop and free dev */
     int (*finish_stream) (struct mic_array_device_t * dev);
     int (*resume_stream) (struct mic_array_device_t *dev);
     int (*read_stream) (struct mic_array_device_t *dev, char *buff, unsigned int frame_cnt);
     int (*config_stream) (struct mic_array_device_t *dev, int cmd, char *cmd_buff);
     int (*find_card) (const char *snd);
+    /* pointer to next 'frame_cnt' bytes, in capture ring when possible,
+     * valid until release_stream. reads of get_stream_buff_size never wrap */
+    int (*acquire_stream) (struct mic_array_device_t *dev, char **buff, unsigned int frame_cnt);
+    int (*release_stream) (struct mic_array_device_t *dev, unsigned int frame_cnt);
 };
 
 int mic_array_device_open(struct mic_array_device_t **);
@@ -0,0 +1,72 @@
+#include <string.h>
+
+#include "CallbackBatch.h"
+
+// what, id, arg, sl, energy
+#define ENTRY_HEAD_SIZE (sizeof(int32_t) * 3 + sizeof(double) * 2)
+
+void CallbackBatch::push(const CallbackEvent& event){
+    Entry entry;
+    entry.what = event.what;
+    entry.id = event.id;
+    entry.arg = event.arg;
+    entry.sl = event.sl;
+    entry.energy = event.energy;
+    for(int i = 0; i < CALLBACK_EVENT_STRINGS; i++){
+        entry.offset[i] = pool.length();
+        entry.length[i] = 0;
+        if(event.strs[i] && !event.strs[i]->empty()){
+            entry.length[i] = event.strs[i]->length();
+            pool.append(*event.strs[i]);
+        }
+    }
+    entries.push_back(entry);
+}
+
+bool CallbackBatch::replace_last(const CallbackEvent& event){
+    if(entries.empty()) return false;
+    Entry& last = entries.back();
+    if(last.what != event.what || last.id != event.id || last.arg != event.arg) return false;
+    for(int i = 0; i < CALLBACK_EVENT_STRINGS; i++){
+        if(last.length[i] || (event.strs[i] && !event.strs[i]->empty())) return false;
+    }
+    last.sl = event.sl;
+    last.energy = event.energy;
+    return true;
+}
+
+uint32_t CallbackBatch::encoded_size(uint32_t index) const {
+    const Entry& entry = entries[index];
+    uint32_t size = ENTRY_HEAD_SIZE;
+    for(int i = 0; i < CALLBACK_EVENT_STRINGS; i++)
+        size += sizeof(int32_t) + entry.length[i];
+    return size;
+}
+
+static inline char* put(char* p, const void* v, uint32_t size){
+    memcpy(p, v, size);
+    return p + size;
+}
+
+uint32_t CallbackBatch::encode(uint32_t first, char* buf, uint32_t capacity, uint32_t& used) const {
+    uint32_t index;
+    char* p = buf;
+    used = 0;
+    for(index = first; index < entries.size(); index++){
+        uint32_t size = encoded_size(index);
+        if(used + size > capacity) break;
+        const Entry& entry = entries[index];
+        p = put(p, &entry.what, sizeof(entry.what));
+        p = put(p, &entry.id, sizeof(entry.id));
+        p = put(p, &entry.arg, sizeof(entry.arg));
+        p = put(p, &entry.sl, sizeof(entry.sl));
+        p = put(p, &entry.energy, sizeof(entry.energy));
+        for(int i = 0; i < CALLBACK_EVENT_STRINGS; i++){
+            int32_t length = entry.length[i];
+            p = put(p, &length, sizeof(length));
+            p = put(p, pool.data() + entry.offset[i], length);
+        }
+        used += size;
+    }
+    return index - first;
+}
@@ -0,0 +1,89 @@
+#ifndef CALLBACK_BATCH_H
+#define CALLBACK_BATCH_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define CALLBACK_EVENT_STRINGS 3
+
+// same as VoiceService.java MSG_*
+enum{
+    MSG_VOICE_EVENT_ID = 0,
+    MSG_INTERMEDIATE_RESULT_ID,
+    MSG_VOICE_COMMAND_ID,
+    MSG_SPEECH_ERROR_ID,
+};
+
+// one callback to java
+// MSG_VOICE_EVENT_ID:          arg = event, sl, energy
+// MSG_INTERMEDIATE_RESULT_ID:  arg = type, strs[0] = asr
+// MSG_VOICE_COMMAND_ID:        strs = asr, nlp, action
+// MSG_SPEECH_ERROR_ID:         arg = errcode
+// strs only valid during the send call, NULL or empty is null in java
+class CallbackEvent{
+public:
+    CallbackEvent(int32_t what, int32_t id, int32_t arg = 0)
+        : what(what), id(id), arg(arg), sl(0.0), energy(0.0){
+        for(int i = 0; i < CALLBACK_EVENT_STRINGS; i++) strs[i] = nullptr;
+    }
+
+    int32_t what;
+    int32_t id;
+    int32_t arg;
+    double sl;
+    double energy;
+    const std::string* strs[CALLBACK_EVENT_STRINGS];
+};
+
+// Events waiting for java, strings copied to a pooled buffer.
+// Encoded to a direct ByteBuffer and delivered by one jni call,
+// each event in native byte order:
+//   int32 what, int32 id, int32 arg, float64 sl, float64 energy,
+//   (int32 length, utf8 bytes) * CALLBACK_EVENT_STRINGS
+class CallbackBatch{
+public:
+    void push(const CallbackEvent& event);
+
+    // update last event in place if it has same what, id and arg,
+    // only events without strings are replaced
+    bool replace_last(const CallbackEvent& event);
+
+    // keep capacity of event list and string pool
+    void clear(){
+        entries.clear();
+        pool.clear();
+    }
+
+    inline bool empty() const {return entries.empty();}
+
+    inline uint32_t size() const {return entries.size();}
+
+    // encode events from 'first' until 'buf' full
+    // return count of events encoded, 'used' set to bytes written
+    uint32_t encode(uint32_t first, char* buf, uint32_t capacity, uint32_t& used) const;
+
+    // bytes of event 'index' encoded
+    uint32_t encoded_size(uint32_t index) const;
+
+    void swap(CallbackBatch& other){
+        entries.swap(other.entries);
+        pool.swap(other.pool);
+    }
+
+private:
+    struct Entry{
+        int32_t what;
+        int32_t id;
+        int32_t arg;
+        double sl;
+        double energy;
+        uint32_t offset[CALLBACK_EVENT_STRINGS];
+        uint32_t length[CALLBACK_EVENT_STRINGS];
+    };
+
+    std::vector<Entry> entries;
+    std::string pool;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include <chrono>
+
+#include "CallbackDispatcher.h"
+
+void CallbackDispatcher::coalesce(int32_t what, int32_t arg){
+    std::lock_guard<std::mutex> lock(mutex);
+    coalesce_types.push_back(std::make_pair(what, arg));
+}
+
+bool CallbackDispatcher::coalescable(const CallbackEvent& event) const {
+    for(size_t i = 0; i < coalesce_types.size(); i++){
+        if(coalesce_types[i].first == event.what && coalesce_types[i].second == event.arg) return true;
+    }
+    return false;
+}
+
+void CallbackDispatcher::push(const CallbackEvent& event){
+    std::lock_guard<std::mutex> lock(mutex);
+    stat.pushed++;
+    if(coalescable(event) && pending.replace_last(event)){
+        stat.coalesced++;
+        return;
+    }
+    pending.push(event);
+    if(pending.size() > stat.max_depth) stat.max_depth = pending.size();
+    cond.notify_one();
+}
+
+void CallbackDispatcher::run(const Handler& handler){
+    CallbackBatch working;
+    std::unique_lock<std::mutex> lk(mutex, std::defer_lock);
+    while(true){
+        lk.lock();
+        cond.wait(lk, [this]{return stopped || !pending.empty();});
+        if(stopped) break;
+        working.swap(pending);
+        lk.unlock();
+
+        auto begin = std::chrono::steady_clock::now();
+        handler(working);
+        uint32_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - begin).count();
+
+        lk.lock();
+        stat.delivered += working.size();
+        stat.batches++;
+        stat.callback_total_us += us;
+        stat.callback_last_us = us;
+        if(us > stat.callback_max_us) stat.callback_max_us = us;
+        lk.unlock();
+        working.clear();
+    }
+}
+
+void CallbackDispatcher::stop(){
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+    cond.notify_all();
+}
+
+void CallbackDispatcher::get_stat(CallbackDispatcherStat& stat){
+    std::lock_guard<std::mutex> lock(mutex);
+    stat = this->stat;
+    stat.depth = pending.size();
+}
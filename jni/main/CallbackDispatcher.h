@@ -0,0 +1,60 @@
+#ifndef CALLBACK_DISPATCHER_H
+#define CALLBACK_DISPATCHER_H
+
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include "CallbackBatch.h"
+
+struct CallbackDispatcherStat{
+    // events pushed, include coalesced
+    uint64_t pushed;
+    // events merged to previous pending event
+    uint64_t coalesced;
+    uint64_t delivered;
+    // handler invocations
+    uint64_t batches;
+    // events pending now, max ever
+    uint32_t depth;
+    uint32_t max_depth;
+    // handler time, microseconds
+    uint64_t callback_total_us;
+    uint32_t callback_max_us;
+    uint32_t callback_last_us;
+};
+
+// Queue of java callbacks. producers only lock to append event,
+// pending events are swapped out and handled without lock,
+// so slow java callback not block siren event and speech threads.
+class CallbackDispatcher{
+public:
+    typedef std::function<void(const CallbackBatch&)> Handler;
+
+    // events of same 'what' and 'arg' pushed back to back
+    // are merged, only the latest sl/energy kept
+    void coalesce(int32_t what, int32_t arg);
+
+    void push(const CallbackEvent& event);
+
+    // handle events on caller thread until stop
+    void run(const Handler& handler);
+
+    void stop();
+
+    void get_stat(CallbackDispatcherStat& stat);
+
+private:
+    bool coalescable(const CallbackEvent& event) const;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    CallbackBatch pending;
+    std::vector<std::pair<int32_t, int32_t> > coalesce_types;
+    CallbackDispatcherStat stat = CallbackDispatcherStat();
+    bool stopped = false;
+};
+
+#endif
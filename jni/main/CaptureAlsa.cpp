@@ -0,0 +1,77 @@
+#include "CaptureBackend.h"
+#include "mic_array.h"
+#include "log.h"
+
+// mic array card, format is fixed by the board so only checked
+class CaptureAlsa : public CaptureBackend{
+public:
+    ~CaptureAlsa(){close();}
+
+    const char* name() const {return "alsa";}
+
+    bool open(const CaptureFormat& format){
+        close();
+        if(mic_array_device_open(&device) != 0){
+            ALOGE("open mic_array failed");
+            device = nullptr;
+            return false;
+        }
+        if(device->channels != format.channels || device->sample_rate != format.rate
+                || device->bit != format.sample_bytes * 8){
+            ALOGE("mic_array %u ch %u hz %u bit, siren wants %u ch %u hz %u bit",
+                    device->channels, device->sample_rate, device->bit,
+                    format.channels, format.rate, format.sample_bytes * 8);
+            close();
+            return false;
+        }
+        uint32_t read_bytes = format.read_bytes;
+        if(device->config_stream(device, MIC_ARRAY_CMD_SET_FRAME_SIZE, (char*)&read_bytes) != 0){
+            ALOGE("mic_array not support read of %u bytes", read_bytes);
+            close();
+            return false;
+        }
+        this->format = format;
+        return true;
+    }
+
+    void close(){
+        if(device != nullptr){
+            device->finish_stream(device);
+            device = nullptr;
+        }
+        started = false;
+    }
+
+    int start(){
+        if(device == nullptr) return -1;
+        if(started) return 0;
+        if(device->start_stream(device) != 0) return -1;
+        started = true;
+        return 0;
+    }
+
+    void stop(){
+        if(device != nullptr && started) device->stop_stream(device);
+        started = false;
+    }
+
+    int read(char* buff, uint32_t length){
+        return device->read_stream(device, buff, length);
+    }
+
+    int acquire(char** buff, uint32_t length){
+        return device->acquire_stream(device, buff, length);
+    }
+
+    void release(uint32_t length){
+        device->release_stream(device, length);
+    }
+
+private:
+    struct mic_array_device_t* device = nullptr;
+    bool started = false;
+};
+
+CaptureBackend* create_alsa_capture(const CaptureOptions& /*options*/){
+    return new CaptureAlsa();
+}
@@ -0,0 +1,95 @@
+#include <stdlib.h>
+#include <errno.h>
+
+#include "CaptureBackend.h"
+
+std::string CaptureOptions::get(const std::string& key, const std::string& def) const {
+    std::map<std::string, std::string>::const_iterator it = values.find(key);
+    return it == values.end() ? def : it->second;
+}
+
+double CaptureOptions::get(const std::string& key, double def) const {
+    std::map<std::string, std::string>::const_iterator it = values.find(key);
+    if(it == values.end() || it->second.empty()) return def;
+    char* end = nullptr;
+    double value = strtod(it->second.c_str(), &end);
+    return *end == '\0' ? value : def;
+}
+
+int CaptureBackend::acquire(char** buff, uint32_t length){
+    if(acquired.size() < length) acquired.resize(length);
+    *buff = acquired.data();
+    return read(*buff, length);
+}
+
+void CapturePacer::start(uint32_t rate){
+    this->rate = rate;
+    frames = 0;
+    clock_gettime(CLOCK_MONOTONIC, &origin);
+}
+
+void CapturePacer::wait(uint32_t frames){
+    if(rate == 0) return;
+    this->frames += frames;
+    uint64_t ns = this->frames * 1000000000ULL / rate;
+    struct timespec deadline;
+    deadline.tv_sec = origin.tv_sec + ns / 1000000000ULL;
+    deadline.tv_nsec = origin.tv_nsec + ns % 1000000000ULL;
+    if(deadline.tv_nsec >= 1000000000L){
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR);
+}
+
+std::map<std::string, CaptureRegistry::Factory>& CaptureRegistry::factories(){
+    static std::map<std::string, Factory> builtin = {
+        {"alsa", create_alsa_capture},
+        {"file", create_file_capture},
+        {"synth", create_synth_capture},
+        {"aggregate", create_aggregate_capture}
+    };
+    return builtin;
+}
+
+void CaptureRegistry::add(const std::string& name, const Factory& factory){
+    factories()[name] = factory;
+}
+
+std::vector<std::string> CaptureRegistry::names(){
+    std::vector<std::string> result;
+    for(auto& it : factories()) result.push_back(it.first);
+    return result;
+}
+
+void CaptureRegistry::parse(const std::string& spec, std::string& name, CaptureOptions& options){
+    size_t colon = spec.find(':');
+    name = spec.substr(0, colon);
+    options.values.clear();
+    options.raw.clear();
+    if(colon == std::string::npos) return;
+
+    options.raw = spec.substr(colon + 1);
+    size_t begin = 0;
+    while(begin < options.raw.length()){
+        size_t end = options.raw.find(',', begin);
+        if(end == std::string::npos) end = options.raw.length();
+        std::string item = options.raw.substr(begin, end - begin);
+        size_t equal = item.find('=');
+        if(equal == std::string::npos){
+            options.values[item] = "";
+        }else{
+            options.values[item.substr(0, equal)] = item.substr(equal + 1);
+        }
+        begin = end + 1;
+    }
+}
+
+CaptureBackend* CaptureRegistry::create(const std::string& spec){
+    std::string name;
+    CaptureOptions options;
+    parse(spec, name, options);
+    std::map<std::string, Factory>::iterator it = factories().find(name);
+    if(it == factories().end()) return nullptr;
+    return it->second(options);
+}
@@ -0,0 +1,114 @@
+#ifndef CAPTURE_BACKEND_H
+#define CAPTURE_BACKEND_H
+
+#include <stdint.h>
+#include <time.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <functional>
+
+// interleaved pcm as siren reads it, negotiated from siren config
+struct CaptureFormat{
+    uint32_t channels;
+    uint32_t rate;
+    // bytes per sample of one channel, 2, 3 or 4, signed little endian
+    uint32_t sample_bytes;
+    // bytes of one read
+    uint32_t read_bytes;
+
+    inline uint32_t frame_bytes() const {return channels * sample_bytes;}
+    inline uint32_t read_frames() const {return read_bytes / frame_bytes();}
+};
+
+// 'key=value' options of a capture spec
+class CaptureOptions{
+public:
+    std::string get(const std::string& key, const std::string& def = "") const;
+    double get(const std::string& key, double def) const;
+    bool has(const std::string& key) const {return values.find(key) != values.end();}
+
+    std::map<std::string, std::string> values;
+    // text after 'name:' as is, for aggregate
+    std::string raw;
+};
+
+// Source of siren input. open negotiates format, false if the source
+// can not give it. read and acquire always return whole read_bytes
+// of format, 0 on success as siren_input_if_t.
+class CaptureBackend{
+public:
+    virtual ~CaptureBackend(){}
+
+    virtual const char* name() const = 0;
+
+    virtual bool open(const CaptureFormat& format) = 0;
+
+    virtual void close(){}
+
+    virtual int start() = 0;
+
+    virtual void stop() = 0;
+
+    virtual int read(char* buff, uint32_t length) = 0;
+
+    // buff valid until release, default reads to own buffer
+    virtual int acquire(char** buff, uint32_t length);
+
+    virtual void release(uint32_t /*length*/){}
+
+    const CaptureFormat& get_format() const {return format;}
+
+protected:
+    CaptureFormat format = CaptureFormat();
+
+private:
+    std::vector<char> acquired;
+};
+
+// Hold back reads of generated sources to wall clock at exact rate,
+// deadlines count from start so rounding never drifts.
+class CapturePacer{
+public:
+    void start(uint32_t rate);
+
+    // sleep until 'frames' more frames would have been captured
+    void wait(uint32_t frames);
+
+private:
+    uint32_t rate = 0;
+    uint64_t frames = 0;
+    struct timespec origin;
+};
+
+// Capture backends by name. spec is 'name' or 'name:key=value,...':
+//   alsa                        mic array card through tinyalsa
+//   file:path=x.pcm,loop=1      raw interleaved pcm in siren format
+//   synth:tone=1000,noise=0.01,impulse=500
+//                               tone hz, noise amplitude, impulse every ms
+//   aggregate:alsa;synth:channels=2
+//                               sources side by side, channels of each
+// file and synth pace at format rate unless realtime=0.
+class CaptureRegistry{
+public:
+    typedef std::function<CaptureBackend*(const CaptureOptions&)> Factory;
+
+    static void add(const std::string& name, const Factory& factory);
+
+    // nullptr if name unknown
+    static CaptureBackend* create(const std::string& spec);
+
+    static void parse(const std::string& spec, std::string& name, CaptureOptions& options);
+
+    static std::vector<std::string> names();
+
+private:
+    static std::map<std::string, Factory>& factories();
+};
+
+CaptureBackend* create_alsa_capture(const CaptureOptions& options);
+CaptureBackend* create_file_capture(const CaptureOptions& options);
+CaptureBackend* create_synth_capture(const CaptureOptions& options);
+CaptureBackend* create_aggregate_capture(const CaptureOptions& options);
+
+#endif
@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <memory>
+
+#include "CaptureBackend.h"
+#include "log.h"
+
+static void write_sample(char* to, int32_t value, uint32_t bytes){
+    // little endian, top bytes of 32 bit value
+    uint32_t u = (uint32_t)value;
+    for(uint32_t i = 0; i < bytes; i++) to[i] = (char)(u >> (8 * (4 - bytes + i)));
+}
+
+// raw interleaved pcm of siren format, looped by default
+class CaptureFile : public CaptureBackend{
+public:
+    CaptureFile(const CaptureOptions& options) :
+        path(options.get("path")),
+        loop(options.get("loop", 1.0) != 0),
+        realtime(options.get("realtime", 1.0) != 0){
+    }
+
+    ~CaptureFile(){close();}
+
+    const char* name() const {return "file";}
+
+    bool open(const CaptureFormat& format){
+        close();
+        fp = fopen(path.c_str(), "rb");
+        if(fp == nullptr){
+            ALOGE("capture file %s open failed", path.c_str());
+            return false;
+        }
+        fseek(fp, 0, SEEK_END);
+        long size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        // trailing partial frame never read
+        usable = size > 0 ? size - size % format.frame_bytes() : 0;
+        if(usable == 0){
+            ALOGE("capture file %s has no whole frame", path.c_str());
+            close();
+            return false;
+        }
+        position = 0;
+        this->format = format;
+        return true;
+    }
+
+    void close(){
+        if(fp != nullptr) fclose(fp);
+        fp = nullptr;
+    }
+
+    int start(){
+        if(fp == nullptr) return -1;
+        if(realtime) pacer.start(format.rate);
+        return 0;
+    }
+
+    void stop(){}
+
+    int read(char* buff, uint32_t length){
+        if(fp == nullptr) return -1;
+        if(realtime) pacer.wait(length / format.frame_bytes());
+        while(length > 0){
+            if(position == usable){
+                if(!loop) return -1;
+                fseek(fp, 0, SEEK_SET);
+                position = 0;
+            }
+            size_t n = length;
+            if(n > usable - position) n = usable - position;
+            if(fread(buff, 1, n, fp) != n) return -1;
+            buff += n;
+            length -= n;
+            position += n;
+        }
+        return 0;
+    }
+
+private:
+    std::string path;
+    bool loop;
+    bool realtime;
+    FILE* fp = nullptr;
+    size_t usable = 0;
+    size_t position = 0;
+    CapturePacer pacer;
+};
+
+// tone, white noise and impulses, same on every channel but noise
+class CaptureSynth : public CaptureBackend{
+public:
+    CaptureSynth(const CaptureOptions& options) :
+        tone(options.get("tone", 0.0)),
+        amplitude(options.get("amp", 0.5)),
+        noise(options.get("noise", 0.0)),
+        impulse_ms(options.get("impulse", 0.0)),
+        realtime(options.get("realtime", 1.0) != 0),
+        seed((uint32_t)options.get("seed", 1.0)){
+    }
+
+    const char* name() const {return "synth";}
+
+    bool open(const CaptureFormat& format){
+        if(format.sample_bytes < 2 || format.sample_bytes > 4){
+            ALOGE("synth not support %u bytes sample", format.sample_bytes);
+            return false;
+        }
+        this->format = format;
+        impulse_period = (uint64_t)llround(impulse_ms * format.rate / 1000);
+        return true;
+    }
+
+    int start(){
+        sample = 0;
+        random = seed ? seed : 1;
+        if(realtime) pacer.start(format.rate);
+        return 0;
+    }
+
+    void stop(){}
+
+    int read(char* buff, uint32_t length){
+        uint32_t frames = length / format.frame_bytes();
+        if(realtime) pacer.wait(frames);
+        for(uint32_t i = 0; i < frames; i++, sample++){
+            double value = 0;
+            if(tone > 0){
+                // phase from sample index, exact however long it runs
+                value += amplitude * sin(2 * M_PI * fmod(tone * sample, format.rate) / format.rate);
+            }
+            if(impulse_period > 0 && sample % impulse_period == 0) value += 1.0;
+            for(uint32_t c = 0; c < format.channels; c++){
+                double v = value;
+                if(noise > 0) v += noise * next_random();
+                if(v > 1.0) v = 1.0;
+                if(v < -1.0) v = -1.0;
+                write_sample(buff, (int32_t)(v * 2147483647.0), format.sample_bytes);
+                buff += format.sample_bytes;
+            }
+        }
+        return 0;
+    }
+
+private:
+    // xorshift, uniform in [-1, 1)
+    double next_random(){
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        return (double)(int32_t)random / 2147483648.0;
+    }
+
+    double tone;
+    double amplitude;
+    double noise;
+    double impulse_ms;
+    bool realtime;
+    uint32_t seed;
+    uint32_t random = 1;
+    uint64_t impulse_period = 0;
+    uint64_t sample = 0;
+    CapturePacer pacer;
+};
+
+// sources side by side in channel order, 'channels' option of each
+// source, one source may leave it out to take the rest
+class CaptureAggregate : public CaptureBackend{
+public:
+    CaptureAggregate(const CaptureOptions& options) : spec(options.raw){
+    }
+
+    const char* name() const {return "aggregate";}
+
+    bool open(const CaptureFormat& format){
+        sources.clear();
+        std::vector<uint32_t> channels;
+        uint32_t assigned = 0;
+        int32_t rest = -1;
+        size_t begin = 0;
+        while(begin < spec.length()){
+            size_t end = spec.find(';', begin);
+            if(end == std::string::npos) end = spec.length();
+            std::string child = spec.substr(begin, end - begin);
+            begin = end + 1;
+
+            std::string name;
+            CaptureOptions options;
+            CaptureRegistry::parse(child, name, options);
+            CaptureBackend* source = CaptureRegistry::create(child);
+            if(source == nullptr){
+                ALOGE("aggregate unknown source %s", child.c_str());
+                return false;
+            }
+            sources.push_back(Source(source));
+            uint32_t n = (uint32_t)options.get("channels", 0.0);
+            if(n == 0){
+                if(rest >= 0){
+                    ALOGE("aggregate only one source can leave out channels");
+                    return false;
+                }
+                rest = channels.size();
+            }
+            channels.push_back(n);
+            assigned += n;
+        }
+        if(sources.empty() || assigned > format.channels
+                || (rest < 0 && assigned != format.channels)
+                || (rest >= 0 && assigned == format.channels)){
+            ALOGE("aggregate channels %u of sources not match %u", assigned, format.channels);
+            return false;
+        }
+        if(rest >= 0) channels[rest] = format.channels - assigned;
+
+        for(size_t i = 0; i < sources.size(); i++){
+            CaptureFormat sub = format;
+            sub.channels = channels[i];
+            sub.read_bytes = format.read_frames() * sub.frame_bytes();
+            if(!sources[i]->open(sub)){
+                ALOGE("aggregate source %s not open with %u channels", sources[i]->name(), sub.channels);
+                sources.clear();
+                return false;
+            }
+        }
+        this->format = format;
+        return true;
+    }
+
+    void close(){
+        for(size_t i = 0; i < sources.size(); i++) sources[i]->close();
+    }
+
+    int start(){
+        for(size_t i = 0; i < sources.size(); i++){
+            if(sources[i]->start() != 0){
+                while(i-- > 0) sources[i]->stop();
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    void stop(){
+        for(size_t i = 0; i < sources.size(); i++) sources[i]->stop();
+    }
+
+    int read(char* buff, uint32_t length){
+        uint32_t frames = length / format.frame_bytes();
+        uint32_t offset = 0;
+        for(size_t i = 0; i < sources.size(); i++){
+            const CaptureFormat& sub = sources[i]->get_format();
+            uint32_t sub_frame = sub.frame_bytes();
+            char* from = nullptr;
+            if(sources[i]->acquire(&from, frames * sub_frame) != 0) return -1;
+            char* to = buff + offset;
+            for(uint32_t f = 0; f < frames; f++){
+                memcpy(to, from, sub_frame);
+                from += sub_frame;
+                to += format.frame_bytes();
+            }
+            sources[i]->release(frames * sub_frame);
+            offset += sub_frame;
+        }
+        return 0;
+    }
+
+private:
+    typedef std::unique_ptr<CaptureBackend> Source;
+
+    std::string spec;
+    std::vector<Source> sources;
+};
+
+CaptureBackend* create_file_capture(const CaptureOptions& options){
+    return new CaptureFile(options);
+}
+
+CaptureBackend* create_synth_capture(const CaptureOptions& options){
+    return new CaptureSynth(options);
+}
+
+CaptureBackend* create_aggregate_capture(const CaptureOptions& options){
+    return new CaptureAggregate(options);
+}
@@ -0,0 +1,146 @@
+#include <string.h>
+
+#include "json.h"
+#include "JsonFields.h"
+
+// same as json-c default depth
+#define MAX_DEPTH 32
+
+static inline const char* skip_space(const char* p, const char* end){
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    return p;
+}
+
+// p at opening quote, return past closing quote
+static const char* skip_string(const char* p, const char* end, bool& escaped){
+    escaped = false;
+    for(p++; p < end; p++){
+        if(*p == '"') return p + 1;
+        if(*p == '\\'){
+            escaped = true;
+            p++;
+        }
+    }
+    return nullptr;
+}
+
+// p at first char of value, return past the value
+static const char* skip_value(const char* p, const char* end){
+    bool escaped;
+    if(p >= end) return nullptr;
+    if(*p == '"') return skip_string(p, end, escaped);
+    if(*p == '{' || *p == '['){
+        // bit set for object, to match closing bracket
+        uint32_t stack = 0;
+        uint32_t depth = 0;
+        while(p < end){
+            switch(*p){
+            case '"':
+                p = skip_string(p, end, escaped);
+                if(p == nullptr) return nullptr;
+                continue;
+            case '{':
+            case '[':
+                if(depth == MAX_DEPTH) return nullptr;
+                stack = (stack << 1) | (*p == '{');
+                depth++;
+                break;
+            case '}':
+            case ']':
+                if((stack & 1) != (*p == '}')) return nullptr;
+                stack >>= 1;
+                if(--depth == 0) return p + 1;
+                break;
+            }
+            p++;
+        }
+        return nullptr;
+    }
+    // number, true, false, null
+    const char* begin = p;
+    while(p < end && *p != ',' && *p != '}' && *p != ']'
+          && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') p++;
+    return p == begin ? nullptr : p;
+}
+
+JsonFields::JsonFields(std::initializer_list<const char*> keys)
+    : values(keys.size()), found(keys.size()), strings(keys.size()){
+    for(const char* key : keys) this->keys.push_back(key);
+    tokener = json_tokener_new();
+}
+
+JsonFields::~JsonFields(){
+    json_tokener_free(tokener);
+}
+
+int32_t JsonFields::key_index(const char* key, uint32_t length) const {
+    for(uint32_t i = 0; i < keys.size(); i++){
+        if(keys[i].length() == length && memcmp(keys[i].data(), key, length) == 0) return i;
+    }
+    return -1;
+}
+
+bool JsonFields::set_string(uint32_t index, const char* begin, const char* end, bool escaped){
+    if(!escaped){
+        values[index].assign(begin + 1, end - begin - 2);
+        return true;
+    }
+    json_tokener_reset(tokener);
+    json_object* obj = json_tokener_parse_ex(tokener, begin, end - begin);
+    if(obj == nullptr) return false;
+    values[index].assign(json_object_get_string(obj), json_object_get_string_len(obj));
+    json_object_put(obj);
+    return true;
+}
+
+// stop at the first occurrence of each key, rest of document
+// not checked once all keys are found
+bool JsonFields::parse(const char* json, uint32_t length){
+    const char* p = json;
+    const char* end = json + length;
+    uint32_t remain = keys.size();
+    bool escaped;
+
+    for(uint32_t i = 0; i < keys.size(); i++){
+        values[i].clear();
+        found[i] = false;
+        strings[i] = false;
+    }
+
+    p = skip_space(p, end);
+    if(p == end || *p != '{') return false;
+    p = skip_space(p + 1, end);
+    if(p < end && *p == '}') return true;
+    while(p < end){
+        if(*p != '"') return false;
+        const char* key_end = skip_string(p, end, escaped);
+        if(key_end == nullptr) return false;
+        int32_t index = key_index(p + 1, key_end - p - 2);
+
+        p = skip_space(key_end, end);
+        if(p == end || *p != ':') return false;
+        p = skip_space(p + 1, end);
+        const char* value = p;
+        if(p < end && *p == '"') p = skip_string(p, end, escaped);
+        else p = skip_value(p, end);
+        if(p == nullptr) return false;
+
+        if(index >= 0 && !found[index]){
+            if(*value == '"'){
+                if(!set_string(index, value, p, escaped)) return false;
+                strings[index] = true;
+            }else{
+                values[index].assign(value, p - value);
+            }
+            found[index] = true;
+            if(--remain == 0) return true;
+        }
+
+        p = skip_space(p, end);
+        if(p == end) return false;
+        if(*p == '}') return true;
+        if(*p != ',') return false;
+        p = skip_space(p + 1, end);
+    }
+    return false;
+}
@@ -0,0 +1,43 @@
+#ifndef JSON_FIELDS_H
+#define JSON_FIELDS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <initializer_list>
+
+struct json_tokener;
+
+// Pull selected top level fields of a json object in one scan,
+// other values are skipped without building json objects.
+// string value is unescaped, others kept as json text.
+class JsonFields{
+public:
+    JsonFields(std::initializer_list<const char*> keys);
+    ~JsonFields();
+
+    // false if not a json object, fields found before error kept
+    bool parse(const char* json, uint32_t length);
+
+    inline bool parse(const std::string& json){return parse(json.data(), json.length());}
+
+    // index of key given in constructor
+    inline bool has(uint32_t index) const {return found[index];}
+
+    inline const std::string& get(uint32_t index) const {return values[index];}
+
+    inline bool is_string(uint32_t index) const {return strings[index];}
+
+private:
+    int32_t key_index(const char* key, uint32_t length) const;
+    bool set_string(uint32_t index, const char* begin, const char* end, bool escaped);
+
+    std::vector<std::string> keys;
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    std::vector<bool> strings;
+    // for escaped strings only
+    json_tokener* tokener;
+};
+
+#endif
@@ -5,24 +5,19 @@
 #include <mutex>
 #include <functional>
 
+#include "CallbackBatch.h"
+
 using std::string;
 
 class VoiceCallback{
 private:
-    enum{
-        MSG_VOICE_EVENT_ID = 0,
-        MSG_INTERMEDIATE_RESULT_ID,
-        MSG_VOICE_COMMAND_ID,
-        MSG_SPEECH_ERROR_ID,
-    };
-    
-    std::function<void(int32_t what, const std::string&)> send;
+    std::function<void(const CallbackEvent&)> send;
     
     std::mutex g_i_mutex;
     
-    void send_message(int32_t what, const std::string& data){
+    void send_message(const CallbackEvent& event){
         //        std::lock_guard<std::mutex> lock(g_i_mutex);
-        if(send) send(what, data);
+        if(send) send(event);
     }
     
 public:
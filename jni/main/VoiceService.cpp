@@ -3,6 +3,7 @@
 
 #include "VoiceService.h"
 #include "siren_control.h"
+#include "JsonFields.h"
 
 #ifdef USB_AUDIO_DEVICE
 #warning "=============================USB_AUDIO_DEVICE==============================="
@@ -168,23 +169,10 @@ int32_t VoiceService::get_vt_word(vector<siren_vt_word>& _vt_words_in){
 }
 
 void VoiceService::voice_event_callback(voice_event_t *voice_event) {
+    // keep siren's buffer, audio is read by put_voice without copy
+    siren_event_ref(voice_event);
     std::lock_guard<std::mutex> lg(event_mutex);
-    int32_t len =  0;
-    char *buff = nullptr;
-    if(voice_event->length > 0){
-        len = voice_event->length;
-    }
-    char *temp = new char[sizeof(voice_event_t) + len];
-    if(len) buff = temp + sizeof(voice_event_t);
-    
-    voice_event_t *_event_t = (voice_event_t*)temp;
-    memcpy(_event_t, voice_event, sizeof(voice_event_t));
-    
-    if ((HAS_VOICE(_event_t->flag) || HAS_VT(_event_t->flag)) && len) {
-        memcpy(buff, voice_event->buff, len);
-        _event_t->buff = buff;
-    }
-    _events.push_back(_event_t);
+    _events.push_back(voice_event);
     event_cond.notify_one();
 }
 
@@ -241,7 +229,7 @@ void VoiceService::onEvent() {
                 _callback->voice_event(session_id, VoiceEvent::VOICE_LOCAL_SLEEP);
                 break;
         }
-        delete[] (char *)_event;
+        siren_event_unref(_event);
     }
     _speech->release();
     _speech.reset();
@@ -252,7 +240,7 @@ void VoiceService::onResponse() {
     auto arbitration = [](const string& activation)->bool {return ("fake" == activation || "reject" == activation);};
     SpeechResult sr;
     string activation, asr;
-    json_object *nlp_obj, *activation_obj;
+    JsonFields extra({"activation"});
     while (true) {
         if (!_speech->poll(sr)) {
             break;
@@ -263,10 +251,9 @@ void VoiceService::onResponse() {
             local_sleep = false;
             activation.clear();
         } else if((sr.type == SPEECH_RES_INTER || sr.type == SPEECH_RES_END) && !sr.extra.empty()) {
-            nlp_obj = json_tokener_parse(sr.extra.c_str());
-            if(TRUE == json_object_object_get_ex(nlp_obj, "activation", &activation_obj)){
-                activation = json_object_get_string(activation_obj);
-                json_object_put(nlp_obj);
+            extra.parse(sr.extra);
+            if(extra.has(0)){
+                activation = extra.get(0);
                 ALOGV("result : activ \t %s", activation.c_str());
                 _callback->voice_event(sr.id, transform_string_to_event(activation));
                 if(arbitration(activation)) {
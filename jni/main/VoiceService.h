@@ -8,7 +8,7 @@
 #include <thread>
 #include <condition_variable>
 #include <stdlib.h>
-#include <list>
+#include <deque>
 #include <vector>
 #include <functional>
 
@@ -89,7 +89,7 @@ private:
     shared_ptr<Speech> _speech;
     shared_ptr<VoiceCallback> _callback;
     shared_ptr<VoiceConfig> _voice_config;
-    list<voice_event_t*> _events;
+    deque<voice_event_t*> _events;
     std::function<std::string()> get_skill_options;
     
     string appid;
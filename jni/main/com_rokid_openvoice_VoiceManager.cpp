@@ -5,8 +5,8 @@
 #include <list>
 #include <atomic>
 
-#include "json.h"
 #include "VoiceService.h"
+#include "CallbackDispatcher.h"
 
 shared_ptr<VoiceService> voice_service = make_shared<VoiceService>();
 
@@ -41,6 +41,9 @@ extern "C" {
     Java_com_rokid_openvoice_VoiceManager_getVtWords(JNIEnv *env, jclass);
 }
 
+// initial size of direct buffer shared with java
+#define BATCH_BUFFER_SIZE (16 * 1024)
+
 class Handle{
 public:
     Handle(JNIEnv *env){
@@ -49,14 +52,9 @@ public:
             ALOGI("find class error");
             return;
         }
-        callback_method_table[MSG_VOICE_EVENT_ID]
-        = env->GetMethodID(callback, "onVoiceEvent", "(IIDD)V");
-        callback_method_table[MSG_INTERMEDIATE_RESULT_ID]
-        = env->GetMethodID(callback, "onIntermediateResult", "(IILjava/lang/String;)V");
-        callback_method_table[MSG_VOICE_COMMAND_ID]
-        = env->GetMethodID(callback, "onVoiceCommand", "(ILjava/lang/String;Ljava/lang/String;Ljava/lang/String;)V");
-        callback_method_table[MSG_SPEECH_ERROR_ID]
-        = env->GetMethodID(callback, "onSpeechError", "(II)V");
+        on_events = env->GetMethodID(callback, "onEvents", "(Ljava/nio/ByteBuffer;I)V");
+        // only latest energy of VOICE_DATA is useful to java
+        dispatcher.coalesce(MSG_VOICE_EVENT_ID, VoiceEvent::VOICE_DATA);
     }
     
     void start(jobject jobj){
@@ -64,122 +62,66 @@ public:
         std::call_once(start_flag, [this]{m_thread = std::thread(&Handle::thread_loop, this);});
     }
     
-    class Message{
-    public:
-        Message(){}
-        Message(int32_t what, const string& data){
-            this->what = what;
-            this->data = data;
-        }
-        int32_t what;
-        string data;
-    };
-    
-    enum{
-        MSG_VOICE_EVENT_ID = 0,
-        MSG_INTERMEDIATE_RESULT_ID,
-        MSG_VOICE_COMMAND_ID,
-        MSG_SPEECH_ERROR_ID,
-    };
+    void send_message(const CallbackEvent& event){
+        dispatcher.push(event);
+    }
     
-    void send_message(const Message& msg){
-        std::lock_guard<std::mutex> lock(m_mutex);
-        message_queue.push_back(msg);
-        m_cond.notify_one();
+    void get_stat(CallbackDispatcherStat& stat){
+        dispatcher.get_stat(stat);
     }
     
 private:
     void thread_loop(){
         _vm->AttachCurrentThread(&_env, NULL);
-        std::unique_lock<std::mutex> lk(m_mutex, std::defer_lock);
-        while(true){
-            lk.lock();
-            m_cond.wait(lk, [this]{return !message_queue.empty();});
-            _env->PushLocalFrame(64);
-            handle_message(message_queue.front());
-            _env->PopLocalFrame(NULL);
-            message_queue.pop_front();
-            lk.unlock();
-        }
+        dispatcher.run([this](const CallbackBatch& batch){handle_batch(batch);});
         _vm->DetachCurrentThread();
     }
     
-    void handle_message(Handle::Message& msg){
-        json_object *json_obj = json_tokener_parse(msg.data.c_str());
-        switch(msg.what){
-            case MSG_VOICE_EVENT_ID:{
-                json_object *id_obj, *event_obj, *sl_obj, *energy_obj;
-                int32_t id, event;
-                double sl, energy;
-                if(TRUE == json_object_object_get_ex(json_obj, "id", &id_obj))
-                    id = json_object_get_int(id_obj);
-                if(TRUE == json_object_object_get_ex(json_obj, "event", &event_obj))
-                    event = json_object_get_int(event_obj);
-                if(TRUE == json_object_object_get_ex(json_obj, "sl", &sl_obj))
-                    sl = json_object_get_double(sl_obj);
-                if(TRUE == json_object_object_get_ex(json_obj, "energy", &energy_obj))
-                    energy = json_object_get_double(energy_obj);
-                _env->CallVoidMethod(jobj, callback_method_table[msg.what], id, event, sl, energy);
-            }
-                break;
-            case MSG_INTERMEDIATE_RESULT_ID:{
-                jstring jasr = 0;
-                json_object *id_obj, *type_obj, *asr_obj;
-                int32_t id, type;
-                std::string asr;
-                if(TRUE == json_object_object_get_ex(json_obj, "id", &id_obj))
-                    id = json_object_get_int(id_obj);
-                if(TRUE == json_object_object_get_ex(json_obj, "type", &type_obj))
-                    type = json_object_get_int(type_obj);
-                if(TRUE == json_object_object_get_ex(json_obj, "asr", &asr_obj))
-                    asr = json_object_get_string(asr_obj);
-                if(asr.length() > 0) jasr = _env->NewStringUTF(asr.c_str());
-                _env->CallVoidMethod(jobj, callback_method_table[msg.what], id, type, jasr);
-            }
-                break;
-            case MSG_VOICE_COMMAND_ID:{
-                jstring jasr = 0, jnlp = 0, jaction = 0;
-                int32_t id;
-                json_object *id_obj, *asr_obj, *nlp_obj, *action_obj;
-                std::string asr, nlp, action;
-                if(TRUE == json_object_object_get_ex(json_obj, "id", &id_obj))
-                    id = json_object_get_int(id_obj);
-                if(TRUE == json_object_object_get_ex(json_obj, "asr", &asr_obj))
-                    asr = json_object_get_string(asr_obj);
-                if(TRUE == json_object_object_get_ex(json_obj, "nlp", &nlp_obj))
-                    nlp = json_object_get_string(nlp_obj);
-                if(TRUE == json_object_object_get_ex(json_obj, "action", &action_obj))
-                    action = json_object_get_string(action_obj);
-                if(asr.length() > 0) jasr = _env->NewStringUTF(asr.c_str());
-                if(nlp.length() > 0) jnlp = _env->NewStringUTF(nlp.c_str());
-                if(action.length() > 0) jaction = _env->NewStringUTF(action.c_str());
-                _env->CallVoidMethod(jobj, callback_method_table[msg.what], id, jasr, jnlp, jaction);
-            }
-                break;
-            case MSG_SPEECH_ERROR_ID:{
-                json_object *id_obj, *errcode_obj;
-                int32_t id, errcode;
-                if(TRUE == json_object_object_get_ex(json_obj, "id", &id_obj))
-                    id = json_object_get_int(id_obj);
-                if(TRUE == json_object_object_get_ex(json_obj, "errcode", &errcode_obj))
-                    errcode = json_object_get_int(errcode_obj);
-                _env->CallVoidMethod(jobj, callback_method_table[msg.what], id, errcode);
+    bool ensure_buffer(uint32_t size){
+        if(size <= buffer_size && buffer_obj != NULL) return true;
+        if(buffer_obj != NULL) _env->DeleteGlobalRef(buffer_obj);
+        buffer_obj = NULL;
+        delete[] buffer;
+        buffer_size = size > BATCH_BUFFER_SIZE ? size : BATCH_BUFFER_SIZE;
+        buffer = new char[buffer_size];
+        jobject local = _env->NewDirectByteBuffer(buffer, buffer_size);
+        if(local == NULL){
+            ALOGE("new direct byte buffer of %u bytes failed", buffer_size);
+            _env->ExceptionClear();
+            return false;
+        }
+        buffer_obj = _env->NewGlobalRef(local);
+        _env->DeleteLocalRef(local);
+        return true;
+    }
+    
+    // deliver events by as few jni calls as buffer allows
+    void handle_batch(const CallbackBatch& batch){
+        uint32_t first = 0, count, used;
+        while(first < batch.size()){
+            if(!ensure_buffer(batch.encoded_size(first))) return;
+            // buffer fits at least the first event
+            count = batch.encode(first, buffer, buffer_size, used);
+            _env->CallVoidMethod(jobj, on_events, buffer_obj, (jint)count);
+            if(_env->ExceptionCheck()){
+                _env->ExceptionDescribe();
+                _env->ExceptionClear();
             }
-                break;
+            first += count;
         }
-        json_object_put(json_obj);
     }
     
-    std::list<Message> message_queue;
+    CallbackDispatcher dispatcher;
     
     std::thread m_thread;
-    std::condition_variable m_cond;
-    std::mutex m_mutex;
     std::once_flag start_flag;
     
-    jmethodID callback_method_table[4];
+    jmethodID on_events;
     JNIEnv *_env;
     jobject jobj;
+    char *buffer = nullptr;
+    uint32_t buffer_size = 0;
+    jobject buffer_obj = NULL;
 };
 shared_ptr<Handle> handle;
 JNIEXPORT jboolean JNICALL 
@@ -280,7 +222,7 @@ Java_com_rokid_openvoice_VoiceManager_registCallback(JNIEnv *env, jclass, jobjec
     ALOGD("%s", __FUNCTION__);
     if(handle.get()) handle->start(env->NewGlobalRef(obj));
     voice_service->regist_callback(
-                        [&](int32_t method_id, const string& data){if(handle.get()) handle->send_message(Handle::Message(method_id, data));});
+                        [&](const CallbackEvent& event){if(handle.get()) handle->send_message(event);});
 }
 
 JNIEXPORT int JNICALL
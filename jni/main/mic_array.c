@@ -27,7 +27,14 @@
 
 #define MIC_SAMPLE_RATE 48000
 #define MIC_CHANNEL 8
-#define FRAME_COUNT MIC_SAMPLE_RATE / 100 * MIC_CHANNEL * 4
+#define MIC_SAMPLE_BYTES 4
+#define MIC_FRAME_BYTES (MIC_CHANNEL * MIC_SAMPLE_BYTES)
+/* default read size, 10ms as siren frame */
+#define FRAME_COUNT MIC_SAMPLE_RATE / 100 * MIC_FRAME_BYTES
+/* period is a multiple of read size close to this */
+#define PERIOD_TIME_MS 20
+#define PERIOD_COUNT 8
+#define WAIT_TIMEOUT_MS 500
 
 #define PCM_CARD 0
 #define PCM_DEVICE 0
@@ -36,15 +43,22 @@ static struct pcm_config pcm_config_default = {
     .channels = MIC_CHANNEL,
     .rate = MIC_SAMPLE_RATE,
     .period_size = 1024,
-    .period_count = 8,
+    .period_count = PERIOD_COUNT,
     .format = PCM_FORMAT_S32_LE,
 };
 
-static struct mic_array_device_ex {
+struct mic_array_device_ex {
     struct mic_array_device_t mic_array;
     
-    int pts;
+    /* opened with PCM_MMAP */
+    int mmap;
+    /* frames acquired in ring, 0 if handed out bounce buffer */
+    unsigned int acquired_offset;
+    unsigned int acquired_frames;
+    /* read size wraps around ring end */
     char* buffer;
+    unsigned int buffer_size;
+    struct mic_array_stat_t stat;
 };
 
 static int mic_array_device_close();
@@ -65,6 +79,12 @@ static int mic_array_device_resume_stream(struct mic_array_device_t* dev);
 
 static int mic_array_device_find_card (const char *snd);
 
+static int mic_array_device_acquire_stream(struct mic_array_device_t* dev, char** buff, unsigned int frame_cnt);
+
+static int mic_array_device_release_stream(struct mic_array_device_t* dev, unsigned int frame_cnt);
+
+static void set_frame_size(struct mic_array_device_ex* dev_ex, unsigned int frame_cnt);
+
 int find_snd(const char* snd)
 {
     char* path = "/proc/asound/cards";
@@ -164,7 +184,6 @@ static int mic_array_device_find_card (const char *snd){
 
 int mic_array_device_open(struct mic_array_device_t **device)
 {
-    int i = 0;
     struct mic_array_device_ex* dev_ex = NULL;
     struct mic_array_device_t* dev = NULL;
     dev_ex = (struct mic_array_device_ex*)malloc(sizeof(struct mic_array_device_ex));
@@ -184,17 +203,24 @@ int mic_array_device_open(struct mic_array_device_t **device)
     dev->config_stream = mic_array_device_config_stream;
     dev->get_stream_buff_size = mic_array_device_get_stream_buff_size;
     dev->find_card = mic_array_device_find_card;
+    dev->acquire_stream = mic_array_device_acquire_stream;
+    dev->release_stream = mic_array_device_release_stream;
     
     dev->pcm = NULL;
-    dev->frame_cnt = FRAME_COUNT;
-    dev_ex->buffer = (char*)malloc(dev->frame_cnt);
+    dev->channels = MIC_CHANNEL;
+    dev->sample_rate = MIC_SAMPLE_RATE;
+    dev->bit = MIC_SAMPLE_BYTES * 8;
+    dev->period_count = PERIOD_COUNT;
+    set_frame_size(dev_ex, FRAME_COUNT);
+    if (dev_ex->buffer == NULL) {
+        free(dev_ex);
+        return -1;
+    }
     *device = dev;
     ALOGI("alloc frame buffer size %d", dev->frame_cnt);
     return 0;
 }
 
-static void resetBuffer(struct mic_array_device_ex* dev) { dev->pts = 0; }
-
 static int mic_array_device_close(struct mic_array_device_t *mic_array_device)
 {
     ALOGI("pcm close");
@@ -210,17 +236,36 @@ static int mic_array_device_close(struct mic_array_device_t *mic_array_device)
     return 0;
 }
 
-static int mic_array_device_start_stream(struct mic_array_device_t* dev)
+/* period holds whole reads so a read never wraps around ring end */
+static void set_frame_size(struct mic_array_device_ex* dev_ex, unsigned int frame_cnt)
+{
+    struct mic_array_device_t* dev = &dev_ex->mic_array;
+    unsigned int frames = frame_cnt / MIC_FRAME_BYTES;
+    unsigned int per_period = MIC_SAMPLE_RATE / 1000 * PERIOD_TIME_MS / frames;
+    
+    if (per_period == 0)
+        per_period = 1;
+    dev->frame_cnt = frame_cnt;
+    dev->period_size = frames * per_period;
+    free(dev_ex->buffer);
+    dev_ex->buffer = (char*)malloc(frame_cnt);
+    dev_ex->buffer_size = dev_ex->buffer ? frame_cnt : 0;
+}
+
+static int open_pcm(struct mic_array_device_t* dev, int card, unsigned int flags)
 {
+    struct pcm_config config = pcm_config_default;
     struct pcm* pcm = NULL;
     
-    int card = find_snd("USB-Audio");
-    if (card < 0) {
-        card = PCM_CARD;
+    config.period_size = dev->period_size;
+    config.period_count = dev->period_count;
+    if (flags & PCM_MMAP) {
+        config.start_threshold = dev->period_size;
+        config.avail_min = dev->frame_cnt / MIC_FRAME_BYTES;
     }
-    pcm = pcm_open(card, PCM_DEVICE, PCM_IN, &pcm_config_default);
+    pcm = pcm_open(card, PCM_DEVICE, PCM_IN | flags, &config);
     if (!pcm || !pcm_is_ready(pcm)) {
-        ALOGE("Unable to open PCM device %u (%s)\n", card, pcm_get_error(pcm));
+        ALOGE("Unable to open PCM device %u flags 0x%x (%s)\n", card, flags, pcm_get_error(pcm));
         if (pcm != NULL) {
             pcm_close(pcm);
             pcm = NULL;
@@ -231,73 +276,173 @@ static int mic_array_device_start_stream(struct mic_array_device_t* dev)
     return 0;
 }
 
+static int mic_array_device_start_stream(struct mic_array_device_t* dev)
+{
+    struct mic_array_device_ex* dev_ex = (struct mic_array_device_ex*)dev;
+    
+    int card = find_snd("USB-Audio");
+    if (card < 0) {
+        card = PCM_CARD;
+    }
+    dev_ex->acquired_frames = 0;
+    dev_ex->mmap = 1;
+    if (open_pcm(dev, card, PCM_MMAP) != 0) {
+        dev_ex->mmap = 0;
+        if (open_pcm(dev, card, 0) != 0)
+            return -1;
+    }
+    if (dev_ex->mmap && pcm_start(dev->pcm) != 0) {
+        ALOGE("pcm start %s", pcm_get_error(dev->pcm));
+        mic_array_device_stop_stream(dev);
+        return -1;
+    }
+    ALOGI("pcm open %s period %u x %u, read %u bytes", dev_ex->mmap ? "mmap" : "rw",
+          dev->period_size, dev->period_count, dev->frame_cnt);
+    return 0;
+}
+
 static int mic_array_device_stop_stream(struct mic_array_device_t* dev)
 {
+    struct mic_array_device_ex* dev_ex = (struct mic_array_device_ex*)dev;
+    
     if (dev->pcm != NULL) {
         pcm_close(dev->pcm);
         dev->pcm = NULL;
     }
+    dev_ex->acquired_frames = 0;
     return 0;
 }
 
+/* stop and free device */
 static int mic_array_device_finish_stream(struct mic_array_device_t* dev)
 {
-    ALOGE("finish stream is no use");
-    return -1;
+    mic_array_device_stop_stream(dev);
+    return mic_array_device_close(dev);
 }
 
-static int read_frame(struct mic_array_device_t* dev, char* buffer)
+static int recover_xrun(struct mic_array_device_ex* dev_ex)
 {
-    return pcm_read(dev->pcm, buffer, dev->frame_cnt);
+    struct pcm* pcm = dev_ex->mic_array.pcm;
+    
+    dev_ex->stat.xruns++;
+    ALOGW("pcm overrun, restart");
+    if (pcm_prepare(pcm) != 0 || pcm_start(pcm) != 0) {
+        ALOGE("pcm restart %s", pcm_get_error(pcm));
+        return -1;
+    }
+    return 0;
 }
 
-static int read_left_frame(
-                           struct mic_array_device_ex* dev, char* buff, int left)
+/* wait until 'frames' captured */
+static int wait_avail(struct mic_array_device_ex* dev_ex, unsigned int frames)
 {
-    int ret = 0;
-    if (dev->pts == 0) {
-        if ((ret = read_frame(dev, dev->buffer)) != 0) {
-            ALOGE("read_frame %s", strerror(errno));
-            resetBuffer(dev);
-            return ret;
-        }
-        memcpy(buff, dev->buffer, left);
-        memcpy(dev->buffer, dev->buffer + left, dev->mic_array.frame_cnt - left);
-        dev->pts = dev->mic_array.frame_cnt - left;
-    } else {
-        if (dev->pts >= left) {
-            memcpy(buff, dev->buffer, left);
-            dev->pts -= left;
-            if (dev->pts != 0) {
-                memcpy(dev->buffer, dev->buffer + left, dev->pts);
-            }
-        } else {
-            memcpy(buff, dev->buffer, dev->pts);
-            left -= dev->pts;
-            if ((ret = read_frame(dev, dev->buffer)) != 0) {
-                ALOGE("read_frame %s", strerror(errno));
-                resetBuffer(dev);
-                return ret;
+    struct pcm* pcm = dev_ex->mic_array.pcm;
+    int avail, ret;
+    
+    while ((avail = pcm_mmap_avail(pcm)) < (int)frames) {
+        if (avail >= 0) {
+            ret = pcm_wait(pcm, WAIT_TIMEOUT_MS);
+            if (ret == 0) {
+                ALOGE("pcm wait timeout");
+                return -1;
             }
-            memcpy(buff + dev->pts, dev->buffer, left);
-            memcpy(dev->buffer, dev->buffer + left,dev->mic_array.frame_cnt - left);
-            dev->pts = dev->mic_array.frame_cnt - left;
+            if (ret > 0)
+                continue;
         }
+        if (recover_xrun(dev_ex) != 0)
+            return -1;
     }
     return 0;
 }
 
-static int mic_array_device_read_stream(struct mic_array_device_t* dev, char* buff, unsigned int frame_cnt)
+static int mic_array_device_acquire_stream(struct mic_array_device_t* dev, char** buff, unsigned int frame_cnt)
 {
-    struct pcm* pcm = dev->pcm;
     struct mic_array_device_ex* dev_ex = (struct mic_array_device_ex*)dev;
-    char* target = NULL;
+    unsigned int frames = frame_cnt / MIC_FRAME_BYTES;
+    unsigned int offset, count, copied;
+    void* areas;
     
+    if (dev->pcm == NULL || buff == NULL || frame_cnt % MIC_FRAME_BYTES != 0) {
+        return -1;
+    }
+    if (frame_cnt > dev_ex->buffer_size) {
+        /* larger than configured read size, period may not align */
+        char* buffer = (char*)realloc(dev_ex->buffer, frame_cnt);
+        if (buffer == NULL)
+            return -1;
+        dev_ex->buffer = buffer;
+        dev_ex->buffer_size = frame_cnt;
+    }
+    dev_ex->acquired_frames = 0;
+    dev_ex->stat.frames++;
+    if (!dev_ex->mmap) {
+        if (mic_array_device_read_stream(dev, dev_ex->buffer, frame_cnt) != 0)
+            return -1;
+        *buff = dev_ex->buffer;
+        dev_ex->stat.bounced++;
+        return 0;
+    }
+    if (wait_avail(dev_ex, frames) != 0) {
+        return -1;
+    }
+    
+    count = frames;
+    if (pcm_mmap_begin(dev->pcm, &areas, &offset, &count) < 0) {
+        return -1;
+    }
+    if (count >= frames) {
+        /* whole read inside ring, hand out dma buffer */
+        *buff = (char*)areas + offset * MIC_FRAME_BYTES;
+        dev_ex->acquired_offset = offset;
+        dev_ex->acquired_frames = frames;
+        dev_ex->stat.direct++;
+        return 0;
+    }
+    
+    /* wraps around ring end */
+    copied = 0;
+    while (1) {
+        memcpy(dev_ex->buffer + copied * MIC_FRAME_BYTES,
+               (char*)areas + offset * MIC_FRAME_BYTES, count * MIC_FRAME_BYTES);
+        pcm_mmap_commit(dev->pcm, offset, count);
+        copied += count;
+        if (copied == frames)
+            break;
+        count = frames - copied;
+        if (pcm_mmap_begin(dev->pcm, &areas, &offset, &count) < 0)
+            return -1;
+    }
+    *buff = dev_ex->buffer;
+    dev_ex->stat.bounced++;
+    return 0;
+}
+
+static int mic_array_device_release_stream(struct mic_array_device_t* dev, unsigned int frame_cnt)
+{
+    struct mic_array_device_ex* dev_ex = (struct mic_array_device_ex*)dev;
     int ret = 0;
-    int left = 0;
-    int size = dev->frame_cnt;
-    if (size <= 0) {
-        ALOGE("frame cnt lt 0");
+    
+    if (dev_ex->acquired_frames != 0 && dev->pcm != NULL) {
+        ret = pcm_mmap_commit(dev->pcm, dev_ex->acquired_offset, dev_ex->acquired_frames);
+        if (ret < 0) {
+            ALOGE("pcm mmap commit %s", pcm_get_error(dev->pcm));
+            recover_xrun(dev_ex);
+        }
+    }
+    dev_ex->acquired_frames = 0;
+    return ret < 0 ? ret : 0;
+}
+
+static int mic_array_device_read_stream(struct mic_array_device_t* dev, char* buff, unsigned int frame_cnt)
+{
+    struct mic_array_device_ex* dev_ex = (struct mic_array_device_ex*)dev;
+    char* frame = NULL;
+    unsigned int size = dev->frame_cnt;
+    unsigned int done;
+    int ret = 0;
+    
+    if (dev->pcm == NULL) {
+        ALOGE("pcm not open");
         return -1;
     }
     
@@ -306,49 +451,44 @@ static int mic_array_device_read_stream(struct mic_array_device_t* dev, char* bu
         return -1;
     }
     
-    if (frame_cnt >= size) {
-        int cnt = frame_cnt / size;
-        int i;
-        left = frame_cnt % size;
-        
-        if (dev_ex->pts > left) {
-            --cnt;
-        }
-        if (dev_ex->pts > 0) {
-            memcpy(buff, dev_ex->buffer, dev_ex->pts);
+    if (!dev_ex->mmap) {
+        if ((ret = pcm_read(dev->pcm, buff, frame_cnt)) != 0) {
+            ALOGE("pcm_read %s", strerror(errno));
         }
-        
-        for (i = 0; i < cnt; i++) {
-            if ((ret = read_frame(dev, buff + dev_ex->pts + i * size)) != 0) {
-                ALOGE("read_frame %s", strerror(errno));
-                resetBuffer(dev_ex);
-                return ret;
-            }
-        }
-        if (frame_cnt - (dev_ex->pts + cnt * size) == 0) {
-            dev_ex->pts = 0;
-            return ret;
-        }
-//        ALOGE("-------------------cnt : %d, left : %d, cache : %d, frame_cnt : %d", cnt, left, dev_ex->pts, frame_cnt);
-        target = buff + dev_ex->pts + cnt * size;
-        left = frame_cnt - (dev_ex->pts + cnt * size);
-        dev_ex->pts = 0;
-    } else {
-        target = buff;
-        left = frame_cnt;
-    }
-    
-    if ((ret = read_left_frame(dev_ex, target, left)) != 0) {
-        ALOGE("read frame return %d, pcm read error", ret);
-        resetBuffer(dev_ex);
         return ret;
     }
     
+    for (done = 0; done < frame_cnt; done += size) {
+        if (frame_cnt - done < size)
+            size = frame_cnt - done;
+        if ((ret = mic_array_device_acquire_stream(dev, &frame, size)) != 0) {
+            ALOGE("read frame return %d, pcm read error", ret);
+            return ret;
+        }
+        memcpy(buff + done, frame, size);
+        mic_array_device_release_stream(dev, size);
+    }
     return ret;
 }
 
 static int mic_array_device_config_stream(struct mic_array_device_t* dev, int cmd, char* cmd_buff)
 {
+    struct mic_array_device_ex* dev_ex = (struct mic_array_device_ex*)dev;
+    
+    switch (cmd) {
+    case MIC_ARRAY_CMD_SET_FRAME_SIZE: {
+        unsigned int frame_cnt = *(unsigned int*)cmd_buff;
+        if (dev->pcm != NULL || frame_cnt == 0 || frame_cnt % MIC_FRAME_BYTES != 0) {
+            ALOGE("set frame size %u failed", frame_cnt);
+            return -1;
+        }
+        set_frame_size(dev_ex, frame_cnt);
+        return dev_ex->buffer == NULL ? -1 : 0;
+    }
+    case MIC_ARRAY_CMD_GET_STAT:
+        memcpy(cmd_buff, &dev_ex->stat, sizeof(struct mic_array_stat_t));
+        return 0;
+    }
     return -1;
 }
 
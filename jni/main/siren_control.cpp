@@ -1,40 +1,71 @@
 #include "siren_control.h"
 
-#include <SLES/OpenSLES.h>
+#include <stdlib.h>
+#include <memory>
 
 #include "VoiceService.h"
-//#include "opensl_io.h"
-#include "mic_array.h"
+#include "CaptureBackend.h"
 #include "log.h"
 
-#include <string.h>
-#define SAMPLERATE 48000
-#define CHANNELS 4
-#define PERIOD_TIME 20 //ms
-#define FRAME_SIZE SAMPLERATE*PERIOD_TIME/1000
-#define BUFFER_SIZE FRAME_SIZE*CHANNELS
+// capture spec of CaptureRegistry, mic array card if not set
+#define CAPTURE_ENV "OPENVOICE_CAPTURE"
+#define CAPTURE_DEFAULT "alsa"
 
 siren_t _siren;
 siren_proc_callback_t event_callback;
-struct mic_array_device_t *mic_array_device = NULL;
+std::unique_ptr<CaptureBackend> capture;
 void* __token = nullptr;
 
-//OPENSL_STREAM* stream = nullptr;
-
 siren_input_if_t siren_input = { init_input, release_input, start_input,
-    stop_input, read_input, on_err_input };
+    stop_input, read_input, on_err_input, acquire_input_frame, release_input_frame };
 
 siren_state_changed_callback_t siren_state_change = { state_changed_callback };
 
+// undo a setup that failed after init_siren
+static void teardown_siren() {
+    destroy_siren(_siren);
+    _siren = 0;
+    capture.reset();
+}
+
 bool setup(void*token, on_voice_event_t callback) {
     __token = token;
     
-    if(mic_array_device_open(&mic_array_device) != 0){
-        ALOGE("open mic_array failed");
+    const char* spec = getenv(CAPTURE_ENV);
+    if(spec == nullptr || *spec == '\0') spec = CAPTURE_DEFAULT;
+    capture.reset(CaptureRegistry::create(spec));
+    if(!capture){
+        ALOGE("unknown capture %s", spec);
         return false;
     }
     event_callback.voice_event_callback = callback;
     _siren = init_siren(token, NULL, &siren_input);
+    if(_siren == 0){
+        ALOGE("init siren failed");
+        capture.reset();
+        return false;
+    }
+
+    // siren reads in format of its config
+    siren_input_format_t input;
+    if(get_siren_input_format(_siren, &input) != SIREN_STATUS_OK){
+        ALOGE("siren input format unknown");
+        teardown_siren();
+        return false;
+    }
+    CaptureFormat format;
+    format.channels = input.channels;
+    format.rate = input.sample_rate;
+    format.sample_bytes = input.sample_bytes;
+    format.read_bytes = input.frame_bytes;
+    if(!capture->open(format)){
+        ALOGE("capture %s not support %u ch %u hz %u bytes", spec,
+                format.channels, format.rate, format.sample_bytes);
+        teardown_siren();
+        return false;
+    }
+    ALOGI("capture %s %u ch %u hz %u bytes, read %u bytes", spec,
+            format.channels, format.rate, format.sample_bytes, format.read_bytes);
     return true;
 }
 
@@ -78,27 +109,28 @@ int init_input(void *token) {
 }
 
 void release_input(void *token) {
+    capture->close();
 }
 
 int start_input(void *token) {
-    //	stream = android_OpenAudioDevice(48000, 1, 0, 1024);
-    //	if (stream == nullptr) {
-    //		ALOGE("failed to open audio device ! \n");
-    //		return -1;
-    //	}
-    return mic_array_device->start_stream(mic_array_device);
-    //	ALOGE("open audio device success! \n");
-    //	return 0;
+    return capture->start();
 }
 
 void stop_input(void *token) {
     ALOGV("%s", __FUNCTION__);
-    //	android_CloseAudioDevice(stream);
+    capture->stop();
 }
 
 int read_input(void *token, char *buff, int frame_cnt) {
-    //	return android_AudioIn(stream, (short*)buff, frame_cnt/2);
-    return mic_array_device->read_stream(mic_array_device, buff, frame_cnt);
+    return capture->read(buff, frame_cnt);
+}
+
+int acquire_input_frame(void *token, char **buff, int frame_cnt) {
+    return capture->acquire(buff, frame_cnt);
+}
+
+void release_input_frame(void *token, int frame_cnt) {
+    capture->release(frame_cnt);
 }
 
 int find_card(const char *snd) {
@@ -30,6 +30,10 @@ extern "C" {
     
     int read_input(void*, char*, int);
     
+    int acquire_input_frame(void*, char**, int);
+    
+    void release_input_frame(void*, int);
+    
     void on_err_input(void*);
     
     void state_changed_callback(void*, int);
@@ -0,0 +1,179 @@
+// Host benchmark of native half of java callbacks:
+// VoiceCallback -> CallbackDispatcher -> encode batch to direct buffer.
+// build with -DCALLBACK_BENCH_JSON to compare with json string messages
+// (build json, serialize, parse per event) used before.
+//
+// build (in jni):
+//   g++ -std=c++11 -O2 -Imain -o callback_bench main/tools/callback_bench.cpp
+//   main/CallbackDispatcher.cpp main/CallbackBatch.cpp main/VoiceCallback.cpp -lpthread
+// json comparison: add -DCALLBACK_BENCH_JSON -Iblacksiren/libjsonc/include
+//     and json-c objects built from blacksiren/libjsonc/src
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+#include "VoiceCallback.h"
+#include "CallbackBatch.h"
+#include "CallbackDispatcher.h"
+#include "EventTypes.h"
+
+#ifdef CALLBACK_BENCH_JSON
+#include "json.h"
+#endif
+
+using std::string;
+using std::chrono::steady_clock;
+using namespace openvoice_process;
+
+static uint32_t events_per_producer = 200000;
+static uint32_t producers = 2;
+
+// voice session: mostly VOICE_DATA, some asr results, one command
+static void produce(VoiceCallback* callback){
+    string asr = "今天天气怎么样";
+    string nlp = "{\"domain\":\"weather\",\"intent\":\"query\",\"slots\":{\"city\":\"北京\"}}";
+    string action = "{\"version\":\"2.0.0\",\"response\":{\"action\":{\"type\":\"NORMAL\"}}}";
+    for(uint32_t i = 0; i < events_per_producer; i++){
+        uint32_t n = i % 100;
+        if(n < 90) callback->voice_event(i, VoiceEvent::VOICE_DATA, 0.0, 23.5);
+        else if(n < 98) callback->intermediate_result(i, ASR_INTER_RESULT_BEGIN, asr);
+        else if(n < 99) callback->voice_command(i, asr, nlp, action);
+        else callback->speech_error(i, SPEECH_ERROR_TIMEOUT);
+    }
+}
+
+static void bench_batch(){
+    VoiceCallback callback;
+    CallbackDispatcher dispatcher;
+    CallbackDispatcherStat stat;
+    uint64_t total = (uint64_t)events_per_producer * producers;
+    uint64_t calls = 0;
+    static char buffer[16 * 1024];
+    callback.set_callback([&](const CallbackEvent& event){dispatcher.push(event);});
+
+    steady_clock::time_point t0 = steady_clock::now();
+    std::thread handler_thread(&CallbackDispatcher::run, &dispatcher, [&](const CallbackBatch& batch){
+        uint32_t first, count, used;
+        for(first = 0; first < batch.size(); first += count){
+            count = batch.encode(first, buffer, sizeof(buffer), used);
+            calls++;
+        }
+    });
+    std::list<std::thread> threads;
+    for(uint32_t i = 0; i < producers; i++) threads.push_back(std::thread(produce, &callback));
+    for(auto& t : threads) t.join();
+    do{
+        std::this_thread::yield();
+        dispatcher.get_stat(stat);
+    }while(stat.delivered < total);
+    double ms = std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - t0).count() / 1000.0;
+    dispatcher.stop();
+    handler_thread.join();
+    printf("batch  %llu events, %.2fms, %.0f events/s, %llu jni calls, %.1f events/call\n",
+           (unsigned long long)total, ms, total * 1000.0 / ms,
+           (unsigned long long)calls, (double)total / calls);
+}
+
+#ifdef CALLBACK_BENCH_JSON
+// json message path, copied from VoiceCallback and Handle before batching
+class JsonConsumer{
+public:
+    void push(int32_t what, const string& data){
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::make_pair(what, data));
+        cond.notify_one();
+    }
+
+    void run(uint64_t total){
+        std::unique_lock<std::mutex> lk(mutex, std::defer_lock);
+        while(handled < total){
+            lk.lock();
+            cond.wait(lk, [this]{return !queue.empty();});
+            json_object *json_obj = json_tokener_parse(queue.front().second.c_str());
+            json_object *obj;
+            const char* keys[] = {"id", "event", "sl", "energy", "type", "asr", "nlp", "action", "errcode"};
+            for(auto key : keys){
+                if(TRUE == json_object_object_get_ex(json_obj, key, &obj)) sink += json_object_get_int(obj);
+            }
+            json_object_put(json_obj);
+            queue.pop_front();
+            handled++;
+            lk.unlock();
+        }
+    }
+
+    std::list<std::pair<int32_t, string> > queue;
+    std::mutex mutex;
+    std::condition_variable cond;
+    uint64_t handled = 0;
+    uint64_t sink = 0;
+};
+
+static void produce_json(JsonConsumer* consumer){
+    string asr = "今天天气怎么样";
+    string nlp = "{\"domain\":\"weather\",\"intent\":\"query\",\"slots\":{\"city\":\"北京\"}}";
+    string action = "{\"version\":\"2.0.0\",\"response\":{\"action\":{\"type\":\"NORMAL\"}}}";
+    for(uint32_t i = 0; i < events_per_producer; i++){
+        uint32_t n = i % 100;
+        json_object *root = json_object_new_object();
+        json_object_object_add(root, "id", json_object_new_int(i));
+        int32_t what;
+        if(n < 90){
+            what = MSG_VOICE_EVENT_ID;
+            json_object_object_add(root, "event", json_object_new_int(VoiceEvent::VOICE_DATA));
+            json_object_object_add(root, "sl", json_object_new_double(0.0));
+            json_object_object_add(root, "energy", json_object_new_double(23.5));
+        }else if(n < 98){
+            what = MSG_INTERMEDIATE_RESULT_ID;
+            json_object_object_add(root, "type", json_object_new_int(ASR_INTER_RESULT_BEGIN));
+            json_object_object_add(root, "asr", json_object_new_string(asr.c_str()));
+        }else if(n < 99){
+            what = MSG_VOICE_COMMAND_ID;
+            json_object_object_add(root, "asr", json_object_new_string(asr.c_str()));
+            json_object_object_add(root, "nlp", json_object_new_string(nlp.c_str()));
+            json_object_object_add(root, "action", json_object_new_string(action.c_str()));
+        }else{
+            what = MSG_SPEECH_ERROR_ID;
+            json_object_object_add(root, "errcode", json_object_new_int(SPEECH_ERROR_TIMEOUT));
+        }
+        std::string str = json_object_to_json_string(root);
+        json_object_put(root);
+        consumer->push(what, str);
+    }
+}
+
+static void bench_json(){
+    JsonConsumer consumer;
+    uint64_t total = (uint64_t)events_per_producer * producers;
+    steady_clock::time_point t0 = steady_clock::now();
+    std::thread consumer_thread(&JsonConsumer::run, &consumer, total);
+    std::list<std::thread> threads;
+    for(uint32_t i = 0; i < producers; i++) threads.push_back(std::thread(produce_json, &consumer));
+    for(auto& t : threads) t.join();
+    consumer_thread.join();
+    double ms = std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - t0).count() / 1000.0;
+    printf("json   %llu events, %.2fms, %.0f events/s, %llu jni calls\n",
+           (unsigned long long)total, ms, total * 1000.0 / ms, (unsigned long long)total);
+}
+#endif
+
+int main(int argc, char** argv){
+    if(argc > 1) events_per_producer = atoi(argv[1]);
+    if(argc > 2) producers = atoi(argv[2]);
+    if(events_per_producer == 0 || producers == 0){
+        printf("usage: %s [events per producer] [producers]\n", argv[0]);
+        return 1;
+    }
+    bench_batch();
+#ifdef CALLBACK_BENCH_JSON
+    bench_json();
+#endif
+    return 0;
+}
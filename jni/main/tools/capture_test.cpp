@@ -0,0 +1,303 @@
+// Test capture backends on plain linux: synth tone, impulse and
+// noise content and exact rate pacing, file loop replay, aggregate
+// channel layout, alsa on the emulated ring of pcm_file.c, and
+// throughput of each source in siren format (8 ch, 48k, S32, 10ms).
+//
+// build (in jni):
+//   gcc -c -O2 -Iinclude -Imain/tools main/mic_array.c main/tools/pcm_file.c
+//   g++ -std=c++11 -O2 -Iinclude -Imain -Imain/tools -o capture_test
+//   main/tools/capture_test.cpp main/CaptureBackend.cpp main/CaptureAlsa.cpp
+//   main/CaptureSources.cpp mic_array.o pcm_file.o
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+#include "CaptureBackend.h"
+#include "pcm_file.h"
+
+using std::string;
+using std::vector;
+using std::unique_ptr;
+using std::chrono::steady_clock;
+
+static int failures = 0;
+
+#define EXPECT(cond, ...) do{ \
+        if(!(cond)){ \
+            printf("FAIL %s:%d ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    }while(0)
+
+static CaptureFormat siren_format(uint32_t channels = 8, uint32_t sample_bytes = 4){
+    CaptureFormat format;
+    format.channels = channels;
+    format.rate = 48000;
+    format.sample_bytes = sample_bytes;
+    format.read_bytes = format.rate / 100 * channels * sample_bytes;
+    return format;
+}
+
+static double elapsed_ms(steady_clock::time_point t0){
+    return std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - t0).count() / 1000.0;
+}
+
+static int32_t sample_at(const char* buff, const CaptureFormat& format, uint32_t frame, uint32_t channel){
+    const char* p = buff + frame * format.frame_bytes() + channel * format.sample_bytes;
+    uint32_t u = 0;
+    for(uint32_t i = 0; i < format.sample_bytes; i++) u |= (uint32_t)(uint8_t)p[i] << (8 * (4 - format.sample_bytes + i));
+    return (int32_t)u;
+}
+
+static unique_ptr<CaptureBackend> open_capture(const string& spec, const CaptureFormat& format){
+    unique_ptr<CaptureBackend> capture(CaptureRegistry::create(spec));
+    if(!capture || !capture->open(format) || capture->start() != 0) return nullptr;
+    return capture;
+}
+
+// S32 frames numbered frame * channels + channel
+static void make_file(const string& path, uint32_t channels, uint32_t frames, uint32_t tail){
+    FILE* fp = fopen(path.c_str(), "wb");
+    for(uint32_t i = 0; i < frames; i++){
+        for(uint32_t c = 0; c < channels; c++){
+            int32_t v = i * channels + c;
+            fwrite(&v, 4, 1, fp);
+        }
+    }
+    for(uint32_t i = 0; i < tail; i++) fputc(0x7f, fp);
+    fclose(fp);
+}
+
+static void test_registry(){
+    vector<string> names = CaptureRegistry::names();
+    EXPECT(names.size() == 4, "%zu builtin", names.size());
+    EXPECT(CaptureRegistry::create("nope") == nullptr, "unknown name");
+    EXPECT(CaptureRegistry::create("") == nullptr, "empty spec");
+
+    string name;
+    CaptureOptions options;
+    CaptureRegistry::parse("synth:tone=440,noise=0.5,flag", name, options);
+    EXPECT(name == "synth" && options.get("tone", 0.0) == 440 && options.get("noise", 0.0) == 0.5
+            && options.has("flag") && options.get("missing", 7.0) == 7, "parse");
+    CaptureRegistry::add("silence", [](const CaptureOptions& o){
+        return create_synth_capture(o);
+    });
+    unique_ptr<CaptureBackend> custom(CaptureRegistry::create("silence:realtime=0"));
+    EXPECT(custom && custom->open(siren_format()), "custom factory");
+}
+
+static void test_synth(uint32_t sample_bytes){
+    CaptureFormat format = siren_format(8, sample_bytes);
+    vector<char> buff(format.read_bytes);
+    uint32_t crossings = 0;
+    int32_t last = 0;
+
+    unique_ptr<CaptureBackend> tone = open_capture("synth:tone=1000,amp=0.5,realtime=0", format);
+    EXPECT(tone != nullptr, "open tone");
+    if(!tone) return;
+    int32_t peak = 0;
+    for(uint32_t r = 0; r < 100; r++){
+        tone->read(buff.data(), format.read_bytes);
+        for(uint32_t f = 0; f < format.read_frames(); f++){
+            int32_t v = sample_at(buff.data(), format, f, 0);
+            EXPECT(v == sample_at(buff.data(), format, f, 7), "channels differ");
+            if(last < 0 && v >= 0) crossings++;
+            if(v > peak) peak = v;
+            last = v;
+        }
+    }
+    // one second of 1kHz
+    EXPECT(crossings >= 999 && crossings <= 1000, "%u crossings", crossings);
+    EXPECT(peak > 0.49 * 2147483647.0 && peak < 0.51 * 2147483647.0, "peak %d", peak);
+
+    unique_ptr<CaptureBackend> impulse = open_capture("synth:impulse=250,realtime=0", format);
+    vector<uint32_t> at;
+    for(uint32_t r = 0; r < 100; r++){
+        impulse->read(buff.data(), format.read_bytes);
+        for(uint32_t f = 0; f < format.read_frames(); f++){
+            if(sample_at(buff.data(), format, f, 3) != 0) at.push_back(r * format.read_frames() + f);
+        }
+    }
+    EXPECT(at.size() == 4 && at[0] == 0 && at[1] == 12000 && at[3] == 36000, "%zu impulses", at.size());
+
+    unique_ptr<CaptureBackend> noise = open_capture("synth:noise=0.1,realtime=0", format);
+    noise->read(buff.data(), format.read_bytes);
+    double sum = 0;
+    uint32_t same = 0;
+    for(uint32_t f = 0; f < format.read_frames(); f++){
+        double v = sample_at(buff.data(), format, f, 0) / 2147483648.0;
+        sum += v * v;
+        if(sample_at(buff.data(), format, f, 0) == sample_at(buff.data(), format, f, 1)) same++;
+    }
+    // uniform in +-0.1, rms 0.1 / sqrt(3)
+    double rms = sqrt(sum / format.read_frames());
+    EXPECT(rms > 0.05 && rms < 0.065 && same < 5, "noise rms %.4f same %u", rms, same);
+    printf("synth    %u bytes: %u crossings of 1kHz, impulses at %u %u, noise rms %.4f\n",
+            sample_bytes, crossings, at.size() > 1 ? at[0] : 0, at.size() > 1 ? at[1] : 0, rms);
+}
+
+static void test_synth_realtime(){
+    CaptureFormat format = siren_format();
+    vector<char> buff(format.read_bytes);
+    unique_ptr<CaptureBackend> synth = open_capture("synth:tone=440", format);
+    steady_clock::time_point t0 = steady_clock::now();
+    vector<double> at;
+    for(uint32_t r = 0; r < 200; r++){
+        synth->read(buff.data(), format.read_bytes);
+        at.push_back(elapsed_ms(t0));
+    }
+    double worst = 0;
+    for(uint32_t r = 0; r < at.size(); r++){
+        double late = at[r] - (r + 1) * 10.0;
+        if(late > worst) worst = late;
+        EXPECT(late > -0.5, "read %u early %.2fms", r, -late);
+    }
+    EXPECT(at.back() < 2005, "2s in %.1fms", at.back());
+    printf("synth    realtime 200 reads of 10ms in %.1fms, latest read %.2fms late\n", at.back(), worst);
+}
+
+static void test_file(const string& path){
+    CaptureFormat format = siren_format();
+    uint32_t frames = format.read_frames() * 3 / 2;
+    vector<char> buff(format.read_bytes);
+
+    // one and a half reads and a partial frame
+    make_file(path, 8, frames, 5);
+    unique_ptr<CaptureBackend> file = open_capture("file:path=" + path + ",realtime=0", format);
+    EXPECT(file != nullptr, "open file");
+    if(!file) return;
+    uint32_t expect = 0;
+    bool ok = true;
+    for(uint32_t r = 0; r < 10 && ok; r++){
+        char* frame;
+        file->acquire(&frame, format.read_bytes);
+        for(uint32_t f = 0; f < format.read_frames() && ok; f++){
+            ok = sample_at(frame, format, f, 5) == (int32_t)(expect * 8 + 5);
+            expect = (expect + 1) % frames;
+        }
+        file->release(format.read_bytes);
+    }
+    EXPECT(ok, "file loop data");
+
+    unique_ptr<CaptureBackend> once = open_capture("file:path=" + path + ",loop=0,realtime=0", format);
+    EXPECT(once->read(buff.data(), format.read_bytes) == 0, "first read");
+    EXPECT(once->read(buff.data(), format.read_bytes) != 0, "read past end without loop");
+
+    unique_ptr<CaptureBackend> missing(CaptureRegistry::create("file:path=/nonexistent.pcm"));
+    EXPECT(!missing->open(format), "missing file");
+    printf("file     loop replay ok, end of file without loop ok\n");
+}
+
+static void test_aggregate(const string& path){
+    CaptureFormat format = siren_format();
+    vector<char> buff(format.read_bytes);
+
+    make_file(path, 6, format.read_frames() * 4, 0);
+    unique_ptr<CaptureBackend> agg = open_capture("aggregate:file:path=" + path
+            + ",realtime=0;synth:impulse=5,channels=2,realtime=0", format);
+    EXPECT(agg != nullptr, "open aggregate");
+    if(!agg) return;
+    agg->read(buff.data(), format.read_bytes);
+    bool ok = true;
+    for(uint32_t f = 0; f < format.read_frames(); f++){
+        for(uint32_t c = 0; c < 6; c++) ok &= sample_at(buff.data(), format, f, c) == (int32_t)(f * 6 + c);
+        int32_t impulse = f % 240 == 0 ? 2147483647 : 0;
+        ok &= sample_at(buff.data(), format, f, 6) == impulse && sample_at(buff.data(), format, f, 7) == impulse;
+    }
+    EXPECT(ok, "aggregate layout");
+
+    unique_ptr<CaptureBackend> bad(CaptureRegistry::create("aggregate:synth:channels=4;synth:channels=2"));
+    EXPECT(!bad->open(format), "channels short");
+    bad.reset(CaptureRegistry::create("aggregate:synth;synth"));
+    EXPECT(!bad->open(format), "two without channels");
+    bad.reset(CaptureRegistry::create("aggregate:synth:channels=4;nope"));
+    EXPECT(!bad->open(format), "unknown child");
+    printf("aggregate file 6 ch + synth 2 ch layout ok\n");
+}
+
+static void test_alsa(const string& path){
+    CaptureFormat format = siren_format();
+    make_file(path, 8, 48000, 0);
+    pcm_file_set_source(path.c_str(), 0, 1);
+
+    unique_ptr<CaptureBackend> wrong(CaptureRegistry::create("alsa"));
+    EXPECT(!wrong->open(siren_format(4)), "alsa accepts 4 ch");
+    unique_ptr<CaptureBackend> alsa = open_capture("alsa", format);
+    EXPECT(alsa != nullptr, "open alsa");
+    if(!alsa) return;
+    bool ok = true;
+    uint32_t expect = 0;
+    for(uint32_t r = 0; r < 300 && ok; r++){
+        char* frame;
+        ok = alsa->acquire(&frame, format.read_bytes) == 0;
+        for(uint32_t f = 0; f < format.read_frames() && ok; f++){
+            ok = sample_at(frame, format, f, 7) == (int32_t)(expect * 8 + 7);
+            expect = (expect + 1) % 48000;
+        }
+        alsa->release(format.read_bytes);
+    }
+    EXPECT(ok, "alsa data");
+    alsa->stop();
+    EXPECT(alsa->start() == 0, "alsa restart");
+    printf("alsa     emulated card 300 reads ok, restart ok\n");
+}
+
+static void bench(const string& spec, const CaptureFormat& format){
+    unique_ptr<CaptureBackend> capture = open_capture(spec, format);
+    if(!capture){
+        EXPECT(0, "open %s", spec.c_str());
+        return;
+    }
+    uint32_t reads = 3000;
+    steady_clock::time_point t0 = steady_clock::now();
+    for(uint32_t r = 0; r < reads; r++){
+        char* frame;
+        capture->acquire(&frame, format.read_bytes);
+        capture->release(format.read_bytes);
+    }
+    double ms = elapsed_ms(t0);
+    printf("bench    %-40.40s %7.0f MB/s %6.0fx realtime\n", spec.c_str(),
+            reads * (double)format.read_bytes / 1048576 / (ms / 1000), reads * 10.0 / ms);
+}
+
+int main(){
+    char tmp[] = "/tmp/capture_testXXXXXX";
+    int fd = mkstemp(tmp);
+    if(fd < 0){
+        printf("mkstemp failed\n");
+        return 1;
+    }
+    close(fd);
+    string path = tmp;
+
+    test_registry();
+    test_synth(2);
+    test_synth(3);
+    test_synth(4);
+    test_synth_realtime();
+    test_file(path);
+    test_aggregate(path);
+    test_alsa(path);
+
+    CaptureFormat format = siren_format();
+    make_file(path, 8, 48000, 0);
+    pcm_file_set_source(path.c_str(), 0, 1);
+    bench("alsa", format);
+    bench("file:path=" + path + ",realtime=0", format);
+    bench("synth:tone=1000,noise=0.01,realtime=0", format);
+    make_file(path, 6, 48000, 0);
+    bench("aggregate:file:path=" + path + ",realtime=0;synth:tone=1000,channels=2,realtime=0", format);
+
+    unlink(tmp);
+    printf("%s\n", failures ? "FAILED" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+// Stress CallbackDispatcher with slow java callbacks:
+// producers push VOICE_DATA at audio frame rate and asr results,
+// handler sleeps per batch. checks producers are not blocked by
+// handler and no asr result lost by coalescing.
+//
+// build (in jni):
+//   g++ -std=c++11 -O2 -Imain -o dispatcher_stress main/tools/dispatcher_stress.cpp
+//   main/CallbackDispatcher.cpp main/CallbackBatch.cpp main/VoiceCallback.cpp -lpthread
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+
+#include "VoiceCallback.h"
+#include "CallbackDispatcher.h"
+#include "EventTypes.h"
+
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+using namespace openvoice_process;
+
+static uint32_t producers = 2;
+// interval of VOICE_DATA, microseconds
+static uint32_t interval = 10000;
+static uint32_t seconds = 5;
+// handler time of one batch, milliseconds
+static uint32_t delay = 50;
+
+static std::atomic<uint64_t> asr_sent(0);
+static std::atomic<uint64_t> asr_received(0);
+
+static void produce(VoiceCallback* callback, vector<double>* latency){
+    string asr = "今天天气怎么样";
+    steady_clock::time_point end = steady_clock::now() + std::chrono::seconds(seconds);
+    uint32_t seq = 0;
+    while(steady_clock::now() < end){
+        steady_clock::time_point t0 = steady_clock::now();
+        if(++seq % 20 == 0){
+            callback->intermediate_result(1, ASR_INTER_RESULT_BEGIN, asr);
+            asr_sent++;
+        }else{
+            callback->voice_event(1, VoiceEvent::VOICE_DATA, 0.0, seq);
+        }
+        latency->push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                steady_clock::now() - t0).count() / 1000.0);
+        std::this_thread::sleep_for(std::chrono::microseconds(interval));
+    }
+}
+
+// count asr results, same decoding as VoiceCallback.java
+static void slow_handler(const CallbackBatch& batch){
+    static vector<char> buf(64 * 1024);
+    uint32_t first = 0, count, used;
+    while(first < batch.size()){
+        if(buf.size() < batch.encoded_size(first)) buf.resize(batch.encoded_size(first));
+        count = batch.encode(first, buf.data(), buf.size(), used);
+        const char* p = buf.data();
+        for(uint32_t i = 0; i < count; i++){
+            int32_t what, length;
+            memcpy(&what, p, sizeof(what));
+            p += sizeof(int32_t) * 3 + sizeof(double) * 2;
+            for(int j = 0; j < CALLBACK_EVENT_STRINGS; j++){
+                memcpy(&length, p, sizeof(length));
+                p += sizeof(length) + length;
+            }
+            if(what == MSG_INTERMEDIATE_RESULT_ID) asr_received++;
+        }
+        first += count;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+}
+
+int main(int argc, char** argv){
+    if(argc > 1) producers = atoi(argv[1]);
+    if(argc > 2) interval = atoi(argv[2]);
+    if(argc > 3) seconds = atoi(argv[3]);
+    if(argc > 4) delay = atoi(argv[4]);
+    if(producers == 0 || seconds == 0){
+        printf("usage: %s [producers] [interval us] [seconds] [handler delay ms]\n", argv[0]);
+        return 1;
+    }
+
+    CallbackDispatcher dispatcher;
+    VoiceCallback callback;
+    dispatcher.coalesce(MSG_VOICE_EVENT_ID, VoiceEvent::VOICE_DATA);
+    callback.set_callback([&](const CallbackEvent& event){dispatcher.push(event);});
+    std::thread handler_thread(&CallbackDispatcher::run, &dispatcher, CallbackDispatcher::Handler(slow_handler));
+
+    vector<vector<double> > latency(producers);
+    vector<std::thread> threads;
+    for(uint32_t i = 0; i < producers; i++) threads.push_back(std::thread(produce, &callback, &latency[i]));
+    for(auto& t : threads) t.join();
+
+    // let handler deliver pending events
+    CallbackDispatcherStat stat;
+    do{
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay + 10));
+        dispatcher.get_stat(stat);
+    }while(stat.depth > 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay + 10));
+    dispatcher.stop();
+    handler_thread.join();
+    dispatcher.get_stat(stat);
+
+    vector<double> all;
+    for(auto& l : latency) all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+    size_t n = all.size();
+    printf("push latency  n=%zu p50=%.1fus p99=%.1fus max=%.1fus\n",
+           n, all[n / 2], all[n * 99 / 100], all[n - 1]);
+    printf("dispatcher    pushed=%llu coalesced=%llu delivered=%llu batches=%llu max_depth=%u\n",
+           (unsigned long long)stat.pushed, (unsigned long long)stat.coalesced,
+           (unsigned long long)stat.delivered, (unsigned long long)stat.batches, stat.max_depth);
+    printf("callback      avg=%.1fms max=%.1fms\n",
+           stat.batches ? stat.callback_total_us / 1000.0 / stat.batches : 0.0, stat.callback_max_us / 1000.0);
+    printf("asr results   sent=%llu received=%llu\n",
+           (unsigned long long)asr_sent.load(), (unsigned long long)asr_received.load());
+
+    bool ok = asr_sent == asr_received && stat.pushed == stat.delivered + stat.coalesced;
+    // producer must not wait for handler
+    ok = ok && all[n - 1] < delay * 1000.0;
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
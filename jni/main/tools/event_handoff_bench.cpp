@@ -0,0 +1,338 @@
+// Count heap allocations and user space copies per audio second on the
+// siren -> VoiceService event path. a forked child plays siren's
+// processing side writing recorded events to a socket channel, parent
+// plays proxy response thread and VoiceService::onEvent.
+//   legacy: message copy in child, new voice_event_t in proxy,
+//           new char[] copy in voice_event_callback
+//   pooled: writev in child, event block from SirenEventPool,
+//           siren_event_ref in voice_event_callback, deque event queue
+//
+// input is raw audio as sent in VAD_DATA (siren proc recording), cut
+// into frames and wrapped with VAD_START/VAD_END every utterance.
+//
+// build (in jni):
+//   g++ -std=c++11 -O2 -DCONFIG_SIREN_LOG_LEVEL=3 -Iinclude -Iblacksiren/libbsiren/include
+//   -o event_handoff_bench main/tools/event_handoff_bench.cpp
+//   blacksiren/libbsiren/src/siren_channel.cpp blacksiren/libbsiren/src/siren_event_pool.cpp
+//   blacksiren/libbsiren/src/siren_log.cpp blacksiren/libbsiren/src/siren_vt_wire.cpp -lpthread
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <new>
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "siren.h"
+#include "isiren.h"
+#include "siren_alg.h"
+#include "siren_channel.h"
+#include "siren_event_pool.h"
+
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+using namespace BlackSiren;
+
+static __thread uint64_t thread_allocs = 0;
+
+void* operator new(size_t size){
+    thread_allocs++;
+    void* p = malloc(size ? size : 1);
+    if(p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size){
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {free(p);}
+void operator delete[](void* p) noexcept {free(p);}
+
+struct Counter{
+    uint64_t allocs = 0;
+    uint64_t copies = 0;
+    uint64_t copy_bytes = 0;
+
+    void copy(void* to, const void* from, size_t size){
+        memcpy(to, from, size);
+        copies++;
+        copy_bytes += size;
+    }
+};
+
+static string pcm_path;
+static uint32_t frame_bytes = 640;
+// bytes of one audio second, 16k mono s16
+static uint32_t second_bytes = 32000;
+static uint32_t seconds = 60;
+static uint32_t utterance_frames = 150;
+// play speed relative to audio time, 0 as fast as possible
+static uint32_t speed = 20;
+
+// ProcessedVoiceResult and data, as built by SirenAudioVBVProcessor
+static vector<string> events;
+static uint64_t audio_bytes = 0;
+
+static void add_event(int prop, const char* data, int size){
+    ProcessedVoiceResult p;
+    memset(&p, 0, sizeof(p));
+    p.size = size;
+    p.prop = prop;
+    p.hasVoice = size ? 1 : 0;
+    p.background_energy = 1.0;
+    string result((const char*)&p, sizeof(p));
+    if(size) result.append(data, size);
+    events.push_back(result);
+}
+
+static void load_events(){
+    string audio;
+    if(!pcm_path.empty()){
+        FILE* fp = fopen(pcm_path.c_str(), "rb");
+        if(fp == nullptr){
+            printf("open %s failed\n", pcm_path.c_str());
+            exit(1);
+        }
+        char buf[4096];
+        size_t n;
+        while((n = fread(buf, 1, sizeof(buf), fp)) > 0) audio.append(buf, n);
+        fclose(fp);
+    }else{
+        audio.resize((size_t)seconds * second_bytes);
+        for(size_t i = 0; i < audio.size(); i++) audio[i] = (char)(i * 31 + (i >> 7));
+    }
+    uint32_t frames = 0;
+    for(size_t off = 0; off + frame_bytes <= audio.size(); off += frame_bytes){
+        if(frames % utterance_frames == 0) add_event(SIREN_EVENT_VAD_START, nullptr, 0);
+        add_event(SIREN_EVENT_VAD_DATA, audio.data() + off, frame_bytes);
+        audio_bytes += frame_bytes;
+        if(++frames % utterance_frames == 0) add_event(SIREN_EVENT_VAD_END, nullptr, 0);
+    }
+    if(frames % utterance_frames) add_event(SIREN_EVENT_VAD_END, nullptr, 0);
+}
+
+// child: siren processing side, send each result to proxy
+static void write_events(SirenSocketChannel& channel, bool pooled){
+    SirenSocketWriter writer(&channel);
+    writer.prepareOnWriteSideProcess();
+    Counter counter;
+    uint64_t base = thread_allocs;
+    uint64_t played = 0;
+    steady_clock::time_point t0 = steady_clock::now();
+    for(auto& e : events){
+        if(speed){
+            played += e.size() - sizeof(ProcessedVoiceResult);
+            std::this_thread::sleep_until(t0 + std::chrono::microseconds(
+                        played * 1000000 / second_bytes / speed));
+        }
+        if(pooled){
+            writer.writeMessage(SIREN_RESPONSE_MSG_ON_VOICE_EVENT, e.data(), e.size());
+        }else{
+            Message* msg = allocateMessage(SIREN_RESPONSE_MSG_ON_VOICE_EVENT, e.size());
+            counter.copy(msg->data, e.data(), e.size());
+            writer.writeMessage(msg);
+            delete [] (char*)msg;
+        }
+    }
+    counter.allocs = thread_allocs - base;
+    writer.writeMessage(SIREN_RESPONSE_MSG_ON_DESTROY, nullptr, 0);
+    printf("  siren child     allocs %8llu  copies %8llu  bytes %10llu\n",
+            (unsigned long long)counter.allocs, (unsigned long long)counter.copies,
+            (unsigned long long)counter.copy_bytes);
+}
+
+// parent: VoiceService event queue, onEvent thread reads audio as put_voice
+struct Service{
+    std::mutex event_mutex;
+    std::condition_variable event_cond;
+    // VoiceService queue: list before, deque now
+    std::list<voice_event_t*> legacy_events;
+    std::deque<voice_event_t*> events;
+    bool pooled;
+    bool done = false;
+    Counter proxy_counter;
+    Counter callback_counter;
+    Counter event_counter;
+    uint64_t checksum = 0;
+    uint64_t data_events = 0;
+
+    void voice_event_callback(voice_event_t* voice_event){
+        uint64_t base = thread_allocs;
+        voice_event_t* event = voice_event;
+        if(pooled){
+            siren_event_ref(voice_event);
+        }else{
+            int32_t len = voice_event->length > 0 ? voice_event->length : 0;
+            char* temp = new char[sizeof(voice_event_t) + len];
+            event = (voice_event_t*)temp;
+            callback_counter.copy(event, voice_event, sizeof(voice_event_t));
+            if(HAS_VOICE(event->flag) && len){
+                callback_counter.copy(temp + sizeof(voice_event_t), voice_event->buff, len);
+                event->buff = temp + sizeof(voice_event_t);
+            }
+        }
+        std::lock_guard<std::mutex> lg(event_mutex);
+        if(pooled) events.push_back(event);
+        else legacy_events.push_back(event);
+        event_cond.notify_one();
+        callback_counter.allocs += thread_allocs - base;
+    }
+
+    void on_event(){
+        std::unique_lock<std::mutex> lk(event_mutex, std::defer_lock);
+        while(true){
+            lk.lock();
+            event_cond.wait(lk, [this]{return !events.empty() || !legacy_events.empty() || done;});
+            voice_event_t* event = nullptr;
+            if(!events.empty()){
+                event = events.front();
+                events.pop_front();
+            }else if(!legacy_events.empty()){
+                event = legacy_events.front();
+                legacy_events.pop_front();
+            }
+            lk.unlock();
+            if(event == nullptr) break;
+            if(event->event == SIREN_EVENT_VAD_DATA && HAS_VOICE(event->flag)){
+                const uint8_t* p = (const uint8_t*)event->buff;
+                for(int i = 0; i < event->length; i += 16) checksum = checksum * 131 + p[i];
+                data_events++;
+            }
+            if(pooled) siren_event_unref(event);
+            else delete [] (char*)event;
+        }
+        event_counter.allocs = thread_allocs;
+    }
+};
+
+static voice_event_t* fill_event(voice_event_t* voice_event, Message* msg){
+    ProcessedVoiceResult* p = (ProcessedVoiceResult*)msg->data;
+    p->data = p->size ? (char*)p + sizeof(ProcessedVoiceResult) : nullptr;
+    voice_event->event = (siren_event_t)p->prop;
+    voice_event->length = p->size;
+    voice_event->background_energy = p->background_energy;
+    voice_event->background_threshold = p->background_threshold;
+    if(p->hasVoice == 1){
+        voice_event->flag |= VOICE_MASK;
+        voice_event->buff = p->data;
+    }
+    return voice_event;
+}
+
+// parent: proxy response thread
+static void read_events(SirenSocketChannel& channel, Service& service){
+    SirenSocketReader reader(&channel);
+    reader.prepareOnReadSideProcess();
+    SirenEventPool& pool = SirenEventPool::instance();
+    uint64_t base = thread_allocs;
+    while(true){
+        Message* msg = nullptr;
+        SirenEventBlock* block = nullptr;
+        if(service.pooled){
+            if(reader.pollMessage(&block) != SIREN_CHANNEL_OK) break;
+            msg = block->message();
+        }else{
+            if(reader.pollMessage(&msg) != SIREN_CHANNEL_OK) break;
+        }
+        bool destroy = msg->msg == SIREN_RESPONSE_MSG_ON_DESTROY;
+        if(msg->msg == SIREN_RESPONSE_MSG_ON_VOICE_EVENT){
+            if(service.pooled){
+                service.voice_event_callback(fill_event(&block->event, msg));
+            }else{
+                voice_event_t* voice_event = new voice_event_t;
+                memset(voice_event, 0, sizeof(voice_event_t));
+                service.voice_event_callback(fill_event(voice_event, msg));
+                delete voice_event;
+            }
+        }
+        if(service.pooled) pool.unref(block);
+        else delete [] (char*)msg;
+        if(destroy) break;
+    }
+    service.proxy_counter.allocs = thread_allocs - base - service.callback_counter.allocs;
+}
+
+static void run(bool pooled){
+    SirenSocketChannel channel(512 * 1024, 512 * 1024);
+    channel.open();
+    printf("%s\n", pooled ? "pooled" : "legacy");
+    fflush(stdout);
+    pid_t pid = fork();
+    if(pid == 0){
+        write_events(channel, pooled);
+        fflush(stdout);
+        _exit(0);
+    }
+
+    Service service;
+    service.pooled = pooled;
+    std::thread event_thread(&Service::on_event, &service);
+    steady_clock::time_point t0 = steady_clock::now();
+    read_events(channel, service);
+    {
+        std::lock_guard<std::mutex> lg(service.event_mutex);
+        service.done = true;
+        service.event_cond.notify_one();
+    }
+    event_thread.join();
+    double ms = std::chrono::duration_cast<std::chrono::microseconds>(
+            steady_clock::now() - t0).count() / 1000.0;
+    waitpid(pid, nullptr, 0);
+
+    Counter* counters[] = {&service.proxy_counter, &service.callback_counter, &service.event_counter};
+    const char* names[] = {"proxy response", "event callback", "onEvent"};
+    Counter total;
+    for(int i = 0; i < 3; i++){
+        printf("  %-15s allocs %8llu  copies %8llu  bytes %10llu\n", names[i],
+                (unsigned long long)counters[i]->allocs, (unsigned long long)counters[i]->copies,
+                (unsigned long long)counters[i]->copy_bytes);
+        total.allocs += counters[i]->allocs;
+        total.copies += counters[i]->copies;
+        total.copy_bytes += counters[i]->copy_bytes;
+    }
+    double audio_seconds = (double)audio_bytes / second_bytes;
+    printf("  %llu events, %.1f audio seconds, %.1fms, checksum %016llx\n",
+            (unsigned long long)events.size(), audio_seconds, ms,
+            (unsigned long long)service.checksum);
+    printf("  service process per audio second: allocs %.1f copies %.1f bytes %.0f\n",
+            total.allocs / audio_seconds, total.copies / audio_seconds,
+            total.copy_bytes / audio_seconds);
+    if(pooled){
+        SirenEventPoolStat stat;
+        SirenEventPool::instance().getStat(stat);
+        printf("  pool allocated %llu reused %llu outstanding %u cached %u\n",
+                (unsigned long long)stat.allocated, (unsigned long long)stat.reused,
+                stat.outstanding, stat.cached);
+    }
+}
+
+int main(int argc, char** argv){
+    int i;
+    for(i = 1; i + 1 < argc; i += 2){
+        string a = argv[i];
+        if(a == "--pcm") pcm_path = argv[i + 1];
+        else if(a == "--frame") frame_bytes = atoi(argv[i + 1]);
+        else if(a == "--rate") second_bytes = atoi(argv[i + 1]);
+        else if(a == "--seconds") seconds = atoi(argv[i + 1]);
+        else if(a == "--speed") speed = atoi(argv[i + 1]);
+        else break;
+    }
+    if(i < argc || frame_bytes == 0 || second_bytes == 0){
+        printf("usage: %s [--pcm file] [--frame bytes] [--rate bytes per second] [--seconds n] [--speed n]\n", argv[0]);
+        return 1;
+    }
+    load_events();
+    run(false);
+    run(true);
+    return 0;
+}
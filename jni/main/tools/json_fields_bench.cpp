@@ -0,0 +1,127 @@
+// Compare JsonFields with full json-c parse (json_tokener_parse +
+// json_object_object_get_ex) reading top level fields of nlp like
+// payloads from 1KB to 50KB, and check both give same values,
+// including escaped strings and malformed documents.
+//
+// build (in jni):
+//   g++ -std=c++11 -O2 -Imain -Iblacksiren/libjsonc/include -o json_fields_bench
+//   main/tools/json_fields_bench.cpp main/JsonFields.cpp
+//   and json-c objects built from blacksiren/libjsonc/src
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "json.h"
+#include "JsonFields.h"
+
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+
+// nlp result with slots list grown to about 'size' bytes,
+// 'activation' placed first or last
+static string make_payload(uint32_t size, bool activation_last){
+    string s = "{";
+    if(!activation_last) s += "\"activation\": \"accept\", ";
+    s += "\"appId\": \"R233A4F187F34C94B93EE3BAECFCE2E3\", \"cloud\": true, "
+         "\"asr\": \"\\u64ad\\u653e\\u5468\\u6770\\u4f26\\u7684\\u6b4c\", "
+         "\"intent\": \"play_song\", \"pattern\": \"($play)($singer)\\u7684\\u6b4c\", "
+         "\"slots\": [";
+    for(uint32_t i = 0; s.length() < size; i++){
+        char buf[256];
+        snprintf(buf, sizeof(buf), "%s{\"type\": \"singer\", \"value\": \"item %u\\\"q\\\"\", "
+                 "\"score\": %u.%02u, \"tags\": [1, 2, {\"k\": null}], \"ok\": false}",
+                 i ? ", " : "", i, i % 100, i % 97);
+        s += buf;
+    }
+    s += "], \"extra\": {\"version\": \"2.0\", \"nested\": {\"a\": [[[]]]}}";
+    if(activation_last) s += ", \"activation\": \"accept\"";
+    s += ", \"confidence\": 0.93}";
+    return s;
+}
+
+static bool full_parse(const string& json, const char* key, string& value){
+    json_object *obj, *field;
+    bool ret = false;
+    obj = json_tokener_parse(json.c_str());
+    if(obj == nullptr) return false;
+    if(TRUE == json_object_object_get_ex(obj, key, &field)){
+        value = json_object_get_string(field);
+        ret = true;
+    }
+    json_object_put(obj);
+    return ret;
+}
+
+static int failures = 0;
+
+static void expect(const char* name, bool ok){
+    if(!ok){
+        printf("FAIL %s\n", name);
+        failures++;
+    }
+}
+
+static void check(){
+    JsonFields fields({"activation", "asr", "confidence", "cloud", "slots"});
+    string json = make_payload(2048, true);
+    string value;
+
+    expect("parse", fields.parse(json));
+    for(int i = 0; i < 4; i++){
+        const char* keys[] = {"activation", "asr", "confidence", "cloud"};
+        expect(keys[i], full_parse(json, keys[i], value) && fields.has(i) && fields.get(i) == value);
+    }
+    expect("slots raw", fields.has(4) && fields.get(4)[0] == '[' && !fields.is_string(4));
+    json_object* slots = json_tokener_parse(fields.get(4).c_str());
+    expect("slots json", slots && json_object_array_length(slots) > 10);
+    json_object_put(slots);
+
+    JsonFields activation({"activation"});
+    expect("missing", activation.parse("{\"nlp\": {\"activation\": \"fake\"}}") && !activation.has(0));
+    expect("empty", activation.parse(" { } ") && !activation.has(0));
+    expect("escaped", activation.parse("{\"activation\":\"a\\\\b\\u0041\"}") && activation.get(0) == "a\\bA");
+    expect("number", activation.parse("{\"activation\":-1.5e3}") && activation.get(0) == "-1.5e3");
+    const char* malformed[] = {"", "[]", "{", "{\"activation\"", "{\"activation\":}",
+        "{\"a\":[1,2}, \"activation\":\"x\"}", "{\"a\":\"unterminated, \"activation\":1",
+        "{\"a\" 1}", "{\"a\":1 \"activation\":2}", "null"};
+    for(const char* m : malformed){
+        bool ok = activation.parse(m, strlen(m));
+        expect(m, !ok && !activation.has(0));
+    }
+}
+
+static void bench(uint32_t size, bool activation_last){
+    string json = make_payload(size, activation_last);
+    uint32_t rounds = 20000000 / json.length() + 10;
+    string value;
+    JsonFields fields({"activation"});
+
+    steady_clock::time_point t0 = steady_clock::now();
+    for(uint32_t i = 0; i < rounds; i++) full_parse(json, "activation", value);
+    double full = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            steady_clock::now() - t0).count() / 1000.0 / rounds;
+
+    t0 = steady_clock::now();
+    for(uint32_t i = 0; i < rounds; i++) fields.parse(json);
+    double scan = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            steady_clock::now() - t0).count() / 1000.0 / rounds;
+
+    printf("%6zu bytes activation %-5s  json-c %9.2fus  JsonFields %8.2fus  x%.1f\n",
+            json.length(), activation_last ? "last" : "first", full, scan, full / scan);
+}
+
+int main(){
+    check();
+    uint32_t sizes[] = {1024, 4096, 16384, 51200};
+    for(uint32_t size : sizes){
+        bench(size, false);
+        bench(size, true);
+    }
+    printf("%s\n", failures ? "FAILED" : "PASS");
+    return failures ? 1 : 0;
+}
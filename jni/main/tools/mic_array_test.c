@@ -0,0 +1,259 @@
+/*
+ * Test mic_array capture on the emulated ring of pcm_file.c:
+ * reads in siren frame size are handed out from the ring without
+ * copy, misaligned reads bounce, data stays continuous across rw
+ * fallback, realtime pacing and overrun recovery.
+ *
+ * build (in jni):
+ *   gcc -O2 -Iinclude -Imain/tools -o mic_array_test main/tools/mic_array_test.c
+ *   main/tools/pcm_file.c main/mic_array.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "mic_array.h"
+#include "pcm_file.h"
+
+#define CHANNELS 8
+#define RATE 48000
+#define FRAME_BYTES (CHANNELS * 4)
+/* 10ms, siren default */
+#define READ_BYTES (RATE / 100 * FRAME_BYTES)
+#define SOURCE_FRAMES (RATE * 2)
+
+static int failures = 0;
+/* next expected frame index of source */
+static uint32_t expect_frame;
+
+#define EXPECT(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+static void make_source(const char *path)
+{
+    FILE *fp = fopen(path, "wb");
+    int32_t frame[CHANNELS];
+    uint32_t i, c;
+
+    for (i = 0; i < SOURCE_FRAMES; i++) {
+        for (c = 0; c < CHANNELS; c++)
+            frame[c] = (int32_t)(i * CHANNELS + c);
+        fwrite(frame, sizeof(frame), 1, fp);
+    }
+    fclose(fp);
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* frames of pattern follow each other */
+static int check(const char *buff, unsigned int bytes)
+{
+    const int32_t *s = (const int32_t *)buff;
+    unsigned int frames = bytes / FRAME_BYTES;
+    unsigned int i, c;
+
+    for (i = 0; i < frames; i++) {
+        for (c = 0; c < CHANNELS; c++) {
+            if (s[i * CHANNELS + c] != (int32_t)(expect_frame * CHANNELS + c)) {
+                printf("  frame %u ch %u got %d expect %u\n", i, c,
+                       s[i * CHANNELS + c], expect_frame * CHANNELS + c);
+                return -1;
+            }
+        }
+        expect_frame = (expect_frame + 1) % SOURCE_FRAMES;
+    }
+    return 0;
+}
+
+static struct mic_array_device_t *open_device(unsigned int read_bytes)
+{
+    struct mic_array_device_t *dev = NULL;
+
+    if (mic_array_device_open(&dev) != 0)
+        return NULL;
+    if (read_bytes != READ_BYTES)
+        dev->config_stream(dev, MIC_ARRAY_CMD_SET_FRAME_SIZE, (char *)&read_bytes);
+    if (dev->start_stream(dev) != 0) {
+        free(dev);
+        return NULL;
+    }
+    expect_frame = 0;
+    return dev;
+}
+
+static void get_stat(struct mic_array_device_t *dev, struct mic_array_stat_t *stat)
+{
+    dev->config_stream(dev, MIC_ARRAY_CMD_GET_STAT, (char *)stat);
+}
+
+static void test_direct(const char *source, unsigned int read_bytes)
+{
+    struct mic_array_device_t *dev;
+    struct mic_array_stat_t stat;
+    unsigned int i, reads = 3000;
+    char *frame;
+    double t0, ms;
+
+    pcm_file_set_source(source, 0, 1);
+    dev = open_device(read_bytes);
+    EXPECT(dev != NULL, "open");
+    if (dev == NULL)
+        return;
+    EXPECT(dev->period_size % (read_bytes / FRAME_BYTES) == 0,
+           "period %u not multiple of read %u", dev->period_size, read_bytes / FRAME_BYTES);
+    t0 = now_ms();
+    for (i = 0; i < reads; i++) {
+        if (dev->acquire_stream(dev, &frame, read_bytes) != 0) {
+            EXPECT(0, "acquire %u", i);
+            break;
+        }
+        if (check(frame, read_bytes) != 0) {
+            EXPECT(0, "data at read %u", i);
+            break;
+        }
+        dev->release_stream(dev, read_bytes);
+    }
+    ms = now_ms() - t0;
+    get_stat(dev, &stat);
+    EXPECT(stat.direct == reads && stat.bounced == 0,
+           "direct %llu bounced %llu", stat.direct, stat.bounced);
+    printf("direct   read %5u bytes period %4u: %u reads, %.0f MB/s, %.0fx realtime\n",
+           read_bytes, dev->period_size, reads,
+           reads * (double)read_bytes / 1048576 / (ms / 1000),
+           reads * (double)(read_bytes / FRAME_BYTES) / RATE * 1000 / ms);
+    dev->stop_stream(dev);
+    free(dev);
+}
+
+/* half read shifts every later read across the ring end now and then */
+static void test_misaligned(const char *source)
+{
+    struct mic_array_device_t *dev;
+    struct mic_array_stat_t stat;
+    unsigned int i;
+    char *frame;
+
+    pcm_file_set_source(source, 0, 1);
+    dev = open_device(READ_BYTES);
+    if (dev == NULL) {
+        EXPECT(0, "open");
+        return;
+    }
+    for (i = 0; i < 1000; i++) {
+        unsigned int bytes = i == 0 ? READ_BYTES / 2 : READ_BYTES;
+        if (dev->acquire_stream(dev, &frame, bytes) != 0 || check(frame, bytes) != 0) {
+            EXPECT(0, "misaligned read %u", i);
+            break;
+        }
+        dev->release_stream(dev, bytes);
+    }
+    get_stat(dev, &stat);
+    EXPECT(stat.bounced > 0 && stat.direct > 0, "direct %llu bounced %llu", stat.direct, stat.bounced);
+    printf("misalign direct %llu bounced %llu\n", stat.direct, stat.bounced);
+    dev->stop_stream(dev);
+    free(dev);
+}
+
+/* read_stream as siren does, mmap and rw */
+static void test_read(const char *source, int mmap)
+{
+    struct mic_array_device_t *dev;
+    char *buff = (char *)malloc(READ_BYTES * 3);
+    unsigned int i;
+
+    pcm_file_set_source(source, 0, mmap);
+    dev = open_device(READ_BYTES);
+    if (dev == NULL) {
+        EXPECT(0, "open");
+        free(buff);
+        return;
+    }
+    for (i = 0; i < 500; i++) {
+        unsigned int bytes = (i % 3 + 1) * READ_BYTES;
+        if (dev->read_stream(dev, buff, bytes) != 0 || check(buff, bytes) != 0) {
+            EXPECT(0, "%s read %u", mmap ? "mmap" : "rw", i);
+            break;
+        }
+    }
+    printf("read     %s ok\n", mmap ? "mmap" : "rw  ");
+    dev->stop_stream(dev);
+    free(dev);
+    free(buff);
+}
+
+static void test_realtime(const char *source)
+{
+    struct mic_array_device_t *dev;
+    struct mic_array_stat_t stat;
+    unsigned int i, reads = 100;
+    char *frame;
+    double t0, ms;
+
+    pcm_file_set_source(source, 1, 1);
+    dev = open_device(READ_BYTES);
+    if (dev == NULL) {
+        EXPECT(0, "open");
+        return;
+    }
+    t0 = now_ms();
+    for (i = 0; i < reads; i++) {
+        if (dev->acquire_stream(dev, &frame, READ_BYTES) != 0 || check(frame, READ_BYTES) != 0) {
+            EXPECT(0, "realtime read %u", i);
+            break;
+        }
+        dev->release_stream(dev, READ_BYTES);
+    }
+    ms = now_ms() - t0;
+    /* first read waits for start threshold of one period */
+    EXPECT(ms > reads * 10 - 30 && ms < reads * 10 + 60, "%u reads of 10ms in %.1fms", reads, ms);
+    printf("realtime %u reads of 10ms in %.1fms\n", reads, ms);
+
+    /* stall longer than the ring */
+    usleep(dev->period_size * dev->period_count * 1000000ULL / RATE + 50000);
+    EXPECT(dev->acquire_stream(dev, &frame, READ_BYTES) == 0, "read after overrun");
+    dev->release_stream(dev, READ_BYTES);
+    get_stat(dev, &stat);
+    EXPECT(stat.xruns == 1, "xruns %llu", stat.xruns);
+    printf("realtime overrun recovered, xruns %llu\n", stat.xruns);
+    dev->stop_stream(dev);
+    free(dev);
+}
+
+int main(void)
+{
+    char source[] = "/tmp/mic_array_testXXXXXX";
+    int fd = mkstemp(source);
+
+    if (fd < 0) {
+        printf("mkstemp failed\n");
+        return 1;
+    }
+    close(fd);
+    make_source(source);
+
+    test_direct(source, READ_BYTES);
+    test_direct(source, RATE * 16 / 1000 * FRAME_BYTES);
+    test_direct(source, RATE * 7 / 1000 * FRAME_BYTES);
+    test_misaligned(source);
+    test_read(source, 1);
+    test_read(source, 0);
+    test_realtime(source);
+
+    unlink(source);
+    printf("%s\n", failures ? "FAILED" : "PASS");
+    return failures ? 1 : 0;
+}
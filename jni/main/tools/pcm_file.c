@@ -0,0 +1,314 @@
+/*
+ * Emulated tinyalsa capture over a file, see pcm_file.h.
+ * hw_ptr and appl_ptr count frames since prepare, the ring holds
+ * period_size * period_count frames. capture stops with overrun when
+ * the ring is full, as with default stop_threshold.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "asoundlib.h"
+#include "pcm_file.h"
+
+struct pcm {
+    struct pcm_config config;
+    unsigned int flags;
+    int ready;
+    int running;
+    int xrun;
+    unsigned int frame_bytes;
+    unsigned int buffer_size;
+    char *ring;
+    unsigned long long hw_ptr;
+    unsigned long long appl_ptr;
+    /* hw_ptr and time at start */
+    unsigned long long start_ptr;
+    struct timespec start_time;
+    size_t source_pos;
+    char error[128];
+};
+
+static char *source;
+static size_t source_size;
+static int source_realtime;
+static int source_mmap = 1;
+
+int pcm_file_set_source(const char *path, int realtime, int mmap)
+{
+    FILE *fp = fopen(path, "rb");
+    long size;
+
+    if (fp == NULL)
+        return -1;
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    free(source);
+    source = NULL;
+    source_size = 0;
+    if (size > 0 && (source = (char *)malloc(size)) != NULL
+        && fread(source, 1, size, fp) == (size_t)size)
+        source_size = size;
+    fclose(fp);
+    source_realtime = realtime;
+    source_mmap = mmap;
+    return source_size ? 0 : -1;
+}
+
+static unsigned long long now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static unsigned long long elapsed_us(struct pcm *pcm)
+{
+    return now_us() - (pcm->start_time.tv_sec * 1000000ULL + pcm->start_time.tv_nsec / 1000);
+}
+
+/* dma writes one period at hw_ptr */
+static void capture_period(struct pcm *pcm)
+{
+    unsigned int bytes = pcm->config.period_size * pcm->frame_bytes;
+    char *to = pcm->ring + (pcm->hw_ptr % pcm->buffer_size) * pcm->frame_bytes;
+    unsigned int n;
+
+    while (bytes > 0) {
+        n = bytes;
+        if (n > source_size - pcm->source_pos)
+            n = source_size - pcm->source_pos;
+        memcpy(to, source + pcm->source_pos, n);
+        to += n;
+        bytes -= n;
+        pcm->source_pos = (pcm->source_pos + n) % source_size;
+    }
+    pcm->hw_ptr += pcm->config.period_size;
+}
+
+static void update_hw(struct pcm *pcm)
+{
+    unsigned long long target;
+    unsigned int period = pcm->config.period_size;
+
+    if (!pcm->running || pcm->xrun)
+        return;
+    if (source_realtime)
+        target = pcm->start_ptr
+            + elapsed_us(pcm) * pcm->config.rate / 1000000 / period * period;
+    else
+        target = pcm->appl_ptr + pcm->buffer_size - period;
+    while (pcm->hw_ptr + period <= target) {
+        capture_period(pcm);
+        if (pcm->hw_ptr - pcm->appl_ptr >= pcm->buffer_size) {
+            pcm->xrun = 1;
+            pcm->running = 0;
+            break;
+        }
+    }
+}
+
+struct pcm *pcm_open(unsigned int card, unsigned int device,
+                     unsigned int flags, struct pcm_config *config)
+{
+    struct pcm *pcm = (struct pcm *)calloc(1, sizeof(struct pcm));
+
+    if (pcm == NULL)
+        return NULL;
+    pcm->config = *config;
+    pcm->flags = flags;
+    if (source_size == 0) {
+        snprintf(pcm->error, sizeof(pcm->error), "no source for card %u device %u", card, device);
+        return pcm;
+    }
+    if ((flags & PCM_MMAP) && !source_mmap) {
+        snprintf(pcm->error, sizeof(pcm->error), "mmap not supported");
+        return pcm;
+    }
+    pcm->frame_bytes = config->channels * pcm_format_to_bits(config->format) / 8;
+    pcm->buffer_size = config->period_size * config->period_count;
+    pcm->ring = (char *)calloc(pcm->buffer_size, pcm->frame_bytes);
+    if (pcm->ring == NULL || pcm->frame_bytes == 0 || pcm->buffer_size == 0) {
+        snprintf(pcm->error, sizeof(pcm->error), "invalid config");
+        return pcm;
+    }
+    pcm->ready = 1;
+    return pcm;
+}
+
+int pcm_close(struct pcm *pcm)
+{
+    if (pcm == NULL)
+        return -EINVAL;
+    free(pcm->ring);
+    free(pcm);
+    return 0;
+}
+
+int pcm_is_ready(struct pcm *pcm)
+{
+    return pcm != NULL && pcm->ready;
+}
+
+const char *pcm_get_error(struct pcm *pcm)
+{
+    return pcm ? pcm->error : "null pcm";
+}
+
+unsigned int pcm_format_to_bits(enum pcm_format format)
+{
+    switch (format) {
+    case PCM_FORMAT_S32_LE:
+    case PCM_FORMAT_S24_LE:
+        return 32;
+    case PCM_FORMAT_S24_3LE:
+        return 24;
+    case PCM_FORMAT_S8:
+        return 8;
+    default:
+        return 16;
+    }
+}
+
+unsigned int pcm_get_buffer_size(struct pcm *pcm)
+{
+    return pcm->buffer_size;
+}
+
+unsigned int pcm_frames_to_bytes(struct pcm *pcm, unsigned int frames)
+{
+    return frames * pcm->frame_bytes;
+}
+
+unsigned int pcm_bytes_to_frames(struct pcm *pcm, unsigned int bytes)
+{
+    return bytes / pcm->frame_bytes;
+}
+
+int pcm_prepare(struct pcm *pcm)
+{
+    pcm->running = 0;
+    pcm->xrun = 0;
+    pcm->hw_ptr = 0;
+    pcm->appl_ptr = 0;
+    return 0;
+}
+
+int pcm_start(struct pcm *pcm)
+{
+    if (!pcm->ready || pcm->xrun) {
+        snprintf(pcm->error, sizeof(pcm->error), "cannot start");
+        return -EBADFD;
+    }
+    pcm->running = 1;
+    pcm->start_ptr = pcm->hw_ptr;
+    clock_gettime(CLOCK_MONOTONIC, &pcm->start_time);
+    return 0;
+}
+
+int pcm_stop(struct pcm *pcm)
+{
+    pcm->running = 0;
+    return 0;
+}
+
+int pcm_mmap_avail(struct pcm *pcm)
+{
+    update_hw(pcm);
+    if (pcm->xrun) {
+        snprintf(pcm->error, sizeof(pcm->error), "overrun");
+        return -EPIPE;
+    }
+    return (int)(pcm->hw_ptr - pcm->appl_ptr);
+}
+
+int pcm_wait(struct pcm *pcm, int timeout)
+{
+    unsigned int avail_min = pcm->config.avail_min > 0 ? pcm->config.avail_min : pcm->config.period_size;
+    unsigned long long deadline = now_us() + timeout * 1000ULL;
+    int avail;
+
+    while ((avail = pcm_mmap_avail(pcm)) < (int)avail_min) {
+        struct timespec ts = {0, 1000000};
+        if (avail < 0)
+            return avail;
+        if (!pcm->running)
+            return -EBADFD;
+        if (now_us() >= deadline)
+            return 0;
+        if (source_realtime)
+            nanosleep(&ts, NULL);
+    }
+    return 1;
+}
+
+int pcm_mmap_begin(struct pcm *pcm, void **areas, unsigned int *offset,
+                   unsigned int *frames)
+{
+    int avail = pcm_mmap_avail(pcm);
+    unsigned int contiguous;
+
+    if (avail < 0)
+        return avail;
+    *areas = pcm->ring;
+    *offset = pcm->appl_ptr % pcm->buffer_size;
+    contiguous = pcm->buffer_size - *offset;
+    if (*frames > (unsigned int)avail)
+        *frames = avail;
+    if (*frames > contiguous)
+        *frames = contiguous;
+    return 0;
+}
+
+int pcm_mmap_commit(struct pcm *pcm, unsigned int offset, unsigned int frames)
+{
+    if (offset != pcm->appl_ptr % pcm->buffer_size
+        || pcm->appl_ptr + frames > pcm->hw_ptr) {
+        snprintf(pcm->error, sizeof(pcm->error), "bad commit");
+        return -EINVAL;
+    }
+    pcm->appl_ptr += frames;
+    return frames;
+}
+
+/* read and mmap_read are the same on the emulated ring */
+static int transfer(struct pcm *pcm, void *data, unsigned int count)
+{
+    unsigned int frames = count / pcm->frame_bytes;
+    char *to = (char *)data;
+    void *areas;
+    unsigned int offset, n;
+    int ret;
+
+    if (!pcm->running && !pcm->xrun && (ret = pcm_start(pcm)) != 0)
+        return ret;
+    while (frames > 0) {
+        if ((ret = pcm_wait(pcm, 1000)) <= 0)
+            return ret ? ret : -ETIMEDOUT;
+        n = frames;
+        if ((ret = pcm_mmap_begin(pcm, &areas, &offset, &n)) < 0)
+            return ret;
+        memcpy(to, (char *)areas + offset * pcm->frame_bytes, n * pcm->frame_bytes);
+        pcm_mmap_commit(pcm, offset, n);
+        to += n * pcm->frame_bytes;
+        frames -= n;
+    }
+    return 0;
+}
+
+int pcm_read(struct pcm *pcm, void *data, unsigned int count)
+{
+    if (pcm->flags & PCM_MMAP)
+        return -ENOSYS;
+    return transfer(pcm, data, count);
+}
+
+int pcm_mmap_read(struct pcm *pcm, void *data, unsigned int count)
+{
+    if (!(pcm->flags & PCM_MMAP))
+        return -ENOSYS;
+    return transfer(pcm, data, count);
+}
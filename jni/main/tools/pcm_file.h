@@ -0,0 +1,27 @@
+/*
+ * Host emulation of the tinyalsa capture api used by mic_array.c.
+ * A capture ring is filled period by period from a file of raw
+ * interleaved frames, as dma would, so mic_array can be built and
+ * tested on linux without audio hardware.
+ */
+#ifndef PCM_FILE_H
+#define PCM_FILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * source for next pcm_open, frames in opened config format, looped.
+ * realtime: dma advances by wall clock at config rate, otherwise
+ * periods are captured as soon as ring has room.
+ * mmap: 0 to fail pcm_open with PCM_MMAP.
+ * return 0 if file loaded
+ */
+int pcm_file_set_source(const char *path, int realtime, int mmap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
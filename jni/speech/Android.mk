@@ -17,7 +17,8 @@ LOCAL_C_INCLUDES := \
 	$(LOCAL_PATH)/include/$(ANDROID_VERSION) \
 	$(MY_LOCAL_PATH)/proto \
 	$(MY_LOCAL_PATH)/include \
-	$(MY_LOCAL_PATH)/src/common
+	$(MY_LOCAL_PATH)/src/common \
+	$(MY_LOCAL_PATH)/../include
 
 COMMON_SRC := \
 	$(MY_LOCAL_PATH)/proto/speech_types.pb.cc \
@@ -26,10 +27,14 @@ COMMON_SRC := \
 	$(MY_LOCAL_PATH)/proto/speech.pb.cc \
 	$(MY_LOCAL_PATH)/src/common/log.cc \
 	$(MY_LOCAL_PATH)/src/common/log.h \
+	$(MY_LOCAL_PATH)/src/common/recv_buffer_pool.cc \
+	$(MY_LOCAL_PATH)/src/common/recv_buffer_pool.h \
 	$(MY_LOCAL_PATH)/src/common/speech_connection.cc \
 	$(MY_LOCAL_PATH)/src/common/speech_connection.h
 
 TTS_SRC := \
+	$(MY_LOCAL_PATH)/src/tts/tts_cache.cc \
+	$(MY_LOCAL_PATH)/src/tts/tts_cache.h \
 	$(MY_LOCAL_PATH)/src/tts/tts_impl.cc \
 	$(MY_LOCAL_PATH)/src/tts/tts_impl.h \
 	$(MY_LOCAL_PATH)/src/tts/types.h
@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
 #include <memory>
 #include "speech_types.h"
 
@@ -52,6 +53,14 @@ public:
 	virtual void set_codec(Codec codec) = 0;
 	// default declaimer "zh"
 	virtual void set_declaimer(const std::string& declaimer) = 0;
+	// voice cache, key is text and codec, declaimer
+	// param 'max_bytes': max bytes of cached voice in memory,
+	//                    default 0, cache disabled
+	// param 'dir': voice of Tts.prefetch stored to this directory,
+	//              loaded when not found in memory. empty: no store
+	// voice cached for a week is still played, and synthesised again
+	// in background like Tts.prefetch
+	virtual void set_cache(uint32_t max_bytes, const std::string& dir) = 0;
 
 	static std::shared_ptr<TtsOptions> new_instance();
 };
@@ -70,6 +79,11 @@ public:
 	//           <= 0  cancel all tts requests
 	virtual void cancel(int32_t id) = 0;
 
+	// synthesise 'texts' and put voice to cache, without results
+	// requests sent when no 'speak' requests pending
+	// no effect if cache disabled, see TtsOptions.set_cache
+	virtual void prefetch(const std::vector<std::string>& texts) = 0;
+
 	// poll tts results
 	// block current thread if no result available
 	// if Tts.release() invoked, poll() will return -1
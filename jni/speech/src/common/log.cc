@@ -1,62 +1,156 @@
 #include <stdio.h>
-#include <chrono>
-#include <sys/time.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <pthread.h>
+#include <thread>
+#include <chrono>
+#include <new>
 #include "log.h"
 
 #ifdef SPEECH_LOG_ANDROID
 #include <android/log.h>
 #endif
 
+using std::mutex;
+using std::lock_guard;
+using log_ring::LogRing;
+using log_ring::LogRecord;
+using log_ring::now_us;
+
 namespace rokid {
 namespace speech {
 
-Log* Log::instance_ = NULL;
+static pthread_key_t ring_key_;
+static pthread_once_t ring_key_once_ = PTHREAD_ONCE_INIT;
 
-Log::Log() {
+static void orphan_ring(void* ring) {
+	reinterpret_cast<LogRing*>(ring)->orphaned.store(true,
+			std::memory_order_release);
+}
+
+static void create_ring_key() {
+	pthread_key_create(&ring_key_, orphan_ring);
+}
+
+static void flush_at_exit() {
+	Log::flush();
+}
+
+Log::Log() : rings_(NULL), async_(true), drain_started_(false),
+	file_(NULL), written_(0), dropped_(0), threads_(0) {
+	waker_.init();
+	pthread_atfork(NULL, NULL, fork_child);
 }
 
 Log* Log::instance() {
-	if (instance_ == NULL)
-		instance_ = new Log();
-	return instance_;
+	// never deleted, logs may be written by static destructors
+	static Log* instance = new Log();
+	return instance;
 }
 
-void Log::v(const char* tag, const char* fmt, ...) {
-	va_list ap;
-	va_start(ap, fmt);
-	instance()->p(Verbose, tag, fmt, ap);
-	va_end(ap);
+void Log::set_async(bool async) {
+	Log* log = instance();
+	if (!async)
+		log->flush();
+	log->async_.store(async);
 }
 
-void Log::d(const char* tag, const char* fmt, ...) {
-	va_list ap;
-	va_start(ap, fmt);
-	instance()->p(Debug, tag, fmt, ap);
-	va_end(ap);
+void Log::set_file(const char* path) {
+	Log* log = instance();
+	log->flush();
+	lock_guard<mutex> locker(log->mutex_);
+	if (log->file_)
+		fclose(log->file_);
+	log->file_ = NULL;
+	if (path)
+		log->file_ = fopen(path, "a");
 }
 
-void Log::i(const char* tag, const char* fmt, ...) {
-	va_list ap;
-	va_start(ap, fmt);
-	instance()->p(Info, tag, fmt, ap);
-	va_end(ap);
+void Log::flush() {
+	Log* log = instance();
+	while (log->drain());
 }
 
-void Log::w(const char* tag, const char* fmt, ...) {
-	va_list ap;
-	va_start(ap, fmt);
-	instance()->p(Warning, tag, fmt, ap);
-	va_end(ap);
+void Log::get_stat(LogStat& stat) {
+	Log* log = instance();
+	lock_guard<mutex> locker(log->mutex_);
+	lock_guard<mutex> rings_locker(log->rings_mutex_);
+	stat.written = log->written_;
+	stat.dropped = log->dropped_;
+	stat.threads = log->threads_;
 }
 
-void Log::e(const char* tag, const char* fmt, ...) {
+void Log::p(LogLevel level, const char* tag, const char* fmt, ...) {
 	va_list ap;
 	va_start(ap, fmt);
-	instance()->p(Error, tag, fmt, ap);
+	if (level < 0 || level >= MaxLogLevel)
+		level = Debug;
+	if (async_.load(std::memory_order_relaxed))
+		record(level, tag, fmt, ap);
+	else {
+		char text[LOG_RING_MAX_LENGTH];
+		vsnprintf(text, sizeof(text), fmt, ap);
+		lock_guard<mutex> locker(mutex_);
+		write(level, tag, now_us(), text);
+	}
 	va_end(ap);
 }
 
+void Log::record(LogLevel level, const char* tag, const char* fmt,
+		va_list ap) {
+	LogRing* ring = thread_ring();
+	if (ring == NULL)
+		return;
+	log_ring::record(ring, waker_, level, tag, fmt, ap);
+}
+
+LogRing* Log::thread_ring() {
+	pthread_once(&ring_key_once_, create_ring_key);
+	LogRing* ring = reinterpret_cast<LogRing*>(
+			pthread_getspecific(ring_key_));
+	if (ring && drain_started_.load(std::memory_order_relaxed))
+		return ring;
+	lock_guard<mutex> locker(rings_mutex_);
+	if (ring == NULL) {
+		ring = new LogRing();
+		pthread_setspecific(ring_key_, ring);
+		ring->next = rings_;
+		rings_ = ring;
+		++threads_;
+	}
+	if (!drain_started_) {
+		static bool exit_registered = false;
+		drain_started_ = true;
+		std::thread(&Log::run_drain, this).detach();
+		if (!exit_registered) {
+			exit_registered = true;
+			atexit(flush_at_exit);
+		}
+	}
+	return ring;
+}
+
+// only forking thread exists in child process,
+// restart drain thread on next log, rings of other threads orphaned
+void Log::fork_child() {
+	Log* log = instance();
+	new (&log->mutex_) mutex();
+	new (&log->rings_mutex_) mutex();
+	pthread_once(&ring_key_once_, create_ring_key);
+	LogRing* self = reinterpret_cast<LogRing*>(
+			pthread_getspecific(ring_key_));
+	LogRing* ring;
+	for (ring = log->rings_; ring; ring = ring->next) {
+		// pending logs written by parent process
+		ring->tail.store(ring->head.load());
+		if (ring != self)
+			ring->orphaned.store(true, std::memory_order_relaxed);
+	}
+	log->waker_.reinit();
+	log->drain_started_ = false;
+}
+
 #ifdef SPEECH_LOG_ANDROID
 static uint32_t AndroidLogLevels[] = {
 	ANDROID_LOG_VERBOSE,
@@ -65,7 +159,7 @@ static uint32_t AndroidLogLevels[] = {
 	ANDROID_LOG_WARN,
 	ANDROID_LOG_ERROR
 };
-#else
+#endif
 static char PosixLogLevels[] = {
 	'V',
 	'D',
@@ -73,27 +167,79 @@ static char PosixLogLevels[] = {
 	'W',
 	'E'
 };
-#endif
 
-void Log::p(LogLevel level, const char* tag, const char* fmt, va_list ap) {
-	if (level < 0 || level >= MaxLogLevel)
-		level = Debug;
+// invoked with 'mutex_' locked
+void Log::write(LogLevel level, const char* tag, uint64_t time_us,
+		const char* text) {
+	++written_;
 #ifdef SPEECH_LOG_ANDROID
-	__android_log_vprint(AndroidLogLevels[level], tag, fmt, ap);
-#else  // posix log
-	struct timeval tv;
+	if (file_ == NULL) {
+		__android_log_write(AndroidLogLevels[level], tag, text);
+		return;
+	}
+#endif
+	time_t sec = time_us / 1000000;
 	struct tm ltm;
-	gettimeofday(&tv, NULL);
-	localtime_r(&tv.tv_sec, &ltm);
-	std::lock_guard<std::mutex> locker(mutex_);
-	printf("%c %04d-%02d-%02d %02d:%02d:%02d [%s] ",
+	localtime_r(&sec, &ltm);
+	fprintf(file_ ? file_ : stdout,
+			"%c %04d-%02d-%02d %02d:%02d:%02d.%03d [%s] %s\n",
 			PosixLogLevels[level],
-			ltm.tm_year + 1900, ltm.tm_mon, ltm.tm_mday,
+			ltm.tm_year + 1900, ltm.tm_mon + 1, ltm.tm_mday,
 			ltm.tm_hour, ltm.tm_min, ltm.tm_sec,
-			tag);
-	vprintf(fmt, ap);
-	printf("\n");
-#endif
+			(int)(time_us % 1000000 / 1000), tag, text);
+}
+
+// write recorded logs of all threads in time order
+// return false if no logs written
+bool Log::drain() {
+	lock_guard<mutex> locker(mutex_);
+	LogRing* rings;
+	LogRing* ring;
+	uint32_t count;
+	char text[LOG_RING_MAX_LENGTH];
+
+	{
+		lock_guard<mutex> rings_locker(rings_mutex_);
+		rings = rings_;
+	}
+	// rings only removed by drain, safe to iterate without lock
+	count = log_ring::drain(rings,
+			[this](const LogRecord& rec, const char* line) {
+		write((LogLevel)rec.level, rec.tag, rec.time_us, line);
+	});
+
+	for (ring = rings; ring; ring = ring->next) {
+		uint32_t dropped = ring->dropped.exchange(0,
+				std::memory_order_relaxed);
+		if (dropped) {
+			dropped_ += dropped;
+			snprintf(text, sizeof(text), "%u logs dropped, ring full",
+					dropped);
+			write(Warning, "speech.Log", now_us(), text);
+			++count;
+		}
+	}
+	if (count)
+		fflush(file_ ? file_ : stdout);
+
+	// free rings of exited threads
+	lock_guard<mutex> rings_locker(rings_mutex_);
+	threads_ -= log_ring::free_orphans(&rings_);
+	return count > 0;
+}
+
+// sleep until a thread records a log, no polling when idle
+void Log::run_drain() {
+	while (true) {
+		if (drain()) {
+			waker_.pause();
+			continue;
+		}
+		waker_.sleep([this]() {
+			lock_guard<mutex> locker(rings_mutex_);
+			return log_ring::pending(rings_);
+		});
+	}
 }
 
 } // namespace speech
@@ -1,7 +1,16 @@
 #pragma once
 
+#include <stdint.h>
+#include <stdio.h>
 #include <stdarg.h>
 #include <mutex>
+#include <atomic>
+#include "log_ring.h"
+
+// logs below this level are removed at compile time
+#ifndef SPEECH_LOG_MIN_LEVEL
+#define SPEECH_LOG_MIN_LEVEL 0
+#endif
 
 namespace rokid {
 namespace speech {
@@ -15,28 +24,95 @@ enum LogLevel {
 	MaxLogLevel
 };
 
+typedef struct {
+	// logs formatted and written to sink
+	uint64_t written;
+	// logs dropped because thread ring full
+	uint64_t dropped;
+	// threads with log ring, freed after thread exit and ring drained
+	uint32_t threads;
+} LogStat;
+
+// Logs are recorded to per-thread lock-free ring (log_ring.h) as
+// (tag, format string, raw args), formatted and written to sink
+// by background thread. 'tag' and 'fmt' must be string literals.
 class Log {
 public:
-	static void v(const char* tag, const char* fmt, ...);
+	template <typename... Args>
+	static inline void v(const char* tag, const char* fmt, Args... args) {
+		if (Verbose >= SPEECH_LOG_MIN_LEVEL)
+			instance()->p(Verbose, tag, fmt, args...);
+	}
+
+	template <typename... Args>
+	static inline void d(const char* tag, const char* fmt, Args... args) {
+		if (Debug >= SPEECH_LOG_MIN_LEVEL)
+			instance()->p(Debug, tag, fmt, args...);
+	}
+
+	template <typename... Args>
+	static inline void i(const char* tag, const char* fmt, Args... args) {
+		if (Info >= SPEECH_LOG_MIN_LEVEL)
+			instance()->p(Info, tag, fmt, args...);
+	}
+
+	template <typename... Args>
+	static inline void w(const char* tag, const char* fmt, Args... args) {
+		if (Warning >= SPEECH_LOG_MIN_LEVEL)
+			instance()->p(Warning, tag, fmt, args...);
+	}
+
+	template <typename... Args>
+	static inline void e(const char* tag, const char* fmt, Args... args) {
+		if (Error >= SPEECH_LOG_MIN_LEVEL)
+			instance()->p(Error, tag, fmt, args...);
+	}
 
-	static void d(const char* tag, const char* fmt, ...);
+	// param 'async': false, format and write log on caller thread
+	static void set_async(bool async);
 
-	static void i(const char* tag, const char* fmt, ...);
+	// write logs to file instead of stdout/android log
+	// param 'path': NULL, restore default sink
+	static void set_file(const char* path);
 
-	static void w(const char* tag, const char* fmt, ...);
+	// write all recorded logs to sink
+	static void flush();
 
-	static void e(const char* tag, const char* fmt, ...);
+	static void get_stat(LogStat& stat);
 
 private:
 	Log();
 
 	static Log* instance();
 
-	void p(LogLevel level, const char* tag, const char* fmt, va_list ap);
+	void p(LogLevel level, const char* tag, const char* fmt, ...);
+
+	void record(LogLevel level, const char* tag, const char* fmt,
+			va_list ap);
+
+	void write(LogLevel level, const char* tag, uint64_t time_us,
+			const char* text);
+
+	log_ring::LogRing* thread_ring();
+
+	bool drain();
+
+	void run_drain();
+
+	static void fork_child();
 
 private:
-	static Log* instance_;
+	// lock for sink and drain
 	std::mutex mutex_;
+	std::mutex rings_mutex_;
+	log_ring::LogRing* rings_;
+	log_ring::LogWaker waker_;
+	std::atomic<bool> async_;
+	std::atomic<bool> drain_started_;
+	FILE* file_;
+	uint64_t written_;
+	uint64_t dropped_;
+	uint32_t threads_;
 };
 
 } // namespace speech
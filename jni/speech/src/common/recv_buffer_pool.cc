@@ -0,0 +1,278 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <new>
+#include "recv_buffer_pool.h"
+#include "log.h"
+
+#define POOL_TAG "speech.RecvBufferPool"
+// payload bytes of smallest size class
+#define CLASS_MIN 1024
+// frames up to COPY_MAX bytes copied out of receive buffer
+#define COPY_MAX 0x10000
+// max idle bytes retained of classes under full capacity
+#define RETAIN_BYTES 0x80000
+// min idle buffers retained of a class frames go to
+#define MIN_RETAIN 2
+// recalculate retain count every RETAIN_WINDOW frames
+#define RETAIN_WINDOW 64
+
+using std::mutex;
+using std::lock_guard;
+
+namespace rokid {
+namespace speech {
+
+void RecvSlice::reset() {
+	if (buf_ == NULL)
+		return;
+	if (buf_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		buf_->pool->recycle(buf_);
+	buf_ = NULL;
+}
+
+RecvBufferPool::RecvBufferPool() : capacity_(0), outstanding_(0),
+	idle_bytes_(0), window_frames_(0), window_max_frame_(0),
+	max_frame_(0), avg_frame_(0), allocated_(0), reused_(0), trimmed_(0),
+	copied_(0) {
+}
+
+RecvBufferPool::~RecvBufferPool() {
+	clear();
+	if (outstanding_ > 0)
+		Log::w(POOL_TAG, "pool destroyed with %u buffers outstanding",
+				outstanding_);
+}
+
+void RecvBufferPool::initialize(uint32_t capacity) {
+	lock_guard<mutex> locker(mutex_);
+	if (capacity == capacity_)
+		return;
+	// buffers of old capacity not reusable, outstanding ones freed
+	// when returned
+	free_idle();
+	classes_.clear();
+	capacity_ = capacity;
+	uint32_t size = CLASS_MIN;
+	SizeClass sc;
+	sc.outstanding = 0;
+	sc.peak_outstanding = 0;
+	sc.retain = MIN_RETAIN;
+	while (size < capacity) {
+		sc.size = size;
+		classes_.push_back(sc);
+		size <<= 1;
+	}
+	sc.size = capacity;
+	// receive buffer of connection, one kept for reconnect
+	sc.retain = 1;
+	classes_.push_back(sc);
+}
+
+void RecvBufferPool::clear() {
+	lock_guard<mutex> locker(mutex_);
+	free_idle();
+	size_t i;
+	for (i = 0; i < classes_.size(); ++i)
+		classes_[i].peak_outstanding = classes_[i].outstanding;
+	window_frames_ = 0;
+	window_max_frame_ = 0;
+}
+
+void RecvBufferPool::free_idle() {
+	size_t i, j;
+	for (i = 0; i < classes_.size(); ++i) {
+		for (j = 0; j < classes_[i].idle.size(); ++j)
+			free_buffer(classes_[i].idle[j]);
+		classes_[i].idle.clear();
+	}
+	idle_bytes_ = 0;
+}
+
+int32_t RecvBufferPool::class_of_capacity(uint32_t capacity) const {
+	size_t i;
+	for (i = 0; i < classes_.size(); ++i) {
+		if (classes_[i].size == capacity)
+			return i;
+	}
+	return -1;
+}
+
+int32_t RecvBufferPool::class_of_length(uint32_t length) const {
+	size_t i;
+	for (i = 0; i < classes_.size(); ++i) {
+		if (classes_[i].size >= length)
+			return i;
+	}
+	return -1;
+}
+
+RecvSlice RecvBufferPool::obtain(uint32_t length) {
+	RecvBuffer* buf;
+	lock_guard<mutex> locker(mutex_);
+	int32_t k = length == 0 ? -1 : class_of_length(length);
+	if (length > 0 && k < 0) {
+		Log::e(POOL_TAG, "obtain %u bytes over capacity %u", length, capacity_);
+		return RecvSlice();
+	}
+	if (k < 0 || classes_[k].idle.empty()) {
+		uint32_t size = k < 0 ? 0 : classes_[k].size;
+		buf = alloc_buffer(this, size);
+		if (buf == NULL) {
+			Log::e(POOL_TAG, "alloc buffer of %u bytes failed", size);
+			return RecvSlice();
+		}
+		++allocated_;
+	} else {
+		buf = classes_[k].idle.back();
+		classes_[k].idle.pop_back();
+		idle_bytes_ -= buf->capacity;
+		++reused_;
+	}
+	buf->refs.store(1, std::memory_order_relaxed);
+	buf->length = 0;
+	buf->type = 0;
+	++outstanding_;
+	if (k >= 0) {
+		SizeClass& sc = classes_[k];
+		if (++sc.outstanding > sc.peak_outstanding)
+			sc.peak_outstanding = sc.outstanding;
+	}
+	return RecvSlice(buf);
+}
+
+RecvSlice RecvBufferPool::detach(RecvSlice& recv, uint32_t length) {
+	RecvSlice r;
+	if (length > COPY_MAX || length * 2 > recv->capacity) {
+		r = std::move(recv);
+		r->length = length;
+		return r;
+	}
+	r = obtain(length);
+	if (r.empty())
+		return r;
+	memcpy(r->data, recv->data, length);
+	r->length = length;
+	lock_guard<mutex> locker(mutex_);
+	++copied_;
+	return r;
+}
+
+void RecvBufferPool::frame_received(uint32_t length) {
+	lock_guard<mutex> locker(mutex_);
+	if (length > max_frame_)
+		max_frame_ = length;
+	if (length > window_max_frame_)
+		window_max_frame_ = length;
+	// moving average, weight 1/8
+	if (avg_frame_ == 0)
+		avg_frame_ = length;
+	else
+		avg_frame_ = avg_frame_ - (avg_frame_ >> 3) + (length >> 3);
+	if (++window_frames_ >= RETAIN_WINDOW)
+		update_retain();
+}
+
+void RecvBufferPool::update_retain() {
+	uint32_t bytes = 0;
+	int32_t top = class_of_length(window_max_frame_);
+	size_t k;
+	// small to large, frames of the window mostly small
+	for (k = 0; k < classes_.size(); ++k) {
+		SizeClass& sc = classes_[k];
+		uint32_t r = sc.peak_outstanding;
+		if (k + 1 == classes_.size()) {
+			// receive buffer, not counted in RETAIN_BYTES
+			r = 1;
+		} else {
+			if ((int32_t)k > top)
+				r = 0;
+			else if (r < MIN_RETAIN)
+				r = MIN_RETAIN;
+			if (r > (RETAIN_BYTES - bytes) / sc.size)
+				r = (RETAIN_BYTES - bytes) / sc.size;
+			bytes += r * sc.size;
+		}
+		if (r != sc.retain) {
+#ifdef SPEECH_SDK_DETAIL_TRACE
+			Log::d(POOL_TAG, "retain count of %u bytes %u --> %u, "
+					"frame avg %u, max %u", sc.size, sc.retain, r,
+					avg_frame_, window_max_frame_);
+#endif
+			sc.retain = r;
+		}
+		while (sc.idle.size() > sc.retain) {
+			idle_bytes_ -= sc.idle.back()->capacity;
+			free_buffer(sc.idle.back());
+			sc.idle.pop_back();
+			++trimmed_;
+		}
+		sc.peak_outstanding = sc.outstanding;
+	}
+	window_frames_ = 0;
+	window_max_frame_ = 0;
+}
+
+void RecvBufferPool::recycle(RecvBuffer* buf) {
+	lock_guard<mutex> locker(mutex_);
+	assert(outstanding_ > 0);
+	--outstanding_;
+	int32_t k = buf->capacity == 0 ? -1 : class_of_capacity(buf->capacity);
+	if (k < 0) {
+		// sentinel or buffer of old capacity
+		free_buffer(buf);
+		return;
+	}
+	SizeClass& sc = classes_[k];
+	// class of same size after initialize() with other capacity
+	if (sc.outstanding > 0)
+		--sc.outstanding;
+	if (sc.idle.size() >= sc.retain) {
+		free_buffer(buf);
+		++trimmed_;
+		return;
+	}
+	sc.idle.push_back(buf);
+	idle_bytes_ += buf->capacity;
+}
+
+void RecvBufferPool::get_stat(RecvBufferPoolStat& stat) {
+	lock_guard<mutex> locker(mutex_);
+	size_t i;
+	stat.capacity = capacity_;
+	stat.outstanding = outstanding_;
+	stat.idle = 0;
+	stat.retain = 0;
+	for (i = 0; i < classes_.size(); ++i) {
+		stat.idle += classes_[i].idle.size();
+		stat.retain += classes_[i].retain;
+	}
+	stat.idle_bytes = idle_bytes_;
+	stat.max_frame = max_frame_;
+	stat.avg_frame = avg_frame_;
+	stat.allocated = allocated_;
+	stat.reused = reused_;
+	stat.trimmed = trimmed_;
+	stat.copied = copied_;
+}
+
+RecvBuffer* RecvBufferPool::alloc_buffer(RecvBufferPool* pool,
+		uint32_t capacity) {
+	void* p = malloc(sizeof(RecvBuffer) + capacity);
+	if (p == NULL)
+		return NULL;
+	RecvBuffer* buf = reinterpret_cast<RecvBuffer*>(p);
+	new (&buf->refs) std::atomic<int32_t>(0);
+	buf->pool = pool;
+	buf->capacity = capacity;
+	buf->length = 0;
+	buf->type = 0;
+	return buf;
+}
+
+void RecvBufferPool::free_buffer(RecvBuffer* buf) {
+	free(buf);
+}
+
+} // namespace speech
+} // namespace rokid
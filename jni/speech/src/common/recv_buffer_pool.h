@@ -0,0 +1,166 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace rokid {
+namespace speech {
+
+class RecvBufferPool;
+
+typedef struct {
+	std::atomic<int32_t> refs;
+	RecvBufferPool* pool;
+	uint32_t capacity;
+	uint32_t length;
+	uint32_t type;
+	char data[];
+} RecvBuffer;
+
+// reference counted handle of RecvBuffer
+// buffer returned to pool when last handle released
+class RecvSlice {
+public:
+	RecvSlice() : buf_(NULL) {
+	}
+
+	// adopt reference of 'buf', not increase refs
+	explicit RecvSlice(RecvBuffer* buf) : buf_(buf) {
+	}
+
+	RecvSlice(const RecvSlice& other) : buf_(other.buf_) {
+		if (buf_)
+			buf_->refs.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	RecvSlice(RecvSlice&& other) : buf_(other.buf_) {
+		other.buf_ = NULL;
+	}
+
+	~RecvSlice() {
+		reset();
+	}
+
+	RecvSlice& operator = (RecvSlice other) {
+		RecvBuffer* t = buf_;
+		buf_ = other.buf_;
+		other.buf_ = t;
+		return *this;
+	}
+
+	void reset();
+
+	inline RecvBuffer* get() const { return buf_; }
+
+	inline RecvBuffer* operator -> () const { return buf_; }
+
+	inline bool empty() const { return buf_ == NULL; }
+
+private:
+	RecvBuffer* buf_;
+};
+
+typedef struct {
+	uint32_t capacity;
+	uint32_t outstanding;
+	uint32_t idle;
+	uint32_t retain;
+	uint32_t idle_bytes;
+	uint32_t max_frame;
+	uint32_t avg_frame;
+	uint64_t allocated;
+	uint64_t reused;
+	uint64_t trimmed;
+	uint64_t copied;
+} RecvBufferPoolStat;
+
+// Buffers for websocket frame receive.
+// Poco WebSocket::receiveFrame requires the whole frame fit in one
+// buffer, so SpeechConnection receives into a buffer of full capacity
+// (max websocket frame size) and hands the frame over with detach():
+// a frame up to COPY_MAX bytes is copied into a buffer of its size
+// class (power of 2 from CLASS_MIN), the receive buffer kept for next
+// frame; a larger frame takes the receive buffer itself. Queued frames
+// hold about their own size, protobuf parse from them in place.
+//
+// Idle buffers retained per class follow the peak of in flight buffers
+// of that class in the last RETAIN_WINDOW frames, classes over the
+// largest frame of the window keep none, and idle bytes of all classes
+// under full capacity are capped at RETAIN_BYTES, one buffer of full
+// capacity is kept for receive.
+class RecvBufferPool {
+public:
+	RecvBufferPool();
+
+	~RecvBufferPool();
+
+	// param 'capacity': payload bytes of largest buffer
+	void initialize(uint32_t capacity);
+
+	// free all idle buffers
+	// outstanding slices still valid, freed when released
+	// pool must not be destroyed before all slices released
+	void clear();
+
+	// buffer of at least 'length' payload bytes
+	// 'length' 0: header only sentinel, for error marker, never pooled
+	RecvSlice obtain(uint32_t length);
+
+	// frame of 'length' bytes received into 'recv'
+	// returns slice holding the frame, 'recv' emptied if taken
+	RecvSlice detach(RecvSlice& recv, uint32_t length);
+
+	// record received frame size
+	void frame_received(uint32_t length);
+
+	inline uint32_t capacity() const { return capacity_; }
+
+	void get_stat(RecvBufferPoolStat& stat);
+
+private:
+	void recycle(RecvBuffer* buf);
+
+	void update_retain();
+
+	void free_idle();
+
+	// -1 if not capacity of a class
+	int32_t class_of_capacity(uint32_t capacity) const;
+
+	int32_t class_of_length(uint32_t length) const;
+
+	static RecvBuffer* alloc_buffer(RecvBufferPool* pool, uint32_t capacity);
+
+	static void free_buffer(RecvBuffer* buf);
+
+private:
+	typedef struct {
+		uint32_t size;
+		uint32_t outstanding;
+		uint32_t peak_outstanding;
+		uint32_t retain;
+		std::vector<RecvBuffer*> idle;
+	} SizeClass;
+
+	std::mutex mutex_;
+	// ascending, last one of full capacity
+	std::vector<SizeClass> classes_;
+	uint32_t capacity_;
+	uint32_t outstanding_;
+	uint32_t idle_bytes_;
+	uint32_t window_frames_;
+	uint32_t window_max_frame_;
+	uint32_t max_frame_;
+	uint32_t avg_frame_;
+	uint64_t allocated_;
+	uint64_t reused_;
+	uint64_t trimmed_;
+	uint64_t copied_;
+
+	friend class RecvSlice;
+};
+
+} // namespace speech
+} // namespace rokid
@@ -72,7 +72,7 @@ void SpeechConnection::initialize(uint32_t ws_buf_size,
 		const PrepareOptions& options, const char* svc) {
 	if (ws_buf_size < MIN_BUF_SIZE)
 		ws_buf_size = MIN_BUF_SIZE;
-	buffer_size_ = ws_buf_size;
+	recv_pool_.initialize(ws_buf_size);
 	options_ = options;
 	service_type_ = svc;
 	stage_ = CONN_INIT;
@@ -93,14 +93,16 @@ void SpeechConnection::release() {
 
 	thread_->join();
 	delete thread_;
-	delete buffer_;
+	locker.lock();
+	responses_.clear();
+	locker.unlock();
+	recv_pool_.clear();
 
 	unique_lock<mutex> rlocker(req_mutex_);
 	req_cond_.notify_all();
 }
 
 void SpeechConnection::run() {
-	buffer_ = new char[buffer_size_];
 	unique_lock<mutex> locker(resp_mutex_);
 	initialized_ = true;
 	// notify initialize(), thread already run
@@ -222,7 +224,8 @@ bool SpeechConnection::do_socket_poll() {
 	Timespan timeout(SOCKET_POLL_TIMEOUT / 1000, 0);
 	int flags;
 	int c;
-	SpeechBinaryResp* bin_resp;
+	RecvSlice bin_resp;
+	RecvSlice recv_buf;
 	bool reconn = true;
 	int32_t keepalive_timeout = KEEPALIVE_TIMEOUT;
 
@@ -259,8 +262,17 @@ bool SpeechConnection::do_socket_poll() {
 		}
 		keepalive_timeout = KEEPALIVE_TIMEOUT;
 
+		// receive into buffer of full capacity, detach() leaves the
+		// frame in a buffer of about its size
+		if (recv_buf.empty())
+			recv_buf = recv_pool_.obtain(recv_pool_.capacity());
+		if (recv_buf.empty()) {
+			push_error_resp();
+			goto close_conn;
+		}
 		try {
-			c = web_socket_->receiveFrame(buffer_, buffer_size_, flags);
+			c = web_socket_->receiveFrame(recv_buf->data,
+					recv_buf->capacity, flags);
 #ifdef SPEECH_SDK_DETAIL_TRACE
 			Log::d(CONN_TAG, "socket recv %d bytes, flags 0x%x", c, flags);
 #endif
@@ -285,12 +297,15 @@ bool SpeechConnection::do_socket_poll() {
 			push_error_resp();
 			goto close_conn;
 		} else {
-			bin_resp = (SpeechBinaryResp*)malloc(c + sizeof(SpeechBinaryResp));
-			bin_resp->length = c;
+			bin_resp = recv_pool_.detach(recv_buf, c);
+			if (bin_resp.empty()) {
+				push_error_resp();
+				goto close_conn;
+			}
 			bin_resp->type = BIN_RESP_DATA;
-			memcpy(bin_resp->data, buffer_, c);
+			recv_pool_.frame_received(c);
 			unique_lock<mutex> locker(resp_mutex_);
-			responses_.push_back(bin_resp);
+			responses_.push_back(std::move(bin_resp));
 			if (stage_ == CONN_WAIT_AUTH) {
 				locker.unlock();
 				AuthResponse auth_res;
@@ -332,15 +347,16 @@ close_conn:
 
 void SpeechConnection::push_error_resp() {
 	lock_guard<mutex> locker(resp_mutex_);
-	SpeechBinaryResp* bin_resp;
+	RecvSlice bin_resp;
 	if (stage_ == CONN_READY) {
 #ifdef SPEECH_SDK_DETAIL_TRACE
 		Log::d(CONN_TAG, "push error response to list");
 #endif
-		bin_resp = (SpeechBinaryResp*)malloc(sizeof(SpeechBinaryResp));
-		bin_resp->length = 0;
+		bin_resp = recv_pool_.obtain(0);
+		if (bin_resp.empty())
+			return;
 		bin_resp->type = BIN_RESP_ERROR;
-		responses_.push_back(bin_resp);
+		responses_.push_back(std::move(bin_resp));
 	}
 }
 
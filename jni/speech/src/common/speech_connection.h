@@ -2,13 +2,14 @@
 
 #include <assert.h>
 #include <string>
-#include <list>
+#include <deque>
 #include <memory>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
 #include "log.h"
+#include "recv_buffer_pool.h"
 #include "speech.h"
 #include "Poco/Net/WebSocket.h"
 
@@ -22,12 +23,6 @@ enum BinRespType {
 	BIN_RESP_ERROR
 };
 
-typedef struct {
-	uint32_t length;
-	uint32_t type;
-	char data[];
-} SpeechBinaryResp;
-
 enum ConnectStage {
 	// not connected
 	CONN_INIT = 0,
@@ -65,12 +60,16 @@ public:
 
 	void release();
 
+	void get_recv_pool_stat(RecvBufferPoolStat& stat) {
+		recv_pool_.get_stat(stat);
+	}
+
 	// params: 'timeout' milliseconds
 	template <typename PBT>
 	ConnectionOpResult send(PBT& pbitem, uint32_t timeout = 0) {
-		std::string buf;
 		std::unique_lock<std::mutex> locker(req_mutex_);
-		if (!pbitem.SerializeToString(&buf)) {
+		// 'send_buffer_' reused, SerializeToString keep its capacity
+		if (!pbitem.SerializeToString(&send_buffer_)) {
 			Log::w(CONN_TAG, "send: protobuf serialize failed");
 			return ConnectionOpResult::INVALID_PB_OBJ;
 		}
@@ -78,14 +77,14 @@ public:
 			Log::d(CONN_TAG, "send: connection not available");
 			return ConnectionOpResult::CONNECTION_NOT_AVAILABLE;
 		}
-		return send(buf.data(), buf.length())
+		return send(send_buffer_.data(), send_buffer_.length())
 			? ConnectionOpResult::SUCCESS
 			: ConnectionOpResult::SOCKET_ERROR;
 	}
 
 	template <typename PBT>
 	ConnectionOpResult recv(PBT& res, uint32_t timeout) {
-		SpeechBinaryResp* resp_data;
+		RecvSlice resp_data;
 		std::unique_lock<std::mutex> locker(resp_mutex_);
 
 		if (!initialized_)
@@ -97,13 +96,14 @@ public:
 				return ConnectionOpResult::NOT_READY;
 		}
 		if (!responses_.empty()) {
-			resp_data = responses_.front();
-			assert(resp_data);
+			resp_data = std::move(responses_.front());
+			assert(!resp_data.empty());
 			responses_.pop_front();
+			locker.unlock();
 			if (resp_data->type == BIN_RESP_DATA) {
+				// parse in place from the buffer frame was detached to
 				bool r = res.ParseFromArray(resp_data->data,
 						resp_data->length);
-				delete resp_data;
 				if (!r) {
 					Log::w(CONN_TAG, "recv: protobuf parse failed");
 					return ConnectionOpResult::INVALID_PB_DATA;
@@ -111,7 +111,6 @@ public:
 				return ConnectionOpResult::SUCCESS;
 			}
 			Log::d(CONN_TAG, "recv: failed, connection broken");
-			delete resp_data;
 			return ConnectionOpResult::CONNECTION_BROKEN;
 		}
 		return ConnectionOpResult::TIMEOUT;
@@ -148,13 +147,16 @@ private:
 	std::mutex resp_mutex_;
 	std::condition_variable req_cond_;
 	std::condition_variable resp_cond_;
-	std::list<SpeechBinaryResp*> responses_;
+	// declared before 'responses_', slices must return to pool
+	// before pool destroyed
+	RecvBufferPool recv_pool_;
+	std::deque<RecvSlice> responses_;
 	std::shared_ptr<Poco::Net::WebSocket> web_socket_;
 	std::thread* thread_;
 	PrepareOptions options_;
 	std::string service_type_;
-	char* buffer_;
-	uint32_t buffer_size_;
+	// serialized request, guarded by 'req_mutex_'
+	std::string send_buffer_;
 	ConnectStage stage_;
 	bool initialized_;
 	uint32_t pending_ping_;
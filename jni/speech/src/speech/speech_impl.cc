@@ -302,10 +302,11 @@ bool SpeechImpl::poll(SpeechResult& res) {
 					if (resin.get()) {
 						if (resin->asr_finish)
 							res.type = SpeechResultType::SPEECH_RES_ASR_FINISH;
-						res.asr = resin->asr;
-						res.nlp = resin->nlp;
-						res.action = resin->action;
-						res.extra = resin->extra;
+						// 'resin' already popped from queue, move out
+						res.asr.swap(resin->asr);
+						res.nlp.swap(resin->nlp);
+						res.action.swap(resin->action);
+						res.extra.swap(resin->extra);
 					}
 					Log::d(tag__, "SpeechImpl.poll return result "
 							"id(%d), type(%d)", res.id, res.type);
@@ -450,8 +451,9 @@ void SpeechImpl::req_config(SpeechRequest& req,
 }
 
 int32_t SpeechImpl::do_request(shared_ptr<SpeechReqInfo>& req) {
-	SpeechRequest treq;
+	SpeechRequest& treq = request_;
 	int32_t rv = 1;
+	treq.Clear();
 	switch (req->type) {
 		case SpeechReqType::TEXT: {
 			shared_ptr<VoiceOptions> empty_opt;
@@ -490,7 +492,8 @@ int32_t SpeechImpl::do_request(shared_ptr<SpeechReqInfo>& req) {
 		case SpeechReqType::VOICE_DATA:
 			treq.set_id(req->id);
 			treq.set_type(ReqType::VOICE);
-			treq.set_voice(*req->data);
+			// voice data not used after sent, move it into request
+			treq.mutable_voice()->swap(*req->data);
 			Log::d(tag__, "SpeechImpl.do_request (%d) send voice data",
 					req->id);
 			break;
@@ -598,11 +601,11 @@ void SpeechImpl::gen_result_by_resp(SpeechResponse& resp) {
 			new_data = true;
 		}
 
+		// move strings out of 'resp', it is cleared by next parse
 		shared_ptr<SpeechResultIn> resin;
-		string extra = resp.extra();
-		if (extra.length() > 0) {
+		if (resp.extra().length() > 0) {
 			resin = make_shared<SpeechResultIn>();
-			resin->extra = extra;
+			resin->extra.swap(*resp.mutable_extra());
 			resin->asr_finish = false;
 			responses_.stream(resp.id(), resin);
 			new_data = true;
@@ -610,21 +613,21 @@ void SpeechImpl::gen_result_by_resp(SpeechResponse& resp) {
 		resin = make_shared<SpeechResultIn>();
 		switch (resp.type()) {
 		case rokid::open::speech::v2::INTERMEDIATE:
-			resin->asr = resp.asr();
+			resin->asr.swap(*resp.mutable_asr());
 			resin->asr_finish = false;
 			responses_.stream(resp.id(), resin);
 			new_data = true;
 			break;
 		case rokid::open::speech::v2::ASR_FINISH:
-			resin->asr = resp.asr();
+			resin->asr.swap(*resp.mutable_asr());
 			resin->asr_finish = true;
 			responses_.stream(resp.id(), resin);
 			new_data = true;
 			break;
 		case rokid::open::speech::v2::FINISH:
 			if (resp.result() == SpeechErrorCode::SUCCESS) {
-				resin->nlp = resp.nlp();
-				resin->action = resp.action();
+				resin->nlp.swap(*resp.mutable_nlp());
+				resin->action.swap(*resp.mutable_action());
 				resin->asr_finish = false;
 				responses_.end(resp.id(), resin);
 				new_data = true;
@@ -79,6 +79,9 @@ private:
 	int32_t next_id_;
 	SpeechOptionsHolder options_;
 	SpeechConnection connection_;
+	// reused by 'send_reqs' thread for every request,
+	// Clear() keep capacity of strings and sub messages
+	rokid::open::speech::v2::SpeechRequest request_;
 	std::list<std::shared_ptr<SpeechReqInfo> > text_reqs_;
 	ReqStreamQueue voice_reqs_;
 	RespStreamQueue responses_;
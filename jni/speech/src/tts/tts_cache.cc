@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "tts_cache.h"
+#include "log.h"
+
+#define CACHE_TAG "speech.TtsCache"
+#define CACHE_FILE_MAGIC 0x32435452 // "RTC2"
+#define CACHE_FILE_SUFFIX ".ttsc"
+// served entry older than this is synthesised again at idle
+#define CACHE_REVALIDATE_AGE (7 * 24 * 3600)
+
+using std::string;
+using std::shared_ptr;
+using std::make_shared;
+using std::mutex;
+using std::lock_guard;
+
+namespace rokid {
+namespace speech {
+
+// FNV-1a, stable between processes (std::hash is not)
+static uint64_t hash_key(const string& key) {
+	uint64_t h = 0xcbf29ce484222325ULL;
+	size_t i;
+	for (i = 0; i < key.length(); ++i) {
+		h ^= (uint8_t)key[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+static bool read_u32(FILE* fp, uint32_t& v) {
+	return fread(&v, sizeof(v), 1, fp) == 1;
+}
+
+static bool write_u32(FILE* fp, uint32_t v) {
+	return fwrite(&v, sizeof(v), 1, fp) == 1;
+}
+
+static bool read_u64(FILE* fp, uint64_t& v) {
+	return fread(&v, sizeof(v), 1, fp) == 1;
+}
+
+static bool write_u64(FILE* fp, uint64_t v) {
+	return fwrite(&v, sizeof(v), 1, fp) == 1;
+}
+
+TtsCache::TtsCache() : max_bytes_(0), bytes_(0), hits_(0), disk_hits_(0),
+	misses_(0), evictions_(0) {
+}
+
+void TtsCache::config(uint32_t max_bytes, const string& dir) {
+	lock_guard<mutex> locker(mutex_);
+	max_bytes_ = max_bytes;
+	dir_ = dir;
+	if (!dir_.empty()) {
+		if (dir_[dir_.length() - 1] != '/')
+			dir_.append("/");
+		mkdir(dir_.c_str(), 0755);
+	}
+	// shrink to new limit
+	while (bytes_ > max_bytes && !lru_.empty()) {
+		bytes_ -= lru_.back().second->bytes;
+		index_.erase(lru_.back().first);
+		lru_.pop_back();
+		++evictions_;
+	}
+	Log::d(CACHE_TAG, "config max bytes %u, dir %s", max_bytes,
+			dir_.c_str());
+}
+
+bool TtsCache::stale(const TtsCacheEntry& entry) const {
+	uint64_t now = time(NULL);
+	return now > entry.time && now - entry.time >= CACHE_REVALIDATE_AGE;
+}
+
+string TtsCache::cache_dir() {
+	lock_guard<mutex> locker(mutex_);
+	return dir_;
+}
+
+string TtsCache::make_key(const string& text, Codec codec,
+		const string& declaimer) {
+	string key;
+	key.reserve(text.length() + declaimer.length() + 4);
+	key.push_back('0' + static_cast<int>(codec));
+	key.push_back('\0');
+	key.append(declaimer);
+	key.push_back('\0');
+	key.append(text);
+	return key;
+}
+
+TtsCacheEntrySp TtsCache::get(const string& key) {
+	TtsCacheEntrySp entry;
+	std::map<string, LruPos>::iterator it;
+	uint32_t max_bytes = max_bytes_;
+	string dir;
+
+	if (max_bytes == 0)
+		return entry;
+	{
+		lock_guard<mutex> locker(mutex_);
+		it = index_.find(key);
+		if (it != index_.end()) {
+			// move to front
+			lru_.splice(lru_.begin(), lru_, it->second);
+			++hits_;
+			return it->second->second;
+		}
+		dir = dir_;
+	}
+	// disk io without lock
+	entry = load(key, dir, max_bytes);
+	lock_guard<mutex> locker(mutex_);
+	if (entry.get()) {
+		++disk_hits_;
+		insert(key, entry);
+	} else
+		++misses_;
+	return entry;
+}
+
+void TtsCache::put(const string& key, const TtsCacheEntrySp& entry,
+		bool persist) {
+	uint32_t max_bytes = max_bytes_;
+	if (max_bytes == 0 || entry.get() == NULL)
+		return;
+	if (entry->bytes > max_bytes / 4) {
+		Log::d(CACHE_TAG, "entry %u bytes too large, not cached",
+				entry->bytes);
+		return;
+	}
+	if (persist) {
+		entry->persist = true;
+		store(key, *entry, cache_dir());
+	}
+	lock_guard<mutex> locker(mutex_);
+	insert(key, entry);
+}
+
+void TtsCache::insert(const string& key, const TtsCacheEntrySp& entry) {
+	std::map<string, LruPos>::iterator it = index_.find(key);
+	if (it != index_.end()) {
+		bytes_ -= it->second->second->bytes;
+		lru_.erase(it->second);
+		index_.erase(it);
+	}
+	lru_.push_front(LruItem(key, entry));
+	index_[key] = lru_.begin();
+	bytes_ += entry->bytes;
+	while (bytes_ > max_bytes_ && lru_.size() > 1) {
+		bytes_ -= lru_.back().second->bytes;
+		index_.erase(lru_.back().first);
+		lru_.pop_back();
+		++evictions_;
+	}
+}
+
+void TtsCache::clear() {
+	lock_guard<mutex> locker(mutex_);
+	lru_.clear();
+	index_.clear();
+	bytes_ = 0;
+}
+
+void TtsCache::get_stat(TtsCacheStat& stat) {
+	lock_guard<mutex> locker(mutex_);
+	stat.entries = lru_.size();
+	stat.bytes = bytes_;
+	stat.hits = hits_;
+	stat.disk_hits = disk_hits_;
+	stat.misses = misses_;
+	stat.evictions = evictions_;
+}
+
+string TtsCache::file_path(const string& dir, const string& key) {
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx" CACHE_FILE_SUFFIX,
+			(unsigned long long)hash_key(key));
+	return dir + name;
+}
+
+// file format (host byte order):
+//   u32 magic, u64 time, u32 key length, key,
+//   u32 voice count, (u32 voice length, voice) * voice count
+TtsCacheEntrySp TtsCache::load(const string& key, const string& dir,
+		uint32_t max_bytes) {
+	TtsCacheEntrySp entry;
+	FILE* fp;
+	uint32_t v;
+	uint64_t created;
+	uint32_t count;
+	uint32_t i;
+	string fkey;
+
+	if (dir.empty())
+		return entry;
+	fp = fopen(file_path(dir, key).c_str(), "rb");
+	if (fp == NULL)
+		return entry;
+	if (!read_u32(fp, v) || v != CACHE_FILE_MAGIC)
+		goto invalid;
+	if (!read_u64(fp, created))
+		goto invalid;
+	if (!read_u32(fp, v) || v != key.length())
+		goto invalid;
+	fkey.resize(v);
+	if (v && fread(&fkey[0], v, 1, fp) != 1)
+		goto invalid;
+	// hash collision
+	if (fkey != key) {
+		fclose(fp);
+		return entry;
+	}
+	if (!read_u32(fp, count))
+		goto invalid;
+	entry = make_shared<TtsCacheEntry>();
+	entry->time = created;
+	entry->persist = true;
+	for (i = 0; i < count; ++i) {
+		shared_ptr<string> voice;
+		if (!read_u32(fp, v) || v > max_bytes)
+			goto invalid;
+		voice = make_shared<string>(v, '\0');
+		if (v && fread(&(*voice)[0], v, 1, fp) != 1)
+			goto invalid;
+		entry->append(voice);
+	}
+	fclose(fp);
+	return entry;
+
+invalid:
+	Log::w(CACHE_TAG, "invalid cache file %s, remove it",
+			file_path(dir, key).c_str());
+	fclose(fp);
+	remove(file_path(dir, key).c_str());
+	return TtsCacheEntrySp();
+}
+
+void TtsCache::store(const string& key, const TtsCacheEntry& entry,
+		const string& dir) {
+	string path;
+	string tmp;
+	FILE* fp;
+	bool r;
+	size_t i;
+
+	if (dir.empty())
+		return;
+	path = file_path(dir, key);
+	tmp = path + ".tmp";
+	fp = fopen(tmp.c_str(), "wb");
+	if (fp == NULL) {
+		Log::w(CACHE_TAG, "open %s failed", tmp.c_str());
+		return;
+	}
+	r = write_u32(fp, CACHE_FILE_MAGIC)
+		&& write_u64(fp, entry.time)
+		&& write_u32(fp, key.length())
+		&& fwrite(key.data(), key.length(), 1, fp) == 1
+		&& write_u32(fp, entry.voices.size());
+	for (i = 0; r && i < entry.voices.size(); ++i) {
+		const string& voice = *entry.voices[i];
+		r = write_u32(fp, voice.length())
+			&& (voice.empty()
+					|| fwrite(voice.data(), voice.length(), 1, fp) == 1);
+	}
+	if (fclose(fp) != 0)
+		r = false;
+	// rename, never leave partial file
+	if (!r || rename(tmp.c_str(), path.c_str()) != 0) {
+		Log::w(CACHE_TAG, "write %s failed", path.c_str());
+		remove(tmp.c_str());
+	}
+}
+
+} // namespace speech
+} // namespace rokid
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include <string>
+#include <list>
+#include <map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "speech_types.h"
+
+namespace rokid {
+namespace speech {
+
+// voice of one tts request, frames kept as received from server,
+// so cached voice is streamed to user same as server voice
+class TtsCacheEntry {
+public:
+	TtsCacheEntry() : bytes(0), time(::time(NULL)), persist(false) {
+	}
+
+	inline void append(const std::shared_ptr<std::string>& voice) {
+		voices.push_back(voice);
+		bytes += voice->length();
+	}
+
+	std::vector<std::shared_ptr<std::string> > voices;
+	uint32_t bytes;
+	// seconds since epoch, when voice received from server
+	uint64_t time;
+	// stored to disk
+	bool persist;
+};
+
+typedef std::shared_ptr<TtsCacheEntry> TtsCacheEntrySp;
+
+typedef struct {
+	uint32_t entries;
+	uint32_t bytes;
+	uint64_t hits;
+	uint64_t disk_hits;
+	uint64_t misses;
+	uint64_t evictions;
+} TtsCacheStat;
+
+// Cache of tts voice, key is text and options (codec, declaimer).
+// Memory LRU bounded by 'max_bytes', entries stored to 'dir'
+// (if not empty) are loaded on memory miss.
+// 'config' may be invoked while other threads use the cache.
+class TtsCache {
+public:
+	TtsCache();
+
+	// param 'max_bytes': 0 disable cache
+	// param 'dir': directory for persistent entries, empty disable
+	void config(uint32_t max_bytes, const std::string& dir);
+
+	inline bool enabled() const { return max_bytes_.load() > 0; }
+
+	// entry larger than this is not cached
+	inline uint32_t max_entry_bytes() const { return max_bytes_.load() / 4; }
+
+	// entry still served, but should be synthesised again
+	bool stale(const TtsCacheEntry& entry) const;
+
+	static std::string make_key(const std::string& text, Codec codec,
+			const std::string& declaimer);
+
+	// return NULL if not cached
+	TtsCacheEntrySp get(const std::string& key);
+
+	// param 'persist': also store entry to disk
+	void put(const std::string& key, const TtsCacheEntrySp& entry,
+			bool persist);
+
+	void clear();
+
+	void get_stat(TtsCacheStat& stat);
+
+private:
+	typedef std::pair<std::string, TtsCacheEntrySp> LruItem;
+	typedef std::list<LruItem>::iterator LruPos;
+
+	void insert(const std::string& key, const TtsCacheEntrySp& entry);
+
+	// copy of 'dir_', empty if disk disabled
+	std::string cache_dir();
+
+	TtsCacheEntrySp load(const std::string& key, const std::string& dir,
+			uint32_t max_bytes);
+
+	void store(const std::string& key, const TtsCacheEntry& entry,
+			const std::string& dir);
+
+	static std::string file_path(const std::string& dir,
+			const std::string& key);
+
+private:
+	std::mutex mutex_;
+	std::list<LruItem> lru_;
+	std::map<std::string, LruPos> index_;
+	// written under 'mutex_', read without it
+	std::atomic<uint32_t> max_bytes_;
+	uint32_t bytes_;
+	// guarded by 'mutex_'
+	std::string dir_;
+	uint64_t hits_;
+	uint64_t disk_hits_;
+	uint64_t misses_;
+	uint64_t evictions_;
+};
+
+} // namespace speech
+} // namespace rokid
@@ -14,11 +14,15 @@ using std::mutex;
 using std::unique_lock;
 using std::lock_guard;
 using std::list;
+using std::vector;
 using rokid::open::speech::v1::TtsRequest;
 using rokid::open::speech::v1::TtsResponse;
+using rokid::open::speech::v1::SpeechErrorCode;
+using std::chrono::duration;
 
 static const uint32_t MODIFY_CODEC = 1;
 static const uint32_t MODIFY_DECLAIMER = 2;
+static const uint32_t MODIFY_CACHE = 4;
 
 class TtsOptionsModifier : public TtsOptionsHolder, public TtsOptions {
 public:
@@ -37,18 +41,34 @@ public:
 		_mask |= MODIFY_DECLAIMER;
 	}
 
+	void set_cache(uint32_t max_bytes, const string& dir) {
+		this->cache_bytes = max_bytes;
+		this->cache_dir = dir;
+		_mask |= MODIFY_CACHE;
+	}
+
 	void modify(TtsOptionsHolder& options) {
 		if (_mask & MODIFY_CODEC)
 			options.codec = codec;
 		if (_mask & MODIFY_DECLAIMER)
 			options.declaimer = declaimer;
+		if (_mask & MODIFY_CACHE) {
+			options.cache_bytes = cache_bytes;
+			options.cache_dir = cache_dir;
+		}
+	}
+
+	inline bool cache_modified() const {
+		return _mask & MODIFY_CACHE;
 	}
 
 private:
 	uint32_t _mask;
 };
 
-TtsImpl::TtsImpl() : initialized_(false) {
+TtsImpl::TtsImpl() : prefetch_id_(0), attached_id_(0), prefetch_ok_(false),
+	prefetch_persist_(false), speak_pending_(false), fill_id_(0),
+	done_persist_(false), initialized_(false) {
 }
 
 bool TtsImpl::prepare(const PrepareOptions& options) {
@@ -71,7 +91,13 @@ void TtsImpl::release() {
 		initialized_ = false;
 		connection_.release();
 		requests_.clear();
+		prefetch_reqs_.clear();
 		req_cond_.notify_one();
+		{
+			// awake 'send_reqs' waiting prefetch finish
+			lock_guard<mutex> locker(resp_mutex_);
+			prefetch_cond_.notify_all();
+		}
 		req_locker.unlock();
 		req_thread_->join();
 		delete req_thread_;
@@ -96,14 +122,55 @@ int32_t TtsImpl::speak(const char* text) {
 	shared_ptr<TtsReqInfo> req(new TtsReqInfo());
 	req->data = text;
 	req->deleted = false;
+	req->prefetch = false;
+	req->refresh = false;
 	lock_guard<mutex> locker(req_mutex_);
 	int32_t id = next_id();
 	req->id = id;
 	requests_.push_back(req);
 	req_cond_.notify_one();
+	// 'send_reqs' may wait prefetch finish, speak first
+	lock_guard<mutex> resp_locker(resp_mutex_);
+	speak_pending_ = true;
+	prefetch_cond_.notify_one();
 	return id;
 }
 
+void TtsImpl::prefetch(const vector<string>& texts) {
+	lock_guard<mutex> locker(req_mutex_);
+	if (!initialized_ || !cache_.enabled())
+		return;
+	size_t i;
+	for (i = 0; i < texts.size(); ++i) {
+		shared_ptr<TtsReqInfo> req(new TtsReqInfo());
+		req->id = next_id();
+		req->data = texts[i];
+		req->deleted = false;
+		req->prefetch = true;
+		req->refresh = false;
+		prefetch_reqs_.push_back(req);
+	}
+	req_cond_.notify_one();
+}
+
+// stale entry was played, synthesise it again when idle
+void TtsImpl::revalidate(const string& text) {
+	lock_guard<mutex> locker(req_mutex_);
+	list<shared_ptr<TtsReqInfo> >::iterator it;
+	for (it = prefetch_reqs_.begin(); it != prefetch_reqs_.end(); ++it) {
+		if ((*it)->data == text)
+			return;
+	}
+	shared_ptr<TtsReqInfo> req(new TtsReqInfo());
+	req->id = next_id();
+	req->data = text;
+	req->deleted = false;
+	req->prefetch = true;
+	req->refresh = true;
+	prefetch_reqs_.push_back(req);
+	req_cond_.notify_one();
+}
+
 void TtsImpl::cancel(int32_t id) {
 	list<shared_ptr<TtsReqInfo> >::iterator it;
 	bool erased = false;
@@ -136,6 +203,8 @@ void TtsImpl::config(const shared_ptr<TtsOptions>& options) {
 	shared_ptr<TtsOptionsModifier> mod =
 		static_pointer_cast<TtsOptionsModifier>(options);
 	mod->modify(options_);
+	if (mod->cache_modified())
+		cache_.config(options_.cache_bytes, options_.cache_dir);
 }
 
 static TtsResultType poptype_to_restype(int32_t type) {
@@ -241,25 +310,159 @@ void TtsImpl::send_reqs() {
 		unique_lock<mutex> locker(req_mutex_);
 		if (!initialized_)
 			break;
-		if (requests_.empty()) {
-			Log::d(tag__, "TtsImpl.send_reqs wait req available");
-			req_cond_.wait(locker);
-		} else {
+		if (!requests_.empty()) {
 			req = requests_.front();
 			requests_.pop_front();
 			status = do_ctl_new_op(req);
 			locker.unlock();
 
-			if (status == TtsStatus::START && do_request(req)) {
+			if (status == TtsStatus::START && start_op(req)) {
 				Log::d(tag__, "TtsImpl.send_reqs wait op finish");
 				unique_lock<mutex> resp_locker(resp_mutex_);
 				controller_.wait_op_finish(req->id, resp_locker);
 			}
+		} else if (prefetch_in_flight()) {
+			locker.unlock();
+			wait_prefetch();
+		} else if (!prefetch_reqs_.empty()) {
+			req = prefetch_reqs_.front();
+			prefetch_reqs_.pop_front();
+			locker.unlock();
+			do_prefetch(req);
+		} else {
+			Log::d(tag__, "TtsImpl.send_reqs wait req available");
+			req_cond_.wait(locker);
 		}
 	}
 	Log::d(tag__, "thread 'send_reqs' quit");
 }
 
+bool TtsImpl::start_op(shared_ptr<TtsReqInfo>& req) {
+	string key;
+	if (cache_.enabled()) {
+		key = TtsCache::make_key(req->data, options_.codec,
+				options_.declaimer);
+		if (attach_prefetch(req, key))
+			return true;
+		TtsCacheEntrySp entry = cache_.get(key);
+		if (entry.get()) {
+			// play at once, even if stale
+			speak_from_cache(req, entry);
+			if (cache_.stale(*entry))
+				revalidate(req->data);
+			return false;
+		}
+	}
+	// connection serve one request a time, drop prefetch in flight
+	abandon_prefetch();
+	return do_request(req, key);
+}
+
+void TtsImpl::speak_from_cache(shared_ptr<TtsReqInfo>& req,
+		const TtsCacheEntrySp& entry) {
+	lock_guard<mutex> locker(resp_mutex_);
+	shared_ptr<TtsOperationController::Operation> op;
+	op = controller_.current_op();
+	// cancelled
+	if (op.get() == NULL || op->id != req->id)
+		return;
+	Log::d(tag__, "speak_from_cache(%d): %u bytes voice cached",
+			req->id, entry->bytes);
+	responses_.start(req->id);
+	size_t i;
+	// cache entry shared, user get a copy
+	for (i = 0; i < entry->voices.size(); ++i)
+		responses_.stream(req->id, make_shared<string>(*entry->voices[i]));
+	responses_.end(req->id);
+	op->status = TtsStatus::END;
+	controller_.finish_op();
+	resp_cond_.notify_one();
+}
+
+// 'speak' same text as prefetch in flight,
+// stream voice already received, and following voice of the prefetch
+bool TtsImpl::attach_prefetch(shared_ptr<TtsReqInfo>& req,
+		const string& key) {
+	lock_guard<mutex> locker(resp_mutex_);
+	if (prefetch_id_ == 0 || prefetch_key_ != key
+			|| prefetch_entry_.get() == NULL)
+		return false;
+	shared_ptr<TtsOperationController::Operation> op;
+	op = controller_.current_op();
+	if (op.get() == NULL || op->id != req->id)
+		return true;
+	Log::d(tag__, "attach_prefetch(%d): attach to prefetch %d, "
+			"%u bytes received", req->id, prefetch_id_,
+			prefetch_entry_->bytes);
+	attached_id_ = req->id;
+	responses_.start(req->id);
+	op->status = TtsStatus::STREAMING;
+	size_t i;
+	for (i = 0; i < prefetch_entry_->voices.size(); ++i)
+		responses_.stream(req->id,
+				make_shared<string>(*prefetch_entry_->voices[i]));
+	controller_.refresh_op_time();
+	resp_cond_.notify_one();
+	return true;
+}
+
+void TtsImpl::do_prefetch(shared_ptr<TtsReqInfo>& req) {
+	string key = TtsCache::make_key(req->data, options_.codec,
+			options_.declaimer);
+	TtsCacheEntrySp cached = cache_.get(key);
+	if (cached.get() && !(req->refresh && cache_.stale(*cached))) {
+		Log::d(tag__, "do_prefetch(%d): already cached", req->id);
+		return;
+	}
+	unique_lock<mutex> resp_locker(resp_mutex_);
+	prefetch_id_ = req->id;
+	prefetch_key_ = key;
+	prefetch_entry_ = make_shared<TtsCacheEntry>();
+	prefetch_ok_ = true;
+	// refreshed entry goes to disk only if the stale one was there
+	prefetch_persist_ = !req->refresh || (cached.get() && cached->persist);
+	attached_id_ = 0;
+	resp_locker.unlock();
+	if (!send_request(req)) {
+		resp_locker.lock();
+		prefetch_id_ = 0;
+		prefetch_entry_.reset();
+	}
+}
+
+bool TtsImpl::prefetch_in_flight() {
+	lock_guard<mutex> locker(resp_mutex_);
+	// invoked with 'req_mutex_' locked and no 'speak' requests
+	speak_pending_ = false;
+	return prefetch_id_ != 0;
+}
+
+void TtsImpl::wait_prefetch() {
+	unique_lock<mutex> locker(resp_mutex_);
+	duration<int, std::milli> ms(NOOP_TIMEOUT);
+	while (prefetch_id_ != 0 && !speak_pending_ && initialized_) {
+		if (prefetch_cond_.wait_for(locker, ms)
+				== std::cv_status::timeout) {
+			Log::w(tag__, "prefetch %d timeout", prefetch_id_);
+			prefetch_id_ = 0;
+			attached_id_ = 0;
+			prefetch_entry_.reset();
+			break;
+		}
+	}
+}
+
+void TtsImpl::abandon_prefetch() {
+	lock_guard<mutex> locker(resp_mutex_);
+	if (prefetch_id_ != 0) {
+		Log::d(tag__, "abandon prefetch %d", prefetch_id_);
+		prefetch_id_ = 0;
+		attached_id_ = 0;
+		prefetch_entry_.reset();
+		prefetch_cond_.notify_all();
+	}
+}
+
 TtsStatus TtsImpl::do_ctl_new_op(shared_ptr<TtsReqInfo>& req) {
 	lock_guard<mutex> locker(resp_mutex_);
 	if (req->deleted) {
@@ -285,30 +488,50 @@ static const char* get_codec_str(Codec codec) {
 	return NULL;
 }
 
-bool TtsImpl::do_request(shared_ptr<TtsReqInfo>& req) {
+bool TtsImpl::send_request(shared_ptr<TtsReqInfo>& req) {
 	Log::d(tag__, "do_request: send req to server. (%d:%s)",
 			req->id, req->data.c_str());
-	TtsRequest treq;
+	TtsRequest& treq = request_;
+	treq.Clear();
 	treq.set_id(req->id);
-	treq.set_text(req->data.c_str());
+	treq.set_text(req->data);
 	treq.set_declaimer(options_.declaimer);
 	treq.set_codec(get_codec_str(options_.codec));
 	ConnectionOpResult r = connection_.send(treq, WS_SEND_TIMEOUT);
 	if (r != ConnectionOpResult::SUCCESS) {
-		TtsError err = TTS_UNKNOWN;
-		if (r == ConnectionOpResult::CONNECTION_NOT_AVAILABLE)
-			err = TTS_SERVICE_UNAVAILABLE;
-		Log::w(tag__, "do_request: (%d) send req failed %d, "
-				"set op error", req->id, r);
-		lock_guard<mutex> locker(resp_mutex_);
-		controller_.set_op_error(err);
-		resp_cond_.notify_one();
+		Log::w(tag__, "do_request: (%d) send req failed %d",
+				req->id, r);
+		if (!req->prefetch) {
+			TtsError err = TTS_UNKNOWN;
+			if (r == ConnectionOpResult::CONNECTION_NOT_AVAILABLE)
+				err = TTS_SERVICE_UNAVAILABLE;
+			lock_guard<mutex> locker(resp_mutex_);
+			controller_.set_op_error(err);
+			resp_cond_.notify_one();
+		}
 		return false;
 	}
 #ifdef SPEECH_SDK_DETAIL_TRACE
 	Log::d(tag__, "req (%d) sent, req done", req->id);
 #endif
-	lock_guard<mutex> locker(resp_mutex_);
+	return true;
+}
+
+// param 'key': cache key, empty if cache disabled
+bool TtsImpl::do_request(shared_ptr<TtsReqInfo>& req, const string& key) {
+	unique_lock<mutex> locker(resp_mutex_);
+	// collect voice for cache before response arrive
+	fill_id_ = req->id;
+	fill_key_ = key;
+	if (key.empty())
+		fill_entry_.reset();
+	else
+		fill_entry_ = make_shared<TtsCacheEntry>();
+	locker.unlock();
+
+	if (!send_request(req))
+		return false;
+	locker.lock();
 	controller_.refresh_op_time();
 	return true;
 }
@@ -318,6 +541,9 @@ void TtsImpl::gen_results() {
 	ConnectionOpResult r;
 	TtsError err;
 	uint32_t timeout;
+	string cache_key;
+	TtsCacheEntrySp cache_entry;
+	bool cache_persist = false;
 
 	Log::d(tag__, "thread 'gen_results' run");
 	while (true) {
@@ -332,6 +558,11 @@ void TtsImpl::gen_results() {
 		if (r == ConnectionOpResult::SUCCESS) {
 			controller_.refresh_op_time();
 			gen_result_by_resp(resp);
+			if (done_entry_.get()) {
+				cache_key.swap(done_key_);
+				cache_entry.swap(done_entry_);
+				cache_persist = done_persist_;
+			}
 		} else if (r == ConnectionOpResult::TIMEOUT) {
 			if (controller_.op_timeout() == 0) {
 				Log::w(tag__, "gen_results: (%d) op timeout, "
@@ -339,21 +570,50 @@ void TtsImpl::gen_results() {
 				controller_.set_op_error(TTS_TIMEOUT);
 				resp_cond_.notify_one();
 			}
-		} else if (r == ConnectionOpResult::CONNECTION_BROKEN) {
-			controller_.set_op_error(TTS_SERVICE_UNAVAILABLE);
-			resp_cond_.notify_one();
 		} else {
-			controller_.set_op_error(TTS_UNKNOWN);
+			if (r == ConnectionOpResult::CONNECTION_BROKEN)
+				controller_.set_op_error(TTS_SERVICE_UNAVAILABLE);
+			else
+				controller_.set_op_error(TTS_UNKNOWN);
 			resp_cond_.notify_one();
+			if (prefetch_id_ != 0) {
+				Log::w(tag__, "gen_results: prefetch %d failed",
+						prefetch_id_);
+				prefetch_id_ = 0;
+				attached_id_ = 0;
+				prefetch_entry_.reset();
+				prefetch_cond_.notify_all();
+			}
 		}
 		locker.unlock();
+
+		// cache may write file, not block 'poll'
+		if (cache_entry.get()) {
+			cache_.put(cache_key, cache_entry, cache_persist);
+			cache_entry.reset();
+		}
 	}
 	Log::d(tag__, "thread 'gen_results' quit");
 }
 
+static shared_ptr<string> take_voice(TtsResponse& resp) {
+	shared_ptr<string> voice;
+#ifdef LOW_PB_VERSION
+	voice.reset(new string());
+	voice->swap(*resp.mutable_voice());
+#else
+	voice.reset(resp.release_voice());
+#endif
+	return voice;
+}
+
 void TtsImpl::gen_result_by_resp(TtsResponse& resp) {
 	bool new_data = false;
 	shared_ptr<TtsOperationController::Operation> op;
+	if (prefetch_id_ != 0 && prefetch_id_ == resp.id()) {
+		gen_prefetch_result(resp);
+		return;
+	}
 	op = controller_.current_op();
 	if (op.get() && op->id == resp.id()) {
 		if (op->status == TtsStatus::START) {
@@ -366,13 +626,18 @@ void TtsImpl::gen_result_by_resp(TtsResponse& resp) {
 
 		Log::d(tag__, "TtsResponse has_voice(%d), finish(%d)",
 				resp.has_voice(), resp.finish());
+		bool fill = fill_entry_.get() && fill_id_ == resp.id();
+		if (fill && resp.result() != SpeechErrorCode::SUCCESS)
+			fill_entry_.reset();
 		if (resp.has_voice()) {
-			shared_ptr<string> voice;
-#ifdef LOW_PB_VERSION
-			voice.reset(new string(resp.voice()));
-#else
-			voice.reset(resp.release_voice());
-#endif
+			shared_ptr<string> voice = take_voice(resp);
+			if (fill_entry_.get() && fill) {
+				if (fill_entry_->bytes + voice->length()
+						> cache_.max_entry_bytes())
+					fill_entry_.reset();
+				else
+					fill_entry_->append(make_shared<string>(*voice));
+			}
 			responses_.stream(resp.id(), voice);
 			new_data = true;
 			Log::d(tag__, "gen_result_by_resp(%d): push voice "
@@ -387,7 +652,13 @@ void TtsImpl::gen_result_by_resp(TtsResponse& resp) {
 				op->status = TtsStatus::END;
 				Log::d(tag__, "gen_result_by_resp(%d): push end resp, "
 						"Status Streaming --> End", resp.id());
+				if (fill_entry_.get() && fill) {
+					done_key_.swap(fill_key_);
+					done_entry_.swap(fill_entry_);
+					done_persist_ = false;
+				}
 			}
+			fill_entry_.reset();
 			controller_.finish_op();
 		}
 
@@ -399,11 +670,62 @@ void TtsImpl::gen_result_by_resp(TtsResponse& resp) {
 	}
 }
 
+void TtsImpl::gen_prefetch_result(TtsResponse& resp) {
+	shared_ptr<TtsOperationController::Operation> op;
+	bool attached = false;
+	if (attached_id_ != 0) {
+		op = controller_.current_op();
+		if (op.get() && op->id == attached_id_)
+			attached = true;
+		else
+			// attached 'speak' cancelled, continue prefetch
+			attached_id_ = 0;
+	}
+	if (resp.result() != SpeechErrorCode::SUCCESS)
+		prefetch_ok_ = false;
+	if (resp.has_voice()) {
+		shared_ptr<string> voice = take_voice(resp);
+		if (prefetch_ok_ && prefetch_entry_->bytes + voice->length()
+				<= cache_.max_entry_bytes()) {
+			prefetch_entry_->append(voice);
+			if (attached)
+				responses_.stream(attached_id_, make_shared<string>(*voice));
+		} else {
+			prefetch_ok_ = false;
+			if (attached)
+				responses_.stream(attached_id_, voice);
+		}
+	}
+	if (resp.finish()) {
+		Log::d(tag__, "prefetch %d finish, %u bytes, ok %d",
+				prefetch_id_, prefetch_entry_->bytes, prefetch_ok_);
+		if (attached) {
+			responses_.end(attached_id_);
+			if (op->status != TtsStatus::CANCELLED
+					&& op->status != TtsStatus::ERROR)
+				op->status = TtsStatus::END;
+			controller_.finish_op();
+		}
+		if (prefetch_ok_) {
+			done_key_ = prefetch_key_;
+			done_entry_ = prefetch_entry_;
+			done_persist_ = prefetch_persist_;
+		}
+		prefetch_id_ = 0;
+		attached_id_ = 0;
+		prefetch_entry_.reset();
+		prefetch_cond_.notify_all();
+	}
+	if (attached)
+		resp_cond_.notify_one();
+}
+
 shared_ptr<Tts> Tts::new_instance() {
 	return make_shared<TtsImpl>();
 }
 
-TtsOptionsHolder::TtsOptionsHolder() : codec(Codec::PCM), declaimer("zh") {
+TtsOptionsHolder::TtsOptionsHolder() : codec(Codec::PCM), declaimer("zh"),
+	cache_bytes(0) {
 }
 
 shared_ptr<TtsOptions> TtsOptions::new_instance() {
@@ -11,6 +11,7 @@
 #include "types.h"
 #include "tts.pb.h"
 #include "pending_queue.h"
+#include "tts_cache.h"
 
 namespace rokid {
 namespace speech {
@@ -24,6 +25,8 @@ public:
 
 	Codec codec;
 	std::string declaimer;
+	uint32_t cache_bytes;
+	std::string cache_dir;
 };
 
 class TtsImpl : public Tts {
@@ -38,6 +41,8 @@ public:
 
 	void cancel(int32_t id);
 
+	void prefetch(const std::vector<std::string>& texts);
+
 	// poll tts results
 	// block current thread if no result available
 	// if Tts.release() invoked, poll() will return -1
@@ -59,14 +64,40 @@ private:
 
 	bool gen_result_by_status();
 
-	bool do_request(std::shared_ptr<TtsReqInfo>& req);
+	bool do_request(std::shared_ptr<TtsReqInfo>& req, const std::string& key);
+
+	bool send_request(std::shared_ptr<TtsReqInfo>& req);
 
 	TtsStatus do_ctl_new_op(std::shared_ptr<TtsReqInfo>& req);
 
+	// return true if need wait op finish
+	bool start_op(std::shared_ptr<TtsReqInfo>& req);
+
+	void speak_from_cache(std::shared_ptr<TtsReqInfo>& req,
+			const TtsCacheEntrySp& entry);
+
+	bool attach_prefetch(std::shared_ptr<TtsReqInfo>& req,
+			const std::string& key);
+
+	void do_prefetch(std::shared_ptr<TtsReqInfo>& req);
+
+	void revalidate(const std::string& text);
+
+	bool prefetch_in_flight();
+
+	void wait_prefetch();
+
+	void abandon_prefetch();
+
+	void gen_prefetch_result(rokid::open::speech::v1::TtsResponse& resp);
+
 private:
 	int32_t next_id_;
 	TtsOptionsHolder options_;
 	SpeechConnection connection_;
+	// reused by 'send_reqs' thread for every request,
+	// Clear() keep capacity of strings
+	rokid::open::speech::v1::TtsRequest request_;
 	std::list<std::shared_ptr<TtsReqInfo> > requests_;
 	TtsStreamQueue responses_;
 	std::mutex req_mutex_;
@@ -74,6 +105,28 @@ private:
 	std::mutex resp_mutex_;
 	std::condition_variable resp_cond_;
 	TtsOperationController controller_;
+	TtsCache cache_;
+	std::list<std::shared_ptr<TtsReqInfo> > prefetch_reqs_;
+	// members below guarded by 'resp_mutex_'
+	// prefetch request in flight, at most one
+	int32_t prefetch_id_;
+	// 'speak' request attached to prefetch in flight with same key
+	int32_t attached_id_;
+	bool prefetch_ok_;
+	// store entry of prefetch in flight to disk
+	bool prefetch_persist_;
+	bool speak_pending_;
+	std::string prefetch_key_;
+	TtsCacheEntrySp prefetch_entry_;
+	std::condition_variable prefetch_cond_;
+	// voice of current op, put to cache when op end
+	int32_t fill_id_;
+	std::string fill_key_;
+	TtsCacheEntrySp fill_entry_;
+	// completed entry, put to cache by 'gen_results' out of lock
+	std::string done_key_;
+	TtsCacheEntrySp done_entry_;
+	bool done_persist_;
 	std::thread* req_thread_;
 	std::thread* resp_thread_;
 	bool initialized_;
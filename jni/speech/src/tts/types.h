@@ -10,6 +10,10 @@ namespace speech {
 typedef struct {
 	int32_t id;
 	bool deleted;
+	// request of Tts.prefetch, voice put to cache only
+	bool prefetch;
+	// prefetch of a stale cached text, replaces its entry
+	bool refresh;
 	std::string data;
 } TtsReqInfo;
 
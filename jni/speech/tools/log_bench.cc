@@ -0,0 +1,110 @@
+// Benchmark caller side cost of Log, synchronous (format and write on
+// caller thread) vs asynchronous (record to thread ring)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include "log.h"
+
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+using rokid::speech::Log;
+using rokid::speech::LogStat;
+
+#define BENCH_TAG "speech.LogBench"
+
+typedef struct {
+	uint32_t threads;
+	uint32_t count;
+	// interval between logs, microseconds
+	uint32_t interval;
+	string file;
+} BenchConfig;
+
+static BenchConfig config_;
+
+static void log_thread(vector<double>* samples) {
+	uint32_t i;
+	steady_clock::time_point t0;
+	samples->reserve(config_.count);
+	for (i = 0; i < config_.count; ++i) {
+		t0 = steady_clock::now();
+		Log::d(BENCH_TAG, "gen_result_by_resp(%d): push voice resp, "
+				"%d bytes, status %s", i, 4096, "streaming");
+		samples->push_back(std::chrono::duration_cast<
+				std::chrono::nanoseconds>(steady_clock::now() - t0).count());
+		if (config_.interval)
+			std::this_thread::sleep_for(std::chrono::microseconds(
+						config_.interval));
+	}
+}
+
+static void bench(bool async) {
+	vector<vector<double> > samples(config_.threads);
+	vector<std::thread> threads;
+	vector<double> all;
+	uint32_t i;
+	LogStat before;
+	LogStat after;
+
+	Log::set_async(async);
+	Log::get_stat(before);
+	steady_clock::time_point t0 = steady_clock::now();
+	for (i = 0; i < config_.threads; ++i)
+		threads.push_back(std::thread(log_thread, &samples[i]));
+	for (i = 0; i < config_.threads; ++i) {
+		threads[i].join();
+		all.insert(all.end(), samples[i].begin(), samples[i].end());
+	}
+	double total = std::chrono::duration_cast<std::chrono::microseconds>(
+			steady_clock::now() - t0).count() / 1000.0;
+	Log::flush();
+	Log::get_stat(after);
+
+	std::sort(all.begin(), all.end());
+	size_t n = all.size();
+	double sum = 0;
+	for (i = 0; i < n; ++i)
+		sum += all[i];
+	printf("%-5s %u threads x %u logs, %.2fms, dropped %llu\n",
+			async ? "async" : "sync", config_.threads, config_.count, total,
+			(unsigned long long)(after.dropped - before.dropped));
+	printf("      per call avg=%.0fns p50=%.0fns p90=%.0fns p99=%.0fns "
+			"max=%.0fns\n", sum / n, all[n * 50 / 100], all[n * 90 / 100],
+			all[n * 99 / 100], all[n - 1]);
+}
+
+int main(int argc, char** argv) {
+	int i;
+	config_.threads = 4;
+	config_.count = 10000;
+	config_.interval = 0;
+	config_.file = "/dev/null";
+	for (i = 1; i + 1 < argc; i += 2) {
+		string a = argv[i];
+		if (a == "--threads")
+			config_.threads = atoi(argv[i + 1]);
+		else if (a == "--count")
+			config_.count = atoi(argv[i + 1]);
+		else if (a == "--interval")
+			config_.interval = atoi(argv[i + 1]);
+		else if (a == "--file")
+			config_.file = argv[i + 1];
+		else
+			break;
+	}
+	if (i < argc || config_.threads == 0 || config_.count == 0) {
+		printf("usage: %s [--threads n] [--count n] [--interval us] "
+				"[--file path]\n", argv[0]);
+		return 1;
+	}
+	Log::set_file(config_.file.c_str());
+	bench(false);
+	bench(true);
+	return 0;
+}
@@ -0,0 +1,487 @@
+// Mock speech/tts websocket server
+// implements the protocol used by SpeechConnection, SpeechImpl, TtsImpl:
+//   AuthRequest --> AuthResponse
+//   SpeechRequest --> SpeechResponse
+//   TtsRequest --> TtsResponse
+// responses are scriptable, latency, response splitting and connection
+// drops can be injected. used for offline benchmark of speech sdk.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include "auth.pb.h"
+#include "speech.pb.h"
+#include "tts.pb.h"
+#include "Poco/Net/HTTPServer.h"
+#include "Poco/Net/HTTPServerParams.h"
+#include "Poco/Net/HTTPRequestHandler.h"
+#include "Poco/Net/HTTPRequestHandlerFactory.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "Poco/Net/SecureServerSocket.h"
+#include "Poco/Net/WebSocket.h"
+#include "Poco/Net/NetException.h"
+#include "Poco/Net/Context.h"
+#include "Poco/Net/SSLManager.h"
+
+#define DEFAULT_PORT 30000
+#define RECV_BUF_SIZE 0x100000
+
+using std::string;
+using std::vector;
+using rokid::open::speech::AuthRequest;
+using rokid::open::speech::AuthResponse;
+using rokid::open::speech::v2::SpeechRequest;
+using rokid::open::speech::v2::SpeechResponse;
+using rokid::open::speech::v1::TtsRequest;
+using rokid::open::speech::v1::TtsResponse;
+using rokid::open::speech::v1::ReqType;
+using rokid::open::speech::v1::SpeechErrorCode;
+using Poco::Timespan;
+using Poco::Exception;
+using Poco::Net::HTTPServer;
+using Poco::Net::HTTPServerParams;
+using Poco::Net::HTTPRequestHandler;
+using Poco::Net::HTTPRequestHandlerFactory;
+using Poco::Net::HTTPServerRequest;
+using Poco::Net::HTTPServerResponse;
+using Poco::Net::SecureServerSocket;
+using Poco::Net::WebSocket;
+using Poco::Net::Context;
+
+typedef struct {
+	uint32_t port;
+	string cert_file;
+	string key_file;
+	bool auth_fail;
+	// delay before first response of a request
+	uint32_t latency;
+	// delay between responses of a request
+	uint32_t frame_delay;
+	// count of INTERMEDIATE asr results before ASR_FINISH
+	uint32_t asr_split;
+	// send INTERMEDIATE asr every 'inter_every' voice data, 0 disabled
+	uint32_t inter_every;
+	// total voice bytes of one tts request
+	uint32_t tts_bytes;
+	// voice bytes of one TtsResponse, random in [min, max]
+	uint32_t tts_frame_min;
+	uint32_t tts_frame_max;
+	// close connection after 'drop_after' responses, 0 never
+	uint32_t drop_after;
+	// percent of requests that connection dropped before finish
+	uint32_t drop_rate;
+	string asr;
+	string nlp;
+	string action;
+	string extra;
+} MockConfig;
+
+static MockConfig config_;
+static std::atomic<uint32_t> connection_count_(0);
+static std::atomic<uint64_t> response_count_(0);
+static bool quit_ = false;
+
+static void sleep_ms(uint32_t ms) {
+	if (ms)
+		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// split position aligned to utf8 character
+static size_t utf8_prefix(const string& s, uint32_t part, uint32_t parts) {
+	size_t pos = s.length() * part / parts;
+	while (pos < s.length() && (s[pos] & 0xc0) == 0x80)
+		++pos;
+	return pos;
+}
+
+class MockConnection : public HTTPRequestHandler {
+public:
+	MockConnection() : sent_(0), seed_(0), voice_count_(0) {
+	}
+
+	void handleRequest(HTTPServerRequest& request,
+			HTTPServerResponse& response) {
+		uint32_t conn_id = ++connection_count_;
+		seed_ = conn_id;
+		try {
+			WebSocket ws(request, response);
+			printf("[%u] websocket connected from %s\n", conn_id,
+					request.clientAddress().toString().c_str());
+			ws.setReceiveTimeout(Timespan(60, 0));
+			run(ws);
+			printf("[%u] connection closed, %u responses\n", conn_id, sent_);
+		} catch (Exception& e) {
+			printf("[%u] connection error: %s\n", conn_id,
+					e.displayText().c_str());
+		}
+	}
+
+private:
+	void run(WebSocket& ws) {
+		vector<char> buf(RECV_BUF_SIZE);
+		string service;
+		int flags;
+		int c;
+
+		while (!quit_) {
+			c = ws.receiveFrame(buf.data(), buf.size(), flags);
+			if ((flags & WebSocket::FRAME_OP_BITMASK)
+					== WebSocket::FRAME_OP_PING) {
+				ws.sendFrame(buf.data(), c, WebSocket::FRAME_FLAG_FIN
+						| WebSocket::FRAME_OP_PONG);
+				continue;
+			}
+			if (c <= 0 || (flags & WebSocket::FRAME_OP_BITMASK)
+					== WebSocket::FRAME_OP_CLOSE)
+				break;
+			if (service.empty()) {
+				if (!do_auth(ws, buf.data(), c, service))
+					break;
+				continue;
+			}
+			if (service == "tts") {
+				if (!do_tts(ws, buf.data(), c))
+					break;
+			} else {
+				if (!do_speech(ws, buf.data(), c))
+					break;
+			}
+		}
+	}
+
+	bool do_auth(WebSocket& ws, const char* data, int length,
+			string& service) {
+		AuthRequest req;
+		AuthResponse resp;
+		if (!req.ParseFromArray(data, length)) {
+			printf("invalid AuthRequest\n");
+			return false;
+		}
+		resp.set_result(config_.auth_fail
+				? rokid::open::speech::AUTH_FAILED
+				: rokid::open::speech::SUCCESS);
+		if (!send(ws, resp))
+			return false;
+		service = req.service();
+		printf("auth %s, service %s, device %s\n",
+				config_.auth_fail ? "failed" : "success",
+				service.c_str(), req.device_id().c_str());
+		return !config_.auth_fail;
+	}
+
+	bool do_speech(WebSocket& ws, const char* data, int length) {
+		SpeechRequest req;
+		if (!req.ParseFromArray(data, length)) {
+			printf("invalid SpeechRequest\n");
+			return false;
+		}
+		switch (req.type()) {
+		case ReqType::START:
+			voice_count_ = 0;
+			return true;
+		case ReqType::VOICE:
+			++voice_count_;
+			if (config_.inter_every
+					&& voice_count_ % config_.inter_every == 0) {
+				SpeechResponse resp;
+				resp.set_id(req.id());
+				resp.set_type(rokid::open::speech::v2::INTERMEDIATE);
+				resp.set_result(SpeechErrorCode::SUCCESS);
+				resp.set_asr(config_.asr.substr(0, utf8_prefix(config_.asr,
+								1, config_.asr_split + 1)));
+				return send(ws, resp);
+			}
+			return true;
+		case ReqType::END:
+		case ReqType::TEXT:
+			break;
+		default:
+			return true;
+		}
+
+		SpeechResponse resp;
+		uint32_t i;
+		sleep_ms(config_.latency);
+		if (should_drop())
+			return false;
+		for (i = 1; i <= config_.asr_split; ++i) {
+			resp.Clear();
+			resp.set_id(req.id());
+			resp.set_type(rokid::open::speech::v2::INTERMEDIATE);
+			resp.set_result(SpeechErrorCode::SUCCESS);
+			resp.set_asr(config_.asr.substr(0, utf8_prefix(config_.asr,
+							i, config_.asr_split + 1)));
+			if (i == 1 && !config_.extra.empty())
+				resp.set_extra(config_.extra);
+			if (!send(ws, resp))
+				return false;
+			sleep_ms(config_.frame_delay);
+		}
+		resp.Clear();
+		resp.set_id(req.id());
+		resp.set_type(rokid::open::speech::v2::ASR_FINISH);
+		resp.set_result(SpeechErrorCode::SUCCESS);
+		resp.set_asr(req.type() == ReqType::TEXT ? req.asr() : config_.asr);
+		if (config_.asr_split == 0 && !config_.extra.empty())
+			resp.set_extra(config_.extra);
+		if (!send(ws, resp))
+			return false;
+		sleep_ms(config_.frame_delay);
+		resp.Clear();
+		resp.set_id(req.id());
+		resp.set_type(rokid::open::speech::v2::FINISH);
+		resp.set_result(SpeechErrorCode::SUCCESS);
+		resp.set_nlp(config_.nlp);
+		resp.set_action(config_.action);
+		return send(ws, resp);
+	}
+
+	bool do_tts(WebSocket& ws, const char* data, int length) {
+		TtsRequest req;
+		TtsResponse resp;
+		uint32_t offset = 0;
+		uint32_t sz;
+		bool drop;
+
+		if (!req.ParseFromArray(data, length)) {
+			printf("invalid TtsRequest\n");
+			return false;
+		}
+		sleep_ms(config_.latency);
+		drop = should_drop();
+		while (offset < config_.tts_bytes) {
+			sz = config_.tts_frame_min;
+			if (config_.tts_frame_max > config_.tts_frame_min)
+				sz += rand_r(&seed_) % (config_.tts_frame_max
+						- config_.tts_frame_min + 1);
+			if (sz > config_.tts_bytes - offset)
+				sz = config_.tts_bytes - offset;
+			resp.Clear();
+			resp.set_id(req.id());
+			resp.set_result(SpeechErrorCode::SUCCESS);
+			if (offset == 0)
+				resp.set_text(req.text());
+			resp.mutable_voice()->assign(sz, (char)(offset & 0xff));
+			offset += sz;
+			resp.set_finish(offset >= config_.tts_bytes);
+			if (!send(ws, resp))
+				return false;
+			// drop connection in the middle of tts stream
+			if (drop)
+				return false;
+			sleep_ms(config_.frame_delay);
+		}
+		if (config_.tts_bytes == 0) {
+			resp.Clear();
+			resp.set_id(req.id());
+			resp.set_result(SpeechErrorCode::SUCCESS);
+			resp.set_finish(true);
+			return send(ws, resp);
+		}
+		return true;
+	}
+
+	bool should_drop() {
+		if (config_.drop_rate == 0)
+			return false;
+		if ((uint32_t)(rand_r(&seed_) % 100) >= config_.drop_rate)
+			return false;
+		printf("inject connection drop\n");
+		return true;
+	}
+
+	template <typename PBT>
+	bool send(WebSocket& ws, PBT& msg) {
+		if (!msg.SerializeToString(&send_buf_))
+			return false;
+		if (config_.drop_after && sent_ >= config_.drop_after) {
+			printf("drop connection after %u responses\n", sent_);
+			return false;
+		}
+		ws.sendFrame(send_buf_.data(), send_buf_.length(),
+				WebSocket::FRAME_BINARY);
+		++sent_;
+		++response_count_;
+		return true;
+	}
+
+private:
+	string send_buf_;
+	uint32_t sent_;
+	unsigned int seed_;
+	uint32_t voice_count_;
+};
+
+class MockConnectionFactory : public HTTPRequestHandlerFactory {
+public:
+	HTTPRequestHandler* createRequestHandler(
+			const HTTPServerRequest& request) {
+		return new MockConnection();
+	}
+};
+
+// script file, one 'key=value' per line, '#' comment
+// keys: asr, nlp, action, extra
+static bool load_script(const char* file) {
+	FILE* fp = fopen(file, "r");
+	char* line = NULL;
+	size_t cap = 0;
+	ssize_t len;
+	char* p;
+
+	if (fp == NULL) {
+		printf("open script %s failed\n", file);
+		return false;
+	}
+	while ((len = getline(&line, &cap, fp)) > 0) {
+		while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+			line[--len] = '\0';
+		if (len == 0 || line[0] == '#')
+			continue;
+		p = strchr(line, '=');
+		if (p == NULL)
+			continue;
+		*p++ = '\0';
+		if (strcmp(line, "asr") == 0)
+			config_.asr = p;
+		else if (strcmp(line, "nlp") == 0)
+			config_.nlp = p;
+		else if (strcmp(line, "action") == 0)
+			config_.action = p;
+		else if (strcmp(line, "extra") == 0)
+			config_.extra = p;
+		else
+			printf("script: unknown key %s\n", line);
+	}
+	free(line);
+	fclose(fp);
+	return true;
+}
+
+static void usage(const char* prog) {
+	printf("usage: %s [options]\n"
+			"  --port <n>            listen port, default %d\n"
+			"  --cert <file>         certificate file (PEM)\n"
+			"  --key <file>          private key file (PEM)\n"
+			"  --auth-fail           reply auth failed\n"
+			"  --script <file>       asr/nlp/action/extra script\n"
+			"  --latency <ms>        delay before first response\n"
+			"  --frame-delay <ms>    delay between responses\n"
+			"  --asr-split <n>       intermediate asr count\n"
+			"  --inter-every <n>     intermediate asr every n voice data\n"
+			"  --tts-bytes <n>       voice bytes per tts request\n"
+			"  --tts-frame <min> <max>  voice bytes per tts response\n"
+			"  --drop-after <n>      close connection after n responses\n"
+			"  --drop-rate <percent> drop connection in middle of requests\n",
+			prog, DEFAULT_PORT);
+}
+
+static bool parse_args(int argc, char** argv) {
+	int i;
+	for (i = 1; i < argc; ++i) {
+		string a = argv[i];
+		bool has1 = i + 1 < argc;
+		if (a == "--port" && has1)
+			config_.port = atoi(argv[++i]);
+		else if (a == "--cert" && has1)
+			config_.cert_file = argv[++i];
+		else if (a == "--key" && has1)
+			config_.key_file = argv[++i];
+		else if (a == "--auth-fail")
+			config_.auth_fail = true;
+		else if (a == "--script" && has1) {
+			if (!load_script(argv[++i]))
+				return false;
+		} else if (a == "--latency" && has1)
+			config_.latency = atoi(argv[++i]);
+		else if (a == "--frame-delay" && has1)
+			config_.frame_delay = atoi(argv[++i]);
+		else if (a == "--asr-split" && has1)
+			config_.asr_split = atoi(argv[++i]);
+		else if (a == "--inter-every" && has1)
+			config_.inter_every = atoi(argv[++i]);
+		else if (a == "--tts-bytes" && has1)
+			config_.tts_bytes = atoi(argv[++i]);
+		else if (a == "--tts-frame" && i + 2 < argc) {
+			config_.tts_frame_min = atoi(argv[++i]);
+			config_.tts_frame_max = atoi(argv[++i]);
+		} else if (a == "--drop-after" && has1)
+			config_.drop_after = atoi(argv[++i]);
+		else if (a == "--drop-rate" && has1)
+			config_.drop_rate = atoi(argv[++i]);
+		else {
+			usage(argv[0]);
+			return false;
+		}
+	}
+	if (config_.tts_frame_min == 0)
+		config_.tts_frame_min = 1;
+	if (config_.tts_frame_max < config_.tts_frame_min)
+		config_.tts_frame_max = config_.tts_frame_min;
+	// speech sdk always connect with https
+	if (config_.cert_file.empty() || config_.key_file.empty()) {
+		printf("--cert and --key required\n");
+		return false;
+	}
+	return true;
+}
+
+static void sig_quit(int sig) {
+	quit_ = true;
+}
+
+int main(int argc, char** argv) {
+	config_.port = DEFAULT_PORT;
+	config_.auth_fail = false;
+	config_.latency = 0;
+	config_.frame_delay = 0;
+	config_.asr_split = 2;
+	config_.inter_every = 0;
+	config_.tts_bytes = 0x10000;
+	config_.tts_frame_min = 0x1000;
+	config_.tts_frame_max = 0x10000;
+	config_.drop_after = 0;
+	config_.drop_rate = 0;
+	config_.asr = "mock asr result";
+	config_.nlp = "{\"domain\":\"mock\",\"intent\":\"mock\"}";
+	config_.action = "{\"version\":\"2.0.0\",\"response\":{}}";
+	config_.extra = "{\"activation\":\"accept\"}";
+	if (!parse_args(argc, argv))
+		return 1;
+
+	signal(SIGINT, sig_quit);
+	signal(SIGTERM, sig_quit);
+	signal(SIGPIPE, SIG_IGN);
+
+	try {
+		Poco::Net::initializeSSL();
+		Context::Ptr context = new Context(Context::SERVER_USE,
+				config_.key_file, config_.cert_file, "",
+				Context::VERIFY_NONE);
+		SecureServerSocket sock(config_.port, 64, context);
+		HTTPServerParams* params = new HTTPServerParams();
+		params->setMaxThreads(16);
+		params->setKeepAlive(true);
+		HTTPServer server(new MockConnectionFactory(), sock, params);
+		server.start();
+		printf("mock server listen on port %u\n", config_.port);
+		while (!quit_)
+			sleep(1);
+		server.stopAll(true);
+	} catch (Exception& e) {
+		printf("mock server failed: %s\n", e.displayText().c_str());
+		return 1;
+	}
+	printf("mock server quit, %u connections, %lu responses\n",
+			connection_count_.load(), (unsigned long)response_count_.load());
+	Poco::Net::uninitializeSSL();
+	return 0;
+}
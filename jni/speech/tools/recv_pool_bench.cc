@@ -0,0 +1,185 @@
+// Benchmark receive buffers of websocket frames 4 - 64 KB:
+// malloc of exact frame size and copy out of one receive buffer (before
+// RecvBufferPool), a pooled buffer of full capacity per frame (as the
+// first RecvBufferPool did, this pool keeps one of them idle), and size
+// classes with detach(). Frames stay queued a random depth before
+// released like responses waiting for recv(). Reports time and mallocs
+// per frame, bytes held by queued frames and idle bytes pool retained.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <deque>
+#include <chrono>
+#include "recv_buffer_pool.h"
+
+using std::string;
+using std::deque;
+using std::chrono::steady_clock;
+using rokid::speech::RecvBufferPool;
+using rokid::speech::RecvBufferPoolStat;
+using rokid::speech::RecvSlice;
+
+// SOCKET_BUF_SIZE of speech sdk
+#define CAPACITY 0x40000
+
+typedef struct {
+	uint32_t count;
+	uint32_t min_frame;
+	uint32_t max_frame;
+	// max frames queued before released
+	uint32_t depth;
+} BenchConfig;
+
+typedef struct {
+	double ns_per_frame;
+	double mallocs_per_frame;
+	double queued_bytes;
+	uint32_t idle_bytes;
+} BenchResult;
+
+static BenchConfig config_;
+
+static uint32_t next_rand(uint32_t& seed) {
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+static uint32_t frame_size(uint32_t& seed) {
+	return config_.min_frame
+		+ next_rand(seed) % (config_.max_frame - config_.min_frame + 1);
+}
+
+static void fill(char* data, uint32_t length, uint32_t i) {
+	memset(data, i & 0xff, length);
+}
+
+static BenchResult run_malloc() {
+	BenchResult r;
+	uint32_t seed = 1;
+	uint32_t dseed = 7;
+	char* recv_buf = (char*)malloc(CAPACITY);
+	deque<char*> queue;
+	deque<uint32_t> sizes;
+	uint64_t queued = 0, held = 0;
+	uint32_t i;
+	steady_clock::time_point begin = steady_clock::now();
+	for (i = 0; i < config_.count; ++i) {
+		uint32_t c = frame_size(seed);
+		fill(recv_buf, c, i);
+		char* p = (char*)malloc(c);
+		memcpy(p, recv_buf, c);
+		queue.push_back(p);
+		sizes.push_back(c);
+		held += c;
+		queued += held;
+		uint32_t keep = next_rand(dseed) % config_.depth;
+		while (queue.size() > keep) {
+			free(queue.front());
+			held -= sizes.front();
+			queue.pop_front();
+			sizes.pop_front();
+		}
+	}
+	r.ns_per_frame = std::chrono::duration<double, std::nano>(
+			steady_clock::now() - begin).count() / config_.count;
+	while (!queue.empty()) {
+		free(queue.front());
+		queue.pop_front();
+	}
+	free(recv_buf);
+	r.mallocs_per_frame = 1.0;
+	r.queued_bytes = (double)queued / config_.count;
+	r.idle_bytes = 0;
+	return r;
+}
+
+static BenchResult run_pool(bool classes) {
+	BenchResult r;
+	uint32_t seed = 1;
+	uint32_t dseed = 7;
+	RecvBufferPool pool;
+	pool.initialize(CAPACITY);
+	RecvSlice recv_buf;
+	deque<RecvSlice> queue;
+	uint64_t queued = 0, held = 0;
+	uint32_t i;
+	steady_clock::time_point begin = steady_clock::now();
+	for (i = 0; i < config_.count; ++i) {
+		uint32_t c = frame_size(seed);
+		RecvSlice frame;
+		if (classes) {
+			if (recv_buf.empty())
+				recv_buf = pool.obtain(CAPACITY);
+			fill(recv_buf->data, c, i);
+			frame = pool.detach(recv_buf, c);
+		} else {
+			frame = pool.obtain(CAPACITY);
+			fill(frame->data, c, i);
+			frame->length = c;
+		}
+		pool.frame_received(c);
+		held += frame->capacity;
+		queue.push_back(std::move(frame));
+		queued += held;
+		uint32_t keep = next_rand(dseed) % config_.depth;
+		while (queue.size() > keep) {
+			held -= queue.front()->capacity;
+			queue.pop_front();
+		}
+	}
+	r.ns_per_frame = std::chrono::duration<double, std::nano>(
+			steady_clock::now() - begin).count() / config_.count;
+	queue.clear();
+	RecvBufferPoolStat stat;
+	pool.get_stat(stat);
+	r.mallocs_per_frame = (double)stat.allocated / config_.count;
+	r.queued_bytes = (double)queued / config_.count;
+	r.idle_bytes = stat.idle_bytes;
+	return r;
+}
+
+static void print_result(const char* name, const BenchResult& r) {
+	printf("%-14s %8.1f ns/frame  %6.4f malloc/frame  queued %8.1f KB"
+			"  idle %6u KB\n", name, r.ns_per_frame, r.mallocs_per_frame,
+			r.queued_bytes / 1024, r.idle_bytes / 1024);
+}
+
+static bool parse_args(int argc, char** argv) {
+	int i;
+	config_.count = 200000;
+	config_.min_frame = 4096;
+	config_.max_frame = 65536;
+	config_.depth = 8;
+	for (i = 1; i < argc; ++i) {
+		string a = argv[i];
+		if (a == "--count" && i + 1 < argc)
+			config_.count = atoi(argv[++i]);
+		else if (a == "--frame" && i + 2 < argc) {
+			config_.min_frame = atoi(argv[++i]);
+			config_.max_frame = atoi(argv[++i]);
+		} else if (a == "--depth" && i + 1 < argc)
+			config_.depth = atoi(argv[++i]);
+		else
+			return false;
+	}
+	return config_.count > 0 && config_.depth > 0
+		&& config_.min_frame > 0 && config_.min_frame <= config_.max_frame
+		&& config_.max_frame <= CAPACITY;
+}
+
+int main(int argc, char** argv) {
+	if (!parse_args(argc, argv)) {
+		printf("usage: %s [--count n] [--frame min max] [--depth n]\n",
+				argv[0]);
+		return 1;
+	}
+	printf("%u frames of %u - %u bytes, queue depth up to %u\n",
+			config_.count, config_.min_frame, config_.max_frame,
+			config_.depth);
+	print_result("malloc+copy", run_malloc());
+	print_result("pool full", run_pool(false));
+	print_result("pool classes", run_pool(true));
+	return 0;
+}
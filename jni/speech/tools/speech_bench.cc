@@ -0,0 +1,363 @@
+// Benchmark client of speech sdk, normally run against mock_server
+// measures request latency percentiles and throughput of
+// Speech (voice or text) and Tts requests, and heap allocations per
+// request of the whole process (sdk threads included). Build it once
+// more with sdk sources of an older tree for a before/after count.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include "speech.h"
+#include "tts.h"
+
+using std::string;
+using std::vector;
+using std::shared_ptr;
+using std::chrono::steady_clock;
+using rokid::speech::Speech;
+using rokid::speech::SpeechResult;
+using rokid::speech::Tts;
+using rokid::speech::TtsResult;
+using rokid::speech::TtsOptions;
+using rokid::speech::PrepareOptions;
+
+typedef steady_clock::time_point TimePoint;
+
+typedef struct {
+	string mode;
+	string host;
+	uint32_t port;
+	string branch;
+	uint32_t count;
+	uint32_t warmup;
+	// voice data count of one speech request
+	uint32_t voice_chunks;
+	uint32_t chunk_bytes;
+	// interval between voice data
+	uint32_t chunk_interval;
+	string text;
+	// tts cache bytes, 0 disable
+	uint32_t cache_bytes;
+	// prefetch text before speak
+	bool prefetch;
+} BenchConfig;
+
+static BenchConfig config_;
+
+static std::atomic<uint64_t> alloc_count_(0);
+static std::atomic<uint64_t> alloc_bytes_(0);
+
+void* operator new(size_t size) {
+	alloc_count_.fetch_add(1, std::memory_order_relaxed);
+	alloc_bytes_.fetch_add(size, std::memory_order_relaxed);
+	void* p = malloc(size ? size : 1);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	free(p);
+}
+
+typedef struct {
+	uint64_t count;
+	uint64_t bytes;
+} AllocMark;
+
+static AllocMark alloc_mark() {
+	AllocMark m;
+	m.count = alloc_count_.load(std::memory_order_relaxed);
+	m.bytes = alloc_bytes_.load(std::memory_order_relaxed);
+	return m;
+}
+
+static void print_allocs(const AllocMark& begin, const AllocMark& end,
+		uint32_t requests) {
+	if (requests == 0)
+		return;
+	printf("%-12s %.1f per request, %.1f KB per request\n", "allocations",
+			(double)(end.count - begin.count) / requests,
+			(end.bytes - begin.bytes) / 1024.0 / requests);
+}
+
+static double elapsed_ms(const TimePoint& begin, const TimePoint& end) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			end - begin).count() / 1000.0;
+}
+
+static void print_percentiles(const char* name, vector<double>& samples) {
+	if (samples.empty()) {
+		printf("%-12s no samples\n", name);
+		return;
+	}
+	std::sort(samples.begin(), samples.end());
+	size_t n = samples.size();
+	double sum = 0;
+	size_t i;
+	for (i = 0; i < n; ++i)
+		sum += samples[i];
+	printf("%-12s n=%zu avg=%.2fms p50=%.2fms p90=%.2fms p99=%.2fms "
+			"max=%.2fms\n", name, n, sum / n,
+			samples[n * 50 / 100], samples[n * 90 / 100],
+			samples[n * 99 / 100], samples[n - 1]);
+}
+
+static void prepare_options(PrepareOptions& opts) {
+	opts.host = config_.host;
+	opts.port = config_.port;
+	opts.branch = config_.branch;
+	// mock server not check auth params, but sdk require not empty
+	opts.key = "bench_key";
+	opts.device_type_id = "bench_device_type";
+	opts.device_id = "bench_device";
+	opts.secret = "bench_secret";
+}
+
+static int bench_speech() {
+	shared_ptr<Speech> speech = Speech::new_instance();
+	PrepareOptions opts;
+	SpeechResult res;
+	vector<double> first_lat;
+	vector<double> end_lat;
+	vector<uint8_t> voice(config_.chunk_bytes, 0);
+	uint32_t errors = 0;
+	uint32_t i, j;
+	int32_t id;
+	bool text_mode = config_.mode == "text";
+	TimePoint bench_begin;
+	TimePoint t0;
+	AllocMark alloc_begin = alloc_mark();
+	bool got_first;
+
+	prepare_options(opts);
+	speech->prepare(opts);
+	for (i = 0; i < config_.count + config_.warmup; ++i) {
+		if (i == config_.warmup) {
+			bench_begin = steady_clock::now();
+			alloc_begin = alloc_mark();
+		}
+		if (text_mode) {
+			t0 = steady_clock::now();
+			id = speech->put_text(config_.text.c_str());
+		} else {
+			id = speech->start_voice();
+			for (j = 0; j < config_.voice_chunks; ++j) {
+				speech->put_voice(id, voice.data(), voice.size());
+				if (config_.chunk_interval)
+					std::this_thread::sleep_for(std::chrono::milliseconds(
+								config_.chunk_interval));
+			}
+			t0 = steady_clock::now();
+			speech->end_voice(id);
+		}
+		got_first = false;
+		while (speech->poll(res)) {
+			if (res.id != id)
+				continue;
+			if (!got_first && res.type != rokid::speech::SPEECH_RES_START) {
+				got_first = true;
+				if (i >= config_.warmup)
+					first_lat.push_back(elapsed_ms(t0, steady_clock::now()));
+			}
+			if (res.type == rokid::speech::SPEECH_RES_END) {
+				if (i >= config_.warmup)
+					end_lat.push_back(elapsed_ms(t0, steady_clock::now()));
+				break;
+			}
+			if (res.type == rokid::speech::SPEECH_RES_ERROR
+					|| res.type == rokid::speech::SPEECH_RES_CANCELLED) {
+				printf("speech %d failed, type %d, err %d\n", id,
+						res.type, res.err);
+				++errors;
+				break;
+			}
+		}
+	}
+	double total = elapsed_ms(bench_begin, steady_clock::now());
+	AllocMark alloc_end = alloc_mark();
+	speech->release();
+
+	printf("speech(%s) %u requests, %u errors, %.2f req/s\n",
+			config_.mode.c_str(), config_.count, errors,
+			config_.count * 1000.0 / total);
+	print_percentiles("first_result", first_lat);
+	print_percentiles("finish", end_lat);
+	print_allocs(alloc_begin, alloc_end, config_.count);
+	return errors ? 1 : 0;
+}
+
+static int bench_tts() {
+	shared_ptr<Tts> tts = Tts::new_instance();
+	PrepareOptions opts;
+	TtsResult res;
+	vector<double> first_lat;
+	vector<double> end_lat;
+	uint64_t bytes = 0;
+	uint32_t errors = 0;
+	uint32_t i;
+	int32_t id;
+	TimePoint bench_begin;
+	TimePoint t0;
+	AllocMark alloc_begin = alloc_mark();
+	bool got_first;
+
+	prepare_options(opts);
+	tts->prepare(opts);
+	// sdk built before tts cache (-DSPEECH_BENCH_NO_TTS_CACHE), for a
+	// before/after allocation count
+#ifndef SPEECH_BENCH_NO_TTS_CACHE
+	if (config_.cache_bytes) {
+		shared_ptr<TtsOptions> topts = TtsOptions::new_instance();
+		topts->set_cache(config_.cache_bytes, "");
+		tts->config(topts);
+	}
+	if (config_.prefetch) {
+		tts->prefetch(vector<string>(1, config_.text));
+		// let prefetch finish before measure
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+	}
+#endif
+	for (i = 0; i < config_.count + config_.warmup; ++i) {
+		if (i == config_.warmup) {
+			bench_begin = steady_clock::now();
+			alloc_begin = alloc_mark();
+			bytes = 0;
+		}
+		t0 = steady_clock::now();
+		id = tts->speak(config_.text.c_str());
+		got_first = false;
+		while (tts->poll(res)) {
+			if (res.id != id)
+				continue;
+			if (res.type == rokid::speech::TTS_RES_VOICE) {
+				if (!got_first && i >= config_.warmup)
+					first_lat.push_back(elapsed_ms(t0, steady_clock::now()));
+				got_first = true;
+				if (res.voice.get())
+					bytes += res.voice->length();
+			} else if (res.type == rokid::speech::TTS_RES_END) {
+				if (i >= config_.warmup)
+					end_lat.push_back(elapsed_ms(t0, steady_clock::now()));
+				break;
+			} else if (res.type == rokid::speech::TTS_RES_ERROR
+					|| res.type == rokid::speech::TTS_RES_CANCELLED) {
+				printf("tts %d failed, type %d, err %d\n", id,
+						res.type, res.err);
+				++errors;
+				break;
+			}
+		}
+	}
+	double total = elapsed_ms(bench_begin, steady_clock::now());
+	AllocMark alloc_end = alloc_mark();
+	tts->release();
+
+	printf("tts %u requests, %u errors, %.2f req/s, %.2f KB/s\n",
+			config_.count, errors, config_.count * 1000.0 / total,
+			bytes * 1000.0 / 1024 / total);
+	print_percentiles("first_voice", first_lat);
+	print_percentiles("finish", end_lat);
+	print_allocs(alloc_begin, alloc_end, config_.count);
+	return errors ? 1 : 0;
+}
+
+static void usage(const char* prog) {
+	printf("usage: %s [options]\n"
+			"  --mode <voice|text|tts>  default voice\n"
+			"  --host <host>         default localhost\n"
+			"  --port <n>            default 30000\n"
+			"  --branch <path>       default /\n"
+			"  --count <n>           requests measured, default 100\n"
+			"  --warmup <n>          requests not measured, default 5\n"
+			"  --chunks <n>          voice data per speech request\n"
+			"  --chunk-bytes <n>     bytes of one voice data\n"
+			"  --chunk-interval <ms> interval between voice data\n"
+			"  --text <text>         text of text/tts requests\n"
+			"  --cache <bytes>       tts cache bytes, default 0 (disabled)\n"
+			"  --prefetch            prefetch tts text before measure\n",
+			prog);
+}
+
+static bool parse_args(int argc, char** argv) {
+	int i;
+	for (i = 1; i < argc; ++i) {
+		string a = argv[i];
+		if (a == "--prefetch") {
+			config_.prefetch = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			usage(argv[0]);
+			return false;
+		}
+		if (a == "--mode")
+			config_.mode = argv[++i];
+		else if (a == "--host")
+			config_.host = argv[++i];
+		else if (a == "--port")
+			config_.port = atoi(argv[++i]);
+		else if (a == "--branch")
+			config_.branch = argv[++i];
+		else if (a == "--count")
+			config_.count = atoi(argv[++i]);
+		else if (a == "--warmup")
+			config_.warmup = atoi(argv[++i]);
+		else if (a == "--chunks")
+			config_.voice_chunks = atoi(argv[++i]);
+		else if (a == "--chunk-bytes")
+			config_.chunk_bytes = atoi(argv[++i]);
+		else if (a == "--chunk-interval")
+			config_.chunk_interval = atoi(argv[++i]);
+		else if (a == "--text")
+			config_.text = argv[++i];
+		else if (a == "--cache")
+			config_.cache_bytes = atoi(argv[++i]);
+		else {
+			usage(argv[0]);
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	config_.mode = "voice";
+	config_.host = "localhost";
+	config_.port = 30000;
+	config_.branch = "/";
+	config_.count = 100;
+	config_.warmup = 5;
+	config_.voice_chunks = 50;
+	// 20ms pcm 16k 16bit mono
+	config_.chunk_bytes = 640;
+	config_.chunk_interval = 0;
+	config_.text = "benchmark text";
+	config_.cache_bytes = 0;
+	config_.prefetch = false;
+	if (!parse_args(argc, argv))
+		return 1;
+	if (config_.count == 0)
+		return 0;
+	if (config_.mode == "tts")
+		return bench_tts();
+	if (config_.mode == "voice" || config_.mode == "text")
+		return bench_speech();
+	usage(argv[0]);
+	return 1;
+}
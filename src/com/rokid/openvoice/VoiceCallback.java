@@ -1,5 +1,9 @@
 package com.rokid.openvoice;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
+
 import android.os.Bundle;
 import android.os.Handler;
 import android.os.Message;
@@ -11,10 +15,60 @@ public final class VoiceCallback {
 
 	private Handler mHandler = null;
 
+	private static final int EVENT_STRINGS = 3;
+
+	private String[] mStrings = new String[EVENT_STRINGS];
+
+	private byte[] mBytes = new byte[256];
+
 	public VoiceCallback(Handler mHandler) {
 		this.mHandler = mHandler;
 	}
 
+	/**
+	 * Events batched by native, buffer only valid during this call.
+	 * each event: int what, int id, int arg, double sl, double energy,
+	 * (int length, utf8 bytes) * 3, native byte order
+	 */
+	private void onEvents(ByteBuffer buf, int count) {
+		buf.order(ByteOrder.nativeOrder());
+		buf.clear();
+		for (int i = 0; i < count; i++) {
+			int what = buf.getInt();
+			int id = buf.getInt();
+			int arg = buf.getInt();
+			double sl = buf.getDouble();
+			double energy = buf.getDouble();
+			for (int j = 0; j < EVENT_STRINGS; j++) {
+				int length = buf.getInt();
+				mStrings[j] = null;
+				if (length > 0) {
+					if (mBytes.length < length)
+						mBytes = new byte[length];
+					buf.get(mBytes, 0, length);
+					mStrings[j] = new String(mBytes, 0, length, StandardCharsets.UTF_8);
+				}
+			}
+			switch (what) {
+			case VoiceService.MSG_VOICE_EVENT:
+				onVoiceEvent(id, arg, sl, energy);
+				break;
+			case VoiceService.MSG_INTERMEDIATE_RESULT:
+				onIntermediateResult(id, arg, mStrings[0]);
+				break;
+			case VoiceService.MSG_VOICE_COMMAND:
+				onVoiceCommand(id, mStrings[0], mStrings[1], mStrings[2]);
+				break;
+			case VoiceService.MSG_SPEECH_ERROR:
+				onSpeechError(id, arg);
+				break;
+			default:
+				Log.w(TAG, "unknown event " + what);
+				break;
+			}
+		}
+	}
+
 	private void onVoiceEvent(int id, int event, double sl, double energy) {
 		Message obtain = Message.obtain();
 		obtain.what = VoiceService.MSG_VOICE_EVENT;